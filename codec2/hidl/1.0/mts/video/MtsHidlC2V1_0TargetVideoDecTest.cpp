@@ -52,6 +52,36 @@ static ComponentTestEnvironment* gEnv = nullptr;
 
 namespace {
 
+// number of output buffers held by the client in SharedOutputBuffersTest
+#define MAX_HELD_OUTPUTS 4
+
+// Returns a checksum of the visible pixels of a graphic buffer.
+uint32_t checksumGraphicBuffer(const std::shared_ptr<C2Buffer>& buffer) {
+    if (!buffer || buffer->data().type() != C2BufferData::GRAPHIC ||
+        buffer->data().graphicBlocks().empty()) {
+        return 0;
+    }
+    const C2ConstGraphicBlock& block = buffer->data().graphicBlocks().front();
+    C2GraphicView view = block.map().get();
+    if (view.error() != C2_OK) {
+        return 0;
+    }
+    const C2PlanarLayout& layout = view.layout();
+    uint32_t checksum = 0;
+    for (uint32_t i = 0; i < layout.numPlanes; ++i) {
+        const C2PlaneInfo& plane = layout.planes[i];
+        for (uint32_t row = 0; row < view.height() / plane.rowSampling;
+             ++row) {
+            const uint8_t* data = view.data()[i] + row * plane.rowInc;
+            for (uint32_t col = 0; col < view.width() / plane.colSampling;
+                 ++col) {
+                checksum = checksum * 31 + data[col * plane.colInc];
+            }
+        }
+    }
+    return checksum;
+}
+
 class Codec2VideoDecHidlTest : public ::testing::VtsHalHidlTargetTestBase {
    private:
     typedef ::testing::VtsHalHidlTargetTestBase Super;
@@ -126,6 +156,9 @@ class Codec2VideoDecHidlTest : public ::testing::VtsHalHidlTargetTestBase {
         mFramesReceived = 0;
         mTimestampUs = 0u;
         mTimestampDevTest = false;
+        mLatencyTest = false;
+        mMaxLatency = 0;
+        mHoldOutputs = false;
         if (mCompName == unknown_comp) mDisableTest = true;
         if (mDisableTest) std::cout << "[   WARN   ] Test Disabled \n";
     }
@@ -178,6 +211,22 @@ class Codec2VideoDecHidlTest : public ::testing::VtsHalHidlTargetTestBase {
                             }
                         }
                     }
+                    if (mLatencyTest) {
+                        // frames queued after this one that are still pending
+                        uint64_t frameIndex =
+                            work->worklets.front()->output.ordinal.frameIndex.peeku();
+                        uint32_t latency = std::count_if(
+                            mFlushedIndices.begin(), mFlushedIndices.end(),
+                            [frameIndex](uint64_t index) { return index > frameIndex; });
+                        mMaxLatency = std::max(mMaxLatency, latency);
+                    }
+                    if (mHoldOutputs &&
+                        mHeldOutputs.size() < MAX_HELD_OUTPUTS) {
+                        const std::shared_ptr<C2Buffer>& buffer =
+                            work->worklets.front()->output.buffers.front();
+                        mHeldOutputs.emplace_back(buffer,
+                                                  checksumGraphicBuffer(buffer));
+                    }
                 }
                 bool mCsd;
                 workDone(mComponent, work, mFlushedIndices, mQueueLock,
@@ -203,6 +252,11 @@ class Codec2VideoDecHidlTest : public ::testing::VtsHalHidlTargetTestBase {
     bool mEos;
     bool mDisableTest;
     bool mTimestampDevTest;
+    bool mLatencyTest;
+    uint32_t mMaxLatency;
+    bool mHoldOutputs;
+    // output buffers held by the test with the checksum of their content
+    std::vector<std::pair<std::shared_ptr<C2Buffer>, uint32_t>> mHeldOutputs;
     uint64_t mTimestampUs;
     std::list<uint64_t> mTimestampUslist;
     std::list<uint64_t> mFlushedIndices;
@@ -478,6 +532,158 @@ TEST_F(Codec2VideoDecHidlTest, DecodeTest) {
     if (mTimestampDevTest) EXPECT_EQ(mTimestampUslist.empty(), true);
 }
 
+// Low latency test: in low latency mode each frame of a stream without
+// reordering shall be output before the next frame is queued
+TEST_F(Codec2VideoDecHidlTest, LowLatencyDecodeTest) {
+    description("Decodes input file one frame at a time in low latency mode");
+    if (mDisableTest) return;
+
+    std::vector<std::unique_ptr<C2SettingResult>> failures;
+    C2GlobalLowLatencyModeTuning lowLatency(C2_TRUE);
+    std::vector<C2Param*> configParam{&lowLatency};
+    c2_status_t status =
+        mComponent->config(configParam, C2_DONT_BLOCK, &failures);
+    if (status != C2_OK || failures.size() != 0u) {
+        std::cout << "[   WARN   ] Test Disabled \n";
+        return;
+    }
+
+    char mURL[512], info[512];
+    std::ifstream eleStream, eleInfo;
+
+    strcpy(mURL, gEnv->getRes().c_str());
+    strcpy(info, gEnv->getRes().c_str());
+    GetURLForComponent(mCompName, mURL, info);
+
+    eleInfo.open(info);
+    ASSERT_EQ(eleInfo.is_open(), true) << mURL << " - file not found";
+    android::Vector<FrameInfo> Info;
+    int bytesCount = 0;
+    uint32_t flags = 0;
+    uint32_t timestamp = 0;
+    uint32_t lastTimestamp = 0;
+    bool reordered = false;
+    while (1) {
+        if (!(eleInfo >> bytesCount)) break;
+        eleInfo >> flags;
+        eleInfo >> timestamp;
+        bool codecConfig = flags ?
+            ((1 << (flags - 1)) & C2FrameData::FLAG_CODEC_CONFIG) != 0 : 0;
+        if (!codecConfig) {
+            if (timestamp < lastTimestamp) reordered = true;
+            lastTimestamp = timestamp;
+        }
+        Info.push_back({bytesCount, flags, timestamp});
+    }
+    eleInfo.close();
+    // frames of reordered streams cannot be output as soon as they are queued
+    if (reordered) {
+        std::cout << "[   WARN   ] Test Disabled \n";
+        return;
+    }
+
+    mLatencyTest = true;
+    ASSERT_EQ(mComponent->start(), C2_OK);
+    ALOGV("mURL : %s", mURL);
+    eleStream.open(mURL, std::ifstream::binary);
+    ASSERT_EQ(eleStream.is_open(), true);
+    typedef std::unique_lock<std::mutex> ULock;
+    for (int i = 0; i < (int)Info.size(); i++) {
+        ASSERT_NO_FATAL_FAILURE(decodeNFrames(
+            mComponent, mQueueLock, mQueueCondition, mWorkQueue,
+            mFlushedIndices, mLinearPool, eleStream, &Info, i, 1,
+            i == (int)Info.size() - 1));
+        // wait for the frame to be returned before queuing the next one
+        ULock l(mQueueLock);
+        mQueueCondition.wait_for(l, TIME_OUT, [this, i]() {
+            return std::find(mFlushedIndices.begin(), mFlushedIndices.end(),
+                             (uint64_t)i) == mFlushedIndices.end();
+        });
+    }
+
+    if (!mEos) {
+        ALOGV("Waiting for input consumption");
+        ASSERT_NO_FATAL_FAILURE(
+            waitOnInputConsumption(mQueueLock, mQueueCondition, mWorkQueue));
+    }
+
+    eleStream.close();
+    std::cout << "[   INFO   ] Max output latency : " << mMaxLatency
+              << " frames \n";
+    EXPECT_EQ(mMaxLatency, 0u);
+}
+
+// Shared output buffers test: output buffers held by the client shall not be
+// overwritten by the decoder, even if it is asked to share them
+TEST_F(Codec2VideoDecHidlTest, SharedOutputBuffersTest) {
+    description("Decodes input file holding output buffers with sharing on");
+    if (mDisableTest) return;
+
+    std::vector<std::unique_ptr<C2SettingResult>> failures;
+    C2PortSharedBuffersTuning::output shared(C2_TRUE);
+    std::vector<C2Param*> configParam{&shared};
+    c2_status_t status =
+        mComponent->config(configParam, C2_DONT_BLOCK, &failures);
+    if (status != C2_OK || failures.size() != 0u) {
+        std::cout << "[   WARN   ] Test Disabled \n";
+        return;
+    }
+    // The service cannot tell when the client releases output buffers, so it
+    // turns sharing off and this test only covers decoders copying the output.
+    // Sharing is covered in process by codec2_hidl_client_loopback_test.
+    C2PortSharedBuffersTuning::output queried(C2_TRUE);
+    ASSERT_EQ(C2_OK,
+              mComponent->query({&queried}, {}, C2_DONT_BLOCK, nullptr));
+    ASSERT_TRUE(queried);
+    EXPECT_EQ(C2_FALSE, queried.value);
+
+    char mURL[512], info[512];
+    std::ifstream eleStream, eleInfo;
+
+    strcpy(mURL, gEnv->getRes().c_str());
+    strcpy(info, gEnv->getRes().c_str());
+    GetURLForComponent(mCompName, mURL, info);
+
+    eleInfo.open(info);
+    ASSERT_EQ(eleInfo.is_open(), true) << mURL << " - file not found";
+    android::Vector<FrameInfo> Info;
+    int bytesCount = 0;
+    uint32_t flags = 0;
+    uint32_t timestamp = 0;
+    while (1) {
+        if (!(eleInfo >> bytesCount)) break;
+        eleInfo >> flags;
+        eleInfo >> timestamp;
+        Info.push_back({bytesCount, flags, timestamp});
+    }
+    eleInfo.close();
+
+    mHoldOutputs = true;
+    ASSERT_EQ(mComponent->start(), C2_OK);
+    ALOGV("mURL : %s", mURL);
+    eleStream.open(mURL, std::ifstream::binary);
+    ASSERT_EQ(eleStream.is_open(), true);
+    ASSERT_NO_FATAL_FAILURE(decodeNFrames(
+        mComponent, mQueueLock, mQueueCondition, mWorkQueue, mFlushedIndices,
+        mLinearPool, eleStream, &Info, 0, (int)Info.size()));
+
+    if (!mEos) {
+        ALOGV("Waiting for input consumption");
+        ASSERT_NO_FATAL_FAILURE(
+            waitOnInputConsumption(mQueueLock, mQueueCondition, mWorkQueue));
+    }
+    eleStream.close();
+
+    typedef std::unique_lock<std::mutex> ULock;
+    ULock l(mQueueLock);
+    EXPECT_EQ(mHeldOutputs.size(), (size_t)MAX_HELD_OUTPUTS);
+    for (size_t i = 0; i < mHeldOutputs.size(); ++i) {
+        EXPECT_EQ(mHeldOutputs[i].second,
+                  checksumGraphicBuffer(mHeldOutputs[i].first))
+            << "held output buffer #" << i << " was overwritten";
+    }
+    mHeldOutputs.clear();
+}
 
 // Adaptive Test
 TEST_F(Codec2VideoDecHidlTest, AdaptiveDecodeTest) {
@@ -27,6 +27,7 @@
 #include <utils/Timers.h>
 
 #include <C2BqBufferPriv.h>
+#include <C2Config.h>
 #include <C2Debug.h>
 #include <C2PlatformSupport.h>
 
@@ -57,6 +58,17 @@ struct CompIntf : public ConfigurableC2Intf {
             std::vector<std::unique_ptr<C2SettingResult>>* const failures
             ) override {
         ALOGV("config");
+        for (C2Param* param : params) {
+            // Output buffers are destroyed in this process as soon as they
+            // are sent to the client, so the component cannot tell when the
+            // client releases them. Do not let it share buffers with the
+            // client.
+            C2PortSharedBuffersTuning::output* shared =
+                    C2PortSharedBuffersTuning::output::From(param);
+            if (shared) {
+                shared->value = C2_FALSE;
+            }
+        }
         return mIntf->config_vb(params, mayBlock, failures);
     }
 
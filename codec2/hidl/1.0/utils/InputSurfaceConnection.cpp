@@ -22,6 +22,7 @@
 
 #include <memory>
 #include <list>
+#include <map>
 #include <mutex>
 #include <atomic>
 
@@ -167,13 +168,7 @@ struct InputSurfaceConnection::Impl : public ComponentWrapper {
         (void)fenceFd;
 
         std::shared_ptr<C2GraphicAllocation> alloc;
-        C2Handle* handle = WrapNativeCodec2GrallocHandle(
-                buffer->handle,
-                buffer->width, buffer->height,
-                buffer->format, buffer->usage, buffer->stride);
-        mAllocatorMutex.lock();
-        c2_status_t err = mAllocator->priorGraphicAllocation(handle, &alloc);
-        mAllocatorMutex.unlock();
+        c2_status_t err = fetchAllocation(bufferId, buffer, &alloc);
         if (err != OK) {
             return UNKNOWN_ERROR;
         }
@@ -234,6 +229,44 @@ struct InputSurfaceConnection::Impl : public ComponentWrapper {
     }
 
 private:
+    // Returns the allocation imported for |buffer| in slot |bufferId|.
+    //
+    // GraphicBufferSource cycles through kBufferCount slots, so the imported
+    // allocation is cached per slot and reused as long as the slot still holds
+    // the same GraphicBuffer (same unique id and generation). The cached
+    // allocation is replaced when the slot is reallocated.
+    c2_status_t fetchAllocation(
+            int32_t bufferId,
+            const sp<GraphicBuffer>& buffer,
+            std::shared_ptr<C2GraphicAllocation>* alloc) {
+        std::lock_guard<std::mutex> lock(mAllocatorMutex);
+        auto it = mAllocations.find(bufferId);
+        if (it != mAllocations.end() &&
+                it->second.uniqueId == buffer->getId() &&
+                it->second.generation == buffer->getGenerationNumber()) {
+            *alloc = it->second.alloc;
+            return C2_OK;
+        }
+        if (it != mAllocations.end()) {
+            ALOGV("fetchAllocation -- slot %d reallocated", bufferId);
+            mAllocations.erase(it);
+        }
+
+        C2Handle* handle = WrapNativeCodec2GrallocHandle(
+                buffer->handle,
+                buffer->width, buffer->height,
+                buffer->format, buffer->usage, buffer->stride);
+        c2_status_t err = mAllocator->priorGraphicAllocation(handle, alloc);
+        if (err != C2_OK) {
+            return err;
+        }
+        mAllocations.emplace(
+                bufferId,
+                CachedAllocation{
+                    buffer->getId(), buffer->getGenerationNumber(), *alloc });
+        return C2_OK;
+    }
+
     c2_status_t compQuery(
             const std::vector<C2Param*> &stackParams,
             const std::vector<C2Param::Index> &heapParamIndices,
@@ -379,6 +412,16 @@ private:
     // Needed for ComponentWrapper implementation
     std::mutex mAllocatorMutex;
     std::shared_ptr<C2Allocator> mAllocator;
+
+    // Allocation imported for a GraphicBufferSource slot, along with the
+    // identity of the GraphicBuffer it was imported from.
+    struct CachedAllocation {
+        uint64_t uniqueId;
+        uint32_t generation;
+        std::shared_ptr<C2GraphicAllocation> alloc;
+    };
+    // Map: bufferId -> CachedAllocation. Protected by mAllocatorMutex.
+    std::map<int32_t, CachedAllocation> mAllocations;
     std::atomic_uint64_t mFrameIndex;
 };
 
@@ -41,6 +41,7 @@
 #include <hardware/google/media/c2/1.0/IComponentStore.h>
 #include <hardware/google/media/c2/1.0/IConfigurable.h>
 
+#include <C2BqBufferPriv.h>
 #include <C2Debug.h>
 #include <C2BufferPriv.h>
 #include <C2PlatformSupport.h>
@@ -87,6 +88,148 @@ ClientList getClientList() {
     return list;
 }
 
+// Instance name reported by loopback clients.
+constexpr const char* kLoopbackInstanceName = "loopback";
+
+// Returns whether components should be created from the loopback client
+// before trying the IComponentStore services.
+bool isLoopbackPreferred() {
+    return ::android::base::GetBoolProperty(
+            "debug.stagefright.c2loopback", false);
+}
+
+// Loopback client wrapping the platform component store. This is created on
+// first use only.
+std::shared_ptr<Codec2Client> getLoopbackClient() {
+    static std::shared_ptr<Codec2Client> sLoopbackClient =
+            Codec2Client::CreateLoopback();
+    return sLoopbackClient;
+}
+
+// Implementation of ConfigurableC2Intf based on a local C2ComponentStore.
+struct LocalStoreIntf : public ConfigurableC2Intf {
+    LocalStoreIntf(const std::shared_ptr<C2ComponentStore>& store) :
+        ConfigurableC2Intf(store->getName()),
+        mStore(store) {
+    }
+
+    virtual c2_status_t config(
+            const std::vector<C2Param*>& params,
+            c2_blocking_t mayBlock,
+            std::vector<std::unique_ptr<C2SettingResult>>* const failures
+            ) override {
+        // Assume all params are blocking
+        if (mayBlock == C2_DONT_BLOCK && params.size() != 0) {
+            return C2_BLOCKING;
+        }
+        return mStore->config_sm(params, failures);
+    }
+
+    virtual c2_status_t query(
+            const std::vector<C2Param::Index>& indices,
+            c2_blocking_t mayBlock,
+            std::vector<std::unique_ptr<C2Param>>* const params
+            ) const override {
+        // Assume all params are blocking
+        if (mayBlock == C2_DONT_BLOCK && indices.size() != 0) {
+            return C2_BLOCKING;
+        }
+        return mStore->query_sm({}, indices, params);
+    }
+
+    virtual c2_status_t querySupportedParams(
+            std::vector<std::shared_ptr<C2ParamDescriptor>>* const params
+            ) const override {
+        return mStore->querySupportedParams_nb(params);
+    }
+
+    virtual c2_status_t querySupportedValues(
+            std::vector<C2FieldSupportedValuesQuery>& fields,
+            c2_blocking_t mayBlock) const override {
+        // Assume all params are blocking
+        if (mayBlock == C2_DONT_BLOCK && fields.size() != 0) {
+            return C2_BLOCKING;
+        }
+        return mStore->querySupportedValues_sm(fields);
+    }
+
+protected:
+    std::shared_ptr<C2ComponentStore> mStore;
+};
+
+// Implementation of ConfigurableC2Intf based on a local C2ComponentInterface.
+struct LocalCompIntf : public ConfigurableC2Intf {
+    LocalCompIntf(const std::shared_ptr<C2ComponentInterface>& intf) :
+        ConfigurableC2Intf(intf->getName()),
+        mIntf(intf) {
+    }
+
+    virtual c2_status_t config(
+            const std::vector<C2Param*>& params,
+            c2_blocking_t mayBlock,
+            std::vector<std::unique_ptr<C2SettingResult>>* const failures
+            ) override {
+        return mIntf->config_vb(params, mayBlock, failures);
+    }
+
+    virtual c2_status_t query(
+            const std::vector<C2Param::Index>& indices,
+            c2_blocking_t mayBlock,
+            std::vector<std::unique_ptr<C2Param>>* const params
+            ) const override {
+        return mIntf->query_vb({}, indices, mayBlock, params);
+    }
+
+    virtual c2_status_t querySupportedParams(
+            std::vector<std::shared_ptr<C2ParamDescriptor>>* const params
+            ) const override {
+        return mIntf->querySupportedParams_nb(params);
+    }
+
+    virtual c2_status_t querySupportedValues(
+            std::vector<C2FieldSupportedValuesQuery>& fields,
+            c2_blocking_t mayBlock) const override {
+        return mIntf->querySupportedValues_vb(fields, mayBlock);
+    }
+
+protected:
+    std::shared_ptr<C2ComponentInterface> mIntf;
+};
+
+// Implementation of ConfigurableC2Intf for a local C2BlockPool. Block pools do
+// not have any configurable parameters yet.
+struct LocalBlockPoolIntf : public ConfigurableC2Intf {
+    LocalBlockPoolIntf(const std::shared_ptr<C2BlockPool>& pool) :
+        ConfigurableC2Intf("C2BlockPool:" + std::to_string(pool->getLocalId())) {
+    }
+
+    virtual c2_status_t config(
+            const std::vector<C2Param*>&,
+            c2_blocking_t,
+            std::vector<std::unique_ptr<C2SettingResult>>* const) override {
+        return C2_OK;
+    }
+
+    virtual c2_status_t query(
+            const std::vector<C2Param::Index>&,
+            c2_blocking_t,
+            std::vector<std::unique_ptr<C2Param>>* const) const override {
+        return C2_OK;
+    }
+
+    virtual c2_status_t querySupportedParams(
+            std::vector<std::shared_ptr<C2ParamDescriptor>>* const
+            ) const override {
+        return C2_OK;
+    }
+
+    virtual c2_status_t querySupportedValues(
+            std::vector<C2FieldSupportedValuesQuery>&,
+            c2_blocking_t) const override {
+        return C2_OK;
+    }
+};
+
 } // unnamed
 
 // Codec2ConfigurableClient
@@ -110,11 +253,72 @@ Codec2ConfigurableClient::Codec2ConfigurableClient(
     }
 }
 
+Codec2ConfigurableClient::Codec2ConfigurableClient(
+        const std::shared_ptr<Codec2ConfigurableClient::LocalBase>& local)
+    : mName(local->getName()), mLocal(local) {
+}
+
 c2_status_t Codec2ConfigurableClient::query(
         const std::vector<C2Param*> &stackParams,
         const std::vector<C2Param::Index> &heapParamIndices,
         c2_blocking_t mayBlock,
         std::vector<std::unique_ptr<C2Param>>* const heapParams) const {
+    if (mLocal) {
+        std::vector<C2Param::Index> indices;
+        indices.reserve(stackParams.size() + heapParamIndices.size());
+        for (C2Param* const& stackParam : stackParams) {
+            if (!stackParam) {
+                ALOGW("query -- null stack param encountered.");
+                continue;
+            }
+            indices.emplace_back(stackParam->index());
+        }
+        indices.insert(indices.end(),
+                       heapParamIndices.begin(), heapParamIndices.end());
+        std::vector<std::unique_ptr<C2Param>> params;
+        c2_status_t status = mLocal->query(indices, mayBlock, &params);
+        if (status != C2_OK && status != C2_BAD_INDEX) {
+            ALOGE("query -- call failed. "
+                    "Error code = %d", static_cast<int>(status));
+            return status;
+        }
+        // Results are matched to stack params by index, as params that could
+        // not be queried are omitted from the result.
+        std::vector<bool> updated(stackParams.size(), false);
+        for (std::unique_ptr<C2Param>& param : params) {
+            if (!param) {
+                continue;
+            }
+            bool isStackParam = false;
+            for (size_t i = 0; i < stackParams.size(); ++i) {
+                if (stackParams[i] && !updated[i] &&
+                        stackParams[i]->index() == param->index()) {
+                    if (!stackParams[i]->updateFrom(*param)) {
+                        ALOGW("query -- param update failed. index = %d",
+                                static_cast<int>(param->index()));
+                    }
+                    updated[i] = true;
+                    isStackParam = true;
+                    break;
+                }
+            }
+            if (isStackParam) {
+                continue;
+            }
+            if (!heapParams) {
+                ALOGW("query -- unexpected extra stack param.");
+            } else {
+                heapParams->emplace_back(std::move(param));
+            }
+        }
+        for (size_t i = 0; i < stackParams.size(); ++i) {
+            if (stackParams[i] && !updated[i]) {
+                stackParams[i]->invalidate();
+            }
+        }
+        return status;
+    }
+
     hidl_vec<ParamIndex> indices(
             stackParams.size() + heapParamIndices.size());
     size_t numIndices = 0;
@@ -208,6 +412,10 @@ c2_status_t Codec2ConfigurableClient::config(
         const std::vector<C2Param*> &params,
         c2_blocking_t mayBlock,
         std::vector<std::unique_ptr<C2SettingResult>>* const failures) {
+    if (mLocal) {
+        return mLocal->config(params, mayBlock, failures);
+    }
+
     Params hidlParams;
     Status hidlStatus = createParamsBlob(&hidlParams, params);
     if (hidlStatus != Status::OK) {
@@ -248,6 +456,10 @@ c2_status_t Codec2ConfigurableClient::config(
 
 c2_status_t Codec2ConfigurableClient::querySupportedParams(
         std::vector<std::shared_ptr<C2ParamDescriptor>>* const params) const {
+    if (mLocal) {
+        return mLocal->querySupportedParams(params);
+    }
+
     // TODO: Cache and query properly!
     c2_status_t status;
     Return<void> transStatus = base()->querySupportedParams(
@@ -284,6 +496,10 @@ c2_status_t Codec2ConfigurableClient::querySupportedParams(
 c2_status_t Codec2ConfigurableClient::querySupportedValues(
         std::vector<C2FieldSupportedValuesQuery>& fields,
         c2_blocking_t mayBlock) const {
+    if (mLocal) {
+        return mLocal->querySupportedValues(fields, mayBlock);
+    }
+
     hidl_vec<FieldSupportedValuesQuery> inFields(fields.size());
     for (size_t i = 0; i < fields.size(); ++i) {
         Status hidlStatus = objcpy(&inFields[i], fields[i]);
@@ -433,6 +649,57 @@ struct Codec2Client::Component::HidlListener : public IComponentListener {
     }
 };
 
+// Codec2Client::Component::LocalListener
+struct Codec2Client::Component::LocalListener : public C2Component::Listener {
+    std::weak_ptr<Component> component;
+    std::weak_ptr<Listener> base;
+
+    virtual void onWorkDone_nb(
+            std::weak_ptr<C2Component> /* c2component */,
+            std::list<std::unique_ptr<C2Work>> workItems) override {
+        size_t numDiscardedInputBuffers = 0;
+        std::shared_ptr<Codec2Client::Component> strongComponent = component.lock();
+        if (strongComponent) {
+            numDiscardedInputBuffers = strongComponent->handleOnWorkDone(workItems);
+        }
+        if (std::shared_ptr<Codec2Client::Listener> listener = base.lock()) {
+            listener->onWorkDone(component, workItems, numDiscardedInputBuffers);
+        } else {
+            ALOGD("onWorkDone -- listener died.");
+        }
+    }
+
+    virtual void onTripped_nb(
+            std::weak_ptr<C2Component> /* c2component */,
+            std::vector<std::shared_ptr<C2SettingResult>> settingResults
+            ) override {
+        if (std::shared_ptr<Codec2Client::Listener> listener = base.lock()) {
+            listener->onTripped(component, settingResults);
+        } else {
+            ALOGD("onTripped -- listener died.");
+        }
+    }
+
+    virtual void onError_nb(
+            std::weak_ptr<C2Component> /* c2component */,
+            uint32_t errorCode) override {
+        ALOGD("onError -- errorCode = %u.", static_cast<unsigned>(errorCode));
+        if (std::shared_ptr<Codec2Client::Listener> listener = base.lock()) {
+            listener->onError(component, errorCode);
+        } else {
+            ALOGD("onError -- listener died.");
+        }
+    }
+
+    void onFrameRendered(uint64_t bufferQueueId, int32_t slotId,
+                         int64_t timestampNs) {
+        if (std::shared_ptr<Codec2Client::Listener> listener = base.lock()) {
+            listener->onFramesRendered(
+                    { Listener::RenderedFrame(bufferQueueId, slotId, timestampNs) });
+        }
+    }
+};
+
 // Codec2Client
 Codec2Client::Base* Codec2Client::base() const {
     return static_cast<Base*>(mBase.get());
@@ -448,6 +715,15 @@ Codec2Client::Codec2Client(const sp<Codec2Client::Base>& base, std::string insta
     }
 }
 
+Codec2Client::Codec2Client(
+        const std::shared_ptr<C2ComponentStore>& localStore,
+        std::string instanceName) :
+    Codec2ConfigurableClient(std::make_shared<LocalStoreIntf>(localStore)),
+    mListed(false),
+    mInstanceName(instanceName),
+    mLocalStore(localStore) {
+}
+
 c2_status_t Codec2Client::createComponent(
         const C2String& name,
         const std::shared_ptr<Codec2Client::Listener>& listener,
@@ -455,6 +731,24 @@ c2_status_t Codec2Client::createComponent(
 
     // TODO: Add support for Bufferpool
 
+    if (mLocalStore) {
+        std::shared_ptr<C2Component> c2component;
+        c2_status_t status = mLocalStore->createComponent(name, &c2component);
+        if (status != C2_OK) {
+            return status;
+        }
+        if (!c2component) {
+            ALOGE("createComponent -- null component.");
+            return C2_CORRUPTED;
+        }
+        *component = std::make_shared<Codec2Client::Component>(c2component);
+        status = Component::setLocalListener(*component, listener);
+        if (status != C2_OK) {
+            ALOGE("createComponent -- setLocalListener returned error: %d.",
+                    static_cast<int>(status));
+        }
+        return status;
+    }
 
     c2_status_t status;
     sp<Component::HidlListener> hidlListener = new Component::HidlListener();
@@ -500,6 +794,19 @@ c2_status_t Codec2Client::createComponent(
 c2_status_t Codec2Client::createInterface(
         const C2String& name,
         std::shared_ptr<Codec2Client::Interface>* const interface) {
+    if (mLocalStore) {
+        std::shared_ptr<C2ComponentInterface> c2interface;
+        c2_status_t status = mLocalStore->createInterface(name, &c2interface);
+        if (status != C2_OK) {
+            ALOGE("createInterface -- call failed. "
+                    "Error code = %d", static_cast<int>(status));
+            return status;
+        }
+        *interface = std::make_shared<Codec2Client::Interface>(
+                std::make_shared<LocalCompIntf>(c2interface));
+        return C2_OK;
+    }
+
     c2_status_t status;
     Return<void> transStatus = base()->createInterface(
             name,
@@ -523,6 +830,12 @@ c2_status_t Codec2Client::createInterface(
 
 c2_status_t Codec2Client::createInputSurface(
         std::shared_ptr<Codec2Client::InputSurface>* const inputSurface) {
+    if (mLocalStore) {
+        // Input surfaces are only provided by IComponentStore services.
+        *inputSurface = nullptr;
+        return C2_OMITTED;
+    }
+
     Return<sp<IInputSurface>> transResult = base()->createInputSurface();
     if (!transResult.isOk()) {
         ALOGE("createInputSurface -- failed transaction.");
@@ -546,6 +859,19 @@ const std::vector<C2Component::Traits>& Codec2Client::listComponents() const {
     if (mListed) {
         return mTraitsList;
     }
+    if (mLocalStore) {
+        mLocalTraits = mLocalStore->listComponents();
+        mTraitsList.clear();
+        mTraitsList.reserve(mLocalTraits.size());
+        for (const std::shared_ptr<const C2Component::Traits>& t : mLocalTraits) {
+            if (t) {
+                mTraitsList.emplace_back(*t);
+                mTraitsList.back().owner = mInstanceName;
+            }
+        }
+        mListed = true;
+        return mTraitsList;
+    }
     Return<void> transStatus = base()->listComponents(
             [this](const hidl_vec<IComponentStore::ComponentTraits>& t) {
                 mTraitsList.resize(t.size());
@@ -579,6 +905,10 @@ c2_status_t Codec2Client::copyBuffer(
 
 std::shared_ptr<C2ParamReflector>
         Codec2Client::getParamReflector() {
+    if (mLocalStore) {
+        return mLocalStore->getParamReflector();
+    }
+
     // TODO: this is not meant to be exposed as C2ParamReflector on the client side; instead, it
     // should reflect the HAL API.
     struct SimpleParamReflector : public C2ParamReflector {
@@ -643,11 +973,34 @@ std::shared_ptr<Codec2Client> Codec2Client::CreateFromService(
     return std::make_shared<Codec2Client>(baseStore, instanceName);
 }
 
+std::shared_ptr<Codec2Client> Codec2Client::CreateLoopback(
+        const std::shared_ptr<C2ComponentStore>& store) {
+    std::shared_ptr<C2ComponentStore> localStore =
+            store ? store : GetCodec2PlatformComponentStore();
+    if (!localStore) {
+        ALOGE("CreateLoopback -- no component store.");
+        return nullptr;
+    }
+    return std::make_shared<Codec2Client>(localStore, kLoopbackInstanceName);
+}
+
 c2_status_t Codec2Client::ForAllStores(
         const std::string &key,
         std::function<c2_status_t(const std::shared_ptr<Codec2Client>&)> predicate) {
     c2_status_t status = C2_NO_INIT;  // no IComponentStores present
 
+    // If requested, try the in-process store first. Components it does not
+    // have, e.g. vendor components, are still created from the services.
+    if (isLoopbackPreferred()) {
+        std::shared_ptr<Codec2Client> client = getLoopbackClient();
+        if (client) {
+            status = predicate(client);
+            if (status == C2_OK) {
+                return status;
+            }
+        }
+    }
+
     // Cache the mapping key -> index of Codec2Client in getClient().
     static std::mutex key2IndexMutex;
     static std::map<std::string, size_t> key2Index;
@@ -801,6 +1154,13 @@ Codec2Client::Component::Component(const sp<Codec2Client::Component::Base>& base
     mBufferPoolSender(nullptr) {
 }
 
+Codec2Client::Component::Component(
+        const std::shared_ptr<C2Component>& local) :
+    Codec2Client::Configurable(std::make_shared<LocalCompIntf>(local->intf())),
+    mBufferPoolSender(nullptr),
+    mLocalComponent(local) {
+}
+
 Codec2Client::Component::~Component() {
 }
 
@@ -808,6 +1168,31 @@ c2_status_t Codec2Client::Component::createBlockPool(
         C2Allocator::id_t id,
         C2BlockPool::local_id_t* blockPoolId,
         std::shared_ptr<Codec2Client::Configurable>* configurable) {
+    if (mLocalComponent) {
+        std::shared_ptr<C2BlockPool> blockPool;
+        configurable->reset();
+        c2_status_t status = CreateCodec2BlockPool(
+                static_cast<C2PlatformAllocatorStore::id_t>(id),
+                mLocalComponent,
+                &blockPool);
+        if (status != C2_OK) {
+            ALOGE("createBlockPool -- call failed. "
+                    "Error code = %d", static_cast<int>(status));
+            return status;
+        }
+        if (!blockPool) {
+            return C2_CORRUPTED;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mLocalBlockPoolsMutex);
+            mLocalBlockPools.emplace(blockPool->getLocalId(), blockPool);
+        }
+        *blockPoolId = blockPool->getLocalId();
+        *configurable = std::make_shared<Codec2Client::Configurable>(
+                std::make_shared<LocalBlockPoolIntf>(blockPool));
+        return C2_OK;
+    }
+
     c2_status_t status;
     Return<void> transStatus = base()->createBlockPool(
             static_cast<uint32_t>(id),
@@ -834,6 +1219,11 @@ c2_status_t Codec2Client::Component::createBlockPool(
 
 c2_status_t Codec2Client::Component::destroyBlockPool(
         C2BlockPool::local_id_t localId) {
+    if (mLocalComponent) {
+        std::lock_guard<std::mutex> lock(mLocalBlockPoolsMutex);
+        return mLocalBlockPools.erase(localId) == 1 ? C2_OK : C2_CORRUPTED;
+    }
+
     Return<Status> transResult = base()->destroyBlockPool(
             static_cast<uint64_t>(localId));
     if (!transResult.isOk()) {
@@ -952,6 +1342,15 @@ c2_status_t Codec2Client::Component::queue(
         }
     }
 
+    if (mLocalComponent) {
+        c2_status_t status = mLocalComponent->queue_nb(items);
+        if (status != C2_OK) {
+            ALOGE("queue -- call failed. "
+                    "Error code = %d", static_cast<int>(status));
+        }
+        return status;
+    }
+
     WorkBundle workBundle;
     Status hidlStatus = objcpy(&workBundle, *items, &mBufferPoolSender);
     if (hidlStatus != Status::OK) {
@@ -975,22 +1374,30 @@ c2_status_t Codec2Client::Component::queue(
 c2_status_t Codec2Client::Component::flush(
         C2Component::flush_mode_t mode,
         std::list<std::unique_ptr<C2Work>>* const flushedWork) {
-    (void)mode; // Flush mode isn't supported in HIDL yet.
     c2_status_t status;
-    Return<void> transStatus = base()->flush(
-            [&status, flushedWork](
-                    Status s, const WorkBundle& wb) {
-                status = static_cast<c2_status_t>(s);
-                if (status != C2_OK) {
-                    ALOGE("flush -- call failed. "
-                            "Error code = %d", static_cast<int>(status));
-                    return;
-                }
-                status = objcpy(flushedWork, wb);
-            });
-    if (!transStatus.isOk()) {
-        ALOGE("flush -- transaction failed.");
-        return C2_TRANSACTION_FAILED;
+    if (mLocalComponent) {
+        status = mLocalComponent->flush_sm(mode, flushedWork);
+        if (status != C2_OK) {
+            ALOGE("flush -- call failed. "
+                    "Error code = %d", static_cast<int>(status));
+        }
+    } else {
+        (void)mode; // Flush mode isn't supported in HIDL yet.
+        Return<void> transStatus = base()->flush(
+                [&status, flushedWork](
+                        Status s, const WorkBundle& wb) {
+                    status = static_cast<c2_status_t>(s);
+                    if (status != C2_OK) {
+                        ALOGE("flush -- call failed. "
+                                "Error code = %d", static_cast<int>(status));
+                        return;
+                    }
+                    status = objcpy(flushedWork, wb);
+                });
+        if (!transStatus.isOk()) {
+            ALOGE("flush -- transaction failed.");
+            return C2_TRANSACTION_FAILED;
+        }
     }
 
     // Indices of flushed work items.
@@ -1040,6 +1447,14 @@ c2_status_t Codec2Client::Component::flush(
 }
 
 c2_status_t Codec2Client::Component::drain(C2Component::drain_mode_t mode) {
+    if (mLocalComponent) {
+        c2_status_t status = mLocalComponent->drain_nb(mode);
+        if (status != C2_OK) {
+            ALOGE("drain -- call failed. "
+                    "Error code = %d", static_cast<int>(status));
+        }
+        return status;
+    }
     Return<Status> transStatus = base()->drain(
             mode == C2Component::DRAIN_COMPONENT_WITH_EOS);
     if (!transStatus.isOk()) {
@@ -1056,13 +1471,17 @@ c2_status_t Codec2Client::Component::drain(C2Component::drain_mode_t mode) {
 }
 
 c2_status_t Codec2Client::Component::start() {
-    Return<Status> transStatus = base()->start();
-    if (!transStatus.isOk()) {
-        ALOGE("start -- transaction failed.");
-        return C2_TRANSACTION_FAILED;
+    c2_status_t status;
+    if (mLocalComponent) {
+        status = mLocalComponent->start();
+    } else {
+        Return<Status> transStatus = base()->start();
+        if (!transStatus.isOk()) {
+            ALOGE("start -- transaction failed.");
+            return C2_TRANSACTION_FAILED;
+        }
+        status = static_cast<c2_status_t>(static_cast<Status>(transStatus));
     }
-    c2_status_t status =
-            static_cast<c2_status_t>(static_cast<Status>(transStatus));
     if (status != C2_OK) {
         ALOGE("start -- call failed. "
                 "Error code = %d", static_cast<int>(status));
@@ -1071,13 +1490,17 @@ c2_status_t Codec2Client::Component::start() {
 }
 
 c2_status_t Codec2Client::Component::stop() {
-    Return<Status> transStatus = base()->stop();
-    if (!transStatus.isOk()) {
-        ALOGE("stop -- transaction failed.");
-        return C2_TRANSACTION_FAILED;
+    c2_status_t status;
+    if (mLocalComponent) {
+        status = mLocalComponent->stop();
+    } else {
+        Return<Status> transStatus = base()->stop();
+        if (!transStatus.isOk()) {
+            ALOGE("stop -- transaction failed.");
+            return C2_TRANSACTION_FAILED;
+        }
+        status = static_cast<c2_status_t>(static_cast<Status>(transStatus));
     }
-    c2_status_t status =
-            static_cast<c2_status_t>(static_cast<Status>(transStatus));
     if (status != C2_OK) {
         ALOGE("stop -- call failed. "
                 "Error code = %d", static_cast<int>(status));
@@ -1090,13 +1513,19 @@ c2_status_t Codec2Client::Component::stop() {
 }
 
 c2_status_t Codec2Client::Component::reset() {
-    Return<Status> transStatus = base()->reset();
-    if (!transStatus.isOk()) {
-        ALOGE("reset -- transaction failed.");
-        return C2_TRANSACTION_FAILED;
+    c2_status_t status;
+    if (mLocalComponent) {
+        status = mLocalComponent->reset();
+        std::lock_guard<std::mutex> lock(mLocalBlockPoolsMutex);
+        mLocalBlockPools.clear();
+    } else {
+        Return<Status> transStatus = base()->reset();
+        if (!transStatus.isOk()) {
+            ALOGE("reset -- transaction failed.");
+            return C2_TRANSACTION_FAILED;
+        }
+        status = static_cast<c2_status_t>(static_cast<Status>(transStatus));
     }
-    c2_status_t status =
-            static_cast<c2_status_t>(static_cast<Status>(transStatus));
     if (status != C2_OK) {
         ALOGE("reset -- call failed. "
                 "Error code = %d", static_cast<int>(status));
@@ -1109,13 +1538,19 @@ c2_status_t Codec2Client::Component::reset() {
 }
 
 c2_status_t Codec2Client::Component::release() {
-    Return<Status> transStatus = base()->release();
-    if (!transStatus.isOk()) {
-        ALOGE("release -- transaction failed.");
-        return C2_TRANSACTION_FAILED;
+    c2_status_t status;
+    if (mLocalComponent) {
+        status = mLocalComponent->release();
+        std::lock_guard<std::mutex> lock(mLocalBlockPoolsMutex);
+        mLocalBlockPools.clear();
+    } else {
+        Return<Status> transStatus = base()->release();
+        if (!transStatus.isOk()) {
+            ALOGE("release -- transaction failed.");
+            return C2_TRANSACTION_FAILED;
+        }
+        status = static_cast<c2_status_t>(static_cast<Status>(transStatus));
     }
-    c2_status_t status =
-            static_cast<c2_status_t>(static_cast<Status>(transStatus));
     if (status != C2_OK) {
         ALOGE("release -- call failed. "
                 "Error code = %d", static_cast<int>(status));
@@ -1137,14 +1572,34 @@ c2_status_t Codec2Client::Component::setOutputSurface(
         igbp = new TWGraphicBufferProducer<HGraphicBufferProducer>(surface);
     }
 
-    Return<Status> transStatus = base()->setOutputSurface(
-            static_cast<uint64_t>(blockPoolId), igbp);
-    if (!transStatus.isOk()) {
-        ALOGE("setOutputSurface -- transaction failed.");
-        return C2_TRANSACTION_FAILED;
+    c2_status_t status;
+    if (mLocalComponent) {
+        std::shared_ptr<C2BlockPool> pool;
+        GetCodec2BlockPool(blockPoolId, mLocalComponent, &pool);
+        if (pool && pool->getAllocatorId() ==
+                C2PlatformAllocatorStore::BUFFERQUEUE) {
+            std::shared_ptr<C2BufferQueueBlockPool> bqPool =
+                    std::static_pointer_cast<C2BufferQueueBlockPool>(pool);
+            std::weak_ptr<LocalListener> weakListener = mLocalListener;
+            bqPool->setRenderCallback(
+                    [weakListener](uint64_t producer, int32_t slot, int64_t nsecs) {
+                        if (std::shared_ptr<LocalListener> listener =
+                                weakListener.lock()) {
+                            listener->onFrameRendered(producer, slot, nsecs);
+                        }
+                    });
+            bqPool->configureProducer(igbp);
+        }
+        status = C2_OK;
+    } else {
+        Return<Status> transStatus = base()->setOutputSurface(
+                static_cast<uint64_t>(blockPoolId), igbp);
+        if (!transStatus.isOk()) {
+            ALOGE("setOutputSurface -- transaction failed.");
+            return C2_TRANSACTION_FAILED;
+        }
+        status = static_cast<c2_status_t>(static_cast<Status>(transStatus));
     }
-    c2_status_t status =
-            static_cast<c2_status_t>(static_cast<Status>(transStatus));
     if (status != C2_OK) {
         ALOGE("setOutputSurface -- call failed. "
                 "Error code = %d", static_cast<int>(status));
@@ -1241,6 +1696,11 @@ status_t Codec2Client::Component::queueToOutputSurface(
 c2_status_t Codec2Client::Component::connectToOmxInputSurface(
         const sp<HGraphicBufferProducer>& producer,
         const sp<HGraphicBufferSource>& source) {
+    if (mLocalComponent) {
+        // Not supported by the component store either.
+        return C2_OMITTED;
+    }
+
     Return<Status> transStatus = base()->connectToOmxInputSurface(
             producer, source);
     if (!transStatus.isOk()) {
@@ -1257,6 +1717,10 @@ c2_status_t Codec2Client::Component::connectToOmxInputSurface(
 }
 
 c2_status_t Codec2Client::Component::disconnectFromInputSurface() {
+    if (mLocalComponent) {
+        return C2_OK;
+    }
+
     Return<Status> transStatus = base()->disconnectFromInputSurface();
     if (!transStatus.isOk()) {
         ALOGE("disconnectToInputSurface -- transaction failed.");
@@ -1309,6 +1773,18 @@ c2_status_t Codec2Client::Component::setDeathListener(
     return C2_OK;
 }
 
+c2_status_t Codec2Client::Component::setLocalListener(
+        const std::shared_ptr<Component>& component,
+        const std::shared_ptr<Listener>& listener) {
+    std::shared_ptr<LocalListener> localListener =
+            std::make_shared<LocalListener>();
+    localListener->base = listener;
+    localListener->component = component;
+    component->mLocalListener = localListener;
+    return component->mLocalComponent->setListener_vb(
+            localListener, C2_MAY_BLOCK);
+}
+
 // Codec2Client::InputSurface
 
 Codec2Client::InputSurface::Base* Codec2Client::InputSurface::base() const {
@@ -1325,6 +1801,10 @@ Codec2Client::InputSurface::InputSurface(const sp<IInputSurface>& base) :
 c2_status_t Codec2Client::InputSurface::connectToComponent(
         const std::shared_ptr<Codec2Client::Component>& component,
         std::shared_ptr<Connection>* connection) {
+    if (component->isLocal()) {
+        ALOGE("connectToComponent -- loopback components are not supported.");
+        return C2_OMITTED;
+    }
     c2_status_t status;
     Return<void> transStatus = base()->connectToComponent(
         component->base(),
@@ -18,6 +18,7 @@
 #define CODEC2_HIDL_CLIENT_H_
 
 #include <gui/IGraphicBufferProducer.h>
+#include <codec2/hidl/1.0/ConfigurableC2Intf.h>
 #include <codec2/hidl/1.0/types.h>
 
 #include <C2PlatformSupport.h>
@@ -61,6 +62,16 @@
  * At the present, createBlockPool() is the only method that yields a
  * Configurable object. Note, however, that Interface, Component and
  * Codec2Client are all subclasses of Configurable.
+ *
+ * Codec2Client::CreateLoopback() creates a Codec2Client object that wraps a
+ * C2ComponentStore living in the same process instead of a remote
+ * IComponentStore. Objects obtained from a loopback client call into the
+ * underlying C2ComponentStore, C2ComponentInterface and C2Component directly,
+ * so C2Work objects are passed through without HIDL marshalling. This is
+ * intended for tests, benchmarks and single-process embedders. Setting the
+ * property debug.stagefright.c2loopback makes CreateComponentByName() and
+ * CreateInterfaceByName() try a loopback client wrapping the platform
+ * component store before the IComponentStore services.
  */
 
 // Forward declaration of Codec2.0 HIDL interfaces
@@ -121,6 +132,10 @@ struct Codec2ConfigurableClient {
 
     typedef ::hardware::google::media::c2::V1_0::IConfigurable Base;
 
+    // In-process counterpart of Base used by loopback clients.
+    typedef ::hardware::google::media::c2::V1_0::utils::ConfigurableC2Intf
+            LocalBase;
+
     const C2String& getName() const;
 
     c2_status_t query(
@@ -145,9 +160,16 @@ struct Codec2ConfigurableClient {
     // base cannot be null.
     Codec2ConfigurableClient(const sp<Base>& base);
 
+    // local cannot be null.
+    Codec2ConfigurableClient(const std::shared_ptr<LocalBase>& local);
+
+    // Return true if this object wraps an in-process configurable.
+    bool isLocal() const { return mLocal != nullptr; }
+
 protected:
     C2String mName;
     sp<Base> mBase;
+    std::shared_ptr<LocalBase> mLocal;
 
     Base* base() const;
 
@@ -198,6 +220,11 @@ struct Codec2Client : public Codec2ConfigurableClient {
             const char* instanceName,
             bool waitForService = true);
 
+    // Create a loopback client that talks to store directly without going
+    // through HIDL. If store is null, the platform component store is used.
+    static std::shared_ptr<Codec2Client> CreateLoopback(
+            const std::shared_ptr<C2ComponentStore>& store = nullptr);
+
     // Try to create a component with a given name from all known
     // IComponentStore services.
     static std::shared_ptr<Component> CreateComponentByName(
@@ -220,12 +247,17 @@ struct Codec2Client : public Codec2ConfigurableClient {
     // base cannot be null.
     Codec2Client(const sp<Base>& base, std::string instanceName);
 
+    // localStore cannot be null.
+    Codec2Client(const std::shared_ptr<C2ComponentStore>& localStore,
+                 std::string instanceName);
+
 protected:
     Base* base() const;
 
     // Finds the first store where the predicate returns OK, and returns the last
     // predicate result. Uses key to remember the last store found, and if cached,
-    // it tries that store before trying all stores (one retry).
+    // it tries that store before trying all stores (one retry). If
+    // debug.stagefright.c2loopback is set, the loopback store is tried first.
     static c2_status_t ForAllStores(
             const std::string& key,
             std::function<c2_status_t(const std::shared_ptr<Codec2Client>&)> predicate);
@@ -239,6 +271,12 @@ protected:
 
     sp<::android::hardware::media::bufferpool::V1_0::IClientManager>
             mHostPoolManager;
+
+    // Non-null for loopback clients only.
+    std::shared_ptr<C2ComponentStore> mLocalStore;
+    // Keeps the aliases of local traits alive.
+    mutable std::vector<std::shared_ptr<const C2Component::Traits>>
+            mLocalTraits;
 };
 
 struct Codec2Client::Listener {
@@ -382,6 +420,9 @@ struct Codec2Client::Component : public Codec2Client::Configurable {
     // base cannot be null.
     Component(const sp<Base>& base);
 
+    // local cannot be null.
+    Component(const std::shared_ptr<C2Component>& local);
+
     ~Component();
 
 protected:
@@ -418,6 +459,20 @@ protected:
             const std::shared_ptr<Listener>& listener);
     sp<::android::hardware::hidl_death_recipient> mDeathRecipient;
 
+    // Loopback mode: the wrapped C2Component and the block pools created by
+    // createBlockPool(), which are kept alive until destroyBlockPool(),
+    // reset() or release() is called.
+    std::shared_ptr<C2Component> mLocalComponent;
+    std::mutex mLocalBlockPoolsMutex;
+    std::map<C2BlockPool::local_id_t, std::shared_ptr<C2BlockPool>>
+            mLocalBlockPools;
+
+    struct LocalListener;
+    std::shared_ptr<LocalListener> mLocalListener;
+    static c2_status_t setLocalListener(
+            const std::shared_ptr<Component>& component,
+            const std::shared_ptr<Listener>& listener);
+
     friend struct Codec2Client;
 
     struct HidlListener;
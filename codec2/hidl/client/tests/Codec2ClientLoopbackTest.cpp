@@ -0,0 +1,517 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "Codec2ClientLoopbackTest"
+
+#include <android-base/properties.h>
+#include <gtest/gtest.h>
+#include <string.h>
+#include <system/graphics.h>
+
+#include <C2Buffer.h>
+#include <C2PlatformSupport.h>
+#include <codec2/hidl/client.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace android {
+
+namespace {
+
+constexpr char kComponentName[] = "c2.android.g711.mlaw.decoder";
+constexpr char kLoopbackProperty[] = "debug.stagefright.c2loopback";
+constexpr size_t kNumFrames = 4;
+constexpr size_t kFrameSize = 160;
+constexpr std::chrono::seconds kTimeout(5);
+
+// mu-law code words with known linear values
+constexpr struct {
+    uint8_t code;
+    int16_t value;
+} kCodes[] = {
+    { 0x00, -32124 },
+    { 0x80, 32124 },
+    { 0x7f, 0 },
+    { 0xff, 0 },
+};
+
+class TestListener : public Codec2Client::Listener {
+public:
+    void onWorkDone(
+            const std::weak_ptr<Codec2Client::Component>& /* comp */,
+            std::list<std::unique_ptr<C2Work>>& workItems,
+            size_t /* numDiscardedInputBuffers */) override {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (std::unique_ptr<C2Work>& work : workItems) {
+            uint64_t index = work->input.ordinal.frameIndex.peeku();
+            mDoneWork.emplace(index, std::move(work));
+        }
+        workItems.clear();
+        mCondition.notify_all();
+    }
+
+    void onTripped(
+            const std::weak_ptr<Codec2Client::Component>& /* comp */,
+            const std::vector<std::shared_ptr<C2SettingResult>>& /* settingResults */) override {
+    }
+
+    void onError(
+            const std::weak_ptr<Codec2Client::Component>& /* comp */,
+            uint32_t errorCode) override {
+        ADD_FAILURE() << "onError " << errorCode;
+    }
+
+    void onDeath(const std::weak_ptr<Codec2Client::Component>& /* comp */) override {
+        ADD_FAILURE() << "onDeath";
+    }
+
+    void onInputBufferDone(const std::shared_ptr<C2Buffer>& /* buffer */) override {
+    }
+
+    void onFramesRendered(const std::vector<RenderedFrame>& /* renderedFrames */) override {
+    }
+
+    bool waitForWork(size_t numWork) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        return mCondition.wait_for(lock, kTimeout, [this, numWork] {
+            return mDoneWork.size() >= numWork;
+        });
+    }
+
+    // Waits for the work of frame |index| and removes it from mDoneWork.
+    std::unique_ptr<C2Work> takeWork(uint64_t index) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (!mCondition.wait_for(lock, kTimeout, [this, index] {
+                return mDoneWork.count(index) != 0;
+            })) {
+            return nullptr;
+        }
+        std::unique_ptr<C2Work> work = std::move(mDoneWork[index]);
+        mDoneWork.erase(index);
+        return work;
+    }
+
+    std::map<uint64_t, std::unique_ptr<C2Work>> mDoneWork;
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+};
+
+constexpr char kAvcDecoderName[] = "c2.android.avc.decoder";
+constexpr uint32_t kWidth = 64;
+constexpr uint32_t kHeight = 64;
+constexpr uint32_t kMbSize = 16;
+constexpr uint32_t kWidthInMbs = kWidth / kMbSize;
+constexpr uint32_t kNumMbs = kWidthInMbs * (kHeight / kMbSize);
+// display buffers the decoder shares with the client at a time, see kNumClientDisplayBuffers
+constexpr size_t kMaxSharedOutputs = 4;
+// frames decoded while holding all outputs
+constexpr size_t kNumHeldFrames = 2 * kMaxSharedOutputs;
+// frames decoded while releasing each output right away, more than the decoder has display
+// buffers (IVD_VIDDEC_MAX_IO_BUFFERS at most)
+constexpr size_t kNumReleasedFrames = 80;
+// the decoder pads display buffers, so they are wider than the frame
+constexpr uint32_t kDisplayBufferStride = 128;
+
+// Sample values of a macroblock of a test frame. Every macroblock is uniform, and macroblocks of
+// different frames differ.
+uint8_t lumaSample(size_t frame, uint32_t mb) {
+    return 16 + (frame * 37 + mb * 11) % 200;
+}
+
+uint8_t cbSample(size_t frame, uint32_t mb) {
+    return 32 + (frame * 13 + mb * 7) % 190;
+}
+
+uint8_t crSample(size_t frame, uint32_t mb) {
+    return 48 + (frame * 29 + mb * 5) % 170;
+}
+
+// Writes H.264 NAL units into an Annex B byte stream.
+class NalWriter {
+public:
+    void writeBits(uint32_t value, uint32_t numBits) {
+        while (numBits--) {
+            mBits.push_back((value >> numBits) & 1);
+        }
+    }
+
+    void writeUE(uint32_t value) {
+        uint32_t numBits = 0;
+        while ((uint64_t(value) + 1) >> (numBits + 1)) {
+            ++numBits;
+        }
+        writeBits(0, numBits);
+        writeBits(value + 1, numBits + 1);
+    }
+
+    void writeSE(int32_t value) {
+        writeUE(value > 0 ? 2 * value - 1 : -2 * value);
+    }
+
+    void align() {
+        while (mBits.size() % 8) {
+            mBits.push_back(0);
+        }
+    }
+
+    // Appends the NAL unit with header |header| written so far to |stream|, with trailing bits
+    // and emulation prevention bytes.
+    void finishNal(uint8_t header, std::vector<uint8_t>* stream) {
+        mBits.push_back(1);
+        align();
+        stream->insert(stream->end(), { 0, 0, 0, 1, header });
+        size_t numZeros = 0;
+        for (size_t i = 0; i < mBits.size(); i += 8) {
+            uint8_t byte = 0;
+            for (size_t j = 0; j < 8; ++j) {
+                byte = (byte << 1) | mBits[i + j];
+            }
+            if (numZeros >= 2 && byte <= 3) {
+                stream->push_back(3);
+                numZeros = 0;
+            }
+            stream->push_back(byte);
+            numZeros = byte == 0 ? numZeros + 1 : 0;
+        }
+        mBits.clear();
+    }
+
+private:
+    std::vector<uint8_t> mBits;
+};
+
+// Returns an access unit of frame |frame|, an IDR picture of I_PCM macroblocks. The first one
+// carries the parameter sets.
+std::vector<uint8_t> makeAccessUnit(size_t frame) {
+    std::vector<uint8_t> stream;
+    NalWriter w;
+    if (frame == 0) {
+        w.writeBits(66, 8);  // profile_idc: baseline
+        w.writeBits(0xc0, 8);  // constraint_set0_flag and constraint_set1_flag
+        w.writeBits(30, 8);  // level_idc
+        w.writeUE(0);  // seq_parameter_set_id
+        w.writeUE(0);  // log2_max_frame_num_minus4
+        w.writeUE(2);  // pic_order_cnt_type
+        w.writeUE(1);  // max_num_ref_frames
+        w.writeBits(0, 1);  // gaps_in_frame_num_value_allowed_flag
+        w.writeUE(kWidthInMbs - 1);  // pic_width_in_mbs_minus1
+        w.writeUE(kHeight / kMbSize - 1);  // pic_height_in_map_units_minus1
+        w.writeBits(1, 1);  // frame_mbs_only_flag
+        w.writeBits(1, 1);  // direct_8x8_inference_flag
+        w.writeBits(0, 1);  // frame_cropping_flag
+        w.writeBits(0, 1);  // vui_parameters_present_flag
+        w.finishNal(0x67, &stream);
+
+        w.writeUE(0);  // pic_parameter_set_id
+        w.writeUE(0);  // seq_parameter_set_id
+        w.writeBits(0, 1);  // entropy_coding_mode_flag
+        w.writeBits(0, 1);  // bottom_field_pic_order_in_frame_present_flag
+        w.writeUE(0);  // num_slice_groups_minus1
+        w.writeUE(0);  // num_ref_idx_l0_default_active_minus1
+        w.writeUE(0);  // num_ref_idx_l1_default_active_minus1
+        w.writeBits(0, 3);  // weighted_pred_flag and weighted_bipred_idc
+        w.writeSE(0);  // pic_init_qp_minus26
+        w.writeSE(0);  // pic_init_qs_minus26
+        w.writeSE(0);  // chroma_qp_index_offset
+        w.writeBits(1, 1);  // deblocking_filter_control_present_flag
+        w.writeBits(0, 1);  // constrained_intra_pred_flag
+        w.writeBits(0, 1);  // redundant_pic_cnt_present_flag
+        w.finishNal(0x68, &stream);
+    }
+
+    w.writeUE(0);  // first_mb_in_slice
+    w.writeUE(7);  // slice_type: I
+    w.writeUE(0);  // pic_parameter_set_id
+    w.writeBits(0, 4);  // frame_num
+    w.writeUE(frame % 2);  // idr_pic_id
+    w.writeBits(0, 2);  // no_output_of_prior_pics_flag and long_term_reference_flag
+    w.writeSE(0);  // slice_qp_delta
+    w.writeUE(1);  // disable_deblocking_filter_idc
+    for (uint32_t mb = 0; mb < kNumMbs; ++mb) {
+        w.writeUE(25);  // mb_type: I_PCM
+        w.align();
+        for (uint32_t i = 0; i < kMbSize * kMbSize; ++i) {
+            w.writeBits(lumaSample(frame, mb), 8);
+        }
+        for (uint32_t i = 0; i < kMbSize * kMbSize / 4; ++i) {
+            w.writeBits(cbSample(frame, mb), 8);
+        }
+        for (uint32_t i = 0; i < kMbSize * kMbSize / 4; ++i) {
+            w.writeBits(crSample(frame, mb), 8);
+        }
+    }
+    w.finishNal(0x65, &stream);
+    return stream;
+}
+
+// Returns whether |view| has interleaved chroma, which is how display buffers of the decoder are
+// laid out, while frames copied out of them are planar.
+bool isSemiPlanar(const C2GraphicView& view) {
+    const C2PlanarLayout& layout = view.layout();
+    return layout.type == C2PlanarLayout::TYPE_YUV
+            && layout.numPlanes == 3
+            && layout.planes[C2PlanarLayout::PLANE_U].colInc == 2
+            && layout.planes[C2PlanarLayout::PLANE_V].colInc == 2
+            && view.data()[C2PlanarLayout::PLANE_V] == view.data()[C2PlanarLayout::PLANE_U] + 1;
+}
+
+// Checks that |view| holds the pixels of frame |frame|.
+void checkFrame(const C2GraphicView& view, size_t frame) {
+    ASSERT_EQ(C2_OK, view.error());
+    ASSERT_EQ(kWidth, view.width());
+    ASSERT_EQ(kHeight, view.height());
+    const C2PlanarLayout& layout = view.layout();
+    ASSERT_EQ(C2PlanarLayout::TYPE_YUV, layout.type);
+    for (uint32_t i = 0; i < layout.numPlanes; ++i) {
+        const C2PlaneInfo& plane = layout.planes[i];
+        uint32_t mbSize = kMbSize / plane.colSampling;
+        for (uint32_t y = 0; y < kHeight / plane.rowSampling; ++y) {
+            const uint8_t* row = view.data()[i] + y * plane.rowInc;
+            for (uint32_t x = 0; x < kWidth / plane.colSampling; ++x) {
+                uint32_t mb = (y / mbSize) * kWidthInMbs + x / mbSize;
+                uint8_t expected = i == C2PlanarLayout::PLANE_Y ? lumaSample(frame, mb)
+                        : i == C2PlanarLayout::PLANE_U ? cbSample(frame, mb)
+                        : crSample(frame, mb);
+                ASSERT_EQ(expected, row[x * plane.colInc])
+                        << "frame " << frame << " plane " << i << " at " << x << "," << y;
+            }
+        }
+    }
+}
+
+} // namespace
+
+class Codec2ClientLoopbackTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mListener = std::make_shared<TestListener>();
+        ASSERT_EQ(C2_OK, GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &mInputPool));
+    }
+
+    // Decodes kNumFrames frames of mu-law code words through |component| and checks the output.
+    void decode(const std::shared_ptr<Codec2Client::Component>& component) {
+        ASSERT_EQ(C2_OK, component->start());
+
+        std::list<std::unique_ptr<C2Work>> items;
+        for (size_t i = 0; i < kNumFrames; ++i) {
+            std::shared_ptr<C2LinearBlock> block;
+            ASSERT_EQ(C2_OK, mInputPool->fetchLinearBlock(
+                    kFrameSize,
+                    { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE },
+                    &block));
+            C2WriteView view = block->map().get();
+            ASSERT_EQ(C2_OK, view.error());
+            for (size_t j = 0; j < kFrameSize; ++j) {
+                view.data()[j] = kCodes[(i + j) % (sizeof(kCodes) / sizeof(kCodes[0]))].code;
+            }
+
+            std::unique_ptr<C2Work> work(new C2Work);
+            work->input.ordinal.frameIndex = i;
+            work->input.ordinal.timestamp = i * kFrameSize * 1000000ll / 8000;
+            work->input.flags = (i + 1 == kNumFrames)
+                    ? C2FrameData::FLAG_END_OF_STREAM : (C2FrameData::flags_t)0;
+            work->input.buffers.push_back(
+                    C2Buffer::CreateLinearBuffer(block->share(0, kFrameSize, C2Fence())));
+            work->worklets.emplace_back(new C2Worklet);
+            items.push_back(std::move(work));
+        }
+        ASSERT_EQ(C2_OK, component->queue(&items));
+        ASSERT_TRUE(mListener->waitForWork(kNumFrames));
+
+        for (size_t i = 0; i < kNumFrames; ++i) {
+            ASSERT_EQ(1u, mListener->mDoneWork.count(i)) << "frame " << i;
+            const std::unique_ptr<C2Work>& work = mListener->mDoneWork[i];
+            ASSERT_EQ(C2_OK, work->result);
+            ASSERT_EQ(1u, work->worklets.size());
+            ASSERT_EQ(1u, work->worklets.front()->output.buffers.size());
+            const std::shared_ptr<C2Buffer>& buffer =
+                    work->worklets.front()->output.buffers.front();
+            ASSERT_EQ(1u, buffer->data().linearBlocks().size());
+            C2ReadView view = buffer->data().linearBlocks().front().map().get();
+            ASSERT_EQ(C2_OK, view.error());
+            ASSERT_EQ(kFrameSize * sizeof(int16_t), view.capacity());
+            const int16_t* samples = reinterpret_cast<const int16_t*>(view.data());
+            for (size_t j = 0; j < kFrameSize; ++j) {
+                ASSERT_EQ(kCodes[(i + j) % (sizeof(kCodes) / sizeof(kCodes[0]))].value,
+                          samples[j]) << "frame " << i << " sample " << j;
+            }
+        }
+
+        EXPECT_EQ(C2_OK, component->stop());
+        EXPECT_EQ(C2_OK, component->release());
+    }
+
+    // Queues access unit |frame| to |component|.
+    void queueFrame(const std::shared_ptr<Codec2Client::Component>& component, size_t frame) {
+        std::vector<uint8_t> data = makeAccessUnit(frame);
+        std::shared_ptr<C2LinearBlock> block;
+        ASSERT_EQ(C2_OK, mInputPool->fetchLinearBlock(
+                data.size(),
+                { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE },
+                &block));
+        C2WriteView view = block->map().get();
+        ASSERT_EQ(C2_OK, view.error());
+        memcpy(view.data(), data.data(), data.size());
+
+        std::list<std::unique_ptr<C2Work>> items;
+        std::unique_ptr<C2Work> work(new C2Work);
+        work->input.ordinal.frameIndex = frame;
+        work->input.ordinal.timestamp = frame * 33333ll;
+        work->input.flags = (C2FrameData::flags_t)0;
+        work->input.buffers.push_back(
+                C2Buffer::CreateLinearBuffer(block->share(0, data.size(), C2Fence())));
+        work->worklets.emplace_back(new C2Worklet);
+        items.push_back(std::move(work));
+        ASSERT_EQ(C2_OK, component->queue(&items));
+    }
+
+    // Takes the work of frame |frame| and returns its output buffer in |buffer|.
+    void takeOutput(size_t frame, std::shared_ptr<C2Buffer>* buffer) {
+        std::unique_ptr<C2Work> work = mListener->takeWork(frame);
+        ASSERT_NE(nullptr, work) << "frame " << frame;
+        ASSERT_EQ(C2_OK, work->result);
+        ASSERT_EQ(1u, work->worklets.size());
+        ASSERT_EQ(1u, work->worklets.front()->output.buffers.size()) << "frame " << frame;
+        *buffer = work->worklets.front()->output.buffers.front();
+        ASSERT_NE(nullptr, *buffer);
+        ASSERT_EQ(1u, (*buffer)->data().graphicBlocks().size());
+    }
+
+    std::shared_ptr<TestListener> mListener;
+    std::shared_ptr<C2BlockPool> mInputPool;
+};
+
+TEST_F(Codec2ClientLoopbackTest, DecodeThroughLoopbackClient) {
+    std::shared_ptr<Codec2Client> client = Codec2Client::CreateLoopback();
+    ASSERT_NE(nullptr, client);
+    EXPECT_EQ("loopback", client->getInstanceName());
+
+    bool listed = false;
+    for (const C2Component::Traits& traits : client->listComponents()) {
+        listed |= traits.name == kComponentName;
+    }
+    EXPECT_TRUE(listed);
+
+    std::shared_ptr<Codec2Client::Component> component;
+    ASSERT_EQ(C2_OK, client->createComponent(kComponentName, mListener, &component));
+    ASSERT_NE(nullptr, component);
+    decode(component);
+}
+
+TEST_F(Codec2ClientLoopbackTest, CreateComponentByNamePrefersLoopback) {
+    std::string oldValue = base::GetProperty(kLoopbackProperty, "");
+    ASSERT_TRUE(base::SetProperty(kLoopbackProperty, "1"));
+
+    std::shared_ptr<Codec2Client> owner;
+    std::shared_ptr<Codec2Client::Component> component =
+            Codec2Client::CreateComponentByName(kComponentName, mListener, &owner);
+    base::SetProperty(kLoopbackProperty, oldValue);
+
+    ASSERT_NE(nullptr, component);
+    ASSERT_NE(nullptr, owner);
+    EXPECT_EQ("loopback", owner->getInstanceName());
+    decode(component);
+}
+
+TEST_F(Codec2ClientLoopbackTest, SharedOutputBuffers) {
+    // Display buffers are only backed by output blocks if these can be decoded into.
+    std::shared_ptr<C2BlockPool> outputPool;
+    ASSERT_EQ(C2_OK, GetCodec2BlockPool(C2BlockPool::BASIC_GRAPHIC, nullptr, &outputPool));
+    std::shared_ptr<C2GraphicBlock> probe;
+    ASSERT_EQ(C2_OK, outputPool->fetchGraphicBlock(
+            kDisplayBufferStride, kHeight * 2, HAL_PIXEL_FORMAT_YCBCR_420_888,
+            { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE }, &probe));
+    {
+        C2GraphicView view = probe->map().get();
+        ASSERT_EQ(C2_OK, view.error());
+        if (!isSemiPlanar(view)
+                || view.layout().planes[C2PlanarLayout::PLANE_Y].rowInc
+                        != (int32_t)kDisplayBufferStride
+                || view.layout().planes[C2PlanarLayout::PLANE_U].rowInc
+                        != (int32_t)kDisplayBufferStride) {
+            std::cout << "[   WARN   ] Test Disabled: output blocks cannot be shared\n";
+            return;
+        }
+    }
+    probe.reset();
+
+    std::shared_ptr<Codec2Client> client = Codec2Client::CreateLoopback();
+    ASSERT_NE(nullptr, client);
+    std::shared_ptr<Codec2Client::Component> component;
+    ASSERT_EQ(C2_OK, client->createComponent(kAvcDecoderName, mListener, &component));
+    ASSERT_NE(nullptr, component);
+
+    // Low latency mode outputs each frame of this stream as soon as it is decoded.
+    C2PortSharedBuffersTuning::output shared(C2_TRUE);
+    C2GlobalLowLatencyModeTuning lowLatency(C2_TRUE);
+    std::vector<std::unique_ptr<C2SettingResult>> failures;
+    ASSERT_EQ(C2_OK, component->config({&shared, &lowLatency}, C2_DONT_BLOCK, &failures));
+    ASSERT_TRUE(failures.empty());
+    // unlike the service, the loopback client lets the component share its output buffers
+    C2PortSharedBuffersTuning::output queried(C2_FALSE);
+    ASSERT_EQ(C2_OK, component->query({&queried}, {}, C2_DONT_BLOCK, nullptr));
+    ASSERT_EQ(C2_TRUE, queried.value);
+    ASSERT_EQ(C2_OK, component->start());
+
+    // Hold all outputs. Only the first ones are shared, the decoder copies the others out as
+    // it would run out of buffers otherwise.
+    std::vector<std::shared_ptr<C2Buffer>> held;
+    for (size_t frame = 0; frame < kNumHeldFrames; ++frame) {
+        ASSERT_NO_FATAL_FAILURE(queueFrame(component, frame));
+    }
+    for (size_t frame = 0; frame < kNumHeldFrames; ++frame) {
+        std::shared_ptr<C2Buffer> buffer;
+        ASSERT_NO_FATAL_FAILURE(takeOutput(frame, &buffer));
+        held.push_back(buffer);
+    }
+    for (size_t frame = 0; frame < kNumHeldFrames; ++frame) {
+        C2GraphicView view = held[frame]->data().graphicBlocks().front().map().get();
+        EXPECT_EQ(frame < kMaxSharedOutputs, isSemiPlanar(view)) << "frame " << frame;
+        // the shared buffers were held while the later frames were decoded
+        ASSERT_NO_FATAL_FAILURE(checkFrame(view, frame)) << "held output was overwritten";
+    }
+    held.clear();
+
+    // Release each output right away. All outputs are shared, and as the decoder has fewer
+    // display buffers than frames, released buffers are reused.
+    std::set<const C2Handle*> handles;
+    for (size_t frame = kNumHeldFrames; frame < kNumHeldFrames + kNumReleasedFrames; ++frame) {
+        ASSERT_NO_FATAL_FAILURE(queueFrame(component, frame));
+        std::shared_ptr<C2Buffer> buffer;
+        ASSERT_NO_FATAL_FAILURE(takeOutput(frame, &buffer));
+        const C2ConstGraphicBlock& block = buffer->data().graphicBlocks().front();
+        C2GraphicView view = block.map().get();
+        ASSERT_TRUE(isSemiPlanar(view)) << "frame " << frame << " was not shared";
+        ASSERT_NO_FATAL_FAILURE(checkFrame(view, frame));
+        handles.insert(block.handle());
+    }
+    EXPECT_LT(handles.size(), kNumReleasedFrames);
+
+    EXPECT_EQ(C2_OK, component->stop());
+    EXPECT_EQ(C2_OK, component->release());
+}
+
+} // namespace android
@@ -18,15 +18,49 @@
 #define LOG_TAG "C2SoftwareCodecServiceRegistrant"
 
 #include <C2PlatformSupport.h>
+#include <android-base/properties.h>
+#include <android-base/strings.h>
 #include <codec2/hidl/1.0/ComponentStore.h>
 #include <media/CodecServiceRegistrant.h>
 #include <log/log.h>
 
+namespace /* unnamed */ {
+
+// Comma-separated list of components whose modules are loaded at service
+// start, or "all" to load every component.
+constexpr char kPrewarmComponentsProperty[] = "media.c2.sw.prewarm";
+
+// Number of warm instances to keep for each prewarmed component.
+constexpr char kWarmInstancesProperty[] = "media.c2.sw.prewarm.instances";
+
+void prewarmPlatformStore(const std::shared_ptr<C2ComponentStore>& store) {
+    std::string components =
+            android::base::GetProperty(kPrewarmComponentsProperty, "");
+    if (components.empty()) {
+        return;
+    }
+    std::vector<C2String> names;
+    if (components != "all") {
+        names = android::base::Split(components, ",");
+    }
+    size_t warmInstances = android::base::GetUintProperty(
+            kWarmInstancesProperty, size_t(0));
+    c2_status_t res = android::PrewarmCodec2PlatformComponentStore(
+            store, names, warmInstances);
+    if (res != C2_OK) {
+        ALOGW("Cannot prewarm all requested components: %d", res);
+    }
+}
+
+} // unnamed namespace
+
 extern "C" void RegisterCodecServices() {
     using namespace ::hardware::google::media::c2::V1_0;
+    std::shared_ptr<C2ComponentStore> platformStore =
+        android::GetCodec2PlatformComponentStore();
+    prewarmPlatformStore(platformStore);
     android::sp<IComponentStore> store =
-        new utils::ComponentStore(
-                android::GetCodec2PlatformComponentStore());
+        new utils::ComponentStore(platformStore);
     if (store == nullptr) {
         ALOGE("Cannot create Codec2's IComponentStore software service.");
     } else {
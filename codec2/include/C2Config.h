@@ -241,6 +241,18 @@ enum C2ParamIndexKind : C2Param::type_index_t {
 
     kParamIndexSurfaceAllocator, // u32
 
+    // encoder statistics
+    kParamIndexEcoStats, // struct
+
+    // encoder threading & speed
+    kParamIndexEncoderThreading, // struct
+    kParamIndexEncoderSpeed, // int32
+
+    kParamIndexSharedBuffers, // bool
+    kParamIndexWorkerThreads, // struct
+    kParamIndexLowLatencyMode, // bool
+    kParamIndexKeyFramesOnly, // bool
+
     // deprecated indices due to renaming
     kParamIndexAacStreamFormat = kParamIndexAacPackaging,
     kParamIndexCsd = kParamIndexInitData,
@@ -918,6 +930,21 @@ typedef C2PortParam<C2Tuning, C2Uint32Value, kParamIndexSurfaceAllocator>
         C2PortSurfaceAllocatorTuning;
 constexpr char C2_PARAMKEY_OUTPUT_SURFACE_ALLOCATOR[] = "output.buffers.surface-allocator-id";
 
+/**
+ * Output buffer sharing.
+ *
+ * If enabled, a decoder may decode into its output buffers directly and keep using them as
+ * reference frames while the client holds them. A buffer is reused only after the client has
+ * released it. Only a few buffers are shared with the client at a time; while the client holds
+ * that many, further frames are copied into separate output buffers as if sharing was disabled.
+ *
+ * This is ignored when outputting to a surface. It is also only available to clients in the same
+ * process as the component, as it relies on the client holding the very C2Buffer objects the
+ * component outputs.
+ */
+typedef C2PortParam<C2Tuning, C2EasyBoolValue, kParamIndexSharedBuffers> C2PortSharedBuffersTuning;
+constexpr char C2_PARAMKEY_OUTPUT_SHARED_BUFFERS[] = "output.buffers.shared";
+
 /**
  * Block pools to use.
  *
@@ -1115,6 +1142,58 @@ typedef C2GlobalParam<C2Tuning, C2Int32Value, kParamIndexRealTimePriority>
         C2RealTimePriorityTuning;
 constexpr char C2_PARAMKEY_PRIORITY[] = "algo.priority";
 
+/**
+ * Worker threads.
+ *
+ * Upper bound on the number of worker threads a component uses and the CPUs those threads may run
+ * on, so that many components can share a device without each sizing itself to all of its CPUs.
+ * A maximum of 0 leaves the thread count to the component (default). A CPU mask of 0 allows any
+ * CPU (default); otherwise bit N allows CPU N and the thread count is also capped at the number
+ * of allowed CPUs. Components apply this at start and whenever it changes.
+ */
+struct C2WorkerThreadsStruct {
+    C2WorkerThreadsStruct()
+        : cpuMask(0), maxThreads(0) { }
+
+    C2WorkerThreadsStruct(uint64_t cpuMask_, uint32_t maxThreads_)
+        : cpuMask(cpuMask_), maxThreads(maxThreads_) { }
+
+    uint64_t cpuMask;       ///< CPUs worker threads may run on (0 for any)
+    uint32_t maxThreads;    ///< maximum number of worker threads (0 for no limit)
+
+    DEFINE_AND_DESCRIBE_C2STRUCT(WorkerThreads)
+    C2FIELD(cpuMask, "cpu-mask")
+    C2FIELD(maxThreads, "max-count")
+};
+
+typedef C2GlobalParam<C2Tuning, C2WorkerThreadsStruct, kParamIndexWorkerThreads>
+        C2WorkerThreadsTuning;
+constexpr char C2_PARAMKEY_WORKER_THREADS[] = "algo.worker-threads";
+
+/**
+ * Low latency mode.
+ *
+ * If true, decoders output each frame as soon as it is decoded, in decode order, and keep no more
+ * internal buffering than decoding requires. This is meant for streams without frame reordering
+ * (e.g. real-time communication); frames of reordered streams are output out of display order.
+ * Default is false.
+ */
+typedef C2GlobalParam<C2Tuning, C2EasyBoolValue, kParamIndexLowLatencyMode>
+        C2GlobalLowLatencyModeTuning;
+constexpr char C2_PARAMKEY_LOW_LATENCY_MODE[] = "algo.low-latency";
+
+/**
+ * Key frame only decoding.
+ *
+ * If true, decoders skip all frames other than key (intra) frames, and return the work of skipped
+ * frames without output. This is meant for generating thumbnails and seek previews. Once the mode
+ * is turned off, decoders may only produce correct output from the next key frame on.
+ * Default is false.
+ */
+typedef C2GlobalParam<C2Tuning, C2EasyBoolValue, kParamIndexKeyFramesOnly>
+        C2GlobalKeyFramesOnlyTuning;
+constexpr char C2_PARAMKEY_KEY_FRAMES_ONLY[] = "algo.key-frames-only";
+
 /* ------------------------------------- protected content ------------------------------------- */
 
 /**
@@ -1801,6 +1880,74 @@ typedef C2StreamParam<C2Tuning, C2IntraRefreshStruct, kParamIndexIntraRefresh>
         C2StreamIntraRefreshTuning;
 constexpr char C2_PARAMKEY_INTRA_REFRESH[] = "coding.intra-refresh";
 
+/**
+ * Encoder statistics reporting.
+ *
+ * If enabled, the encoder publishes per-frame statistics (frame type, size, average QP and
+ * timestamp) and session statistics (bitrate, frame rate) to the ECO service. The session is
+ * obtained for the configured picture size and |cameraRecording| flag. Statistics are not
+ * collected at all if disabled (default).
+ */
+struct C2EcoStatsStruct {
+    C2EcoStatsStruct()
+        : enabled(C2_FALSE), cameraRecording(C2_FALSE) { }
+
+    C2EcoStatsStruct(c2_bool_t enabled_, c2_bool_t cameraRecording_)
+        : enabled(enabled_), cameraRecording(cameraRecording_) { }
+
+    c2_bool_t enabled;          ///< statistics reporting is enabled
+    c2_bool_t cameraRecording;  ///< the session is a camera recording session
+
+    DEFINE_AND_DESCRIBE_C2STRUCT(EcoStats)
+    C2FIELD(enabled, "enabled")
+    C2FIELD(cameraRecording, "camera-recording")
+};
+
+typedef C2GlobalParam<C2Tuning, C2EcoStatsStruct, kParamIndexEcoStats> C2EcoStatsTuning;
+constexpr char C2_PARAMKEY_ECO_STATS[] = "coding.eco-stats";
+
+/**
+ * Encoder threading.
+ *
+ * Number of encoding threads and tile layout used by a software encoder. Zero counts are chosen
+ * by the component from the picture size, the frame rate or operating rate and the number of
+ * online CPUs (default). Components round tile counts to what the coding format supports (e.g.
+ * powers of two for VP9) and ignore them if the format has no tiles.
+ */
+struct C2EncoderThreadingStruct {
+    C2EncoderThreadingStruct()
+        : threads(0), tileColumns(0), tileRows(0), rowMt(C2_TRUE) { }
+
+    C2EncoderThreadingStruct(
+            uint32_t threads_, uint32_t tileColumns_, uint32_t tileRows_, c2_bool_t rowMt_)
+        : threads(threads_), tileColumns(tileColumns_), tileRows(tileRows_), rowMt(rowMt_) { }
+
+    uint32_t threads;       ///< number of encoding threads (0 for automatic)
+    uint32_t tileColumns;   ///< number of tile columns (0 for automatic)
+    uint32_t tileRows;      ///< number of tile rows (0 for automatic)
+    c2_bool_t rowMt;        ///< threads may share a tile by encoding superblock rows in parallel
+
+    DEFINE_AND_DESCRIBE_C2STRUCT(EncoderThreading)
+    C2FIELD(threads, "threads")
+    C2FIELD(tileColumns, "tile-columns")
+    C2FIELD(tileRows, "tile-rows")
+    C2FIELD(rowMt, "row-mt")
+};
+
+typedef C2StreamParam<C2Tuning, C2EncoderThreadingStruct, kParamIndexEncoderThreading>
+        C2StreamEncoderThreadingTuning;
+constexpr char C2_PARAMKEY_ENCODER_THREADING[] = "coding.threading";
+
+/**
+ * Encoder speed.
+ *
+ * Component specific trade-off between encoding speed and compression efficiency; higher values
+ * are faster. For VP8 and VP9 this is the libvpx cpu-used setting.
+ */
+typedef C2StreamParam<C2Tuning, C2Int32Value, kParamIndexEncoderSpeed>
+        C2StreamEncoderSpeedTuning;
+constexpr char C2_PARAMKEY_ENCODER_SPEED[] = "coding.speed";
+
 /* ====================================== IMAGE COMPONENTS ====================================== */
 
 /**
@@ -442,10 +442,29 @@ public:
         if (orig.size() == 0) {
             return nullptr;
         }
-        void *mem = ::operator new (orig.size());
+        return std::unique_ptr<C2Param>(CopyTo(::operator new (orig.size()), orig));
+    }
+
+    /// Constructs a clone of |orig| at |mem|, which must be suitably aligned and hold at least
+    /// orig.size() bytes. The caller retains ownership of |mem|. Returns nullptr if |orig| is
+    /// invalid.
+    inline static C2Param* CopyTo(void *mem, const C2Param &orig) {
+        if (orig.size() == 0) {
+            return nullptr;
+        }
         C2Param *param = new (mem) C2Param(orig.size(), orig._mIndex);
         param->updateFrom(orig);
-        return std::unique_ptr<C2Param>(param);
+        return param;
+    }
+
+    /// Constructs a clone of |orig| as a stream parameter at |mem|. See CopyTo().
+    inline static C2Param* CopyToAsStream(
+            void *mem, const C2Param &orig, bool output, unsigned stream) {
+        C2Param *copy = CopyTo(mem, orig);
+        if (copy) {
+            copy->_mIndex.convertToStream(output, stream);
+        }
+        return copy;
     }
 
     /// Returns managed clone of |orig| as a stream parameter at heap.
@@ -22,6 +22,10 @@
 #define __C2_GENERATE_GLOBAL_VARS__
 #include <_C2MacroUtils.h>
 #include <C2Enum.h>
+#include <C2ParamDef.h>
+#include <util/C2InterfaceHelper.h>
+#include <util/C2InterfaceUtils.h>
+#include <util/C2ParamUtils.h>
 
 /** \file
  * Tests for vndk/util.
@@ -117,3 +121,361 @@ TEST_F(C2UtilTest, EnumUtilsTest) {
     EXPECT_EQ("__23", _C2EnumUtils::camelCaseToDashed("__23"));
 }
 
+
+/* ------------------------------- C2FieldSupportedValuesHelper ------------------------------- */
+
+namespace {
+
+template<typename T>
+void checkRangeLookup(T min, T max, T step, T num, T denom, T lo, T hi) {
+    C2FieldSupportedValues fsv(min, max, step, num, denom);
+    C2SupportedRange<T> range(fsv);
+    C2FieldSupportedValuesHelper<T> helper(fsv);
+    for (T v = lo; v <= hi; ++v) {
+        EXPECT_EQ(range.contains(v), helper.supports(v)) << "value " << +v;
+    }
+}
+
+template<typename T>
+void checkListedSeries(const C2SupportedRange<T> &range) {
+    std::vector<T> values;
+    ASSERT_TRUE(range.listSeries(&values, 1024));
+    ASSERT_FALSE(values.empty());
+    EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+    for (T v : values) {
+        EXPECT_TRUE(range.contains(v)) << "value " << +v;
+    }
+    // the endpoints are listed exactly when contained
+    EXPECT_EQ(range.contains(range.min()),
+              std::binary_search(values.begin(), values.end(), range.min()));
+    EXPECT_EQ(range.contains(range.max()),
+              std::binary_search(values.begin(), values.end(), range.max()))
+            << "max " << +range.max();
+    C2FieldSupportedValuesHelper<T> helper(range);
+    EXPECT_EQ(range.contains(range.max()), helper.supports(range.max()));
+}
+
+} // namespace
+
+TEST_F(C2UtilTest, SupportedRangeListSeriesTest) {
+    // the last power exceeds the maximum in double precision, but not once converted to float
+    C2SupportedRange<float> floats = C2SupportedRange<float>::InSeries(0.1f, 1000.f, 10.f, 1.f);
+    std::vector<float> values;
+    ASSERT_TRUE(floats.listSeries(&values, 16));
+    EXPECT_EQ((std::vector<float>{ 0.1f, 1.f, 10.f, 100.f, 1000.f }), values);
+    EXPECT_TRUE(floats.contains(1000.f));
+    checkListedSeries(floats);
+
+    checkListedSeries(C2SupportedRange<float>::InSeries(0.5f, 512.f, 2.f, 1.f));
+    checkListedSeries(C2SupportedRange<float>::InSeries(0.3f, 2.43f, 3.f, 1.f));
+    checkListedSeries(C2SupportedRange<float>::InMacSeries(0.1f, 1000.f, 0.5f, 3.f, 1.f));
+    checkListedSeries(C2SupportedRange<int32_t>::InSeries(1, 1024, 2, 1));
+    checkListedSeries(C2SupportedRange<int32_t>::InSeries(3, 1000, 3, 1));
+    checkListedSeries(C2SupportedRange<uint32_t>::InMacSeries(1, 1023, 1, 2, 1));
+    checkListedSeries(C2SupportedRange<int64_t>::InSeries(1, INT64_MAX, 2, 1));
+}
+
+TEST_F(C2UtilTest, FieldSupportedValuesHelperRangeTest) {
+    // simple and arithmetic ranges
+    checkRangeLookup<int32_t>(1, 30000, 1, 1, 1, 0, 30005);
+    checkRangeLookup<uint32_t>(16, 4096, 16, 1, 1, 0, 5000);
+    // geometric series
+    checkRangeLookup<int32_t>(1, 100000, 0, 2, 1, -5, 100005);
+    checkRangeLookup<int32_t>(3, 100000, 0, 3, 1, -5, 100005);
+    // multiply-accumulate series
+    checkRangeLookup<uint32_t>(1, 100000, 1, 2, 1, 0, 100005);
+    checkRangeLookup<int32_t>(10, 5000, 7, 3, 2, 0, 6000);
+}
+
+TEST_F(C2UtilTest, FieldSupportedValuesHelperValuesTest) {
+    C2FieldSupportedValuesHelper<int32_t> values(
+            C2FieldSupportedValues(false, std::vector<int32_t>{ 5, 1, 9, 3 }));
+    EXPECT_TRUE(values.supports(1));
+    EXPECT_TRUE(values.supports(3));
+    EXPECT_TRUE(values.supports(5));
+    EXPECT_TRUE(values.supports(9));
+    EXPECT_FALSE(values.supports(4));
+    EXPECT_FALSE(values.supports(10));
+
+    // first value is the minimum mask
+    C2FieldSupportedValuesHelper<uint32_t> flags(
+            C2FieldSupportedValues(true, std::vector<uint32_t>{ 1, 2, 4 }));
+    EXPECT_TRUE(flags.supports(1));
+    EXPECT_TRUE(flags.supports(3));
+    EXPECT_TRUE(flags.supports(7));
+    EXPECT_FALSE(flags.supports(0));
+    EXPECT_FALSE(flags.supports(8));
+}
+
+/* --------------------------------------- C2ParamArena --------------------------------------- */
+
+namespace {
+
+enum {
+    kParamIndexArenaTest = C2Param::TYPE_INDEX_VENDOR_START,
+};
+
+typedef C2StreamParam<C2Info, C2Int32Value, kParamIndexArenaTest> C2ArenaTestInfo;
+
+} // namespace
+
+TEST_F(C2UtilTest, ParamArenaTest) {
+    C2ParamArena arena(64 /* chunkSize */);
+    C2ArenaTestInfo::output orig(1u, 42);
+
+    std::vector<C2Param*> copies;
+    for (int i = 0; i < 32; ++i) {
+        C2Param *copy = arena.copy(orig);
+        ASSERT_NE(nullptr, copy);
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(copy) % C2ParamArena::ALIGNMENT);
+        copies.push_back(copy);
+    }
+    // earlier copies must stay valid as the arena grows
+    for (C2Param *copy : copies) {
+        EXPECT_EQ(orig, *copy);
+    }
+    EXPECT_EQ(32 * ((sizeof(orig) + 7) & ~7), arena.used());
+
+    C2Param *stream = arena.copyAsStream(orig, false /* output */, 3u);
+    ASSERT_NE(nullptr, stream);
+    C2ArenaTestInfo::input *input = C2ArenaTestInfo::input::From(stream);
+    ASSERT_NE(nullptr, input);
+    EXPECT_EQ(3u, input->stream());
+    EXPECT_EQ(42, input->value);
+
+    C2ArenaTestInfo::output *emplaced = arena.emplace<C2ArenaTestInfo::output>(2u, 7);
+    EXPECT_EQ(2u, emplaced->stream());
+    EXPECT_EQ(7, emplaced->value);
+
+    C2ArenaTestInfo::output invalid(1u, 0);
+    invalid.invalidate();
+    EXPECT_EQ(nullptr, arena.copy(invalid));
+
+    // memory is recycled after clear()
+    arena.clear();
+    EXPECT_EQ(0u, arena.used());
+    EXPECT_EQ(copies[0], arena.copy(orig));
+}
+
+/* ------------------------------------- C2InterfaceHelper ------------------------------------- */
+
+namespace {
+
+enum {
+    kParamIndexDependencyTestA = C2Param::TYPE_INDEX_VENDOR_START + 1,
+    kParamIndexDependencyTestB,
+    kParamIndexDependencyTestC,
+    kParamIndexDependencyTestD,
+    kParamIndexDependencyTestE,
+};
+
+typedef C2GlobalParam<C2Tuning, C2Int32Value, kParamIndexDependencyTestA> C2DependencyTestA;
+typedef C2GlobalParam<C2Tuning, C2Int32Value, kParamIndexDependencyTestB> C2DependencyTestB;
+typedef C2GlobalParam<C2Tuning, C2Int32Value, kParamIndexDependencyTestC> C2DependencyTestC;
+typedef C2GlobalParam<C2Tuning, C2Int32Value, kParamIndexDependencyTestD> C2DependencyTestD;
+typedef C2GlobalParam<C2Tuning, C2Int32Value, kParamIndexDependencyTestE> C2DependencyTestE;
+
+/**
+ * Interface where A has down dependencies (C and D) on both sides of the independent B, and E
+ * depends on both D and B. Parameters are added in the order A, C, B, D, E.
+ */
+class DependencyTestInterface : public C2InterfaceHelper {
+public:
+    DependencyTestInterface() : C2InterfaceHelper(std::make_shared<C2ReflectorHelper>()) {
+        setDerivedInstance(this);
+
+        addParameter(
+                DefineParam(mA, "test.a")
+                .withDefault(new C2DependencyTestA(0))
+                .withFields({ C2F(mA, value).any() })
+                .withSetter(SetA)
+                .build());
+
+        addParameter(
+                DefineParam(mC, "test.c")
+                .withDefault(new C2DependencyTestC(1))
+                .withFields({ C2F(mC, value).any() })
+                .withSetter(SetC, mA)
+                .build());
+
+        addParameter(
+                DefineParam(mB, "test.b")
+                .withDefault(new C2DependencyTestB(0))
+                .withFields({ C2F(mB, value).any() })
+                .withSetter(SetB)
+                .build());
+
+        addParameter(
+                DefineParam(mD, "test.d")
+                .withDefault(new C2DependencyTestD(0))
+                .withFields({ C2F(mD, value).any() })
+                .withSetter(SetD, mA)
+                .build());
+
+        addParameter(
+                DefineParam(mE, "test.e")
+                .withDefault(new C2DependencyTestE(0))
+                .withFields({ C2F(mE, value).any() })
+                .withSetter(SetE, mD, mB)
+                .build());
+    }
+
+private:
+    static C2R SetA(bool mayBlock, C2P<C2DependencyTestA> &me) {
+        (void)mayBlock;
+        (void)me;
+        return C2R::Ok();
+    }
+
+    static C2R SetB(bool mayBlock, C2P<C2DependencyTestB> &me) {
+        (void)mayBlock;
+        (void)me;
+        return C2R::Ok();
+    }
+
+    // C = A + 1
+    static C2R SetC(bool mayBlock, C2P<C2DependencyTestC> &me,
+                    const C2P<C2DependencyTestA> &a) {
+        (void)mayBlock;
+        me.set().value = a.v.value + 1;
+        return C2R::Ok();
+    }
+
+    // D = 2 * A
+    static C2R SetD(bool mayBlock, C2P<C2DependencyTestD> &me,
+                    const C2P<C2DependencyTestA> &a) {
+        (void)mayBlock;
+        me.set().value = 2 * a.v.value;
+        return C2R::Ok();
+    }
+
+    // E = D + B
+    static C2R SetE(bool mayBlock, C2P<C2DependencyTestE> &me,
+                    const C2P<C2DependencyTestD> &d, const C2P<C2DependencyTestB> &b) {
+        (void)mayBlock;
+        me.set().value = d.v.value + b.v.value;
+        return C2R::Ok();
+    }
+
+    std::shared_ptr<C2DependencyTestA> mA;
+    std::shared_ptr<C2DependencyTestB> mB;
+    std::shared_ptr<C2DependencyTestC> mC;
+    std::shared_ptr<C2DependencyTestD> mD;
+    std::shared_ptr<C2DependencyTestE> mE;
+};
+
+void checkDependencyValues(
+        const DependencyTestInterface &intf, int32_t c, int32_t d, int32_t e) {
+    C2DependencyTestC cValue;
+    C2DependencyTestD dValue;
+    C2DependencyTestE eValue;
+    ASSERT_EQ(C2_OK, intf.query({ &cValue, &dValue, &eValue }, {}, C2_MAY_BLOCK, nullptr));
+    EXPECT_EQ(c, cValue.value);
+    EXPECT_EQ(d, dValue.value);
+    EXPECT_EQ(e, eValue.value);
+}
+
+} // namespace
+
+TEST_F(C2UtilTest, InterfaceHelperDependencyOrderTest) {
+    DependencyTestInterface intf;
+    std::vector<std::unique_ptr<C2SettingResult>> failures;
+
+    // A dirties C and D; setting B in the same call must not drop D (or E after it).
+    C2DependencyTestA a(5);
+    C2DependencyTestB b(7);
+    ASSERT_EQ(C2_OK, intf.config({ &a, &b }, C2_MAY_BLOCK, &failures));
+    EXPECT_TRUE(failures.empty());
+    checkDependencyValues(intf, 6, 10, 17);
+
+    // parameters may be passed out of dependency order
+    a.value = 1;
+    b.value = 2;
+    ASSERT_EQ(C2_OK, intf.config({ &b, &a }, C2_MAY_BLOCK, &failures));
+    checkDependencyValues(intf, 2, 2, 4);
+
+    // a dependency after the last param
+    a.value = 3;
+    C2DependencyTestC c(0);
+    ASSERT_EQ(C2_OK, intf.config({ &a, &c }, C2_MAY_BLOCK, &failures));
+    checkDependencyValues(intf, 4, 6, 8);
+
+    // no dirty flags are left over for the next call
+    b.value = 4;
+    ASSERT_EQ(C2_OK, intf.config({ &b }, C2_MAY_BLOCK, &failures));
+    checkDependencyValues(intf, 4, 6, 10);
+}
+
+namespace {
+
+enum {
+    kParamIndexSchemaTest = C2Param::TYPE_INDEX_VENDOR_START + 16,
+};
+
+typedef C2GlobalParam<C2Tuning, C2Int32Value, kParamIndexSchemaTest> C2SchemaTestTuning;
+
+/**
+ * Interface sharing its schema, with a default and possible values set by the instance.
+ */
+class SchemaTestInterface : public C2InterfaceHelper {
+public:
+    SchemaTestInterface(
+            const std::shared_ptr<C2ReflectorHelper> &reflector, int32_t def, int32_t max)
+        : C2InterfaceHelper(reflector) {
+        setDerivedInstance(this);
+        shareSchema("schema-test");
+
+        addParameter(
+                DefineParam(mValue, "test.value")
+                .withDefault(new C2SchemaTestTuning(def))
+                .withFields({ C2F(mValue, value).inRange(0, max) })
+                .withSetter(SetValue)
+                .build());
+    }
+
+    int32_t queryMax() {
+        C2SchemaTestTuning value;
+        std::vector<C2FieldSupportedValuesQuery> queries = {
+            C2FieldSupportedValuesQuery::Possible(C2ParamField(&value, &value.value)),
+        };
+        EXPECT_EQ(C2_OK, querySupportedValues(queries, C2_MAY_BLOCK));
+        EXPECT_EQ(C2_OK, queries[0].status);
+        EXPECT_EQ(C2FieldSupportedValues::RANGE, queries[0].values.type);
+        return queries[0].values.range.max.i32;
+    }
+
+    int32_t queryValue() {
+        C2SchemaTestTuning value;
+        EXPECT_EQ(C2_OK, query({ &value }, {}, C2_MAY_BLOCK, nullptr));
+        return value.value;
+    }
+
+private:
+    static C2R SetValue(bool mayBlock, C2P<C2SchemaTestTuning> &me) {
+        (void)mayBlock;
+        return me.F(me.v.value).validatePossible(me.v.value);
+    }
+
+    std::shared_ptr<C2SchemaTestTuning> mValue;
+};
+
+} // namespace
+
+TEST_F(C2UtilTest, InterfaceHelperSharedSchemaTest) {
+    std::shared_ptr<C2ReflectorHelper> reflector = std::make_shared<C2ReflectorHelper>();
+    SchemaTestInterface first(reflector, 1, 10);
+    SchemaTestInterface same(reflector, 1, 10);
+    // instances with other declarations must not take them from the shared schema
+    SchemaTestInterface otherMax(reflector, 1, 20);
+    SchemaTestInterface otherDefault(reflector, 5, 10);
+
+    EXPECT_EQ(10, first.queryMax());
+    EXPECT_EQ(10, same.queryMax());
+    EXPECT_EQ(20, otherMax.queryMax());
+    EXPECT_EQ(10, otherDefault.queryMax());
+
+    EXPECT_EQ(1, first.queryValue());
+    EXPECT_EQ(1, same.queryValue());
+    EXPECT_EQ(1, otherMax.queryValue());
+    EXPECT_EQ(5, otherDefault.queryValue());
+}
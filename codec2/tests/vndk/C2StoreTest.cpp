@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <C2Component.h>
+#include <C2PlatformSupport.h>
+
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+namespace {
+
+constexpr char kComponentName[] = "c2.android.g711.mlaw.decoder";
+
+} // namespace
+
+class C2StoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mStore = GetCodec2PlatformComponentStore();
+        ASSERT_NE(nullptr, mStore);
+    }
+
+    void TearDown() override {
+        for (const std::shared_ptr<C2Component> &component : mComponents) {
+            EXPECT_EQ(C2_OK, component->release());
+        }
+        mComponents.clear();
+        mStore.reset();
+    }
+
+    /**
+     * Creates a component through the store, keeps it until the end of the test and records its
+     * node ID.
+     */
+    void createComponent() {
+        std::shared_ptr<C2Component> component;
+        ASSERT_EQ(C2_OK, mStore->createComponent(kComponentName, &component));
+        ASSERT_NE(nullptr, component);
+        std::lock_guard<std::mutex> lock(mMutex);
+        EXPECT_TRUE(mNodeIds.insert(component->intf()->getId()).second)
+                << "duplicate node ID " << component->intf()->getId();
+        mComponents.push_back(component);
+    }
+
+    std::shared_ptr<C2ComponentStore> mStore;
+    std::mutex mMutex;
+    std::vector<std::shared_ptr<C2Component>> mComponents;
+    std::set<c2_node_id_t> mNodeIds;
+};
+
+TEST_F(C2StoreTest, WarmInstancesHaveUniqueNodeIds) {
+    ASSERT_EQ(C2_OK, PrewarmCodec2PlatformComponentStore(mStore, { kComponentName }, 2));
+    // take more instances than the pool holds so that warm, refilled and cold instances mix
+    for (int i = 0; i < 8; ++i) {
+        createComponent();
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(8u, mNodeIds.size());
+}
+
+TEST_F(C2StoreTest, ConcurrentCreateWithWarmPool) {
+    ASSERT_EQ(C2_OK, PrewarmCodec2PlatformComponentStore(mStore, { kComponentName }, 2));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([this] {
+            for (int j = 0; j < 8; ++j) {
+                createComponent();
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(32u, mNodeIds.size());
+}
+
+TEST_F(C2StoreTest, ShrinkWarmPool) {
+    ASSERT_EQ(C2_OK, PrewarmCodec2PlatformComponentStore(mStore, { kComponentName }, 4));
+    createComponent();
+    ASSERT_EQ(C2_OK, PrewarmCodec2PlatformComponentStore(mStore, { kComponentName }, 1));
+    ASSERT_EQ(C2_OK, PrewarmCodec2PlatformComponentStore(mStore, { kComponentName }, 0));
+    // the store keeps creating components once the pool is gone
+    for (int i = 0; i < 3; ++i) {
+        createComponent();
+    }
+    EXPECT_EQ(4u, mNodeIds.size());
+}
+
+TEST_F(C2StoreTest, DestroyStoreWhileRefilling) {
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(C2_OK, PrewarmCodec2PlatformComponentStore(mStore, { kComponentName }, 4));
+        createComponent();
+        for (const std::shared_ptr<C2Component> &component : mComponents) {
+            EXPECT_EQ(C2_OK, component->release());
+        }
+        mComponents.clear();
+        // node IDs are unique per store only
+        mNodeIds.clear();
+        // dropping the last reference stops the warm pool thread and releases warm instances
+        mStore.reset();
+        mStore = GetCodec2PlatformComponentStore();
+        ASSERT_NE(nullptr, mStore);
+    }
+}
+
+} // namespace android
@@ -31,9 +31,15 @@
 #include <dlfcn.h>
 #include <unistd.h> // getpagesize
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <thread>
 
 namespace android {
 
@@ -473,7 +479,14 @@ public:
             std::vector<std::unique_ptr<C2SettingResult>> *const failures) override;
     C2PlatformComponentStore();
 
-    virtual ~C2PlatformComponentStore() override = default;
+    virtual ~C2PlatformComponentStore() override;
+
+    /**
+     * Loads the modules of the named components (or of all components if |names| is empty) and
+     * keeps them resident. If |warmInstances| is positive, also keeps that many created but
+     * never started instances of each named component for createComponent() to hand out.
+     */
+    c2_status_t prewarm(const std::vector<C2String> &names, size_t warmInstances);
 
 private:
 
@@ -565,31 +578,137 @@ private:
          * \retval C2_REFUSED   permission denied to load the component module
          */
         c2_status_t fetchModule(std::shared_ptr<ComponentModule> *module) {
-            c2_status_t res = C2_OK;
             std::lock_guard<std::mutex> lock(mMutex);
-            std::shared_ptr<ComponentModule> localModule = mModule.lock();
-            if (localModule == nullptr) {
-                localModule = std::make_shared<ComponentModule>();
-                res = localModule->init(mAlias, mLibPath);
+            return fetchModule_l(module);
+        }
+
+        /**
+         * Loads the component module and keeps it loaded for the lifetime of this loader. Also
+         * sets the number of warm component instances to keep.
+         *
+         * \param warmInstances number of created but never started components to keep
+         */
+        c2_status_t prewarm(size_t warmInstances) {
+            std::list<std::shared_ptr<C2Component>> components;
+            c2_status_t res;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                res = fetchModule_l(&mPinnedModule);
                 if (res == C2_OK) {
-                    mModule = localModule;
+                    mNumWarmInstances = warmInstances;
+                    while (mWarmComponents.size() > mNumWarmInstances) {
+                        components.splice(components.end(), mWarmComponents,
+                                          std::prev(mWarmComponents.end()));
+                    }
                 }
             }
-            *module = localModule;
+            for (const std::shared_ptr<C2Component> &component : components) {
+                (void)component->release();
+            }
             return res;
         }
 
+        /**
+         * Takes a warm component instance if one is available.
+         *
+         * \return true if a warm instance was returned in |component|
+         */
+        bool takeWarmComponent(std::shared_ptr<C2Component> *component) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mWarmComponents.empty()) {
+                return false;
+            }
+            *component = std::move(mWarmComponents.front());
+            mWarmComponents.pop_front();
+            return true;
+        }
+
+        /**
+         * Creates component instances until the warm pool is full. Components are created
+         * without holding the loader lock so that concurrent fetches are not delayed.
+         *
+         * \param nextNodeId function returning a unique node ID for each new component
+         */
+        void refillWarmComponents(const std::function<c2_node_id_t()> &nextNodeId) {
+            while (true) {
+                std::shared_ptr<ComponentModule> module;
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    if (mWarmComponents.size() >= mNumWarmInstances || !mPinnedModule) {
+                        return;
+                    }
+                    module = mPinnedModule;
+                }
+                std::shared_ptr<C2Component> component;
+                if (module->createComponent(nextNodeId(), &component) != C2_OK || !component) {
+                    ALOGD("failed to create warm instance of %s", mAlias.c_str());
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    if (mWarmComponents.size() < mNumWarmInstances) {
+                        mWarmComponents.push_back(std::move(component));
+                        continue;
+                    }
+                }
+                // the pool was shrunk while the component was being created
+                (void)component->release();
+                return;
+            }
+        }
+
+        /**
+         * \return true if the warm pool of this loader is not full.
+         */
+        bool needsRefill() {
+            std::lock_guard<std::mutex> lock(mMutex);
+            return mPinnedModule && mWarmComponents.size() < mNumWarmInstances;
+        }
+
+        /**
+         * Releases warm instances and unpins the module.
+         */
+        void clearWarmComponents() {
+            std::list<std::shared_ptr<C2Component>> components;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                components.swap(mWarmComponents);
+                mNumWarmInstances = 0;
+                mPinnedModule.reset();
+            }
+            for (const std::shared_ptr<C2Component> &component : components) {
+                (void)component->release();
+            }
+        }
+
         /**
          * Creates a component loader for a specific library path (or name).
          */
         ComponentLoader(std::string alias, std::string libPath)
-            : mAlias(alias), mLibPath(libPath) {}
+            : mAlias(alias), mLibPath(libPath), mNumWarmInstances(0) {}
 
     private:
-        std::mutex mMutex; ///< mutex guarding the module
+        c2_status_t fetchModule_l(std::shared_ptr<ComponentModule> *module) {
+            c2_status_t res = C2_OK;
+            std::shared_ptr<ComponentModule> localModule = mModule.lock();
+            if (localModule == nullptr) {
+                localModule = std::make_shared<ComponentModule>();
+                res = localModule->init(mAlias, mLibPath);
+                if (res == C2_OK) {
+                    mModule = localModule;
+                }
+            }
+            *module = localModule;
+            return res;
+        }
+
+        std::mutex mMutex; ///< mutex guarding the module and the warm pool
         std::weak_ptr<ComponentModule> mModule; ///< weak reference to the loaded module
         std::string mAlias; ///< component alias
         std::string mLibPath; ///< library path
+        std::shared_ptr<ComponentModule> mPinnedModule; ///< module kept loaded by prewarm()
+        size_t mNumWarmInstances; ///< target size of the warm pool
+        std::list<std::shared_ptr<C2Component>> mWarmComponents; ///< warm component instances
     };
 
     struct Interface : public C2InterfaceHelper {
@@ -642,10 +761,33 @@ private:
      */
     c2_status_t findComponent(C2String name, ComponentLoader **loader);
 
+    /**
+     * Wakes up the warm pool thread (starting it if needed) to refill the warm pools.
+     */
+    void requestWarmPoolRefill();
+
+    /**
+     * Main loop of the warm pool thread.
+     */
+    void warmPoolLoop();
+
+    /**
+     * \return a node ID not yet used by any component created by this store.
+     */
+    c2_node_id_t nextNodeId();
+
     std::map<C2String, ComponentLoader> mComponents; ///< map of name -> components
     std::vector<C2String> mComponentsList; ///< list of components
     std::shared_ptr<C2ReflectorHelper> mReflector;
     Interface mInterface;
+
+    std::mutex mWarmPoolMutex; ///< mutex guarding the warm pool thread state
+    std::condition_variable mWarmPoolCondition; ///< signaled when a refill is requested
+    bool mWarmPoolRefillRequested; ///< whether some warm pools need refilling
+    bool mWarmPoolStopping; ///< whether the warm pool thread shall exit
+    std::thread mWarmPoolThread; ///< thread creating warm component instances
+
+    std::atomic<c2_node_id_t> mNextNodeId; ///< node ID of the next created component
 };
 
 c2_status_t C2PlatformComponentStore::ComponentModule::init(
@@ -784,7 +926,10 @@ std::shared_ptr<const C2Component::Traits> C2PlatformComponentStore::ComponentMo
 
 C2PlatformComponentStore::C2PlatformComponentStore()
     : mReflector(std::make_shared<C2ReflectorHelper>()),
-      mInterface(mReflector) {
+      mInterface(mReflector),
+      mWarmPoolRefillRequested(false),
+      mWarmPoolStopping(false),
+      mNextNodeId(0) {
 
     auto emplace = [this](const char *alias, const char *libPath) {
         // ComponentLoader is neither copiable nor movable, so it must be
@@ -859,6 +1004,82 @@ C2PlatformComponentStore::C2PlatformComponentStore()
     emplace("OMX.google.xaac.decoder", "libstagefright_soft_c2xaacdec.so");
 }
 
+C2PlatformComponentStore::~C2PlatformComponentStore() {
+    {
+        std::lock_guard<std::mutex> lock(mWarmPoolMutex);
+        mWarmPoolStopping = true;
+    }
+    mWarmPoolCondition.notify_all();
+    if (mWarmPoolThread.joinable()) {
+        mWarmPoolThread.join();
+    }
+    for (auto &entry : mComponents) {
+        entry.second.clearWarmComponents();
+    }
+}
+
+c2_status_t C2PlatformComponentStore::prewarm(
+        const std::vector<C2String> &names, size_t warmInstances) {
+    c2_status_t res = C2_OK;
+    const std::vector<C2String> &aliases = names.empty() ? mComponentsList : names;
+    for (const C2String &alias : aliases) {
+        ComponentLoader *loader;
+        c2_status_t err = findComponent(alias, &loader);
+        if (err == C2_OK) {
+            err = loader->prewarm(warmInstances);
+        }
+        if (err != C2_OK) {
+            ALOGD("failed to prewarm %s: %d", alias.c_str(), err);
+            res = res ? res : err;
+        }
+    }
+    if (warmInstances > 0) {
+        requestWarmPoolRefill();
+    }
+    return res;
+}
+
+void C2PlatformComponentStore::requestWarmPoolRefill() {
+    std::lock_guard<std::mutex> lock(mWarmPoolMutex);
+    if (mWarmPoolStopping) {
+        return;
+    }
+    mWarmPoolRefillRequested = true;
+    if (!mWarmPoolThread.joinable()) {
+        mWarmPoolThread = std::thread(&C2PlatformComponentStore::warmPoolLoop, this);
+    }
+    mWarmPoolCondition.notify_one();
+}
+
+void C2PlatformComponentStore::warmPoolLoop() {
+    std::unique_lock<std::mutex> lock(mWarmPoolMutex);
+    while (true) {
+        mWarmPoolCondition.wait(lock, [this] {
+            return mWarmPoolStopping || mWarmPoolRefillRequested;
+        });
+        if (mWarmPoolStopping) {
+            return;
+        }
+        mWarmPoolRefillRequested = false;
+        lock.unlock();
+        for (auto &entry : mComponents) {
+            if (entry.second.needsRefill()) {
+                entry.second.refillWarmComponents([this] { return nextNodeId(); });
+            }
+            // do not delay shutdown by more than one component creation
+            std::lock_guard<std::mutex> stopLock(mWarmPoolMutex);
+            if (mWarmPoolStopping) {
+                return;
+            }
+        }
+        lock.lock();
+    }
+}
+
+c2_node_id_t C2PlatformComponentStore::nextNodeId() {
+    return mNextNodeId.fetch_add(1, std::memory_order_relaxed);
+}
+
 c2_status_t C2PlatformComponentStore::copyBuffer(
         std::shared_ptr<C2GraphicBuffer> src, std::shared_ptr<C2GraphicBuffer> dst) {
     (void)src;
@@ -914,11 +1135,14 @@ c2_status_t C2PlatformComponentStore::createComponent(
     ComponentLoader *loader;
     c2_status_t res = findComponent(name, &loader);
     if (res == C2_OK) {
+        if (loader->takeWarmComponent(component)) {
+            requestWarmPoolRefill();
+            return C2_OK;
+        }
         std::shared_ptr<ComponentModule> module;
         res = loader->fetchModule(&module);
         if (res == C2_OK) {
-            // TODO: get a unique node ID
-            res = module->createComponent(0, component);
+            res = module->createComponent(nextNodeId(), component);
         }
     }
     return res;
@@ -971,4 +1195,15 @@ std::shared_ptr<C2ComponentStore> GetCodec2PlatformComponentStore() {
     return store;
 }
 
+c2_status_t PrewarmCodec2PlatformComponentStore(
+        const std::shared_ptr<C2ComponentStore> &store,
+        const std::vector<C2String> &names,
+        size_t warmInstances) {
+    if (store == nullptr || store != GetCodec2PlatformComponentStore()) {
+        return C2_BAD_VALUE;
+    }
+    return std::static_pointer_cast<C2PlatformComponentStore>(store)->prewarm(
+            names, warmInstances);
+}
+
 } // namespace android
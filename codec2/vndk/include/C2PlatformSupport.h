@@ -123,6 +123,30 @@ c2_status_t CreateCodec2BlockPool(
  */
 std::shared_ptr<C2ComponentStore> GetCodec2PlatformComponentStore();
 
+/**
+ * Loads the modules of the given components of the platform component store ahead of time so that
+ * the first createComponent() or createInterface() call does not have to load them. The modules
+ * stay loaded for as long as |store| is alive.
+ *
+ * If |warmInstances| is positive, the store also keeps up to |warmInstances| created but never
+ * started instances of each of these components, and createComponent() hands these out. Warm
+ * pools are refilled on a background thread.
+ *
+ * \param store         the platform component store, as returned by
+ *                      GetCodec2PlatformComponentStore()
+ * \param names         names of the components to prewarm; all components if empty
+ * \param warmInstances number of warm instances to keep per component
+ *
+ * \retval C2_OK        the component modules were loaded
+ * \retval C2_BAD_VALUE |store| is not the platform component store
+ * \retval C2_NOT_FOUND some of the components are not known to the store
+ * \retval C2_CORRUPTED some of the component modules could not be loaded
+ */
+c2_status_t PrewarmCodec2PlatformComponentStore(
+        const std::shared_ptr<C2ComponentStore> &store,
+        const std::vector<C2String> &names,
+        size_t warmInstances = 0);
+
 /**
  * Sets the preferred component store in this process for the sole purpose of accessing its
  * interface. If this is not called, the default IComponentStore HAL (if exists) is the preferred
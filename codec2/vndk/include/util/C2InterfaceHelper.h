@@ -163,6 +163,16 @@ public:
         FieldHelper(const ParamRef &param, const _C2FieldId &field,
                     std::unique_ptr<C2FieldSupportedValues> &&values);
 
+        /**
+         * Creates helper for a field with possible values shared with other interface instances.
+         *
+         * \param param parameter reference
+         * \param field field identifier
+         * \param values shared possible values for the field
+         */
+        FieldHelper(const ParamRef &param, const _C2FieldId &field,
+                    std::shared_ptr<const C2FieldSupportedValues> values);
+
         /**
          * Creates a param-field identifier for this field. This method is called after the
          * underlying parameter has been initialized.
@@ -191,18 +201,63 @@ public:
          */
         const C2FieldSupportedValues *getPossibleValues() const;
 
+        /**
+         * Gets the possible values for this field so that they can be shared.
+         */
+        std::shared_ptr<const C2FieldSupportedValues> getSharedPossibleValues() const;
+
+        /**
+         * Gets a helper for checking values against the possible values of this field. The
+         * helper is created on first use and kept for the lifetime of this field.
+         *
+         * \param T the type of this field. This must be the same for all calls.
+         */
+        template<typename T>
+        const C2FieldSupportedValuesHelper<T> &getPossibleValuesHelper() const {
+            if (!mPossibleHelper) {
+                mPossibleHelper = std::make_shared<C2FieldSupportedValuesHelper<T>>(*mPossible);
+            }
+            return *std::static_pointer_cast<C2FieldSupportedValuesHelper<T>>(mPossibleHelper);
+        }
+
+        /**
+         * Gets a helper for checking values against the currently supported values of this
+         * field. The helper is created on first use and kept until the supported values change.
+         *
+         * \param T the type of this field. This must be the same for all calls.
+         */
+        template<typename T>
+        const C2FieldSupportedValuesHelper<T> &getSupportedValuesHelper() const {
+            if (!mSupported) {
+                return getPossibleValuesHelper<T>();
+            }
+            if (!mSupportedHelper) {
+                mSupportedHelper = std::make_shared<C2FieldSupportedValuesHelper<T>>(*mSupported);
+            }
+            return *std::static_pointer_cast<C2FieldSupportedValuesHelper<T>>(mSupportedHelper);
+        }
+
     protected:
         // TODO: move to impl for safety
         ParamRef mParam;
         _C2FieldId mFieldId;
-        std::unique_ptr<C2FieldSupportedValues> mPossible;
+        std::shared_ptr<const C2FieldSupportedValues> mPossible; ///< immutable, may be shared
         std::unique_ptr<C2FieldSupportedValues> mSupported; ///< if different from possible
+        // type-erased C2FieldSupportedValuesHelper<T> objects for the above
+        mutable std::shared_ptr<void> mPossibleHelper;
+        mutable std::shared_ptr<void> mSupportedHelper;
     };
 
     template<typename T>
     struct C2_HIDE Param;
     class ParamHelper;
 
+    /**
+     * Immutable declaration of a parameter (descriptor, default value and possible values of its
+     * fields) that is shared by all instances of an interface that use the same schema.
+     */
+    struct SchemaEntry;
+
     /**
      * Factory is an interface to get the parameter helpers from a std::shared_ptr<T> &.
      */
@@ -238,11 +293,11 @@ public:
         Field(std::shared_ptr<FieldHelper> helper, C2Param::Index index);
 
         bool supportsAtAll(T value) const {
-            return C2FieldSupportedValuesHelper<T>(*_mHelper->getPossibleValues()).supports(value);
+            return _mHelper->getPossibleValuesHelper<T>().supports(value);
         }
 
         bool supportsNow(T value) const {
-            return C2FieldSupportedValuesHelper<T>(*_mHelper->getSupportedValues()).supports(value);
+            return _mHelper->getSupportedValuesHelper<T>().supports(value);
         }
 
         /**
@@ -273,7 +328,11 @@ public:
 
     class ParamHelper {
     public:
-        ParamHelper(ParamRef param, C2StringLiteral name, C2StructDescriptor &&);
+        /**
+         * Constructor. |describe| creates the struct descriptor of the parameter. It is not
+         * called for parameters adopted from a shared schema.
+         */
+        ParamHelper(ParamRef param, C2StringLiteral name, C2StructDescriptor (*describe)());
         ParamHelper(ParamHelper &&);
         ~ParamHelper();
 
@@ -326,7 +385,7 @@ public:
         /// returns that parameter refs for parameters that depend on this
         const std::vector<ParamRef> getDependenciesAsRefs() const;
 
-        /// returns and moves out stored struct descriptor
+        /// creates the struct descriptor of this parameter
         C2StructDescriptor retrieveStructDescriptor();
 
         /// returns the name of this parameter
@@ -347,6 +406,26 @@ public:
          */
         c2_status_t validate(const std::shared_ptr<C2ParamReflector> &reflector);
 
+        /**
+         * Returns the shareable declaration of this parameter. This must be called after
+         * validate().
+         */
+        std::shared_ptr<const SchemaEntry> getSchemaEntry() const;
+
+        /**
+         * Adopts a shared declaration of this parameter built by another interface instance. This
+         * is used instead of validate(), and releases the values built for this instance that are
+         * part of the declaration.
+         *
+         * The declaration is only adopted if it matches this parameter, including its attributes,
+         * dependencies, default value and the possible values of its fields.
+         *
+         * \retval C2_OK        the declaration was adopted
+         * \retval C2_BAD_VALUE the declaration does not match this parameter. This parameter is
+         *                      not modified.
+         */
+        c2_status_t adopt(const std::shared_ptr<const SchemaEntry> &entry);
+
     protected:
         typedef C2ParamDescriptor::attrib_t attrib_t;
         attrib_t& attrib();
@@ -449,7 +528,7 @@ public:
     public:
         /** Construct the parameter builder from minimal info required. */
         ParamBuilder(std::shared_ptr<T> &param, C2StringLiteral name)
-            : ParamHelper(param, name, C2StructDescriptor((T*)nullptr)),
+            : ParamHelper(param, name, &DescribeStruct),
               mTypedParam(&param) {
             attrib() = attrib_t::IS_PERSISTENT;
         }
@@ -633,6 +712,11 @@ public:
 
     protected:
         std::shared_ptr<T> *mTypedParam;
+
+    private:
+        static C2StructDescriptor DescribeStruct() {
+            return C2StructDescriptor((T*)nullptr);
+        }
     };
 
     template<typename T>
@@ -641,6 +725,13 @@ public:
     }
 
 public:
+    /**
+     * Helper implementing query calls.
+     *
+     * This reads from the last published snapshot of the parameter values and does not take the
+     * interface lock, so queries never block on (or block) configuration. Snapshots are published
+     * atomically at the end of each config call that changes any value.
+     */
     c2_status_t query(
             const std::vector<C2Param*> &stackParams,
             const std::vector<C2Param::Index> &heapParamIndices,
@@ -698,9 +789,31 @@ protected:
     std::shared_ptr<C2ReflectorHelper> mReflector;
     struct FactoryImpl;
     std::shared_ptr<FactoryImpl> _mFactory;
+    struct Schema;
+    std::shared_ptr<Schema> mSchema; ///< shared schema or nullptr if not shared
+    struct ValueSnapshot;
+    /// last published parameter values, or nullptr if it needs to be created. This must be
+    /// accessed using std::atomic_load/store.
+    mutable std::shared_ptr<const ValueSnapshot> mSnapshot;
+    size_t mSchemaPosition; ///< number of parameters added (position in the shared schema)
 
     C2InterfaceHelper(std::shared_ptr<C2ReflectorHelper> reflector);
 
+    /**
+     * Shares the immutable part of the parameter declarations with all other instances of this
+     * interface that use the same |key| and reflector. The first instance builds the schema, and
+     * later instances adopt the parameter descriptors, default values and possible field values
+     * from it instead of allocating and validating their own copies.
+     *
+     * This must be called before adding any parameters, and all instances using the same key
+     * should add the same parameters in the same order. Each parameter is compared against the
+     * shared declaration, and an instance that adds a parameter that differs (e.g. in its default
+     * or possible values) stops sharing from that point on.
+     *
+     * \param key schema key, e.g. the component name
+     */
+    void shareSchema(const C2String &key);
+
     /**
      * Adds a parameter to this interface.
      * \note This method CHECKs.
@@ -716,6 +829,16 @@ protected:
      */
     size_t getDependencyIndex_l(C2Param::Index ix) const;
 
+    /**
+     * Returns the last published snapshot of the parameter values, creating it if needed.
+     */
+    std::shared_ptr<const ValueSnapshot> getSnapshot() const;
+
+    /**
+     * Creates and publishes a snapshot of the current parameter values. mMutex must be held.
+     */
+    std::shared_ptr<const ValueSnapshot> publishSnapshot_l() const;
+
     virtual ~C2InterfaceHelper() = default;
 
     /**
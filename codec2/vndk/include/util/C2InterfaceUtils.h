@@ -236,6 +236,21 @@ public:
      */
     C2SupportedRange<T> limitedTo(const C2SupportedRange<T> &limit) const;
 
+    /**
+     * Lists the values of this range in increasing order if it is a geometric or
+     * multiply-accumulate series of at most |maxCount| values.
+     *
+     * contains() evaluates such series for every value checked, so callers checking many values
+     * can look them up in the listed values instead.
+     *
+     * \param values   vector to receive the values of the series
+     * \param maxCount maximum number of values to list
+     *
+     * \return true if the values were listed, false if this range is not such a series, or if it
+     *         has more than |maxCount| values.
+     */
+    bool listSeries(std::vector<T> *values, size_t maxCount) const;
+
     /**
      * Converts this object to a C2FieldSupportedValues object.
      */
@@ -17,6 +17,10 @@
 #ifndef C2UTILS_PARAM_UTILS_H_
 #define C2UTILS_PARAM_UTILS_H_
 
+#include <C2Param.h>
+
+#include <memory>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -26,8 +30,6 @@
 
 /// \cond INTERNAL
 
-struct C2Param;
-
 class C2ParamUtils {
     friend class C2UtilTest_ParamUtilsTest_Test;
 
@@ -38,6 +40,69 @@ public:
     C2Param *ParseFirst(const uint8_t *blob, size_t size);
 };
 
+/**
+ * Arena for short-lived parameter copies.
+ *
+ * Parameters are allocated back-to-back in large chunks at 64-bit boundaries (the same layout as
+ * a params blob) and are owned by the arena. Pointers returned remain valid until clear() is
+ * called or the arena is destroyed, which releases all parameters at once. Chunks are retained
+ * across clear(), so an arena that is reused for each batch does not allocate in steady state.
+ *
+ * This class is not thread-safe.
+ */
+class C2ParamArena {
+public:
+    /// alignment of all parameters in the arena
+    constexpr static size_t ALIGNMENT = 8;
+
+    /// \param chunkSize minimum size of a chunk in bytes
+    explicit C2ParamArena(size_t chunkSize = 4096);
+    ~C2ParamArena() = default;
+
+    /**
+     * Returns uninitialized storage for |size| bytes aligned to ALIGNMENT, or nullptr if |size| is
+     * 0.
+     */
+    void *allocate(size_t size);
+
+    /// Returns a clone of |orig| in the arena, or nullptr if |orig| is invalid.
+    C2Param *copy(const C2Param &orig);
+
+    /// Returns a clone of |orig| as a stream parameter in the arena.
+    C2Param *copyAsStream(const C2Param &orig, bool output, unsigned stream);
+
+    /**
+     * Constructs a fixed-size parameter of type |T| in the arena. Destructors are never run on
+     * arena storage, so |T| must be trivially destructible (as all parameter structures are).
+     */
+    template<typename T, typename ...Args>
+    T *emplace(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "arena parameters must be trivially destructible");
+        return new (allocate(sizeof(T))) T(std::forward<Args>(args)...);
+    }
+
+    /// Releases all parameters in the arena. Previously returned pointers become invalid.
+    void clear();
+
+    /// Returns the number of bytes used in the arena.
+    size_t used() const;
+
+private:
+    struct Chunk {
+        std::unique_ptr<uint64_t[]> mData;
+        size_t mCapacity; ///< in bytes
+    };
+
+    const size_t mChunkSize;
+    std::vector<Chunk> mChunks;
+    size_t mCurrent; ///< index of the chunk currently being filled
+    size_t mOffset;  ///< bytes used in the current chunk
+    size_t mFilled;  ///< bytes used in the chunks before the current one
+
+    C2_DO_NOT_COPY(C2ParamArena);
+};
+
 /// \endcond
 
 #endif  // C2UTILS_PARAM_UTILS_H_
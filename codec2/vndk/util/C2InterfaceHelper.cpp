@@ -20,6 +20,9 @@
 
 #include <android-base/stringprintf.h>
 
+#include <algorithm>
+#include <atomic>
+
 using ::android::base::StringPrintf;
 
 /* --------------------------------- ReflectorHelper --------------------------------- */
@@ -65,10 +68,51 @@ void C2ReflectorHelper::addStructDescriptor(C2StructDescriptor &&strukt) {
 
 /* ---------------------------- ParamHelper ---------------------------- */
 
+namespace {
+
+/**
+ * Returns whether |a| and |b| are the same supported values of a field of |size| bytes. Values of
+ * fields of up to 4 bytes only set the low 32 bits of the primitives.
+ */
+bool SameSupportedValues(
+        const C2FieldSupportedValues *a, const C2FieldSupportedValues *b, size_t size) {
+    if (!a || !b) {
+        return a == b;
+    }
+    auto same = [size](const C2Value::Primitive &x, const C2Value::Primitive &y) {
+        return size > 4 ? x.u64 == y.u64 : x.u32 == y.u32;
+    };
+    if (a->type != b->type) {
+        return false;
+    }
+    switch (a->type) {
+        case C2FieldSupportedValues::RANGE:
+            return same(a->range.min, b->range.min) && same(a->range.max, b->range.max)
+                    && same(a->range.step, b->range.step) && same(a->range.num, b->range.num)
+                    && same(a->range.denom, b->range.denom);
+        case C2FieldSupportedValues::VALUES:
+        case C2FieldSupportedValues::FLAGS:
+            return std::equal(a->values.begin(), a->values.end(),
+                              b->values.begin(), b->values.end(), same);
+        default:
+            return true;
+    }
+}
+
+} // namespace
+
+struct C2InterfaceHelper::SchemaEntry {
+    C2Param::Index index = 0u;
+    _C2ParamInspector::attrib_t attrib;
+    std::shared_ptr<C2Param> defaultValue; ///< never modified
+    std::shared_ptr<C2ParamDescriptor> descriptor;
+    std::map<_C2FieldId, std::shared_ptr<const C2FieldSupportedValues>> possibleValues;
+};
+
 class C2InterfaceHelper::ParamHelper::Impl {
 public:
-    Impl(ParamRef param, C2StringLiteral name, C2StructDescriptor &&strukt)
-        : mParam(param), mName(name), _mStruct(strukt) { }
+    Impl(ParamRef param, C2StringLiteral name, C2StructDescriptor (*describe)())
+        : mParam(param), mName(name), mDescribe(describe) { }
 
     Impl(Impl&&) = default;
 
@@ -80,13 +124,6 @@ public:
         return mAttrib;
     }
 
-    void build() {
-        // move dependencies into descriptor
-        mDescriptor = std::make_shared<C2ParamDescriptor>(
-                index(), (C2ParamDescriptor::attrib_t)mAttrib,
-                std::move(mName), std::move(mDependencies));
-    }
-
     void createFieldsAndSupportedValues(const std::shared_ptr<C2ParamReflector> &reflector) {
         for (const C2FieldUtils::Info &f :
                 C2FieldUtils::enumerateFields(*mDefaultValue, reflector)) {
@@ -159,7 +196,7 @@ public:
     }
 
     C2StructDescriptor retrieveStructDescriptor() {
-        return std::move(_mStruct);
+        return mDescribe();
     }
 
     void setDefaultValue(std::shared_ptr<C2Param> default_) {
@@ -207,6 +244,11 @@ public:
     }
 
     c2_status_t validate(const std::shared_ptr<C2ParamReflector> &reflector) {
+        // adopted parameters use the descriptor of the shared declaration instead
+        mDescriptor = std::make_shared<C2ParamDescriptor>(
+                index(), (C2ParamDescriptor::attrib_t)mAttrib,
+                C2String(mName), std::vector<C2Param::Index>(mDependencies));
+
         if (!mSetter && mFields.empty()) {
             C2_LOG(WARNING) << "Param " << mName << " has no setter, making it const";
             // dependencies are empty in this case
@@ -228,6 +270,73 @@ public:
         return C2_OK;
     }
 
+    std::shared_ptr<const SchemaEntry> getSchemaEntry() const {
+        std::shared_ptr<SchemaEntry> entry = std::make_shared<SchemaEntry>();
+        entry->index = index();
+        entry->attrib = mAttrib;
+        entry->defaultValue = mDefaultValue;
+        entry->descriptor = mDescriptor;
+        for (const auto &it : mFields) {
+            entry->possibleValues.emplace_hint(
+                    entry->possibleValues.end(), it.first, it.second->getSharedPossibleValues());
+        }
+        return entry;
+    }
+
+    c2_status_t adopt(const std::shared_ptr<const SchemaEntry> &entry) {
+        if (!matches(*entry)) {
+            return C2_BAD_VALUE;
+        }
+        // the struct descriptor has already been added to the reflector by the schema builder
+        mAttrib = entry->attrib;
+        mDefaultValue = entry->defaultValue;
+        mDescriptor = entry->descriptor;
+        mFields.clear();
+        for (const auto &it : entry->possibleValues) {
+            mFields.emplace_hint(
+                    mFields.end(), it.first,
+                    std::make_shared<FieldHelper>(mParam, it.first, it.second));
+        }
+        return C2_OK;
+    }
+
+    /**
+     * Returns whether this parameter, before validation, declares the same as |entry|.
+     */
+    bool matches(const SchemaEntry &entry) const {
+        if (!mDefaultValue || entry.index != index() || entry.descriptor->name() != mName
+                || entry.descriptor->dependencies() != mDependencies
+                || !(*entry.defaultValue == *mDefaultValue)) {
+            return false;
+        }
+        // validate() makes parameters without setter and fields const
+        attrib_t attrib = mAttrib;
+        if (!mSetter && mFields.empty()) {
+            attrib |= attrib_t::IS_CONST;
+        }
+        if (attrib != entry.attrib) {
+            return false;
+        }
+        // possible values of const parameters are derived from their type
+        if (attrib & attrib_t::IS_CONST) {
+            return true;
+        }
+        if (mFields.size() != entry.possibleValues.size()) {
+            return false;
+        }
+        auto it = entry.possibleValues.begin();
+        for (const auto &field : mFields) {
+            if (!(field.first == it->first)
+                    || !SameSupportedValues(
+                            field.second->getPossibleValues(), it->second.get(),
+                            _C2ParamInspector::GetSize(field.first))) {
+                return false;
+            }
+            ++it;
+        }
+        return true;
+    }
+
     std::shared_ptr<C2Param> value() {
         return mParam.get();
     }
@@ -240,7 +349,7 @@ private:
     typedef _C2ParamInspector::attrib_t attrib_t;
     ParamRef mParam;
     C2String mName;
-    C2StructDescriptor _mStruct;
+    C2StructDescriptor (*mDescribe)();
     std::shared_ptr<C2Param> mDefaultValue;
     attrib_t mAttrib;
     std::function<C2R(const C2Param *, bool, bool *, Factory &)> mSetter;
@@ -253,9 +362,8 @@ private:
 };
 
 C2InterfaceHelper::ParamHelper::ParamHelper(
-        ParamRef param, C2StringLiteral name, C2StructDescriptor &&strukt)
-    : mImpl(std::make_unique<C2InterfaceHelper::ParamHelper::Impl>(
-            param, name, std::move(strukt))) { }
+        ParamRef param, C2StringLiteral name, C2StructDescriptor (*describe)())
+    : mImpl(std::make_unique<C2InterfaceHelper::ParamHelper::Impl>(param, name, describe)) { }
 
 C2InterfaceHelper::ParamHelper::ParamHelper(C2InterfaceHelper::ParamHelper &&) = default;
 
@@ -270,7 +378,6 @@ C2InterfaceHelper::ParamHelper::attrib_t& C2InterfaceHelper::ParamHelper::attrib
 }
 
 std::shared_ptr<C2InterfaceHelper::ParamHelper> C2InterfaceHelper::ParamHelper::build() {
-    mImpl->build();
     return std::make_shared<C2InterfaceHelper::ParamHelper>(std::move(*this));
 }
 
@@ -343,6 +450,16 @@ c2_status_t C2InterfaceHelper::ParamHelper::validate(
     return mImpl->validate(reflector);
 }
 
+std::shared_ptr<const C2InterfaceHelper::SchemaEntry>
+C2InterfaceHelper::ParamHelper::getSchemaEntry() const {
+    return mImpl->getSchemaEntry();
+}
+
+c2_status_t C2InterfaceHelper::ParamHelper::adopt(
+        const std::shared_ptr<const SchemaEntry> &entry) {
+    return mImpl->adopt(entry);
+}
+
 std::shared_ptr<C2Param> C2InterfaceHelper::ParamHelper::value() {
     return mImpl->value();
 }
@@ -366,19 +483,32 @@ C2InterfaceHelper::FieldHelper::FieldHelper(const ParamRef &param, const _C2Fiel
             << C2FieldSupportedValuesHelper<uint32_t>(*mPossible);
 }
 
+C2InterfaceHelper::FieldHelper::FieldHelper(const ParamRef &param, const _C2FieldId &field,
+            std::shared_ptr<const C2FieldSupportedValues> values)
+    : mParam(param),
+      mFieldId(field),
+      mPossible(values) {
+}
+
 void C2InterfaceHelper::FieldHelper::setSupportedValues(
         std::unique_ptr<C2FieldSupportedValues> &&values) {
     mSupported = std::move(values);
+    mSupportedHelper.reset();
 }
 
 const C2FieldSupportedValues *C2InterfaceHelper::FieldHelper::getSupportedValues() const {
-    return (mSupported ? mSupported : mPossible).get();
+    return mSupported ? mSupported.get() : mPossible.get();
 }
 
 const C2FieldSupportedValues *C2InterfaceHelper::FieldHelper::getPossibleValues() const {
     return mPossible.get();
 }
 
+std::shared_ptr<const C2FieldSupportedValues>
+C2InterfaceHelper::FieldHelper::getSharedPossibleValues() const {
+    return mPossible;
+}
+
 
 /* ---------------------------- Field ---------------------------- */
 
@@ -438,6 +568,28 @@ template struct C2InterfaceHelper::Field<uint64_t>;
 //template struct C2InterfaceHelper::Field<c2_cntr64_t>;
 template struct C2InterfaceHelper::Field<float>;
 
+/* --------------------------------- Snapshot --------------------------------- */
+
+/**
+ * Immutable snapshot of the parameter values of an interface.
+ *
+ * Parameter values are copy-on-write (setters replace the value instead of modifying it), so a
+ * snapshot only needs to hold on to the current value objects.
+ */
+struct C2InterfaceHelper::ValueSnapshot {
+    typedef std::pair<C2Param::Index, std::shared_ptr<const C2Param>> Entry;
+
+    /// values sorted by parameter index
+    std::vector<Entry> values;
+
+    std::shared_ptr<const C2Param> find(C2Param::Index ix) const {
+        auto it = std::lower_bound(
+                values.begin(), values.end(), ix,
+                [](const Entry &entry, C2Param::Index index) { return entry.first < index; });
+        return (it != values.end() && it->first == ix) ? it->second : nullptr;
+    }
+};
+
 /* --------------------------------- Factory --------------------------------- */
 
 struct C2InterfaceHelper::FactoryImpl : public C2InterfaceHelper::Factory {
@@ -458,7 +610,10 @@ public:
 
     void addParam(std::shared_ptr<ParamHelper> param) {
         _mParams.insert({ param->ref(), param });
-        _mIndexToHelper.insert({param->index(), param});
+
+        // Parameters are added after their dependencies, so the order of addition is a
+        // topological order of the dependency graph. Use it as the dependency index.
+        size_t depIx = _mParamsInOrder.size();
 
         // add down-dependencies (and validate dependencies as a result)
         size_t ix = 0;
@@ -468,20 +623,40 @@ public:
                 C2_LOG(FATAL) << "Parameter " << param->name() << " has a dependency at index "
                         << ix << " that is not yet defined";
             }
-            _mParams.find(ref)->second->addDownDependency(param->index());
+            std::shared_ptr<ParamHelper> dep = _mParams.find(ref)->second;
+            dep->addDownDependency(param->index());
+            _mDownDependencies[getDependencyIndex(dep->index())].push_back(depIx);
             ++ix;
         }
 
-        _mDependencyIndex.emplace(param->index(), _mDependencyIndex.size());
+        _mDependencyIndex.emplace(param->index(), depIx);
+        _mParamsInOrder.push_back(param);
+        _mDownDependencies.emplace_back();
+        _mDirty.push_back(false);
+    }
+
+    /// returns the parameter at dependency index |depIx|
+    const std::shared_ptr<ParamHelper> &getParamAt(size_t depIx) const {
+        return _mParamsInOrder[depIx];
+    }
+
+    /// returns the dependency indices of the parameters that depend on the one at |depIx|
+    const std::vector<size_t> &getDownDependencyIndices(size_t depIx) const {
+        return _mDownDependencies[depIx];
+    }
+
+    /// returns the per-parameter dirty flags used by config (indexed by dependency index)
+    std::vector<char> &getDirtyFlags() {
+        return _mDirty;
     }
 
     std::shared_ptr<ParamHelper> getParam(C2Param::Index ix) const {
         // TODO: handle streams separately
-        const auto it = _mIndexToHelper.find(ix);
-        if (it == _mIndexToHelper.end()) {
+        const auto it = _mDependencyIndex.find(ix);
+        if (it == _mDependencyIndex.end()) {
             return nullptr;
         }
-        return it->second;
+        return _mParamsInOrder[it->second];
     }
 
     /**
@@ -492,6 +667,16 @@ public:
         return helper ? helper->value() : nullptr;
     }
 
+    std::shared_ptr<const ValueSnapshot> createSnapshot() const {
+        std::shared_ptr<ValueSnapshot> snapshot = std::make_shared<ValueSnapshot>();
+        snapshot->values.reserve(_mDependencyIndex.size());
+        // _mDependencyIndex is sorted by index
+        for (const auto &it : _mDependencyIndex) {
+            snapshot->values.emplace_back(it.first, _mParamsInOrder[it.second]->value());
+        }
+        return snapshot;
+    }
+
     c2_status_t querySupportedParams(
             std::vector<std::shared_ptr<C2ParamDescriptor>> *const params) const {
         for (const auto &it : _mParams) {
@@ -512,9 +697,74 @@ public:
 
 private:
     std::map<ParamRef, std::shared_ptr<ParamHelper>> _mParams;
-    std::map<C2Param::Index, std::shared_ptr<ParamHelper>> _mIndexToHelper;
     std::shared_ptr<C2ParamReflector> _mReflector;
     std::map<C2Param::Index, size_t> _mDependencyIndex;
+    std::vector<std::shared_ptr<ParamHelper>> _mParamsInOrder; ///< by dependency index
+    std::vector<std::vector<size_t>> _mDownDependencies; ///< by dependency index
+    std::vector<char> _mDirty; ///< by dependency index
+};
+
+/* --------------------------------- Schema --------------------------------- */
+
+/**
+ * Parameter declarations shared by interface instances with the same schema key and reflector.
+ *
+ * Entries are appended in declaration order by whichever instance adds a parameter at a given
+ * position first, and are immutable afterwards.
+ */
+struct C2InterfaceHelper::Schema {
+    /**
+     * Returns the schema for |key| and |reflector|, creating it if needed.
+     */
+    static std::shared_ptr<Schema> Get(
+            const std::shared_ptr<C2ReflectorHelper> &reflector, const C2String &key) {
+        typedef std::pair<const C2ReflectorHelper *, C2String> Key;
+        struct Value {
+            std::weak_ptr<C2ReflectorHelper> reflector;
+            std::shared_ptr<Schema> schema;
+        };
+        static std::mutex sLock;
+        static std::map<Key, Value> sSchemas;
+
+        std::lock_guard<std::mutex> lock(sLock);
+        // drop the schemas of released reflectors
+        for (auto it = sSchemas.begin(); it != sSchemas.end(); ) {
+            if (it->second.reflector.expired()) {
+                it = sSchemas.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        Value &value = sSchemas[Key(reflector.get(), key)];
+        // a different reflector may have been allocated at the same address
+        if (!value.schema || value.reflector.lock() != reflector) {
+            value.reflector = reflector;
+            value.schema = std::make_shared<Schema>();
+        }
+        return value.schema;
+    }
+
+    /**
+     * Returns the entry at |position|, or nullptr if no instance has added it yet.
+     */
+    std::shared_ptr<const SchemaEntry> get(size_t position) const {
+        std::lock_guard<std::mutex> lock(mLock);
+        return position < mEntries.size() ? mEntries[position] : nullptr;
+    }
+
+    /**
+     * Publishes |entry| at |position| unless another instance has already done so.
+     */
+    void publish(size_t position, const std::shared_ptr<const SchemaEntry> &entry) {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (position == mEntries.size()) {
+            mEntries.push_back(entry);
+        }
+    }
+
+private:
+    mutable std::mutex mLock;
+    std::vector<std::shared_ptr<const SchemaEntry>> mEntries;
 };
 
 /* --------------------------------- Helper --------------------------------- */
@@ -537,7 +787,17 @@ static std::string asString(C2Param *p) {
 
 C2InterfaceHelper::C2InterfaceHelper(std::shared_ptr<C2ReflectorHelper> reflector)
     : mReflector(reflector),
-      _mFactory(std::make_shared<FactoryImpl>(reflector)) { }
+      _mFactory(std::make_shared<FactoryImpl>(reflector)),
+      mSchemaPosition(0) { }
+
+void C2InterfaceHelper::shareSchema(const C2String &key) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mSchema || mSchemaPosition != 0) {
+        C2_LOG(WARNING) << "Schema " << key << " must be shared before adding parameters";
+        return;
+    }
+    mSchema = Schema::Get(mReflector, key);
+}
 
 
 size_t C2InterfaceHelper::GetBaseOffset(const std::shared_ptr<C2ParamReflector> &reflector,
@@ -575,15 +835,34 @@ size_t C2InterfaceHelper::GetBaseOffset(const std::shared_ptr<C2ParamReflector>
 
 void C2InterfaceHelper::addParameter(std::shared_ptr<ParamHelper> param) {
     std::lock_guard<std::mutex> lock(mMutex);
-    mReflector->addStructDescriptor(param->retrieveStructDescriptor());
-    c2_status_t err = param->validate(mReflector);
+    std::shared_ptr<const SchemaEntry> entry;
+    if (mSchema) {
+        entry = mSchema->get(mSchemaPosition);
+    }
+    c2_status_t err = C2_OK;
+    if (!entry || param->adopt(entry) != C2_OK) {
+        if (entry) {
+            C2_LOG(WARNING) << "Param " << param->name()
+                    << " does not match shared schema; no longer sharing";
+            mSchema.reset();
+        }
+        mReflector->addStructDescriptor(param->retrieveStructDescriptor());
+        err = param->validate(mReflector);
+        if (mSchema && err != C2_CORRUPTED) {
+            mSchema->publish(mSchemaPosition, param->getSchemaEntry());
+        }
+    }
     if (err != C2_CORRUPTED) {
+        ++mSchemaPosition;
         _mFactory->addParam(param);
 
         // run setter to ensure correct values
         bool changed = false;
         std::vector<std::unique_ptr<C2SettingResult>> failures;
         (void)param->trySet(param->value().get(), C2_MAY_BLOCK, &changed, *_mFactory, &failures);
+
+        // recreate snapshot on next query
+        std::atomic_store(&mSnapshot, std::shared_ptr<const ValueSnapshot>());
     }
 }
 
@@ -599,15 +878,19 @@ c2_status_t C2InterfaceHelper::config(
     bool paramBlocking = false;
     bool paramTimedOut = false;
     bool paramCorrupted = false;
+    bool anyChanged = false;
 
     // dependencies
-    // down dependencies are marked dirty, but params set are not immediately
-    // marked dirty (unless they become down dependency) so that we can
-    // avoid setting them if they did not change
-
-    // TODO: there could be multiple indices for the same dependency index
-    // { depIx, paramIx } may be a suitable key
-    std::map<size_t, std::pair<C2Param::Index, bool>> dependencies;
+    // Parameters are set in dependency order (the order they were added in), which is a
+    // topological order of the dependency graph precomputed by the factory. Down dependencies of
+    // changed parameters are marked dirty, but params set are not immediately marked dirty
+    // (unless they become down dependency) so that we can avoid setting them if they did not
+    // change.
+    //
+    // The dirty flags are owned by the factory (as config is serialized) and are all cleared by
+    // the time this method returns.
+    std::vector<char> &dirty = _mFactory->getDirtyFlags();
+    size_t firstDirty = dirty.size(); // lowest dirty dependency index
 
     // we cannot determine the last valid parameter, so add an extra
     // loop iteration after the last parameter
@@ -631,37 +914,33 @@ c2_status_t C2InterfaceHelper::config(
                 paramNotFound = true;
                 continue;
             }
-
-            //
-            // first insert - mark not dirty
-            // it may have been marked dirty by a dependency update
-            // this does not overrwrite(!)
-            (void)dependencies.insert({ paramDepIx, { paramIx, false /* dirty */ }});
-            auto it = dependencies.find(paramDepIx);
-            C2_LOG(VERBOSE) << "marking dependency for setting at #" << paramDepIx << ": "
-                    << it->second.first << ", update "
-                    << (it->second.second ? "always (dirty)" : "only if changed");
+            C2_LOG(VERBOSE) << "setting #" << paramDepIx << ": " << paramIx << ", update "
+                    << (dirty[paramDepIx] ? "always (dirty)" : "only if changed");
         } else {
             // process any remaining dependencies
-            if (dependencies.empty()) {
+            if (firstDirty == dirty.size()) {
                 continue;
             }
             C2_LOG(VERBOSE) << "handling dirty down dependencies after last setting";
         }
 
-        // process any dirtied down-dependencies until the next param
-        while (dependencies.size() && dependencies.begin()->first <= paramDepIx) {
-            auto min = dependencies.begin();
-            C2Param::Index ix = min->second.first;
-            bool dirty = min->second.second;
-            dependencies.erase(min);
+        // process any dirtied down-dependencies until (and including) the next param
+        size_t end = last ? dirty.size() : paramDepIx + 1;
+        for (size_t depIx = std::min(firstDirty, paramDepIx); depIx < end; ++depIx) {
+            bool isParam = !last && depIx == paramDepIx;
+            if (!dirty[depIx] && !isParam) {
+                continue;
+            }
+            bool wasDirty = dirty[depIx];
+            dirty[depIx] = false;
 
-            std::shared_ptr<ParamHelper> param = _mFactory->getParam(ix);
+            std::shared_ptr<ParamHelper> param = _mFactory->getParamAt(depIx);
+            C2Param::Index ix = param->index();
             C2_LOG(VERBOSE) << "old value " << asString(param->value().get());
-            if (!last) {
+            if (isParam) {
                 C2_LOG(VERBOSE) << "new value " << asString(p);
             }
-            if (!last && !dirty && ix == paramIx && *param->value() == *p) {
+            if (isParam && !wasDirty && *param->value() == *p) {
                 // no change in value - and dependencies were not updated
                 // no need to update
                 C2_LOG(VERBOSE) << "ignoring setting unchanged param " << ix;
@@ -673,7 +952,7 @@ c2_status_t C2InterfaceHelper::config(
             C2_LOG(VERBOSE) << "setting param " << ix;
             std::shared_ptr<C2Param> oldValue = param->value();
             c2_status_t res = param->trySet(
-                    (!last && paramIx == ix) ? p : param->value().get(), mayBlock,
+                    isParam ? p : param->value().get(), mayBlock,
                     &changed, *_mFactory, failures);
             std::shared_ptr<C2Param> newValue = param->value();
             C2_CHECK_EQ(oldValue == newValue, *oldValue == *newValue);
@@ -688,7 +967,7 @@ c2_status_t C2InterfaceHelper::config(
             }
 
             // copy back result for configured values (or invalidate if it does not fit or match)
-            if (updateParams && !last && paramIx == ix) {
+            if (updateParams && isParam) {
                 if (!p->updateFrom(*param->value())) {
                     p->invalidate();
                 }
@@ -696,23 +975,23 @@ c2_status_t C2InterfaceHelper::config(
 
             // compare ptrs as params are copy on write
             if (changed) {
+                anyChanged = true;
                 C2_LOG(VERBOSE) << "param " << ix << " value changed";
-                // value changed update down-dependencies and mark them dirty
-                for (const C2Param::Index ix : param->getDownDependencies()) {
-                    C2_LOG(VERBOSE) << 1;
-                    auto insert_res = dependencies.insert(
-                            { getDependencyIndex_l(ix), { ix, true /* dirty */ }});
-                    if (!insert_res.second) {
-                        (*insert_res.first).second.second = true; // mark dirty
-                    }
-
-                    auto it = dependencies.find(getDependencyIndex_l(ix));
-                    C2_CHECK(it->second.second);
-                    C2_LOG(VERBOSE) << "marking down dependencies to update at #"
-                            << getDependencyIndex_l(ix) << ": " << it->second.first;
+                // value changed update down-dependencies and mark them dirty. Down dependencies
+                // always follow this parameter in dependency order.
+                for (size_t downIx : _mFactory->getDownDependencyIndices(depIx)) {
+                    dirty[downIx] = true;
+                    C2_LOG(VERBOSE) << "marking down dependencies to update at #" << downIx;
                 }
             }
         }
+        // all flags before |end| are cleared, but flags after it may have been set while handling
+        // this or any earlier param
+        firstDirty = std::find(dirty.begin() + end, dirty.end(), true) - dirty.begin();
+    }
+
+    if (anyChanged) {
+        publishSnapshot_l();
     }
 
     return (paramCorrupted ? C2_CORRUPTED :
@@ -727,12 +1006,33 @@ size_t C2InterfaceHelper::getDependencyIndex_l(C2Param::Index ix) const {
     return _mFactory->getDependencyIndex(ix);
 }
 
+std::shared_ptr<const C2InterfaceHelper::ValueSnapshot> C2InterfaceHelper::getSnapshot() const {
+    std::shared_ptr<const ValueSnapshot> snapshot = std::atomic_load(&mSnapshot);
+    if (!snapshot) {
+        // parameters were added since the last snapshot. This only happens before the first
+        // query after construction.
+        std::lock_guard<std::mutex> lock(mMutex);
+        snapshot = std::atomic_load(&mSnapshot);
+        if (!snapshot) {
+            snapshot = publishSnapshot_l();
+        }
+    }
+    return snapshot;
+}
+
+std::shared_ptr<const C2InterfaceHelper::ValueSnapshot>
+C2InterfaceHelper::publishSnapshot_l() const {
+    std::shared_ptr<const ValueSnapshot> snapshot = _mFactory->createSnapshot();
+    std::atomic_store(&mSnapshot, snapshot);
+    return snapshot;
+}
+
 c2_status_t C2InterfaceHelper::query(
         const std::vector<C2Param*> &stackParams,
         const std::vector<C2Param::Index> &heapParamIndices,
         c2_blocking_t mayBlock __unused /* TODO */,
         std::vector<std::unique_ptr<C2Param>>* const heapParams) const {
-    std::lock_guard<std::mutex> lock(mMutex);
+    std::shared_ptr<const ValueSnapshot> snapshot = getSnapshot();
     bool paramWasInvalid = false;
     bool paramNotFound = false;
     bool paramDidNotFit = false;
@@ -743,7 +1043,7 @@ c2_status_t C2InterfaceHelper::query(
             paramWasInvalid = true;
             p->invalidate();
         } else {
-            std::shared_ptr<C2Param> value = _mFactory->getParamValue(p->index());
+            std::shared_ptr<const C2Param> value = snapshot->find(p->index());
             if (!value) {
                 paramNotFound = true;
                 p->invalidate();
@@ -755,7 +1055,7 @@ c2_status_t C2InterfaceHelper::query(
     }
 
     for (const C2Param::Index ix : heapParamIndices) {
-        std::shared_ptr<C2Param> value = _mFactory->getParamValue(ix);
+        std::shared_ptr<const C2Param> value = snapshot->find(ix);
         if (value) {
             std::unique_ptr<C2Param> p = C2Param::Copy(*value);
             if (p != nullptr) {
@@ -27,6 +27,7 @@
 #include <C2ParamInternal.h>
 #include <util/C2InterfaceUtils.h>
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <map>
@@ -132,6 +133,51 @@ bool C2SupportedRange<T>::contains(T value) const {
     return false;
 }
 
+template<typename T>
+bool C2SupportedRange<T>::listSeries(std::vector<T> *values, size_t maxCount) const {
+    values->clear();
+    if (_mMin > _mMax || isSimpleRange() || isArithmeticSeries()) {
+        return false;
+    }
+    // these must match the evaluation in contains()
+    if (isGeometricSeries()) {
+        double base = _mNum / _mDenom;
+        if (!(base > 1)) {
+            return false; // series does not progress
+        }
+        for (double power = 0; ; ++power) {
+            double value = _mMin * pow(base, power) + MIN_STEP / 2;
+            // compare after the conversion to T, like contains() does, so that values rounding
+            // down to |_mMax| are listed. Values beyond T's range cannot be converted.
+            if (value >= double(MAX_VALUE) + 1 || T(value) > _mMax) {
+                break;
+            } else if (values->size() == maxCount) {
+                return false;
+            }
+            values->push_back(T(value));
+        }
+    } else if (isMacSeries()) {
+        double lastValue = _mMin;
+        double base = _mNum / _mDenom;
+        while (true) {
+            if (values->size() == maxCount) {
+                return false;
+            }
+            values->push_back(T(lastValue + MIN_STEP / 2));
+            double nextValue = fma(lastValue, base, _mStep);
+            if (nextValue <= lastValue || nextValue > _mMax) {
+                break;
+            }
+            lastValue = nextValue;
+        }
+    } else {
+        return false;
+    }
+    // rounding may produce repeated values
+    values->erase(std::unique(values->begin(), values->end()), values->end());
+    return true;
+}
+
 template<typename T>
 C2SupportedRange<T> C2SupportedRange<T>::limitedTo(const C2SupportedRange<T> &limit) const {
     // TODO - this only works for simple ranges
@@ -306,30 +352,69 @@ template class C2SupportedValueSet<float>;
 
 /* ---------------------- C2FieldSupportedValuesHelper ---------------------- */
 
+/**
+ * Maximum number of values of a geometric or multiply-accumulate series that are listed for
+ * lookup. Longer series are evaluated for each value.
+ */
+constexpr size_t kMaxListedSeriesValues = 1024;
+
 template<typename T>
 struct C2FieldSupportedValuesHelper<T>::Impl {
     Impl(const C2FieldSupportedValues &values)
         : _mType(values.type),
           _mRange(values),
           _mValues(values),
-          _mFlags(values) { }
+          _mFlags(values),
+          _mUseSortedValues(false) {
+        compile();
+    }
 
     bool supports(T value) const;
 
 private:
     typedef typename _C2FieldValueHelper<T>::ValueType ValueType;
+    // NOTE: C2Debug.cpp relies on the layout of the members up to and including _mFlags
     C2FieldSupportedValues::type_t _mType;
     C2SupportedRange<ValueType> _mRange;
     C2SupportedValueSet<ValueType> _mValues;
-    C2SupportedValueSet<ValueType> _mFlags;
+    C2SupportedFlags<ValueType> _mFlags;
+
+    /**
+     * Precomputes a sorted list of the supported values for value sets and for series ranges, so
+     * that supports() is a binary search (instead of a linear search or a series evaluation).
+     */
+    void compile();
+
+    bool _mUseSortedValues; ///< whether to look up values in _mSortedValues
+    std::vector<ValueType> _mSortedValues; ///< all supported values in increasing order
 
 //    friend std::ostream& operator<< <T>(std::ostream& os, const C2FieldSupportedValuesHelper<T>::Impl &i);
 //    friend std::ostream& operator<<(std::ostream& os, const Impl &i);
     std::ostream& streamOut(std::ostream& os) const;
 };
 
+template<typename T>
+void C2FieldSupportedValuesHelper<T>::Impl::compile() {
+    if (_mType == C2FieldSupportedValues::VALUES) {
+        _mSortedValues = _mValues.values();
+        // NaN is never supported (as it is not equal to itself), and cannot be sorted
+        _mSortedValues.erase(
+                std::remove_if(_mSortedValues.begin(), _mSortedValues.end(),
+                               [](ValueType v) { return v != v; }),
+                _mSortedValues.end());
+        std::sort(_mSortedValues.begin(), _mSortedValues.end());
+        _mUseSortedValues = true;
+    } else if (_mType == C2FieldSupportedValues::RANGE) {
+        // series are listed in increasing order
+        _mUseSortedValues = _mRange.listSeries(&_mSortedValues, kMaxListedSeriesValues);
+    }
+}
+
 template<typename T>
 bool C2FieldSupportedValuesHelper<T>::Impl::supports(T value) const {
+    if (_mUseSortedValues) {
+        return std::binary_search(_mSortedValues.begin(), _mSortedValues.end(), ValueType(value));
+    }
     switch (_mType) {
         case C2FieldSupportedValues::RANGE: return _mRange.contains(value);
         case C2FieldSupportedValues::VALUES: return _mValues.contains(value);
@@ -19,6 +19,7 @@
 #include <util/C2Debug-log.h>
 #include <util/C2ParamUtils.h>
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -207,3 +208,61 @@ C2Param *C2ParamUtils::ParseFirst(const uint8_t *blob, size_t size) {
     return param;
 }
 
+
+/* ------------------------------------- C2ParamArena ------------------------------------- */
+
+C2ParamArena::C2ParamArena(size_t chunkSize)
+    : mChunkSize(chunkSize),
+      mCurrent(0),
+      mOffset(0),
+      mFilled(0) {
+}
+
+void *C2ParamArena::allocate(size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+    size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    while (mCurrent < mChunks.size()) {
+        Chunk &chunk = mChunks[mCurrent];
+        if (chunk.mCapacity - mOffset >= size) {
+            void *mem = reinterpret_cast<uint8_t*>(chunk.mData.get()) + mOffset;
+            mOffset += size;
+            return mem;
+        }
+        // the tail of this chunk is wasted until the next clear()
+        mFilled += chunk.mCapacity;
+        ++mCurrent;
+        mOffset = 0;
+    }
+    size_t capacity = std::max(size, mChunkSize);
+    mChunks.push_back({ std::unique_ptr<uint64_t[]>(
+            new uint64_t[(capacity + sizeof(uint64_t) - 1) / sizeof(uint64_t)]), capacity });
+    mCurrent = mChunks.size() - 1;
+    mOffset = size;
+    return mChunks.back().mData.get();
+}
+
+C2Param *C2ParamArena::copy(const C2Param &orig) {
+    if (orig.size() == 0) {
+        return nullptr;
+    }
+    return C2Param::CopyTo(allocate(orig.size()), orig);
+}
+
+C2Param *C2ParamArena::copyAsStream(const C2Param &orig, bool output, unsigned stream) {
+    if (orig.size() == 0) {
+        return nullptr;
+    }
+    return C2Param::CopyToAsStream(allocate(orig.size()), orig, output, stream);
+}
+
+void C2ParamArena::clear() {
+    mCurrent = 0;
+    mOffset = 0;
+    mFilled = 0;
+}
+
+size_t C2ParamArena::used() const {
+    return mFilled + mOffset;
+}
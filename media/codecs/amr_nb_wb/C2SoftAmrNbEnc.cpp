@@ -34,6 +34,7 @@ class C2SoftAmrNbEnc::IntfImpl : public C2InterfaceHelper {
     explicit IntfImpl(const std::shared_ptr<C2ReflectorHelper>& helper)
         : C2InterfaceHelper(helper) {
         setDerivedInstance(this);
+        shareSchema(COMPONENT_NAME);
 
         addParameter(
             DefineParam(mInputFormat, C2_NAME_INPUT_STREAM_FORMAT_SETTING)
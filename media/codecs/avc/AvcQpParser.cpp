@@ -0,0 +1,259 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "AvcQpParser"
+#include <log/log.h>
+
+#include <string.h>
+
+#include "AvcQpParser.h"
+
+namespace android {
+
+namespace {
+
+enum : uint32_t {
+    NAL_SLICE = 1,
+    NAL_IDR_SLICE = 5,
+    NAL_SPS = 7,
+    NAL_PPS = 8,
+};
+
+enum : uint32_t {
+    SLICE_P = 0,
+    SLICE_B = 1,
+    SLICE_I = 2,
+    SLICE_SP = 3,
+    SLICE_SI = 4,
+};
+
+// Upper bounds of syntax element loops, so that corrupt data cannot keep the parser busy.
+constexpr uint32_t kMaxRefIdxActive = 32;
+constexpr uint32_t kMaxMemoryManagementOps = 66;
+
+}  // namespace
+
+AvcQpParser::AvcQpParser() {
+    reset();
+}
+
+void AvcQpParser::reset() {
+    memset(mSps, 0, sizeof(mSps));
+    memset(mPps, 0, sizeof(mPps));
+}
+
+int32_t AvcQpParser::parse(const uint8_t *data, size_t size) {
+    size_t offset = FindNalStart(data, size, 0);
+    while (offset < size) {
+        uint8_t header = data[offset];
+        uint32_t nalRefIdc = (header >> 5) & 3;
+        uint32_t nalType = header & 0x1f;
+        size_t next = FindNalStart(data, size, offset + 1);
+        // the payload may include the zero bytes of the next start code, which are never read
+        NalBitReader br(data + offset + 1, next - offset - 1);
+        switch (nalType) {
+            case NAL_SPS:
+                parseSps(br);
+                break;
+            case NAL_PPS:
+                parsePps(br);
+                break;
+            case NAL_SLICE:
+            case NAL_IDR_SLICE:
+                return parseSliceQp(br, nalType, nalRefIdc);
+            default:
+                break;
+        }
+        offset = next;
+    }
+    return -1;
+}
+
+void AvcQpParser::parseSps(NalBitReader &br) {
+    Sps sps;
+    sps.valid = ParseAvcSps(br, &sps);
+    if (sps.id < kMaxSps) {
+        mSps[sps.id] = sps;
+    }
+}
+
+void AvcQpParser::parsePps(NalBitReader &br) {
+    Pps pps;
+    memset(&pps, 0, sizeof(pps));
+    uint32_t ppsId = br.readUE();
+    if (ppsId >= kMaxPps) {
+        return;
+    }
+    pps.spsId = br.readUE();
+    pps.entropyCodingMode = br.readFlag();
+    pps.bottomFieldPicOrderInFramePresent = br.readFlag();
+    uint32_t numSliceGroups = br.readUE() + 1;
+    pps.numRefIdxL0DefaultActive = br.readUE() + 1;
+    pps.numRefIdxL1DefaultActive = br.readUE() + 1;
+    pps.weightedPred = br.readFlag();
+    pps.weightedBipredIdc = br.readBits(2);
+    pps.picInitQp = 26 + br.readSE();
+    br.readSE();  // pic_init_qs_minus26
+    br.readSE();  // chroma_qp_index_offset
+    br.readFlag();  // deblocking_filter_control_present_flag
+    br.readFlag();  // constrained_intra_pred_flag
+    pps.redundantPicCntPresent = br.readFlag();
+    // slice groups are not used by encoders of the profiles supported here
+    pps.valid = !br.error() && pps.spsId < kMaxSps && numSliceGroups == 1
+            && pps.numRefIdxL0DefaultActive <= kMaxRefIdxActive
+            && pps.numRefIdxL1DefaultActive <= kMaxRefIdxActive;
+    mPps[ppsId] = pps;
+}
+
+int32_t AvcQpParser::parseSliceQp(
+        NalBitReader &br, uint32_t nalType, uint32_t nalRefIdc) const {
+    br.readUE();  // first_mb_in_slice
+    uint32_t sliceType = br.readUE() % 5;
+    uint32_t ppsId = br.readUE();
+    if (ppsId >= kMaxPps || !mPps[ppsId].valid || !mSps[mPps[ppsId].spsId].valid) {
+        ALOGV("slice refers to unknown parameter sets");
+        return -1;
+    }
+    const Pps &pps = mPps[ppsId];
+    const Sps &sps = mSps[pps.spsId];
+    bool isB = sliceType == SLICE_B;
+    bool isP = sliceType == SLICE_P || sliceType == SLICE_SP;
+
+    if (sps.separateColourPlane) {
+        br.readBits(2);  // colour_plane_id
+    }
+    br.readBits(sps.log2MaxFrameNum);  // frame_num
+    bool fieldPic = false;
+    if (!sps.frameMbsOnly) {
+        fieldPic = br.readFlag();
+        if (fieldPic) {
+            br.readFlag();  // bottom_field_flag
+        }
+    }
+    if (nalType == NAL_IDR_SLICE) {
+        br.readUE();  // idr_pic_id
+    }
+    if (sps.picOrderCntType == 0) {
+        br.readBits(sps.log2MaxPicOrderCntLsb);  // pic_order_cnt_lsb
+        if (pps.bottomFieldPicOrderInFramePresent && !fieldPic) {
+            br.readSE();  // delta_pic_order_cnt_bottom
+        }
+    } else if (sps.picOrderCntType == 1 && !sps.deltaPicOrderAlwaysZero) {
+        br.readSE();  // delta_pic_order_cnt[0]
+        if (pps.bottomFieldPicOrderInFramePresent && !fieldPic) {
+            br.readSE();  // delta_pic_order_cnt[1]
+        }
+    }
+    if (pps.redundantPicCntPresent) {
+        br.readUE();  // redundant_pic_cnt
+    }
+    if (isB) {
+        br.readFlag();  // direct_spatial_mv_pred_flag
+    }
+    uint32_t numRefIdxActive[2] = { pps.numRefIdxL0DefaultActive, pps.numRefIdxL1DefaultActive };
+    if (isP || isB) {
+        if (br.readFlag()) {  // num_ref_idx_active_override_flag
+            numRefIdxActive[0] = br.readUE() + 1;
+            if (isB) {
+                numRefIdxActive[1] = br.readUE() + 1;
+            }
+        }
+    }
+    if (numRefIdxActive[0] > kMaxRefIdxActive || numRefIdxActive[1] > kMaxRefIdxActive) {
+        return -1;
+    }
+
+    // ref_pic_list_modification()
+    for (uint32_t list = 0; list < (isB ? 2u : isP ? 1u : 0u); ++list) {
+        if (!br.readFlag()) {  // ref_pic_list_modification_flag_lX
+            continue;
+        }
+        uint32_t modificationOfPicNumsIdc;
+        uint32_t numOps = 0;
+        do {
+            modificationOfPicNumsIdc = br.readUE();
+            if (modificationOfPicNumsIdc > 3 || ++numOps > kMaxRefIdxActive + 1 || br.error()) {
+                return -1;
+            }
+            if (modificationOfPicNumsIdc != 3) {
+                br.readUE();  // abs_diff_pic_num_minus1 or long_term_pic_num
+            }
+        } while (modificationOfPicNumsIdc != 3);
+    }
+
+    // pred_weight_table()
+    if ((pps.weightedPred && isP) || (pps.weightedBipredIdc == 1 && isB)) {
+        br.readUE();  // luma_log2_weight_denom
+        if (sps.chromaArrayType != 0) {
+            br.readUE();  // chroma_log2_weight_denom
+        }
+        for (uint32_t list = 0; list < (isB ? 2u : 1u); ++list) {
+            for (uint32_t i = 0; i < numRefIdxActive[list]; ++i) {
+                if (br.readFlag()) {  // luma_weight_lX_flag
+                    br.readSE();  // luma_weight_lX
+                    br.readSE();  // luma_offset_lX
+                }
+                if (sps.chromaArrayType != 0 && br.readFlag()) {  // chroma_weight_lX_flag
+                    for (uint32_t j = 0; j < 4; ++j) {
+                        br.readSE();  // chroma_weight_lX and chroma_offset_lX
+                    }
+                }
+            }
+        }
+    }
+
+    // dec_ref_pic_marking()
+    if (nalRefIdc != 0) {
+        if (nalType == NAL_IDR_SLICE) {
+            br.readFlag();  // no_output_of_prior_pics_flag
+            br.readFlag();  // long_term_reference_flag
+        } else if (br.readFlag()) {  // adaptive_ref_pic_marking_mode_flag
+            uint32_t mmco;
+            uint32_t numOps = 0;
+            do {
+                mmco = br.readUE();
+                if (mmco > 6 || ++numOps > kMaxMemoryManagementOps || br.error()) {
+                    return -1;
+                }
+                if (mmco == 1 || mmco == 3) {
+                    br.readUE();  // difference_of_pic_nums_minus1
+                }
+                if (mmco == 2) {
+                    br.readUE();  // long_term_pic_num
+                }
+                if (mmco == 3 || mmco == 6) {
+                    br.readUE();  // long_term_frame_idx
+                }
+                if (mmco == 4) {
+                    br.readUE();  // max_long_term_frame_idx_plus1
+                }
+            } while (mmco != 0);
+        }
+    }
+
+    if (pps.entropyCodingMode && sliceType != SLICE_I && sliceType != SLICE_SI) {
+        br.readUE();  // cabac_init_idc
+    }
+    int32_t qp = pps.picInitQp + br.readSE();  // slice_qp_delta
+    if (br.error()) {
+        ALOGV("slice header is truncated");
+        return -1;
+    }
+    return qp;
+}
+
+}  // namespace android
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AVC_QP_PARSER_H_
+#define ANDROID_AVC_QP_PARSER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <NalBitReader.h>
+
+#include "AvcSps.h"
+
+namespace android {
+
+/**
+ * Extracts the QP of encoded H.264 frames from their slice headers.
+ *
+ * libavc does not report the QP it encoded a frame with. As it uses a single QP per frame, the
+ * QP of the first slice of a frame is the QP of the frame.
+ */
+class AvcQpParser {
+public:
+    AvcQpParser();
+
+    /**
+     * Parses the NAL units of an Annex B byte stream. Sequence and picture parameter sets are
+     * remembered for the following calls.
+     *
+     * \return the QP of the first slice in |data|, or -1 if there is no slice, or the slice refers
+     *         to parameter sets that have not been seen or that use features not supported here.
+     */
+    int32_t parse(const uint8_t *data, size_t size);
+
+    /**
+     * Forgets all parameter sets.
+     */
+    void reset();
+
+private:
+    struct Sps : AvcSps {
+        bool valid;
+    };
+
+    struct Pps {
+        bool valid;
+        uint32_t spsId;
+        bool entropyCodingMode;
+        bool bottomFieldPicOrderInFramePresent;
+        uint32_t numRefIdxL0DefaultActive;
+        uint32_t numRefIdxL1DefaultActive;
+        bool weightedPred;
+        uint32_t weightedBipredIdc;
+        int32_t picInitQp;
+        bool redundantPicCntPresent;
+    };
+
+    static constexpr size_t kMaxSps = 32;
+    static constexpr size_t kMaxPps = 256;
+
+    void parseSps(NalBitReader &br);
+    void parsePps(NalBitReader &br);
+    int32_t parseSliceQp(NalBitReader &br, uint32_t nalType, uint32_t nalRefIdc) const;
+
+    Sps mSps[kMaxSps];
+    Pps mPps[kMaxPps];
+};
+
+}  // namespace android
+
+#endif  // ANDROID_AVC_QP_PARSER_H_
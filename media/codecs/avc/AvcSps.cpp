@@ -0,0 +1,249 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "AvcSps"
+#include <log/log.h>
+
+#include <string.h>
+
+#include "AvcSps.h"
+
+namespace android {
+
+namespace {
+
+enum : uint32_t {
+    NAL_SLICE = 1,
+    NAL_IDR_SLICE = 5,
+    NAL_SPS = 7,
+};
+
+enum : uint32_t {
+    PROFILE_BASELINE = 66,
+    PROFILE_MAIN = 77,
+    PROFILE_EXTENDED = 88,
+    PROFILE_HIGH = 100,
+};
+
+enum : uint32_t {
+    CONSTRAINT_SET3 = 1 << 4,
+    CONSTRAINT_SET5 = 1 << 2,
+};
+
+constexpr uint32_t kMaxSpsId = 31;
+constexpr uint32_t kMaxPicOrderCntCycle = 255;
+constexpr uint32_t kMaxCpbCnt = 32;
+// MaxDpbFrames never exceeds 16 for any level.
+constexpr uint32_t kMaxDpbFrames = 16;
+
+bool SkipHrdParameters(NalBitReader &br) {
+    uint32_t cpbCnt = br.readUE() + 1;
+    if (cpbCnt > kMaxCpbCnt) {
+        return false;
+    }
+    br.readBits(8);  // bit_rate_scale and cpb_size_scale
+    for (uint32_t i = 0; i < cpbCnt; ++i) {
+        br.readUE();  // bit_rate_value_minus1
+        br.readUE();  // cpb_size_value_minus1
+        br.readFlag();  // cbr_flag
+    }
+    br.readBits(20);  // delay and time offset lengths
+    return !br.error();
+}
+
+}  // namespace
+
+bool AvcSps::mayReorderFrames() const {
+    if (picOrderCntType == 2 || maxNumReorderFrames == 0) {
+        return false;
+    }
+    switch (profileIdc) {
+        case PROFILE_BASELINE:
+            return false;
+        case PROFILE_MAIN:
+        case PROFILE_EXTENDED:
+        case PROFILE_HIGH:
+            // constraint_set5_flag excludes B slices in these profiles
+            return !(constraintFlags & CONSTRAINT_SET5);
+        default:
+            return true;
+    }
+}
+
+bool ParseAvcSps(NalBitReader &br, AvcSps *sps) {
+    memset(sps, 0, sizeof(*sps));
+    sps->profileIdc = br.readBits(8);
+    sps->constraintFlags = br.readBits(8);
+    br.readBits(8);  // level_idc
+    sps->id = br.readUE();
+    if (sps->id > kMaxSpsId) {
+        return false;
+    }
+    sps->chromaArrayType = 1;
+    bool intraProfile = false;
+    switch (sps->profileIdc) {
+        case 44: case 83: case 86: case 100: case 110: case 118: case 122: case 128: case 134:
+        case 135: case 138: case 139: case 244: {
+            uint32_t chromaFormatIdc = br.readUE();
+            if (chromaFormatIdc == 3) {
+                sps->separateColourPlane = br.readFlag();
+            }
+            sps->chromaArrayType = sps->separateColourPlane ? 0 : chromaFormatIdc;
+            br.readUE();  // bit_depth_luma_minus8
+            br.readUE();  // bit_depth_chroma_minus8
+            br.readFlag();  // qpprime_y_zero_transform_bypass_flag
+            if (br.readFlag()) {  // seq_scaling_matrix_present_flag
+                for (uint32_t i = 0; i < (chromaFormatIdc != 3 ? 8u : 12u); ++i) {
+                    if (!br.readFlag()) {  // seq_scaling_list_present_flag
+                        continue;
+                    }
+                    int32_t lastScale = 8;
+                    int32_t nextScale = 8;
+                    for (uint32_t j = 0; j < (i < 6 ? 16u : 64u) && nextScale != 0; ++j) {
+                        nextScale = (lastScale + br.readSE() + 256) % 256;
+                        lastScale = nextScale == 0 ? lastScale : nextScale;
+                    }
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    switch (sps->profileIdc) {
+        case 44: case 86: case 100: case 110: case 122: case 244:
+            // constraint_set3_flag marks the intra profiles among these
+            intraProfile = (sps->constraintFlags & CONSTRAINT_SET3) != 0;
+            break;
+        default:
+            break;
+    }
+    sps->log2MaxFrameNum = br.readUE() + 4;
+    sps->picOrderCntType = br.readUE();
+    if (sps->picOrderCntType == 0) {
+        sps->log2MaxPicOrderCntLsb = br.readUE() + 4;
+    } else if (sps->picOrderCntType == 1) {
+        sps->deltaPicOrderAlwaysZero = br.readFlag();
+        br.readSE();  // offset_for_non_ref_pic
+        br.readSE();  // offset_for_top_to_bottom_field
+        uint32_t numRefFramesInPicOrderCntCycle = br.readUE();
+        if (numRefFramesInPicOrderCntCycle > kMaxPicOrderCntCycle) {
+            return false;
+        }
+        for (uint32_t i = 0; i < numRefFramesInPicOrderCntCycle; ++i) {
+            br.readSE();  // offset_for_ref_frame
+        }
+    }
+    br.readUE();  // max_num_ref_frames
+    br.readFlag();  // gaps_in_frame_num_value_allowed_flag
+    br.readUE();  // pic_width_in_mbs_minus1
+    br.readUE();  // pic_height_in_map_units_minus1
+    sps->frameMbsOnly = br.readFlag();
+    if (br.error() || sps->log2MaxFrameNum > 16 || sps->picOrderCntType > 2
+            || (sps->picOrderCntType == 0 && sps->log2MaxPicOrderCntLsb > 16)) {
+        return false;
+    }
+
+    sps->maxNumReorderFrames = intraProfile ? 0 : kMaxDpbFrames;
+    if (!sps->frameMbsOnly) {
+        br.readFlag();  // mb_adaptive_frame_field_flag
+    }
+    br.readFlag();  // direct_8x8_inference_flag
+    if (br.readFlag()) {  // frame_cropping_flag
+        for (uint32_t i = 0; i < 4; ++i) {
+            br.readUE();  // frame_crop_*_offset
+        }
+    }
+    if (!br.readFlag()) {  // vui_parameters_present_flag
+        return !br.error();
+    }
+
+    // vui_parameters()
+    if (br.readFlag()) {  // aspect_ratio_info_present_flag
+        if (br.readBits(8) == 255) {  // aspect_ratio_idc is Extended_SAR
+            br.readBits(32);  // sar_width and sar_height
+        }
+    }
+    if (br.readFlag()) {  // overscan_info_present_flag
+        br.readFlag();  // overscan_appropriate_flag
+    }
+    if (br.readFlag()) {  // video_signal_type_present_flag
+        br.readBits(4);  // video_format and video_full_range_flag
+        if (br.readFlag()) {  // colour_description_present_flag
+            br.readBits(24);  // colour_primaries, transfer_characteristics, matrix_coefficients
+        }
+    }
+    if (br.readFlag()) {  // chroma_loc_info_present_flag
+        br.readUE();  // chroma_sample_loc_type_top_field
+        br.readUE();  // chroma_sample_loc_type_bottom_field
+    }
+    if (br.readFlag()) {  // timing_info_present_flag
+        br.readBits(32);  // num_units_in_tick
+        br.readBits(32);  // time_scale
+        br.readFlag();  // fixed_frame_rate_flag
+    }
+    bool nalHrd = br.readFlag();  // nal_hrd_parameters_present_flag
+    if (nalHrd && !SkipHrdParameters(br)) {
+        return false;
+    }
+    bool vclHrd = br.readFlag();  // vcl_hrd_parameters_present_flag
+    if (vclHrd && !SkipHrdParameters(br)) {
+        return false;
+    }
+    if (nalHrd || vclHrd) {
+        br.readFlag();  // low_delay_hrd_flag
+    }
+    br.readFlag();  // pic_struct_present_flag
+    if (br.readFlag()) {  // bitstream_restriction_flag
+        br.readFlag();  // motion_vectors_over_pic_boundaries_flag
+        br.readUE();  // max_bytes_per_pic_denom
+        br.readUE();  // max_bits_per_mb_denom
+        br.readUE();  // log2_max_mv_length_horizontal
+        br.readUE();  // log2_max_mv_length_vertical
+        sps->maxNumReorderFrames = br.readUE();
+        br.readUE();  // max_dec_frame_buffering
+    }
+    return !br.error();
+}
+
+bool FindAvcFrameReordering(const uint8_t *data, size_t size, bool *mayReorder) {
+    bool found = false;
+    size_t offset = FindNalStart(data, size, 0);
+    while (offset < size) {
+        uint32_t nalType = data[offset] & 0x1f;
+        if (nalType >= NAL_SLICE && nalType <= NAL_IDR_SLICE) {
+            // parameter sets precede the slices that use them
+            break;
+        }
+        size_t next = FindNalStart(data, size, offset + 1);
+        if (nalType == NAL_SPS) {
+            // the payload may include the zero bytes of the next start code, which are never read
+            NalBitReader br(data + offset + 1, next - offset - 1);
+            AvcSps sps;
+            if (ParseAvcSps(br, &sps)) {
+                *mayReorder = sps.mayReorderFrames();
+                found = true;
+            } else {
+                ALOGV("could not parse SPS");
+            }
+        }
+        offset = next;
+    }
+    return found;
+}
+
+}  // namespace android
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AVC_SPS_H_
+#define ANDROID_AVC_SPS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <NalBitReader.h>
+
+namespace android {
+
+/**
+ * The fields of an H.264 sequence parameter set used by the software codecs.
+ */
+struct AvcSps {
+    uint32_t id;
+    uint32_t profileIdc;
+    uint32_t constraintFlags;  // constraint_set0_flag in bit 7 to constraint_set5_flag in bit 2
+    bool separateColourPlane;
+    uint32_t chromaArrayType;
+    uint32_t log2MaxFrameNum;
+    uint32_t picOrderCntType;
+    uint32_t log2MaxPicOrderCntLsb;
+    bool deltaPicOrderAlwaysZero;
+    bool frameMbsOnly;
+    // max_num_reorder_frames of the VUI. If absent, this is inferred as the spec does, using the
+    // largest DPB size in frames of any level.
+    uint32_t maxNumReorderFrames;
+
+    /**
+     * Returns whether frames of this sequence may be output in a different order than they are
+     * decoded in. This is not the case if the sequence uses picture order count type 2, signals
+     * max_num_reorder_frames of 0, or is of a profile or constraint set that excludes B slices.
+     */
+    bool mayReorderFrames() const;
+};
+
+/**
+ * Parses the RBSP of an SPS NAL unit following the NAL unit header into |sps|.
+ *
+ * \return true if the SPS was parsed, false if it is truncated or uses values out of range. In
+ *         the latter case |sps| is only partially filled, though its id is valid if below 32.
+ */
+bool ParseAvcSps(NalBitReader &br, AvcSps *sps);
+
+/**
+ * Finds the last SPS before the first slice in the Annex B byte stream |data|, and returns whether
+ * frames of its sequence may be reordered in |mayReorder|.
+ *
+ * \return false if |data| contains no SPS that could be parsed.
+ */
+bool FindAvcFrameReordering(const uint8_t *data, size_t size, bool *mayReorder);
+
+}  // namespace android
+
+#endif  // ANDROID_AVC_SPS_H_
@@ -30,6 +30,8 @@
 #include <Codec2BufferUtils.h>
 #include <SimpleC2Interface.h>
 #include <util/C2InterfaceHelper.h>
+#include <eco/ECOEncoderStatsProvider.h>
+#include <eco/ECOServiceConstants.h>
 
 #include "C2SoftAvcEnc.h"
 #include "ih264e.h"
@@ -153,6 +155,26 @@ public:
                 .withFields({C2F(mSyncFramePeriod, value).any()})
                 .withSetter(Setter<decltype(*mSyncFramePeriod)>::StrictValueWithNoDeps)
                 .build());
+
+        addParameter(
+                DefineParam(mEcoStats, C2_PARAMKEY_ECO_STATS)
+                .withDefault(new C2EcoStatsTuning(C2_FALSE, C2_FALSE))
+                .withFields({
+                    C2F(mEcoStats, enabled).oneOf({ C2_FALSE, C2_TRUE }),
+                    C2F(mEcoStats, cameraRecording).oneOf({ C2_FALSE, C2_TRUE })
+                })
+                .withSetter(EcoStatsSetter)
+                .build());
+
+        addParameter(
+                DefineParam(mWorkerThreads, C2_PARAMKEY_WORKER_THREADS)
+                .withDefault(new C2WorkerThreadsTuning(0u, 0u))
+                .withFields({
+                    C2F(mWorkerThreads, cpuMask).any(),
+                    C2F(mWorkerThreads, maxThreads).any()
+                })
+                .withSetter(SimpleInterface<void>::BaseParams::WorkerThreadsSetter)
+                .build());
     }
 
     static C2R BitrateSetter(bool mayBlock, C2P<C2StreamBitrateInfo::output> &me) {
@@ -268,6 +290,13 @@ public:
         return res;
     }
 
+    static C2R EcoStatsSetter(bool mayBlock, C2P<C2EcoStatsTuning> &me) {
+        (void)mayBlock;
+        C2R res = me.F(me.v.enabled).validatePossible(me.v.enabled);
+        res.plus(me.F(me.v.cameraRecording).validatePossible(me.v.cameraRecording));
+        return res;
+    }
+
     IV_PROFILE_T getProfile_l() const {
         switch (mProfileLevel->profile) {
         case PROFILE_AVC_CONSTRAINED_BASELINE:  [[fallthrough]];
@@ -323,6 +352,8 @@ public:
     std::shared_ptr<C2StreamFrameRateInfo::output> getFrameRate_l() const { return mFrameRate; }
     std::shared_ptr<C2StreamBitrateInfo::output> getBitrate_l() const { return mBitrate; }
     std::shared_ptr<C2StreamRequestSyncFrameTuning::output> getRequestSync_l() const { return mRequestSync; }
+    std::shared_ptr<C2EcoStatsTuning> getEcoStats_l() const { return mEcoStats; }
+    std::shared_ptr<C2WorkerThreadsTuning> getWorkerThreads_l() const { return mWorkerThreads; }
 
 private:
     std::shared_ptr<C2StreamFormatConfig::input> mInputFormat;
@@ -337,6 +368,8 @@ private:
     std::shared_ptr<C2BitrateTuning::output> mBitrate;
     std::shared_ptr<C2StreamProfileLevelInfo::output> mProfileLevel;
     std::shared_ptr<C2StreamSyncFrameIntervalTuning::output> mSyncFramePeriod;
+    std::shared_ptr<C2EcoStatsTuning> mEcoStats;
+    std::shared_ptr<C2WorkerThreadsTuning> mWorkerThreads;
 };
 
 #define ive_api_function  ih264e_api_function
@@ -361,6 +394,74 @@ static size_t GetCPUCoreCount() {
     return (size_t)cpuCoreCount;
 }
 
+int32_t GetEcoProfile(IV_PROFILE_T profile) {
+    switch (profile) {
+    case IV_PROFILE_BASE: return media::eco::AVCProfileBaseline;
+    case IV_PROFILE_MAIN: return media::eco::AVCProfileMain;
+    default:              return -1;
+    }
+}
+
+int32_t GetEcoLevel(WORD32 avcLevel) {
+    struct Level {
+        WORD32 avcLevel;
+        int32_t ecoLevel;
+    };
+    constexpr Level levels[] = {
+        { 10, media::eco::AVCLevel1 },
+        {  9, media::eco::AVCLevel1b },
+        { 11, media::eco::AVCLevel11 },
+        { 12, media::eco::AVCLevel12 },
+        { 13, media::eco::AVCLevel13 },
+        { 20, media::eco::AVCLevel2 },
+        { 21, media::eco::AVCLevel21 },
+        { 22, media::eco::AVCLevel22 },
+        { 30, media::eco::AVCLevel3 },
+        { 31, media::eco::AVCLevel31 },
+        { 32, media::eco::AVCLevel32 },
+        { 40, media::eco::AVCLevel4 },
+        { 41, media::eco::AVCLevel41 },
+        { 42, media::eco::AVCLevel42 },
+        { 50, media::eco::AVCLevel5 },
+    };
+    for (const Level &level : levels) {
+        if (avcLevel == level.avcLevel) {
+            return level.ecoLevel;
+        }
+    }
+    return -1;
+}
+
+int8_t GetEcoFrameType(IV_PICTURE_CODING_TYPE_T frameType) {
+    switch (frameType) {
+    case IV_IDR_FRAME: [[fallthrough]];
+    case IV_I_FRAME:   return media::eco::FrameTypeI;
+    case IV_P_FRAME:   return media::eco::FrameTypeP;
+    case IV_B_FRAME:   return media::eco::FrameTypeB;
+    default:           return media::eco::FrameTypeUnknown;
+    }
+}
+
+// Returns the libavc color format of input in |format|.
+IV_COLOR_FORMAT_T GetIvColorFormat(EncoderInputConverter::Format format) {
+    switch (format) {
+        case EncoderInputConverter::FORMAT_NV12: return IV_YUV_420SP_UV;
+        case EncoderInputConverter::FORMAT_NV21: return IV_YUV_420SP_VU;
+        case EncoderInputConverter::FORMAT_I420:
+        default:                                 return IV_YUV_420P;
+    }
+}
+
+// Returns the input format of the libavc color format |colorFormat|.
+EncoderInputConverter::Format GetInputFormat(IV_COLOR_FORMAT_T colorFormat) {
+    switch (colorFormat) {
+        case IV_YUV_420SP_UV: return EncoderInputConverter::FORMAT_NV12;
+        case IV_YUV_420SP_VU: return EncoderInputConverter::FORMAT_NV21;
+        case IV_YUV_420P:
+        default:              return EncoderInputConverter::FORMAT_I420;
+    }
+}
+
 }  // namespace
 
 C2SoftAvcEnc::C2SoftAvcEnc(
@@ -375,6 +476,7 @@ C2SoftAvcEnc::C2SoftAvcEnc(
       mSawOutputEOS(false),
       mSignalledError(false),
       mCodecCtx(nullptr),
+      mNumEcoFrames(0),
       // TODO: output buffer size
       mOutBufferSize(524288) {
 
@@ -465,6 +567,17 @@ c2_status_t C2SoftAvcEnc::setDimensions() {
     return C2_OK;
 }
 
+void C2SoftAvcEnc::setWorkerThreads(
+        const std::shared_ptr<C2WorkerThreadsTuning> &workerThreads) {
+    // leave the CPUs of the component thread alone until they are first restricted
+    if (mWorkerThreads || workerThreads->cpuMask) {
+        SetWorkerCpus(*workerThreads);
+    }
+    mWorkerThreads = workerThreads;
+    mNumCores = LimitWorkerThreads(GetCPUCoreCount(), *mWorkerThreads);
+    mInputConverter.setNumThreads(mNumCores);
+}
+
 c2_status_t C2SoftAvcEnc::setNumCores() {
     IV_STATUS_T status;
     ive_ctl_set_num_cores_ip_t s_num_cores_ip;
@@ -833,6 +946,31 @@ void C2SoftAvcEnc::logVersion() {
     return;
 }
 
+void C2SoftAvcEnc::pushEcoSessionStats() {
+    media::eco::SimpleEncoderConfig config(
+            COMPONENT_NAME, media::eco::CodecTypeAVC, GetEcoProfile(mAVCEncProfile),
+            GetEcoLevel(mAVCEncLevel), mBitrate->value, mIDRInterval, mFrameRate->value);
+    if (!mEcoStatsProvider->pushSessionStats(config)) {
+        ALOGD("ECO session stats not accepted");
+    }
+}
+
+void C2SoftAvcEnc::pushEcoFrameStats(
+        IV_PICTURE_CODING_TYPE_T frameType, const C2ConstLinearBlock &block,
+        uint64_t timestamp) {
+    // libavc does not report the QP of the encoded frame, so read it from the slice header.
+    int32_t qp = -1;
+    C2ReadView rView = block.map().get();
+    if (rView.error() == C2_OK) {
+        qp = mEcoQpParser.parse(rView.data(), rView.capacity());
+    } else {
+        ALOGD("read view map err = %d", rView.error());
+    }
+    media::eco::SimpleEncodedFrameData frame(
+            mNumEcoFrames++, GetEcoFrameType(frameType), timestamp, qp, block.size());
+    mEcoStatsProvider->pushFrameStats(frame);
+}
+
 c2_status_t C2SoftAvcEnc::initEncoder() {
     IV_STATUS_T status;
     WORD32 level;
@@ -841,23 +979,28 @@ c2_status_t C2SoftAvcEnc::initEncoder() {
 
     c2_status_t errType = C2_OK;
 
+    std::shared_ptr<C2EcoStatsTuning> ecoStats;
+    std::shared_ptr<C2WorkerThreadsTuning> workerThreads;
     {
         IntfImpl::Lock lock = mIntf->lock();
         mSize = mIntf->getSize_l();
         mBitrate = mIntf->getBitrate_l();
         mFrameRate = mIntf->getFrameRate_l();
         mIntraRefresh = mIntf->getIntraRefresh_l();
+        mAVCEncProfile = mIntf->getProfile_l();
         mAVCEncLevel = mIntf->getLevel_l();
         mIInterval = mIntf->getSyncFramePeriod_l();
         mIDRInterval = mIntf->getSyncFramePeriod_l();
+        ecoStats = mIntf->getEcoStats_l();
+        workerThreads = mIntf->getWorkerThreads_l();
     }
+    setWorkerThreads(workerThreads);
     uint32_t width = mSize->width;
     uint32_t height = mSize->height;
 
     mStride = width;
-
-    // TODO
-    mIvVideoColorFormat = IV_YUV_420P;
+    mInputConverter.configure(GetInputFormat(mIvVideoColorFormat), width, height, width, height,
+                              true /* halfChromaStride */);
 
     ALOGD("Params width %d height %d level %d colorFormat %d", width,
             height, mAVCEncLevel, mIvVideoColorFormat);
@@ -1056,6 +1199,16 @@ c2_status_t C2SoftAvcEnc::initEncoder() {
     mSpsPpsHeaderReceived = false;
     mStarted = true;
 
+    if (ecoStats->enabled) {
+        mEcoStatsProvider = media::eco::ECOEncoderStatsProvider::Create(
+                COMPONENT_NAME, width, height, ecoStats->cameraRecording);
+        mNumEcoFrames = 0;
+        mEcoQpParser.reset();
+        if (mEcoStatsProvider != nullptr) {
+            pushEcoSessionStats();
+        }
+    }
+
     return C2_OK;
 }
 
@@ -1065,6 +1218,11 @@ c2_status_t C2SoftAvcEnc::releaseEncoder() {
     iv_retrieve_mem_rec_op_t s_retrieve_mem_op;
     iv_mem_rec_t *ps_mem_rec;
 
+    if (mEcoStatsProvider != nullptr) {
+        mEcoStatsProvider->release();
+        mEcoStatsProvider = nullptr;
+    }
+
     if (!mStarted) {
         return C2_OK;
     }
@@ -1149,77 +1307,23 @@ c2_status_t C2SoftAvcEnc::setEncodeArgs(
         return C2_BAD_VALUE;
     }
     ALOGV("width = %d, height = %d", input->width(), input->height());
-    const C2PlanarLayout &layout = input->layout();
-    uint8_t *yPlane = const_cast<uint8_t *>(input->data()[C2PlanarLayout::PLANE_Y]);
-    uint8_t *uPlane = const_cast<uint8_t *>(input->data()[C2PlanarLayout::PLANE_U]);
-    uint8_t *vPlane = const_cast<uint8_t *>(input->data()[C2PlanarLayout::PLANE_V]);
-    int32_t yStride = layout.planes[C2PlanarLayout::PLANE_Y].rowInc;
-    int32_t uStride = layout.planes[C2PlanarLayout::PLANE_U].rowInc;
-    int32_t vStride = layout.planes[C2PlanarLayout::PLANE_V].rowInc;
+    EncoderInputConverter::Frame frame;
+    c2_status_t err = mInputConverter.convert(*input, &frame);
+    if (err != C2_OK) {
+        return err;
+    }
+    uint8_t *yPlane = const_cast<uint8_t *>(frame.y);
+    uint8_t *uPlane = const_cast<uint8_t *>(frame.u);
+    uint8_t *vPlane = const_cast<uint8_t *>(frame.v);
+    int32_t yStride = frame.yStride;
+    int32_t uStride = frame.uStride;
+    int32_t vStride = frame.vStride;
 
     uint32_t width = mSize->width;
     uint32_t height = mSize->height;
     // width and height are always even (as block size is 16x16)
     CHECK_EQ((width & 1u), 0u);
     CHECK_EQ((height & 1u), 0u);
-    size_t yPlaneSize = width * height;
-
-    switch (layout.type) {
-        case C2PlanarLayout::TYPE_RGB:
-            [[fallthrough]];
-        case C2PlanarLayout::TYPE_RGBA: {
-            ALOGV("yPlaneSize = %zu", yPlaneSize);
-            MemoryBlock conversionBuffer = mConversionBuffers.fetch(yPlaneSize * 3 / 2);
-            mConversionBuffersInUse.emplace(conversionBuffer.data(), conversionBuffer);
-            yPlane = conversionBuffer.data();
-            uPlane = yPlane + yPlaneSize;
-            vPlane = uPlane + yPlaneSize / 4;
-            yStride = width;
-            uStride = vStride = yStride / 2;
-            ConvertRGBToPlanarYUV(yPlane, yStride, height, conversionBuffer.size(), *input);
-            break;
-        }
-        case C2PlanarLayout::TYPE_YUV: {
-            if (!IsYUV420(*input)) {
-                ALOGE("input is not YUV420");
-                return C2_BAD_VALUE;
-            }
-
-            if (layout.planes[layout.PLANE_Y].colInc == 1
-                    && layout.planes[layout.PLANE_U].colInc == 1
-                    && layout.planes[layout.PLANE_V].colInc == 1
-                    && uStride == vStride
-                    && yStride == 2 * vStride) {
-                // I420 compatible - already set up above
-                break;
-            }
-
-            // copy to I420
-            yStride = width;
-            uStride = vStride = yStride / 2;
-            MemoryBlock conversionBuffer = mConversionBuffers.fetch(yPlaneSize * 3 / 2);
-            mConversionBuffersInUse.emplace(conversionBuffer.data(), conversionBuffer);
-            MediaImage2 img = CreateYUV420PlanarMediaImage2(width, height, yStride, height);
-            status_t err = ImageCopy(conversionBuffer.data(), &img, *input);
-            if (err != OK) {
-                ALOGE("Buffer conversion failed: %d", err);
-                return C2_BAD_VALUE;
-            }
-            yPlane = conversionBuffer.data();
-            uPlane = yPlane + yPlaneSize;
-            vPlane = uPlane + yPlaneSize / 4;
-            break;
-
-        }
-
-        case C2PlanarLayout::TYPE_YUVA:
-            ALOGE("YUVA plane type is not supported");
-            return C2_BAD_VALUE;
-
-        default:
-            ALOGE("Unrecognized plane type: %d", layout.type);
-            return C2_BAD_VALUE;
-    }
 
     switch (mIvVideoColorFormat) {
         case IV_YUV_420P:
@@ -1229,13 +1333,13 @@ c2_status_t C2SoftAvcEnc::setEncodeArgs(
             ps_inp_raw_buf->apv_bufs[1] = uPlane;
             ps_inp_raw_buf->apv_bufs[2] = vPlane;
 
-            ps_inp_raw_buf->au4_wd[0] = input->width();
-            ps_inp_raw_buf->au4_wd[1] = input->width() / 2;
-            ps_inp_raw_buf->au4_wd[2] = input->width() / 2;
+            ps_inp_raw_buf->au4_wd[0] = width;
+            ps_inp_raw_buf->au4_wd[1] = width / 2;
+            ps_inp_raw_buf->au4_wd[2] = width / 2;
 
-            ps_inp_raw_buf->au4_ht[0] = input->height();
-            ps_inp_raw_buf->au4_ht[1] = input->height() / 2;
-            ps_inp_raw_buf->au4_ht[2] = input->height() / 2;
+            ps_inp_raw_buf->au4_ht[0] = height;
+            ps_inp_raw_buf->au4_ht[1] = height / 2;
+            ps_inp_raw_buf->au4_ht[2] = height / 2;
 
             ps_inp_raw_buf->au4_strd[0] = yStride;
             ps_inp_raw_buf->au4_strd[1] = uStride;
@@ -1258,13 +1362,15 @@ c2_status_t C2SoftAvcEnc::setEncodeArgs(
         default:
         {
             ps_inp_raw_buf->apv_bufs[0] = yPlane;
-            ps_inp_raw_buf->apv_bufs[1] = uPlane;
+            // interleaved chroma starts with U for UV and with V for VU
+            ps_inp_raw_buf->apv_bufs[1] =
+                    mIvVideoColorFormat == IV_YUV_420SP_VU ? vPlane : uPlane;
 
-            ps_inp_raw_buf->au4_wd[0] = input->width();
-            ps_inp_raw_buf->au4_wd[1] = input->width();
+            ps_inp_raw_buf->au4_wd[0] = width;
+            ps_inp_raw_buf->au4_wd[1] = width;
 
-            ps_inp_raw_buf->au4_ht[0] = input->height();
-            ps_inp_raw_buf->au4_ht[1] = input->height() / 2;
+            ps_inp_raw_buf->au4_ht[0] = height;
+            ps_inp_raw_buf->au4_ht[1] = height / 2;
 
             ps_inp_raw_buf->au4_strd[0] = yStride;
             ps_inp_raw_buf->au4_strd[1] = uStride;
@@ -1286,8 +1392,27 @@ void C2SoftAvcEnc::process(
     WORD32 timeDelay, timeTaken;
     uint64_t timestamp = work->input.ordinal.timestamp.peekull();
 
+    std::shared_ptr<const C2GraphicView> view;
+    std::shared_ptr<C2Buffer> inputBuffer;
+    if (!work->input.buffers.empty()) {
+        inputBuffer = work->input.buffers[0];
+        view = std::make_shared<const C2GraphicView>(
+                inputBuffer->data().graphicBlocks().front().map().get());
+        if (view->error() != C2_OK) {
+            ALOGE("graphic view map err = %d", view->error());
+            return;
+        }
+    }
+
     // Initialize encoder if not already initialized
     if (mCodecCtx == nullptr) {
+        // Take I420, NV12 or NV21 input directly in the layout of the first frame. Frames in
+        // other layouts are converted to it.
+        EncoderInputConverter::Format format = EncoderInputConverter::FORMAT_I420;
+        if (view) {
+            EncoderInputConverter::GetDirectFormat(*view, true /* halfChromaStride */, &format);
+        }
+        mIvVideoColorFormat = GetIvColorFormat(format);
         if (C2_OK != initEncoder()) {
             ALOGE("Failed to initialize encoder");
             mSignalledError = true;
@@ -1338,6 +1463,10 @@ void C2SoftAvcEnc::process(
         }
         memcpy(csd->m.value, header, s_encode_op.s_out_buf.u4_bytes);
         work->worklets.front()->output.configUpdate.push_back(std::move(csd));
+        if (mEcoStatsProvider != nullptr) {
+            // remember the parameter sets that the slice headers refer to
+            mEcoQpParser.parse(header, s_encode_op.s_out_buf.u4_bytes);
+        }
 
         DUMP_TO_FILE(
                 mOutFile, csd->m.value, csd->flexCount());
@@ -1349,11 +1478,15 @@ void C2SoftAvcEnc::process(
         std::shared_ptr<C2StreamIntraRefreshTuning::output> intraRefresh = mIntf->getIntraRefresh_l();
         std::shared_ptr<C2StreamBitrateInfo::output> bitrate = mIntf->getBitrate_l();
         std::shared_ptr<C2StreamRequestSyncFrameTuning::output> requestSync = mIntf->getRequestSync_l();
+        std::shared_ptr<C2WorkerThreadsTuning> workerThreads = mIntf->getWorkerThreads_l();
         lock.unlock();
 
         if (bitrate != mBitrate) {
             mBitrate = bitrate;
             setBitRate();
+            if (mEcoStatsProvider != nullptr) {
+                pushEcoSessionStats();
+            }
         }
 
         if (intraRefresh != mIntraRefresh) {
@@ -1361,6 +1494,11 @@ void C2SoftAvcEnc::process(
             setAirParams();
         }
 
+        if (workerThreads != mWorkerThreads) {
+            setWorkerThreads(workerThreads);
+            setNumCores();
+        }
+
         if (requestSync != mRequestSync) {
             // we can handle IDR immediately
             if (requestSync->value) {
@@ -1389,18 +1527,6 @@ void C2SoftAvcEnc::process(
     //         }
     //     }
     // }
-    std::shared_ptr<const C2GraphicView> view;
-    std::shared_ptr<C2Buffer> inputBuffer;
-    if (!work->input.buffers.empty()) {
-        inputBuffer = work->input.buffers[0];
-        view = std::make_shared<const C2GraphicView>(
-                inputBuffer->data().graphicBlocks().front().map().get());
-        if (view->error() != C2_OK) {
-            ALOGE("graphic view map err = %d", view->error());
-            return;
-        }
-    }
-
     std::shared_ptr<C2LinearBlock> block;
 
     do {
@@ -1472,7 +1598,7 @@ void C2SoftAvcEnc::process(
         } else {
             // Release input buffer reference
             mBuffers.erase(freed);
-            mConversionBuffersInUse.erase(freed);
+            mInputConverter.release(freed);
         }
     }
 
@@ -1491,6 +1617,11 @@ void C2SoftAvcEnc::process(
                     0u /* stream id */, C2PictureTypeKeyFrame));
         }
         work->worklets.front()->output.buffers.push_back(buffer);
+        if (mEcoStatsProvider != nullptr) {
+            pushEcoFrameStats(
+                    s_encode_op.u4_encoded_frame_type, buffer->data().linearBlocks().front(),
+                    work->worklets.front()->output.ordinal.timestamp.peekull());
+        }
     }
 
     if (s_encode_op.u4_is_last) {
@@ -19,16 +19,25 @@
 
 #include <map>
 
+#include <utils/StrongPointer.h>
 #include <utils/Vector.h>
 
+#include <EncoderInputConverter.h>
 #include <SimpleC2Component.h>
 
+#include "AvcQpParser.h"
 #include "ih264_typedefs.h"
 #include "iv2.h"
 #include "ive2.h"
 
 namespace android {
 
+namespace media {
+namespace eco {
+class ECOEncoderStatsProvider;
+}  // namespace eco
+}  // namespace media
+
 #define CODEC_MAX_CORES          4
 #define LEN_STATUS_BUFFER        (10  * 1024)
 #define MAX_VBV_BUFF_SIZE        (120 * 16384)
@@ -161,7 +170,7 @@ private:
 
     IV_COLOR_FORMAT_T mIvVideoColorFormat;
 
-    IV_PROFILE_T mAVCEncProfile __unused;
+    IV_PROFILE_T mAVCEncProfile;
     WORD32   mAVCEncLevel;
     bool     mStarted;
     bool     mSpsPpsHeaderReceived;
@@ -190,6 +199,13 @@ private:
     std::shared_ptr<C2StreamFrameRateInfo::output> mFrameRate;
     std::shared_ptr<C2StreamBitrateInfo::output> mBitrate;
     std::shared_ptr<C2StreamRequestSyncFrameTuning::output> mRequestSync;
+    std::shared_ptr<C2WorkerThreadsTuning> mWorkerThreads;
+
+    // ECO stats provider; only created if stats reporting is enabled.
+    sp<media::eco::ECOEncoderStatsProvider> mEcoStatsProvider;
+    int32_t mNumEcoFrames;
+    // Finds the QP of the encoded frames for the ECO stats.
+    AvcQpParser mEcoQpParser;
 
     uint32_t mOutBufferSize;
     UWORD32 mHeaderGenerated;
@@ -202,8 +218,7 @@ private:
     UWORD32 mIDRInterval;
     UWORD32 mDisableDeblkLevel;
     std::map<const void *, std::shared_ptr<C2Buffer>> mBuffers;
-    MemoryBlockPool mConversionBuffers;
-    std::map<const void *, MemoryBlock> mConversionBuffersInUse;
+    EncoderInputConverter mInputConverter;
 
     void initEncParams();
     c2_status_t initEncoder();
@@ -213,6 +228,7 @@ private:
     c2_status_t setQp();
     c2_status_t setEncMode(IVE_ENC_MODE_T e_enc_mode);
     c2_status_t setDimensions();
+    void setWorkerThreads(const std::shared_ptr<C2WorkerThreadsTuning> &workerThreads);
     c2_status_t setNumCores();
     c2_status_t setFrameRate();
     c2_status_t setIpeParams();
@@ -224,6 +240,10 @@ private:
     c2_status_t setDeblockParams();
     c2_status_t setVbvParams();
     void logVersion();
+    void pushEcoSessionStats();
+    void pushEcoFrameStats(
+            IV_PICTURE_CODING_TYPE_T frameType, const C2ConstLinearBlock &block,
+            uint64_t timestamp);
     c2_status_t setEncodeArgs(
             ive_video_encode_ip_t *ps_encode_ip,
             ive_video_encode_op_t *ps_encode_op,
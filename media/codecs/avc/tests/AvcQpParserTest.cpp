@@ -0,0 +1,99 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "AvcQpParser.h"
+
+namespace android {
+
+namespace {
+
+// high profile, CABAC, weighted prediction, pic_init_qp 23; the SPS contains emulation prevention
+// bytes
+const uint8_t kSpsPps[] = {
+    0x00, 0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x0c, 0xac, 0xd9, 0x41, 0x41, 0xfa, 0x10, 0x00, 0x00,
+    0x03, 0x00, 0x10, 0x00, 0x00, 0x03, 0x02, 0x80, 0xf1, 0x42, 0x99, 0x60,
+
+    0x00, 0x00, 0x00, 0x01, 0x68, 0xeb, 0xe3, 0xcb, 0x22, 0xc0,
+};
+
+// IDR frame with QP 11, truncated after the slice header
+const uint8_t kIdrSlice[] = {
+    0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00, 0x33, 0xff, 0xfe, 0xdf, 0x32, 0xf8, 0x14, 0xd6, 0x25,
+};
+
+// P frame with QP 13 and a prediction weight table
+const uint8_t kPSlice[] = {
+    0x00, 0x00, 0x00, 0x01, 0x41, 0x9a, 0x21, 0x6c, 0x42, 0xbf, 0xfe, 0x38, 0x40, 0x00, 0x0d, 0x48,
+};
+
+} // namespace
+
+class AvcQpParserTest : public ::testing::Test {
+protected:
+    int32_t parse(const uint8_t *data, size_t size) {
+        return mParser.parse(data, size);
+    }
+
+    template<size_t N>
+    int32_t parse(const uint8_t (&data)[N]) {
+        return mParser.parse(data, N);
+    }
+
+    AvcQpParser mParser;
+};
+
+TEST_F(AvcQpParserTest, ParameterSetsOnly) {
+    EXPECT_EQ(-1, parse(kSpsPps));
+}
+
+TEST_F(AvcQpParserTest, SliceQp) {
+    EXPECT_EQ(-1, parse(kSpsPps));
+    EXPECT_EQ(11, parse(kIdrSlice));
+    EXPECT_EQ(13, parse(kPSlice));
+}
+
+TEST_F(AvcQpParserTest, ParameterSetsAndSliceInOneBuffer) {
+    std::vector<uint8_t> frame(kSpsPps, kSpsPps + sizeof(kSpsPps));
+    frame.insert(frame.end(), kIdrSlice, kIdrSlice + sizeof(kIdrSlice));
+    EXPECT_EQ(11, parse(frame.data(), frame.size()));
+}
+
+TEST_F(AvcQpParserTest, MissingParameterSets) {
+    EXPECT_EQ(-1, parse(kPSlice));
+    parse(kSpsPps);
+    mParser.reset();
+    EXPECT_EQ(-1, parse(kIdrSlice));
+}
+
+TEST_F(AvcQpParserTest, TruncatedSliceHeader) {
+    parse(kSpsPps);
+    for (size_t size = 0; size < 8; ++size) {
+        EXPECT_EQ(-1, parse(kPSlice, size)) << "size " << size;
+    }
+    EXPECT_EQ(13, parse(kPSlice));
+}
+
+TEST_F(AvcQpParserTest, TruncatedParameterSets) {
+    // a truncated PPS is not used for the following slices
+    parse(kSpsPps, sizeof(kSpsPps) - 4);
+    EXPECT_EQ(-1, parse(kIdrSlice));
+}
+
+} // namespace android
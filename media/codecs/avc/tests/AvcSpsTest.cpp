@@ -0,0 +1,292 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "AvcSps.h"
+
+namespace android {
+
+namespace {
+
+// Writes the RBSP of a NAL unit and wraps it into an Annex B NAL unit.
+class NalWriter {
+public:
+    void writeBits(uint32_t value, uint32_t numBits) {
+        while (numBits--) {
+            mBits.push_back((value >> numBits) & 1);
+        }
+    }
+
+    void writeFlag(bool value) { writeBits(value, 1); }
+
+    void writeUE(uint32_t value) {
+        uint32_t numBits = 0;
+        while ((uint64_t(value) + 1) >> (numBits + 1)) {
+            ++numBits;
+        }
+        writeBits(0, numBits);
+        writeBits(value + 1, numBits + 1);
+    }
+
+    // Returns the NAL unit with a start code, the header byte |header|, the RBSP with trailing
+    // bits and emulation prevention bytes.
+    std::vector<uint8_t> nal(uint8_t header) const {
+        std::vector<uint8_t> bits = mBits;
+        bits.push_back(1);
+        while (bits.size() % 8) {
+            bits.push_back(0);
+        }
+        std::vector<uint8_t> out = { 0, 0, 0, 1, header };
+        size_t numZeros = 0;
+        for (size_t i = 0; i < bits.size(); i += 8) {
+            uint8_t byte = 0;
+            for (size_t j = 0; j < 8; ++j) {
+                byte = (byte << 1) | bits[i + j];
+            }
+            if (numZeros >= 2 && byte <= 3) {
+                out.push_back(3);
+                numZeros = 0;
+            }
+            out.push_back(byte);
+            numZeros = byte == 0 ? numZeros + 1 : 0;
+        }
+        return out;
+    }
+
+private:
+    std::vector<uint8_t> mBits;
+};
+
+constexpr uint8_t kSpsHeader = 0x67;
+constexpr uint8_t kIdrHeader = 0x65;
+
+struct SpsParams {
+    uint32_t profileIdc = 100;
+    uint32_t constraintFlags = 0;
+    uint32_t picOrderCntType = 0;
+    bool vui = false;
+    bool hrd = false;
+    bool bitstreamRestriction = false;
+    uint32_t maxNumReorderFrames = 0;
+};
+
+std::vector<uint8_t> makeSps(const SpsParams &params) {
+    NalWriter w;
+    w.writeBits(params.profileIdc, 8);
+    w.writeBits(params.constraintFlags, 8);
+    w.writeBits(40, 8);  // level_idc
+    w.writeUE(0);  // seq_parameter_set_id
+    if (params.profileIdc == 100) {
+        w.writeUE(1);  // chroma_format_idc
+        w.writeUE(0);  // bit_depth_luma_minus8
+        w.writeUE(0);  // bit_depth_chroma_minus8
+        w.writeFlag(false);  // qpprime_y_zero_transform_bypass_flag
+        w.writeFlag(false);  // seq_scaling_matrix_present_flag
+    }
+    w.writeUE(0);  // log2_max_frame_num_minus4
+    w.writeUE(params.picOrderCntType);
+    if (params.picOrderCntType == 0) {
+        w.writeUE(2);  // log2_max_pic_order_cnt_lsb_minus4
+    }
+    w.writeUE(4);  // max_num_ref_frames
+    w.writeFlag(false);  // gaps_in_frame_num_value_allowed_flag
+    w.writeUE(79);  // pic_width_in_mbs_minus1
+    w.writeUE(44);  // pic_height_in_map_units_minus1
+    w.writeFlag(true);  // frame_mbs_only_flag
+    w.writeFlag(true);  // direct_8x8_inference_flag
+    w.writeFlag(false);  // frame_cropping_flag
+    w.writeFlag(params.vui);
+    if (params.vui) {
+        w.writeFlag(true);  // aspect_ratio_info_present_flag
+        w.writeBits(255, 8);  // aspect_ratio_idc
+        w.writeBits(1, 16);  // sar_width
+        w.writeBits(1, 16);  // sar_height
+        w.writeFlag(false);  // overscan_info_present_flag
+        w.writeFlag(true);  // video_signal_type_present_flag
+        w.writeBits(5, 3);  // video_format
+        w.writeFlag(false);  // video_full_range_flag
+        w.writeFlag(true);  // colour_description_present_flag
+        w.writeBits(0x010101, 24);
+        w.writeFlag(false);  // chroma_loc_info_present_flag
+        w.writeFlag(true);  // timing_info_present_flag
+        w.writeBits(1001, 32);  // num_units_in_tick
+        w.writeBits(60000, 32);  // time_scale
+        w.writeFlag(false);  // fixed_frame_rate_flag
+        w.writeFlag(params.hrd);  // nal_hrd_parameters_present_flag
+        if (params.hrd) {
+            w.writeUE(1);  // cpb_cnt_minus1
+            w.writeBits(0, 8);  // bit_rate_scale and cpb_size_scale
+            for (uint32_t i = 0; i < 2; ++i) {
+                w.writeUE(1000);  // bit_rate_value_minus1
+                w.writeUE(2000);  // cpb_size_value_minus1
+                w.writeFlag(i == 0);  // cbr_flag
+            }
+            w.writeBits(0x5a5a5, 20);  // delay and time offset lengths
+        }
+        w.writeFlag(false);  // vcl_hrd_parameters_present_flag
+        if (params.hrd) {
+            w.writeFlag(true);  // low_delay_hrd_flag
+        }
+        w.writeFlag(false);  // pic_struct_present_flag
+        w.writeFlag(params.bitstreamRestriction);
+        if (params.bitstreamRestriction) {
+            w.writeFlag(true);  // motion_vectors_over_pic_boundaries_flag
+            w.writeUE(2);  // max_bytes_per_pic_denom
+            w.writeUE(1);  // max_bits_per_mb_denom
+            w.writeUE(16);  // log2_max_mv_length_horizontal
+            w.writeUE(16);  // log2_max_mv_length_vertical
+            w.writeUE(params.maxNumReorderFrames);
+            w.writeUE(4);  // max_dec_frame_buffering
+        }
+    }
+    return w.nal(kSpsHeader);
+}
+
+std::vector<uint8_t> makeIdrSlice() {
+    NalWriter w;
+    w.writeUE(0);  // first_mb_in_slice
+    w.writeUE(7);  // slice_type
+    w.writeUE(0);  // pic_parameter_set_id
+    return w.nal(kIdrHeader);
+}
+
+bool parse(const std::vector<uint8_t> &nal, AvcSps *sps) {
+    // skip the start code and the NAL unit header
+    NalBitReader br(nal.data() + 5, nal.size() - 5);
+    return ParseAvcSps(br, sps);
+}
+
+bool findReordering(const std::vector<uint8_t> &data, bool *mayReorder) {
+    return FindAvcFrameReordering(data.data(), data.size(), mayReorder);
+}
+
+} // namespace
+
+TEST(AvcSpsTest, ParseWithoutVui) {
+    AvcSps sps;
+    ASSERT_TRUE(parse(makeSps(SpsParams()), &sps));
+    EXPECT_EQ(0u, sps.id);
+    EXPECT_EQ(100u, sps.profileIdc);
+    EXPECT_EQ(1u, sps.chromaArrayType);
+    EXPECT_EQ(4u, sps.log2MaxFrameNum);
+    EXPECT_EQ(0u, sps.picOrderCntType);
+    EXPECT_EQ(6u, sps.log2MaxPicOrderCntLsb);
+    EXPECT_TRUE(sps.frameMbsOnly);
+    // inferred from the largest DPB
+    EXPECT_EQ(16u, sps.maxNumReorderFrames);
+    EXPECT_TRUE(sps.mayReorderFrames());
+}
+
+TEST(AvcSpsTest, ParseVuiBitstreamRestriction) {
+    SpsParams params;
+    params.vui = true;
+    params.hrd = true;
+    params.bitstreamRestriction = true;
+    for (uint32_t reorder : { 0u, 1u, 3u }) {
+        params.maxNumReorderFrames = reorder;
+        AvcSps sps;
+        ASSERT_TRUE(parse(makeSps(params), &sps)) << "reorder " << reorder;
+        EXPECT_EQ(reorder, sps.maxNumReorderFrames);
+        EXPECT_EQ(reorder != 0, sps.mayReorderFrames());
+    }
+
+    // without bitstream restriction the VUI does not limit reordering
+    params.bitstreamRestriction = false;
+    AvcSps sps;
+    ASSERT_TRUE(parse(makeSps(params), &sps));
+    EXPECT_EQ(16u, sps.maxNumReorderFrames);
+}
+
+TEST(AvcSpsTest, SequencesWithoutReordering) {
+    AvcSps sps;
+    SpsParams params;
+
+    // baseline profile has no B slices
+    params.profileIdc = 66;
+    ASSERT_TRUE(parse(makeSps(params), &sps));
+    EXPECT_FALSE(sps.mayReorderFrames());
+
+    // main profile allows B slices unless constraint_set5_flag is set
+    params.profileIdc = 77;
+    ASSERT_TRUE(parse(makeSps(params), &sps));
+    EXPECT_TRUE(sps.mayReorderFrames());
+    params.constraintFlags = 0x04;
+    ASSERT_TRUE(parse(makeSps(params), &sps));
+    EXPECT_FALSE(sps.mayReorderFrames());
+
+    // picture order count type 2 outputs in decode order
+    params.constraintFlags = 0;
+    params.picOrderCntType = 2;
+    ASSERT_TRUE(parse(makeSps(params), &sps));
+    EXPECT_FALSE(sps.mayReorderFrames());
+
+    // high 10 intra profile
+    params = SpsParams();
+    params.constraintFlags = 0x10;
+    ASSERT_TRUE(parse(makeSps(params), &sps));
+    EXPECT_EQ(0u, sps.maxNumReorderFrames);
+    EXPECT_FALSE(sps.mayReorderFrames());
+}
+
+TEST(AvcSpsTest, Truncated) {
+    SpsParams params;
+    params.vui = true;
+    params.bitstreamRestriction = true;
+    std::vector<uint8_t> nal = makeSps(params);
+    AvcSps sps;
+    ASSERT_TRUE(parse(nal, &sps));
+    // the last byte only holds the trailing bits
+    for (size_t size = 5; size + 1 < nal.size(); ++size) {
+        std::vector<uint8_t> truncated(nal.begin(), nal.begin() + size);
+        EXPECT_FALSE(parse(truncated, &sps)) << "size " << size;
+    }
+}
+
+TEST(AvcSpsTest, FindReordering) {
+    SpsParams params;
+    params.vui = true;
+    params.bitstreamRestriction = true;
+    params.maxNumReorderFrames = 0;
+    std::vector<uint8_t> lowDelaySps = makeSps(params);
+    params.maxNumReorderFrames = 2;
+    std::vector<uint8_t> reorderSps = makeSps(params);
+    std::vector<uint8_t> slice = makeIdrSlice();
+
+    bool mayReorder = true;
+    EXPECT_FALSE(findReordering(slice, &mayReorder));
+    EXPECT_FALSE(findReordering({}, &mayReorder));
+
+    ASSERT_TRUE(findReordering(lowDelaySps, &mayReorder));
+    EXPECT_FALSE(mayReorder);
+
+    // the last SPS before the first slice counts
+    std::vector<uint8_t> data = reorderSps;
+    data.insert(data.end(), lowDelaySps.begin(), lowDelaySps.end());
+    data.insert(data.end(), slice.begin(), slice.end());
+    data.insert(data.end(), reorderSps.begin(), reorderSps.end());
+    mayReorder = true;
+    ASSERT_TRUE(findReordering(data, &mayReorder));
+    EXPECT_FALSE(mayReorder);
+
+    data = slice;
+    data.insert(data.end(), lowDelaySps.begin(), lowDelaySps.end());
+    EXPECT_FALSE(findReordering(data, &mayReorder));
+}
+
+} // namespace android
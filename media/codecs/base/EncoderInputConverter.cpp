@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "EncoderInputConverter"
+#include <log/log.h>
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <EncoderInputConverter.h>
+
+namespace android {
+
+namespace {
+
+// RGB input is not split into slices of fewer rows than this
+constexpr size_t kMinSliceRows = 32;
+
+void CopyPlane(uint8_t *dst, int32_t dstStride, const uint8_t *src, int32_t srcStride,
+               size_t width, size_t height) {
+    for (size_t i = 0; i < height; ++i) {
+        memcpy(dst, src, width);
+        dst += dstStride;
+        src += srcStride;
+    }
+}
+
+}  // namespace
+
+EncoderInputConverter::EncoderInputConverter()
+    : mFormat(FORMAT_I420),
+      mWidth(0),
+      mHeight(0),
+      mStride(0),
+      mVStride(0),
+      mHalfChromaStride(false),
+      mNumThreads(1),
+      mNumSlices(0),
+      mNextSlice(0),
+      mDoneSlices(0),
+      mStopping(false) {
+}
+
+EncoderInputConverter::~EncoderInputConverter() {
+    stopWorkers();
+}
+
+void EncoderInputConverter::configure(
+        Format format, uint32_t width, uint32_t height, uint32_t stride, uint32_t vstride,
+        bool halfChromaStride) {
+    mFormat = format;
+    mWidth = width;
+    mHeight = height;
+    mStride = stride;
+    mVStride = vstride;
+    mHalfChromaStride = halfChromaStride;
+    releaseAll();
+}
+
+void EncoderInputConverter::setNumThreads(size_t numThreads) {
+    numThreads = std::max(numThreads, (size_t)1);
+    if (numThreads != mNumThreads) {
+        // workers are started again on the next conversion that needs them
+        stopWorkers();
+        mNumThreads = numThreads;
+    }
+}
+
+// static
+bool EncoderInputConverter::GetDirectFormat(
+        const C2GraphicView &view, bool halfChromaStride, Format *format) {
+    if (view.layout().type != C2PlanarLayout::TYPE_YUV || !IsYUV420(view)) {
+        return false;
+    }
+    const C2PlanarLayout &layout = view.layout();
+    const C2PlaneInfo &y = layout.planes[C2PlanarLayout::PLANE_Y];
+    const C2PlaneInfo &u = layout.planes[C2PlanarLayout::PLANE_U];
+    const C2PlaneInfo &v = layout.planes[C2PlanarLayout::PLANE_V];
+    if (y.colInc != 1) {
+        return false;
+    }
+    if (u.colInc == 1 && v.colInc == 1) {
+        if (halfChromaStride && (u.rowInc != v.rowInc || y.rowInc != 2 * v.rowInc)) {
+            return false;
+        }
+        *format = FORMAT_I420;
+        return true;
+    }
+    if (IsNV12(view)) {
+        *format = FORMAT_NV12;
+        return true;
+    }
+    if (IsNV21(view)) {
+        *format = FORMAT_NV21;
+        return true;
+    }
+    return false;
+}
+
+c2_status_t EncoderInputConverter::convert(const C2GraphicView &view, Frame *frame) {
+    if (view.width() < mWidth || view.height() < mHeight) {
+        ALOGW("unexpected input size %ux%u for %ux%u",
+              view.width(), view.height(), mWidth, mHeight);
+        return C2_BAD_VALUE;
+    }
+    const C2GraphicView src = view.subView(C2Rect(mWidth, mHeight));
+    const C2PlanarLayout &layout = src.layout();
+    Format format;
+    bool rgb = false;
+    switch (layout.type) {
+        case C2PlanarLayout::TYPE_RGB:
+            [[fallthrough]];
+        case C2PlanarLayout::TYPE_RGBA:
+            rgb = true;
+            break;
+
+        case C2PlanarLayout::TYPE_YUV:
+            if (!IsYUV420(src)) {
+                ALOGE("input is not YUV420");
+                return C2_BAD_VALUE;
+            }
+            if (GetDirectFormat(src, mHalfChromaStride, &format) && format == mFormat) {
+                frame->y = src.data()[C2PlanarLayout::PLANE_Y];
+                frame->u = src.data()[C2PlanarLayout::PLANE_U];
+                frame->v = src.data()[C2PlanarLayout::PLANE_V];
+                frame->yStride = layout.planes[C2PlanarLayout::PLANE_Y].rowInc;
+                frame->uStride = layout.planes[C2PlanarLayout::PLANE_U].rowInc;
+                frame->vStride = layout.planes[C2PlanarLayout::PLANE_V].rowInc;
+                frame->converted = false;
+                return C2_OK;
+            }
+            break;
+
+        case C2PlanarLayout::TYPE_YUVA:
+            ALOGE("YUVA plane type is not supported");
+            return C2_BAD_VALUE;
+
+        default:
+            ALOGE("Unrecognized plane type: %d", layout.type);
+            return C2_BAD_VALUE;
+    }
+
+    MemoryBlock buffer = mBuffers.fetch(bufferSize(rgb));
+    if (buffer.size() < bufferSize(rgb)) {
+        ALOGE("could not allocate conversion buffer of size %zu", bufferSize(rgb));
+        return C2_NO_MEMORY;
+    }
+    if (rgb) {
+        c2_status_t err = convertRGB(src, buffer.data());
+        if (err != C2_OK) {
+            return err;
+        }
+    } else if (GetDirectFormat(src, false /* halfChromaStride */, &format)
+            && format == mFormat) {
+        copyPlanes(src, buffer.data());
+    } else {
+        MediaImage2 img;
+        if (mFormat == FORMAT_I420) {
+            img = CreateYUV420PlanarMediaImage2(mWidth, mHeight, mStride, mVStride);
+        } else {
+            img = CreateYUV420SemiPlanarMediaImage2(mWidth, mHeight, mStride, mVStride);
+            if (mFormat == FORMAT_NV21) {
+                std::swap(img.mPlane[img.U].mOffset, img.mPlane[img.V].mOffset);
+            }
+        }
+        status_t err = ImageCopy(buffer.data(), &img, src);
+        if (err != OK) {
+            ALOGE("Buffer conversion failed: %d", err);
+            return C2_BAD_VALUE;
+        }
+    }
+    getFrame(buffer.data(), rgb, frame);
+    mBuffersInUse.emplace(buffer.data(), buffer);
+    return C2_OK;
+}
+
+void EncoderInputConverter::release(const void *y) {
+    mBuffersInUse.erase(y);
+}
+
+void EncoderInputConverter::releaseAll() {
+    mBuffersInUse.clear();
+}
+
+size_t EncoderInputConverter::bufferSize(bool rgb) const {
+    size_t size = (size_t)mStride * mVStride * 3 / 2;
+    if (rgb && mFormat != FORMAT_I420) {
+        // RGB is converted to planar chroma first, which is then interleaved after it
+        size += (size_t)mStride * mVStride / 2;
+    }
+    return size;
+}
+
+void EncoderInputConverter::getFrame(uint8_t *buffer, bool rgb, Frame *frame) const {
+    uint8_t *chroma = buffer + (size_t)mStride * mVStride;
+    frame->y = buffer;
+    frame->yStride = mStride;
+    if (mFormat == FORMAT_I420) {
+        frame->u = chroma;
+        frame->v = chroma + (size_t)(mStride / 2) * (mVStride / 2);
+        frame->uStride = frame->vStride = mStride / 2;
+    } else {
+        if (rgb) {
+            chroma += (size_t)mStride * mVStride / 2;
+        }
+        frame->u = mFormat == FORMAT_NV12 ? chroma : chroma + 1;
+        frame->v = mFormat == FORMAT_NV12 ? chroma + 1 : chroma;
+        frame->uStride = frame->vStride = mStride;
+    }
+    frame->converted = true;
+}
+
+void EncoderInputConverter::copyPlanes(const C2GraphicView &src, uint8_t *dst) const {
+    Frame frame;
+    getFrame(dst, false /* rgb */, &frame);
+    const C2PlanarLayout &layout = src.layout();
+    CopyPlane(const_cast<uint8_t *>(frame.y), frame.yStride,
+              src.data()[C2PlanarLayout::PLANE_Y], layout.planes[C2PlanarLayout::PLANE_Y].rowInc,
+              mWidth, mHeight);
+    if (mFormat == FORMAT_I420) {
+        CopyPlane(const_cast<uint8_t *>(frame.u), frame.uStride,
+                  src.data()[C2PlanarLayout::PLANE_U],
+                  layout.planes[C2PlanarLayout::PLANE_U].rowInc, mWidth / 2, mHeight / 2);
+        CopyPlane(const_cast<uint8_t *>(frame.v), frame.vStride,
+                  src.data()[C2PlanarLayout::PLANE_V],
+                  layout.planes[C2PlanarLayout::PLANE_V].rowInc, mWidth / 2, mHeight / 2);
+    } else {
+        // the interleaved chroma plane starts with the first of U and V
+        const uint8_t *chroma = std::min(src.data()[C2PlanarLayout::PLANE_U],
+                                         src.data()[C2PlanarLayout::PLANE_V]);
+        CopyPlane(const_cast<uint8_t *>(std::min(frame.u, frame.v)), frame.uStride,
+                  chroma, layout.planes[C2PlanarLayout::PLANE_U].rowInc, mWidth, mHeight / 2);
+    }
+}
+
+c2_status_t EncoderInputConverter::convertRGB(const C2GraphicView &src, uint8_t *dst) {
+    size_t planarSize = (size_t)mStride * mVStride * 3 / 2;
+    size_t numSlices = std::max(std::min(mNumThreads, mHeight / kMinSliceRows), (size_t)1);
+    // slices start at even rows as chroma rows are shared by two rows
+    size_t sliceRows = (((mHeight + numSlices - 1) / numSlices) + 1) & ~(size_t)1;
+    std::vector<status_t> results(numSlices, OK);
+    runSlices(numSlices, [this, &src, dst, planarSize, sliceRows, &results](size_t slice) {
+        size_t startRow = slice * sliceRows;
+        size_t endRow = std::min(startRow + sliceRows, (size_t)mHeight);
+        if (startRow >= endRow) {
+            return;
+        }
+        results[slice] = ConvertRGBRowsToPlanarYUV(
+                dst, mStride, mVStride, planarSize, src, startRow, endRow);
+        if (results[slice] != OK || mFormat == FORMAT_I420) {
+            return;
+        }
+        const uint8_t *u = dst + (size_t)mStride * mVStride;
+        const uint8_t *v = u + (size_t)(mStride / 2) * (mVStride / 2);
+        const uint8_t *first = mFormat == FORMAT_NV12 ? u : v;
+        const uint8_t *second = mFormat == FORMAT_NV12 ? v : u;
+        uint8_t *chroma = dst + planarSize;
+        for (size_t row = startRow / 2; row < endRow / 2; ++row) {
+            const uint8_t *firstRow = first + row * (mStride / 2);
+            const uint8_t *secondRow = second + row * (mStride / 2);
+            uint8_t *chromaRow = chroma + row * mStride;
+            for (size_t i = 0; i < mWidth / 2; ++i) {
+                chromaRow[2 * i] = firstRow[i];
+                chromaRow[2 * i + 1] = secondRow[i];
+            }
+        }
+    });
+    for (status_t result : results) {
+        if (result != OK) {
+            ALOGE("RGB conversion failed: %d", result);
+            return C2_NO_MEMORY;
+        }
+    }
+    return C2_OK;
+}
+
+void EncoderInputConverter::runSlices(
+        size_t numSlices, const std::function<void(size_t)> &slice) {
+    if (numSlices <= 1) {
+        if (numSlices) {
+            slice(0);
+        }
+        return;
+    }
+    while (mWorkers.size() + 1 < mNumThreads) {
+        mWorkers.emplace_back(&EncoderInputConverter::workerLoop, this);
+    }
+
+    std::unique_lock<std::mutex> lock(mLock);
+    mSlice = slice;
+    mNumSlices = numSlices;
+    mNextSlice = 0;
+    mDoneSlices = 0;
+    mWorkCondition.notify_all();
+    while (mNextSlice < mNumSlices) {
+        size_t index = mNextSlice++;
+        lock.unlock();
+        slice(index);
+        lock.lock();
+        ++mDoneSlices;
+    }
+    mDoneCondition.wait(lock, [this] { return mDoneSlices == mNumSlices; });
+    mSlice = nullptr;
+    mNumSlices = 0;
+}
+
+void EncoderInputConverter::workerLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+    while (!mStopping) {
+        if (mNextSlice >= mNumSlices) {
+            mWorkCondition.wait(lock);
+            continue;
+        }
+        // mSlice does not change until all slices are done
+        size_t index = mNextSlice++;
+        lock.unlock();
+        mSlice(index);
+        lock.lock();
+        if (++mDoneSlices == mNumSlices) {
+            mDoneCondition.notify_one();
+        }
+    }
+}
+
+void EncoderInputConverter::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mStopping = true;
+        mWorkCondition.notify_all();
+    }
+    for (std::thread &worker : mWorkers) {
+        worker.join();
+    }
+    mWorkers.clear();
+    std::lock_guard<std::mutex> lock(mLock);
+    mStopping = false;
+}
+
+}  // namespace android
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SharedDisplayBuffers"
+#include <log/log.h>
+
+#include <malloc.h>
+#include <system/graphics.h>
+
+#include <algorithm>
+
+#include <C2PlatformSupport.h>
+#include <Codec2BufferUtils.h>
+#include <SharedDisplayBuffers.h>
+
+namespace android {
+
+namespace {
+
+constexpr size_t kHeapAlignment = 128;
+
+}  // namespace
+
+// Identifies a shared buffer in release notifications.
+struct SharedDisplayBuffers::Release {
+    std::weak_ptr<State> state;
+    uint32_t generation;
+    uint32_t id;
+};
+
+SharedDisplayBuffers::SharedDisplayBuffers()
+    : mState(std::make_shared<State>()),
+      mMaxShared(0),
+      mNumShared(0) {
+    mState->generation = 0;
+}
+
+SharedDisplayBuffers::~SharedDisplayBuffers() {
+    clear();
+}
+
+c2_status_t SharedDisplayBuffers::allocate(
+        const std::shared_ptr<C2BlockPool> &pool, size_t count, size_t maxShared,
+        uint32_t stride, size_t ySize, size_t uvSize) {
+    clear();
+    mMaxShared = maxShared;
+
+    // Buffers of a surface are recycled by the consumer regardless of whether the decoder still
+    // references them, so they cannot be shared.
+    if (pool->getAllocatorId() != C2PlatformAllocatorStore::BUFFERQUEUE) {
+        uint32_t height = (((ySize + stride - 1) / stride) + 1) & ~1;
+        C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+        while (mBuffers.size() < count) {
+            std::shared_ptr<C2GraphicBlock> block;
+            c2_status_t err = pool->fetchGraphicBlock(
+                    stride, height, HAL_PIXEL_FORMAT_YCBCR_420_888, usage, &block);
+            if (err != C2_OK) {
+                ALOGD("fetchGraphicBlock for display buffer failed with status %d", err);
+                break;
+            }
+            std::unique_ptr<C2GraphicView> view =
+                    std::make_unique<C2GraphicView>(block->map().get());
+            if (view->error() != C2_OK || !IsNV12(*view)
+                    || view->layout().planes[C2PlanarLayout::PLANE_Y].rowInc != (int32_t)stride
+                    || view->layout().planes[C2PlanarLayout::PLANE_U].rowInc != (int32_t)stride
+                    || (size_t)stride * (block->height() / 2) < uvSize) {
+                ALOGD("output blocks cannot be used as display buffers");
+                break;
+            }
+            mBuffers.push_back({ view->data()[C2PlanarLayout::PLANE_Y],
+                                 view->data()[C2PlanarLayout::PLANE_U] });
+            mBlocks.push_back(std::move(block));
+            mViews.push_back(std::move(view));
+        }
+        if (mBuffers.size() == count) {
+            ALOGV("sharing %zu output blocks of %ux%u", count, stride, height);
+            return C2_OK;
+        }
+        clear();
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t *mem = (uint8_t *)memalign(kHeapAlignment, ySize + uvSize);
+        if (!mem) {
+            ALOGE("could not allocate display buffer of size %zu", ySize + uvSize);
+            clear();
+            return C2_NO_MEMORY;
+        }
+        mHeap.emplace_back(mem, free);
+        mBuffers.push_back({ mem, mem + ySize });
+    }
+    return C2_OK;
+}
+
+void SharedDisplayBuffers::clear() {
+    {
+        std::lock_guard<std::mutex> lock(mState->lock);
+        ++mState->generation;
+        mState->released.clear();
+    }
+    mMaxShared = 0;
+    mNumShared = 0;
+    mBuffers.clear();
+    mViews.clear();
+    mBlocks.clear();
+    mHeap.clear();
+}
+
+std::shared_ptr<C2Buffer> SharedDisplayBuffers::share(
+        uint32_t id, const uint8_t *y, const uint8_t *uv, uint32_t yStride, uint32_t uvStride,
+        uint32_t width, uint32_t height) {
+    if (id >= mBlocks.size() || mNumShared >= mMaxShared) {
+        return nullptr;
+    }
+    const std::shared_ptr<C2GraphicBlock> &block = mBlocks[id];
+    const C2PlanarLayout &layout = mViews[id]->layout();
+    const Buffer &buffer = mBuffers[id];
+    if ((int32_t)yStride != layout.planes[C2PlanarLayout::PLANE_Y].rowInc
+            || (int32_t)uvStride != layout.planes[C2PlanarLayout::PLANE_U].rowInc
+            || y < buffer.y) {
+        return nullptr;
+    }
+    // The decoder may place the frame anywhere within its padded buffer; express that as a crop.
+    size_t offset = y - buffer.y;
+    uint32_t left = offset % yStride;
+    uint32_t top = offset / yStride;
+    if (((left | top) & 1) || uv != buffer.uv + (top / 2) * uvStride + left
+            || left + width > block->width() || top + height > block->height()) {
+        return nullptr;
+    }
+
+    std::shared_ptr<C2Buffer> output = C2Buffer::CreateGraphicBuffer(
+            block->share(C2Rect(width, height).at(left, top), ::C2Fence()));
+    Release *release = new Release;
+    release->state = mState;
+    release->id = id;
+    {
+        std::lock_guard<std::mutex> lock(mState->lock);
+        release->generation = mState->generation;
+    }
+    if (output->registerOnDestroyNotify(&OnBufferReleased, release) != C2_OK) {
+        delete release;
+        return nullptr;
+    }
+    ++mNumShared;
+    return output;
+}
+
+std::vector<uint32_t> SharedDisplayBuffers::takeReleased() {
+    std::vector<uint32_t> released;
+    {
+        std::lock_guard<std::mutex> lock(mState->lock);
+        released.swap(mState->released);
+    }
+    mNumShared -= std::min(mNumShared, released.size());
+    return released;
+}
+
+// static
+void SharedDisplayBuffers::OnBufferReleased(const C2Buffer *buffer, void *arg) {
+    (void)buffer;
+    std::unique_ptr<Release> release(static_cast<Release *>(arg));
+    std::shared_ptr<State> state = release->state.lock();
+    if (!state) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(state->lock);
+    if (state->generation == release->generation) {
+        state->released.push_back(release->id);
+    }
+}
+
+// static
+c2_status_t SharedDisplayBuffers::CopyFrame(
+        C2GraphicView &view, const uint8_t *y, const uint8_t *uv, uint32_t yStride,
+        uint32_t uvStride, uint32_t width, uint32_t height) {
+    const uint8_t *base = std::min(y, uv);
+    MediaImage2 img = CreateYUV420SemiPlanarMediaImage2(width, height, yStride, height);
+    img.mPlane[MediaImage2::Y].mOffset = y - base;
+    img.mPlane[MediaImage2::U].mOffset = uv - base;
+    img.mPlane[MediaImage2::U].mRowInc = uvStride;
+    img.mPlane[MediaImage2::V].mOffset = uv + 1 - base;
+    img.mPlane[MediaImage2::V].mRowInc = uvStride;
+    view.setCrop_be(C2Rect(width, height));
+    return ImageCopy(view, base, &img) == OK ? C2_OK : C2_CORRUPTED;
+}
+
+}  // namespace android
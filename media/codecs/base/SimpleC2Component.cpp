@@ -21,7 +21,12 @@
 #include <cutils/properties.h>
 #include <media/stagefright/foundation/AMessage.h>
 
+#include <errno.h>
 #include <inttypes.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <algorithm>
 
 #include <C2Config.h>
 #include <C2Debug.h>
@@ -566,4 +571,33 @@ std::shared_ptr<C2Buffer> SimpleC2Component::createGraphicBuffer(
     return C2Buffer::CreateGraphicBuffer(block->share(crop, ::C2Fence()));
 }
 
+// static
+uint32_t SimpleC2Component::LimitWorkerThreads(
+        uint32_t numThreads, const C2WorkerThreadsStruct &workerThreads) {
+    if (workerThreads.maxThreads > 0) {
+        numThreads = std::min(numThreads, workerThreads.maxThreads);
+    }
+    if (workerThreads.cpuMask != 0) {
+        numThreads = std::min(numThreads, (uint32_t)__builtin_popcountll(workerThreads.cpuMask));
+    }
+    return std::max(numThreads, 1u);
+}
+
+// static
+void SimpleC2Component::SetWorkerCpus(const C2WorkerThreadsStruct &workerThreads) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    long numCpus = sysconf(_SC_NPROCESSORS_CONF);
+    for (long cpu = 0; cpu < numCpus && cpu < CPU_SETSIZE; ++cpu) {
+        if (workerThreads.cpuMask == 0
+                || (cpu < 64 && (workerThreads.cpuMask & (1ull << cpu)))) {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    if (sched_setaffinity(0 /* calling thread */, sizeof(cpus), &cpus) != 0) {
+        ALOGW("could not restrict worker threads to CPUs %#" PRIx64 " (errno %d)",
+              workerThreads.cpuMask, errno);
+    }
+}
+
 } // namespace android
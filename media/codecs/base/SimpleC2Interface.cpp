@@ -36,6 +36,7 @@ SimpleInterface<void>::BaseParams::BaseParams(
         std::vector<C2String> aliases)
     : C2InterfaceHelper(reflector) {
     setDerivedInstance(this);
+    shareSchema(name);
 
     addParameter(
             DefineParam(mName, C2_PARAMKEY_COMPONENT_NAME)
@@ -298,6 +299,26 @@ void SimpleInterface<void>::BaseParams::noTimeStretch() {
             .build());
 }
 
+void SimpleInterface<void>::BaseParams::addWorkerThreads() {
+    addParameter(
+            DefineParam(mWorkerThreads, C2_PARAMKEY_WORKER_THREADS)
+            .withDefault(new C2WorkerThreadsTuning(0u, 0u))
+            .withFields({
+                C2F(mWorkerThreads, cpuMask).any(),
+                C2F(mWorkerThreads, maxThreads).any(),
+            })
+            .withSetter(WorkerThreadsSetter)
+            .build());
+}
+
+// static
+C2R SimpleInterface<void>::BaseParams::WorkerThreadsSetter(
+        bool mayBlock, C2P<C2WorkerThreadsTuning> &me) {
+    (void)mayBlock;
+    (void)me;  // any thread count and CPU mask is acceptable
+    return C2R::Ok();
+}
+
 /*
     Clients need to handle the following base params due to custom dependency.
 
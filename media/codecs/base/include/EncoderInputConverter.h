@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ENCODER_INPUT_CONVERTER_H_
+#define ENCODER_INPUT_CONVERTER_H_
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <C2Buffer.h>
+#include <Codec2BufferUtils.h>
+
+namespace android {
+
+/**
+ * Input stage of software video encoders that brings raw graphic input into the YUV 420 layout
+ * the encoder takes.
+ *
+ * Each frame takes the cheapest route for its layout. Input already in the layout of the encoder
+ * is passed through, input that only has other strides has its planes copied row by row, other
+ * YUV 420 input is copied using ImageCopy, and RGB input is converted in row slices on worker
+ * threads.
+ *
+ * Converted frames are held in conversion buffers that stay in use until they are released, so
+ * encoders can hold on to input frames until the encoder library returns them.
+ */
+class EncoderInputConverter {
+public:
+    // YUV 420 layouts of encoder input
+    enum Format {
+        FORMAT_I420,  // planar, U plane before V plane
+        FORMAT_NV12,  // semi-planar, U before V
+        FORMAT_NV21,  // semi-planar, V before U
+    };
+
+    struct Frame {
+        const uint8_t *y;
+        const uint8_t *u;
+        const uint8_t *v;
+        int32_t yStride;
+        int32_t uStride;
+        int32_t vStride;
+        bool converted;  // whether the frame is held in a conversion buffer
+    };
+
+    EncoderInputConverter();
+    ~EncoderInputConverter();
+
+    /**
+     * Sets up conversion to |width| x |height| frames in |format|, with a luma row increment of
+     * |stride| bytes and |vstride| luma rows. If |halfChromaStride| is set, I420 input is only
+     * passed through if the row increment of its chroma planes is half of its luma plane.
+     * Releases all conversion buffers.
+     */
+    void configure(Format format, uint32_t width, uint32_t height, uint32_t stride,
+                   uint32_t vstride, bool halfChromaStride);
+
+    /**
+     * Sets the number of threads RGB input is converted on, including the calling thread.
+     */
+    void setNumThreads(size_t numThreads);
+
+    /**
+     * Brings |view| into the configured layout. Returns C2_BAD_VALUE if |view| is neither RGB nor
+     * YUV 420, or is smaller than the configured size.
+     */
+    c2_status_t convert(const C2GraphicView &view, Frame *frame);
+
+    /**
+     * Releases the conversion buffer of the converted frame whose luma plane is at |y|. This does
+     * nothing for frames that were passed through.
+     */
+    void release(const void *y);
+
+    /**
+     * Releases all conversion buffers.
+     */
+    void releaseAll();
+
+    /**
+     * Returns true if |view| can be passed through as |format|. See configure() for
+     * |halfChromaStride|.
+     */
+    static bool GetDirectFormat(
+            const C2GraphicView &view, bool halfChromaStride, Format *format);
+
+private:
+    size_t bufferSize(bool rgb) const;
+    void copyPlanes(const C2GraphicView &src, uint8_t *dst) const;
+    c2_status_t convertRGB(const C2GraphicView &src, uint8_t *dst);
+    void getFrame(uint8_t *buffer, bool rgb, Frame *frame) const;
+
+    // Runs |slice| for each slice index up to |numSlices| on the worker threads and the calling
+    // thread, and returns once all slices are done.
+    void runSlices(size_t numSlices, const std::function<void(size_t)> &slice);
+    void workerLoop();
+    void stopWorkers();
+
+    Format mFormat;
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mStride;
+    uint32_t mVStride;
+    bool mHalfChromaStride;
+
+    MemoryBlockPool mBuffers;
+    std::map<const void *, MemoryBlock> mBuffersInUse;
+
+    size_t mNumThreads;
+    std::vector<std::thread> mWorkers;
+
+    std::mutex mLock;
+    std::condition_variable mWorkCondition;
+    std::condition_variable mDoneCondition;
+    std::function<void(size_t)> mSlice;
+    size_t mNumSlices;   // GUARDED_BY(mLock)
+    size_t mNextSlice;   // GUARDED_BY(mLock)
+    size_t mDoneSlices;  // GUARDED_BY(mLock)
+    bool mStopping;      // GUARDED_BY(mLock)
+};
+
+}  // namespace android
+
+#endif  // ENCODER_INPUT_CONVERTER_H_
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NAL_BIT_READER_H_
+#define NAL_BIT_READER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace android {
+
+/**
+ * Returns the offset of the first byte after the next Annex B start code at or after |offset| in
+ * |data|, or |size| if there is none.
+ */
+inline size_t FindNalStart(const uint8_t *data, size_t size, size_t offset) {
+    for (size_t i = offset; i + 3 <= size; ++i) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            return i + 3;
+        }
+    }
+    return size;
+}
+
+/**
+ * Reads the RBSP of an H.264 or H.265 NAL unit, skipping emulation prevention bytes.
+ *
+ * Reading past the end of the data yields zero bits and sets the error flag, so parsers can read
+ * a whole syntax structure and check error() once.
+ */
+class NalBitReader {
+public:
+    NalBitReader(const uint8_t *data, size_t size)
+        : mData(data), mSize(size), mPos(0), mNumZeros(0), mByte(0), mBitsLeft(0),
+          mError(false) {}
+
+    uint32_t readBits(uint32_t numBits) {
+        uint32_t value = 0;
+        while (numBits--) {
+            if (mBitsLeft == 0) {
+                loadByte();
+            }
+            --mBitsLeft;
+            value = (value << 1) | ((mByte >> mBitsLeft) & 1);
+        }
+        return value;
+    }
+
+    void skipBits(uint32_t numBits) {
+        while (numBits > 32) {
+            readBits(32);
+            numBits -= 32;
+        }
+        readBits(numBits);
+    }
+
+    bool readFlag() { return readBits(1) != 0; }
+
+    uint32_t readUE() {
+        uint32_t leadingZeros = 0;
+        while (!readFlag()) {
+            if (mError || ++leadingZeros > 31) {
+                mError = true;
+                return 0;
+            }
+        }
+        return (uint32_t)((1ull << leadingZeros) - 1) + readBits(leadingZeros);
+    }
+
+    int32_t readSE() {
+        uint32_t value = readUE();
+        return (value & 1) ? (int32_t)((value >> 1) + 1) : -(int32_t)(value >> 1);
+    }
+
+    bool error() const { return mError; }
+
+private:
+    void loadByte() {
+        if (mPos < mSize && mNumZeros >= 2 && mData[mPos] == 3) {
+            // emulation prevention byte
+            ++mPos;
+            mNumZeros = 0;
+        }
+        if (mPos >= mSize) {
+            mError = true;
+            mByte = 0;
+        } else {
+            mByte = mData[mPos++];
+            mNumZeros = mByte == 0 ? mNumZeros + 1 : 0;
+        }
+        mBitsLeft = 8;
+    }
+
+    const uint8_t *mData;
+    size_t mSize;
+    size_t mPos;
+    uint32_t mNumZeros;
+    uint8_t mByte;
+    uint32_t mBitsLeft;
+    bool mError;
+};
+
+}  // namespace android
+
+#endif  // NAL_BIT_READER_H_
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SHARED_DISPLAY_BUFFERS_H_
+#define SHARED_DISPLAY_BUFFERS_H_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <C2Buffer.h>
+
+namespace android {
+
+/**
+ * Display buffers shared between a software decoder and its client.
+ *
+ * The decoder decodes into these NV12 buffers and keeps referencing them, so a buffer may only be
+ * handed back to the decoder once the client has released the output buffer it was shared in.
+ * Releases are observed through C2Buffer destroy notifications, which is only correct if the
+ * client holds the C2Buffer returned by share() itself, i.e. if it is in the same process.
+ *
+ * Buffers are backed by output blocks when the output pool provides them in a layout the decoder
+ * can write to, in which case decoded frames are output without copying. Otherwise they are backed
+ * by heap memory and decoded frames have to be copied into output blocks.
+ *
+ * Only a limited number of buffers is shared with the client at a time, so that the decoder never
+ * runs out of buffers to decode into however many output buffers the client holds. Frames decoded
+ * beyond that limit have to be copied as well.
+ */
+class SharedDisplayBuffers {
+public:
+    struct Buffer {
+        uint8_t *y;   // luma plane
+        uint8_t *uv;  // interleaved chroma plane
+    };
+
+    SharedDisplayBuffers();
+    ~SharedDisplayBuffers();
+
+    /**
+     * Allocates |count| buffers with a luma plane of |ySize| bytes and a chroma plane of |uvSize|
+     * bytes, of which at most |maxShared| are shared with the client at a time. Frames are expected
+     * to be decoded with a row increment of |stride| bytes in both planes. Any previously allocated
+     * buffers are cleared.
+     */
+    c2_status_t allocate(
+            const std::shared_ptr<C2BlockPool> &pool, size_t count, size_t maxShared,
+            uint32_t stride, size_t ySize, size_t uvSize);
+
+    /**
+     * Drops all buffers. Buffers still held by the client return to the pool once released, and
+     * are no longer reported by takeReleased().
+     */
+    void clear();
+
+    size_t size() const { return mBuffers.size(); }
+    bool empty() const { return mBuffers.empty(); }
+    const Buffer &operator[](size_t id) const { return mBuffers[id]; }
+
+    /**
+     * Returns an output buffer for the |width| x |height| frame decoded into buffer |id| at |y|
+     * and |uv|, or nullptr if the frame cannot be output without copying, including when the
+     * client already holds the maximum number of shared buffers. Once the client releases the
+     * returned buffer, |id| is reported by takeReleased().
+     */
+    std::shared_ptr<C2Buffer> share(
+            uint32_t id, const uint8_t *y, const uint8_t *uv, uint32_t yStride, uint32_t uvStride,
+            uint32_t width, uint32_t height);
+
+    /**
+     * Returns the ids of shared buffers released by the client since the last call.
+     */
+    std::vector<uint32_t> takeReleased();
+
+    /**
+     * Copies the |width| x |height| NV12 frame at |y| and |uv| into |view|.
+     */
+    static c2_status_t CopyFrame(
+            C2GraphicView &view, const uint8_t *y, const uint8_t *uv, uint32_t yStride,
+            uint32_t uvStride, uint32_t width, uint32_t height);
+
+private:
+    // Shared with the release notifications of buffers held by the client, which may outlive us.
+    struct State {
+        std::mutex lock;
+        uint32_t generation;
+        std::vector<uint32_t> released;
+    };
+
+    struct Release;
+
+    static void OnBufferReleased(const C2Buffer *buffer, void *arg);
+
+    std::shared_ptr<State> mState;
+    size_t mMaxShared;
+    // buffers shared with the client that have not been reported by takeReleased() yet
+    size_t mNumShared;
+    std::vector<Buffer> mBuffers;
+    std::vector<std::shared_ptr<C2GraphicBlock>> mBlocks;
+    std::vector<std::unique_ptr<C2GraphicView>> mViews;
+    std::vector<std::unique_ptr<uint8_t, void (*)(void *)>> mHeap;
+};
+
+}  // namespace android
+
+#endif  // SHARED_DISPLAY_BUFFERS_H_
@@ -21,6 +21,7 @@
 #include <unordered_map>
 
 #include <C2Component.h>
+#include <C2Config.h>
 
 #include <media/stagefright/foundation/AHandler.h>
 #include <media/stagefright/foundation/ALooper.h>
@@ -152,6 +153,19 @@ protected:
             const std::shared_ptr<C2GraphicBlock> &block,
             const C2Rect &crop);
 
+    /**
+     * Returns |numThreads| capped at what |workerThreads| allows, but at least 1.
+     */
+    static uint32_t LimitWorkerThreads(
+            uint32_t numThreads, const C2WorkerThreadsStruct &workerThreads);
+
+    /**
+     * Restricts the calling thread to the CPUs allowed by |workerThreads|. Called on the
+     * component thread, this also covers worker threads the codec library creates from it
+     * afterwards, as they inherit the CPUs of their creator.
+     */
+    static void SetWorkerCpus(const C2WorkerThreadsStruct &workerThreads);
+
     static constexpr uint32_t NO_DRAIN = ~0u;
 
     C2ReadView mDummyReadView;
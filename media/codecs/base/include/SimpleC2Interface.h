@@ -123,6 +123,13 @@ public:
         /// must add support for C2ComponentTimeStretchTuning.
         void noTimeStretch();
 
+        /// Adds support for C2WorkerThreadsTuning. The component must then limit its worker
+        /// threads accordingly, both at start and when the tuning changes.
+        void addWorkerThreads();
+
+        /// Setter for C2WorkerThreadsTuning, for components that define it themselves.
+        static C2R WorkerThreadsSetter(bool mayBlock, C2P<C2WorkerThreadsTuning> &me);
+
         std::shared_ptr<C2ApiLevelSetting> mApiLevel;
         std::shared_ptr<C2ApiFeaturesSetting> mApiFeatures;
 
@@ -135,6 +142,7 @@ public:
         std::shared_ptr<C2ComponentDomainSetting> mDomain;
         std::shared_ptr<C2ComponentAttributesSetting> mAttrib;
         std::shared_ptr<C2ComponentTimeStretchTuning> mTimeStretch;
+        std::shared_ptr<C2WorkerThreadsTuning> mWorkerThreads;
 
         std::shared_ptr<C2PortMediaTypeSetting::input> mInputMediaType;
         std::shared_ptr<C2PortMediaTypeSetting::output> mOutputMediaType;
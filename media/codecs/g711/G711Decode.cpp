@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "G711Decode.h"
+
+namespace android {
+
+namespace {
+
+// Expands one A-law sample. This is the reference for the table and the
+// vector paths below, which must produce identical output.
+constexpr int16_t ALawToLinear(uint8_t x) {
+    int32_t ix = x ^ 0x55;
+    ix &= 0x7f;
+
+    int32_t iexp = ix >> 4;
+    int32_t mant = ix & 0x0f;
+
+    if (iexp > 0) {
+        mant += 16;
+    }
+
+    mant = (mant << 4) + 8;
+
+    if (iexp > 1) {
+        mant = mant << (iexp - 1);
+    }
+
+    return (x > 127) ? mant : -mant;
+}
+
+// Expands one mu-law sample. This is the reference for the table and the
+// vector paths below, which must produce identical output.
+constexpr int16_t MLawToLinear(uint8_t x) {
+    int32_t mantissa = ~x;
+    int32_t exponent = (mantissa >> 4) & 7;
+    int32_t segment = exponent + 1;
+    mantissa &= 0x0f;
+
+    int32_t step = 4 << segment;
+
+    int32_t abs = (0x80l << exponent) + step * mantissa + step / 2 - 4 * 33;
+
+    return (x < 0x80) ? -abs : abs;
+}
+
+// Expansion of all 256 code words.
+struct G711Table {
+    int16_t value[256];
+
+    constexpr explicit G711Table(int16_t (*expand)(uint8_t)) : value() {
+        for (int i = 0; i < 256; ++i) {
+            value[i] = expand(uint8_t(i));
+        }
+    }
+};
+
+constexpr G711Table kALawTable(ALawToLinear);
+constexpr G711Table kMLawTable(MLawToLinear);
+
+// Decodes as many samples as possible with vector instructions and returns
+// the number of samples decoded. The remaining samples are decoded from the
+// table.
+//
+// Both laws compute the magnitude as (base << exponent) per sample. A 16-byte
+// table covers the 8 possible exponents, so this maps to a byte shuffle and a
+// 16-bit multiply on x86 and to a per-lane shift on ARM.
+#if defined(__SSSE3__)
+
+template <bool kALaw>
+size_t DecodeVector(int16_t *out, const uint8_t *in, size_t inSize) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    size_t i = 0;
+    for (; i + 16 <= inSize; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        __m128i mant;
+        __m128i scale;
+        if (kALaw) {
+            const __m128i kLead = _mm_setr_epi8(
+                    0, 16, 16, 16, 16, 16, 16, 16, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i kPow2 = _mm_setr_epi8(
+                    1, 1, 2, 4, 8, 16, 32, 64, 0, 0, 0, 0, 0, 0, 0, 0);
+            __m128i ix = _mm_and_si128(
+                    _mm_xor_si128(x, _mm_set1_epi8(0x55)), _mm_set1_epi8(0x7f));
+            __m128i exponent = _mm_and_si128(_mm_srli_epi16(ix, 4), _mm_set1_epi8(0x07));
+            mant = _mm_or_si128(
+                    _mm_and_si128(ix, _mm_set1_epi8(0x0f)), _mm_shuffle_epi8(kLead, exponent));
+            scale = _mm_shuffle_epi8(kPow2, exponent);
+        } else {
+            const __m128i kPow2 = _mm_setr_epi8(
+                    1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0);
+            __m128i m = _mm_xor_si128(x, _mm_set1_epi8((char)0xff));
+            __m128i exponent = _mm_and_si128(_mm_srli_epi16(m, 4), _mm_set1_epi8(0x07));
+            mant = _mm_and_si128(m, _mm_set1_epi8(0x0f));
+            scale = _mm_shuffle_epi8(kPow2, exponent);
+        }
+        const __m128i shiftBias = _mm_set1_epi16(kALaw ? 8 : 0x84);
+        const __m128i offset = _mm_set1_epi16(kALaw ? 0 : 0x84);
+        const int mantShift = kALaw ? 4 : 3;
+
+        // Code words below 0x80 decode to negative samples in both laws.
+        __m128i negative = _mm_cmpgt_epi8(x, _mm_set1_epi8(-1));
+
+        __m128i mantLo = _mm_unpacklo_epi8(mant, zero);
+        __m128i mantHi = _mm_unpackhi_epi8(mant, zero);
+        __m128i absLo = _mm_sub_epi16(_mm_mullo_epi16(
+                _mm_add_epi16(_mm_slli_epi16(mantLo, mantShift), shiftBias),
+                _mm_unpacklo_epi8(scale, zero)), offset);
+        __m128i absHi = _mm_sub_epi16(_mm_mullo_epi16(
+                _mm_add_epi16(_mm_slli_epi16(mantHi, mantShift), shiftBias),
+                _mm_unpackhi_epi8(scale, zero)), offset);
+        __m128i signLo = _mm_or_si128(_mm_unpacklo_epi8(negative, negative), one);
+        __m128i signHi = _mm_or_si128(_mm_unpackhi_epi8(negative, negative), one);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_sign_epi16(absLo, signLo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), _mm_sign_epi16(absHi, signHi));
+    }
+    return i;
+}
+
+#elif defined(__ARM_NEON)
+
+template <bool kALaw>
+size_t DecodeVector(int16_t *out, const uint8_t *in, size_t inSize) {
+    size_t i = 0;
+    for (; i + 8 <= inSize; i += 8) {
+        uint16x8_t x = vmovl_u8(vld1_u8(in + i));
+        int16x8_t abs;
+        if (kALaw) {
+            uint16x8_t ix = vandq_u16(veorq_u16(x, vdupq_n_u16(0x55)), vdupq_n_u16(0x7f));
+            uint16x8_t exponent = vshrq_n_u16(ix, 4);
+            uint16x8_t mant = vandq_u16(ix, vdupq_n_u16(0x0f));
+            mant = vorrq_u16(
+                    mant, vandq_u16(vcgtq_u16(exponent, vdupq_n_u16(0)), vdupq_n_u16(16)));
+            mant = vaddq_u16(vshlq_n_u16(mant, 4), vdupq_n_u16(8));
+            int16x8_t shift = vreinterpretq_s16_u16(vqsubq_u16(exponent, vdupq_n_u16(1)));
+            abs = vreinterpretq_s16_u16(vshlq_u16(mant, shift));
+        } else {
+            uint16x8_t m = veorq_u16(x, vdupq_n_u16(0xff));
+            int16x8_t shift = vreinterpretq_s16_u16(
+                    vshrq_n_u16(vandq_u16(m, vdupq_n_u16(0x70)), 4));
+            uint16x8_t mant = vandq_u16(m, vdupq_n_u16(0x0f));
+            mant = vaddq_u16(vshlq_n_u16(mant, 3), vdupq_n_u16(0x84));
+            abs = vreinterpretq_s16_u16(
+                    vsubq_u16(vshlq_u16(mant, shift), vdupq_n_u16(0x84)));
+        }
+        // Code words below 0x80 decode to negative samples in both laws.
+        uint16x8_t negative = vcltq_u16(x, vdupq_n_u16(0x80));
+        vst1q_s16(out + i, vbslq_s16(negative, vnegq_s16(abs), abs));
+    }
+    return i;
+}
+
+#else
+
+template <bool kALaw>
+size_t DecodeVector(int16_t *, const uint8_t *, size_t) {
+    return 0;
+}
+
+#endif
+
+template <bool kALaw>
+void DecodeG711(int16_t *out, const uint8_t *in, size_t inSize) {
+    const G711Table &table = kALaw ? kALawTable : kMLawTable;
+    size_t done = DecodeVector<kALaw>(out, in, inSize);
+    for (size_t i = done; i < inSize; ++i) {
+        out[i] = table.value[in[i]];
+    }
+}
+
+}  // namespace
+
+void DecodeALaw(int16_t *out, const uint8_t *in, size_t inSize) {
+    DecodeG711<true>(out, in, inSize);
+}
+
+void DecodeMLaw(int16_t *out, const uint8_t *in, size_t inSize) {
+    DecodeG711<false>(out, in, inSize);
+}
+
+size_t DecodeALawVector(int16_t *out, const uint8_t *in, size_t inSize) {
+    return DecodeVector<true>(out, in, inSize);
+}
+
+size_t DecodeMLawVector(int16_t *out, const uint8_t *in, size_t inSize) {
+    return DecodeVector<false>(out, in, inSize);
+}
+
+}  // namespace android
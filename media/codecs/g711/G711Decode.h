@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_G711_DECODE_H_
+#define ANDROID_G711_DECODE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace android {
+
+// Decodes |inSize| A-law or mu-law code words from |in| into 16-bit linear
+// samples in |out|.
+void DecodeALaw(int16_t *out, const uint8_t *in, size_t inSize);
+void DecodeMLaw(int16_t *out, const uint8_t *in, size_t inSize);
+
+// Decodes as many leading code words as the vector path of this target handles
+// and returns their number. The rest are left to the table. Exposed for tests.
+size_t DecodeALawVector(int16_t *out, const uint8_t *in, size_t inSize);
+size_t DecodeMLawVector(int16_t *out, const uint8_t *in, size_t inSize);
+
+}  // namespace android
+
+#endif  // ANDROID_G711_DECODE_H_
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "G711Decode.h"
+
+namespace android {
+
+namespace {
+
+// Scalar per-sample decoders that the table and vector paths must match bit for bit.
+void ReferenceALaw(int16_t *out, const uint8_t *in, size_t inSize) {
+    while (inSize > 0) {
+        inSize--;
+        int32_t x = *in++;
+
+        int32_t ix = x ^ 0x55;
+        ix &= 0x7f;
+
+        int32_t iexp = ix >> 4;
+        int32_t mant = ix & 0x0f;
+
+        if (iexp > 0) {
+            mant += 16;
+        }
+
+        mant = (mant << 4) + 8;
+
+        if (iexp > 1) {
+            mant = mant << (iexp - 1);
+        }
+
+        *out++ = (x > 127) ? mant : -mant;
+    }
+}
+
+void ReferenceMLaw(int16_t *out, const uint8_t *in, size_t inSize) {
+    while (inSize > 0) {
+        inSize--;
+        int32_t x = *in++;
+
+        int32_t mantissa = ~x;
+        int32_t exponent = (mantissa >> 4) & 7;
+        int32_t segment = exponent + 1;
+        mantissa &= 0x0f;
+
+        int32_t step = 4 << segment;
+
+        int32_t abs = (0x80l << exponent) + step * mantissa + step / 2 - 4 * 33;
+
+        *out++ = (x < 0x80) ? -abs : abs;
+    }
+}
+
+typedef void (*DecodeFn)(int16_t *, const uint8_t *, size_t);
+typedef size_t (*DecodeVectorFn)(int16_t *, const uint8_t *, size_t);
+
+struct Law {
+    const char *name;
+    DecodeFn decode;
+    DecodeVectorFn decodeVector;
+    DecodeFn reference;
+};
+
+const Law kLaws[] = {
+    { "alaw", DecodeALaw, DecodeALawVector, ReferenceALaw },
+    { "mlaw", DecodeMLaw, DecodeMLawVector, ReferenceMLaw },
+};
+
+// All 256 code words in an order that puts every code word in every lane over the buffer.
+std::vector<uint8_t> AllCodeWords(size_t size) {
+    std::vector<uint8_t> in(size);
+    for (size_t i = 0; i < size; ++i) {
+        in[i] = uint8_t(i * 37 + i / 256);
+    }
+    return in;
+}
+
+}  // namespace
+
+class G711DecodeTest : public ::testing::TestWithParam<Law> {
+};
+
+TEST_P(G711DecodeTest, AllCodeWords) {
+    const Law &law = GetParam();
+    std::vector<uint8_t> in(256);
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = uint8_t(i);
+    }
+    std::vector<int16_t> expected(in.size());
+    law.reference(expected.data(), in.data(), in.size());
+
+    std::vector<int16_t> out(in.size());
+    law.decode(out.data(), in.data(), in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        ASSERT_EQ(expected[i], out[i]) << law.name << " code word " << i;
+    }
+}
+
+TEST_P(G711DecodeTest, VectorPathOnly) {
+    const Law &law = GetParam();
+    std::vector<uint8_t> in = AllCodeWords(4096);
+    std::vector<int16_t> expected(in.size());
+    law.reference(expected.data(), in.data(), in.size());
+
+    // the vector path writes exactly the samples it reports
+    std::vector<int16_t> out(in.size(), 0x5a5a);
+    size_t done = law.decodeVector(out.data(), in.data(), in.size());
+    ASSERT_LE(done, in.size());
+#if defined(__SSSE3__) || defined(__ARM_NEON)
+    EXPECT_GT(done, in.size() - 16) << law.name << " vector path not taken";
+#endif
+    for (size_t i = 0; i < done; ++i) {
+        ASSERT_EQ(expected[i], out[i]) << law.name << " sample " << i << " code " << int(in[i]);
+    }
+    for (size_t i = done; i < in.size(); ++i) {
+        ASSERT_EQ(0x5a5a, out[i]) << law.name << " sample " << i << " written past " << done;
+    }
+}
+
+TEST_P(G711DecodeTest, TailLengths) {
+    const Law &law = GetParam();
+    std::vector<uint8_t> all = AllCodeWords(300);
+    // cover lengths that are not a multiple of the vector width of any target, at unaligned
+    // input and output offsets
+    for (size_t offset = 0; offset < 3; ++offset) {
+        for (size_t size = 0; size + offset <= all.size(); ++size) {
+            const uint8_t *in = all.data() + offset;
+            std::vector<int16_t> expected(size + offset);
+            law.reference(expected.data() + offset, in, size);
+
+            std::vector<int16_t> out(size + offset + 1, 0x5a5a);
+            law.decode(out.data() + offset, in, size);
+            for (size_t i = 0; i < size; ++i) {
+                ASSERT_EQ(expected[offset + i], out[offset + i])
+                        << law.name << " size " << size << " offset " << offset
+                        << " sample " << i;
+            }
+            ASSERT_EQ(0x5a5a, out[offset + size]) << law.name << " size " << size;
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Laws, G711DecodeTest, ::testing::ValuesIn(kLaws));
+
+}  // namespace android
@@ -26,6 +26,7 @@
 #include <SimpleC2Interface.h>
 
 #include "C2SoftHevcDec.h"
+#include "HevcSps.h"
 #include "ihevcd_cxa.h"
 
 namespace android {
@@ -50,6 +51,7 @@ public:
         noOutputReferences();
         noInputLatency();
         noTimeStretch();
+        addWorkerThreads();
 
         // TODO: output latency and reordering
 
@@ -185,6 +187,27 @@ public:
                 .withConstValue(new C2StreamPixelFormatInfo::output(
                                      0u, HAL_PIXEL_FORMAT_YCBCR_420_888))
                 .build());
+
+        addParameter(
+                DefineParam(mSharedBuffers, C2_PARAMKEY_OUTPUT_SHARED_BUFFERS)
+                .withDefault(new C2PortSharedBuffersTuning::output(C2_FALSE))
+                .withFields({C2F(mSharedBuffers, value).oneOf({ C2_FALSE, C2_TRUE })})
+                .withSetter(Setter<decltype(*mSharedBuffers)>::NonStrictValueWithNoDeps)
+                .build());
+
+        addParameter(
+                DefineParam(mLowLatency, C2_PARAMKEY_LOW_LATENCY_MODE)
+                .withDefault(new C2GlobalLowLatencyModeTuning(C2_FALSE))
+                .withFields({C2F(mLowLatency, value).oneOf({ C2_FALSE, C2_TRUE })})
+                .withSetter(Setter<decltype(*mLowLatency)>::NonStrictValueWithNoDeps)
+                .build());
+
+        addParameter(
+                DefineParam(mKeyFramesOnly, C2_PARAMKEY_KEY_FRAMES_ONLY)
+                .withDefault(new C2GlobalKeyFramesOnlyTuning(C2_FALSE))
+                .withFields({C2F(mKeyFramesOnly, value).oneOf({ C2_FALSE, C2_TRUE })})
+                .withSetter(Setter<decltype(*mKeyFramesOnly)>::NonStrictValueWithNoDeps)
+                .build());
     }
 
     static C2R SizeSetter(bool mayBlock, const C2P<C2StreamPictureSizeInfo::output> &oldMe,
@@ -275,10 +298,30 @@ public:
         return C2R::Ok();
     }
 
+    std::shared_ptr<C2StreamMaxPictureSizeTuning::output> getMaxSize_l() {
+        return mMaxSize;
+    }
+
     std::shared_ptr<C2StreamColorAspectsInfo::output> getColorAspects_l() {
         return mColorAspects;
     }
 
+    std::shared_ptr<C2PortSharedBuffersTuning::output> getSharedBuffers_l() {
+        return mSharedBuffers;
+    }
+
+    std::shared_ptr<C2WorkerThreadsTuning> getWorkerThreads_l() {
+        return mWorkerThreads;
+    }
+
+    std::shared_ptr<C2GlobalLowLatencyModeTuning> getLowLatencyMode_l() {
+        return mLowLatency;
+    }
+
+    std::shared_ptr<C2GlobalKeyFramesOnlyTuning> getKeyFramesOnly_l() {
+        return mKeyFramesOnly;
+    }
+
 private:
     std::shared_ptr<C2StreamProfileLevelInfo::input> mProfileLevel;
     std::shared_ptr<C2StreamPictureSizeInfo::output> mSize;
@@ -289,6 +332,9 @@ private:
     std::shared_ptr<C2StreamColorAspectsTuning::output> mDefaultColorAspects;
     std::shared_ptr<C2StreamColorAspectsInfo::output> mColorAspects;
     std::shared_ptr<C2StreamPixelFormatInfo::output> mPixelFormat;
+    std::shared_ptr<C2PortSharedBuffersTuning::output> mSharedBuffers;
+    std::shared_ptr<C2GlobalLowLatencyModeTuning> mLowLatency;
+    std::shared_ptr<C2GlobalKeyFramesOnlyTuning> mKeyFramesOnly;
 };
 
 static size_t getCpuCoreCount() {
@@ -314,6 +360,14 @@ static void ivd_aligned_free(void *ctxt, void *mem) {
     free(mem);
 }
 
+// Shared display buffers double as reference frames, so rows need room for the horizontal
+// padding libhevc adds on either side.
+constexpr uint32_t kDisplayBufferPadding = 80;
+// Display buffers allocated on top of what the decoder needs, which is how many can be shared
+// with the client at a time. Frames decoded while the client holds that many are copied out, so
+// that the decoder always has a buffer to decode into.
+constexpr uint32_t kNumClientDisplayBuffers = 4;
+
 C2SoftHevcDec::C2SoftHevcDec(
         const char *name,
         c2_node_id_t id,
@@ -325,7 +379,13 @@ C2SoftHevcDec::C2SoftHevcDec(
         mIvColorformat(IV_YUV_420P),
         mWidth(320),
         mHeight(240),
-        mHeaderDecoded(false) {
+        mMaxWidth(0),
+        mMaxHeight(0),
+        mHeaderDecoded(false),
+        mShareDisplayBuffers(false),
+        mLowLatency(false),
+        mMayReorder(true),
+        mKeyFramesOnly(false) {
 }
 
 C2SoftHevcDec::~C2SoftHevcDec() {
@@ -356,6 +416,7 @@ void C2SoftHevcDec::onRelease() {
     if (mOutBlock) {
         mOutBlock.reset();
     }
+    mDisplayBuffers.clear();
 }
 
 c2_status_t C2SoftHevcDec::onFlush_sm() {
@@ -380,6 +441,9 @@ c2_status_t C2SoftHevcDec::onFlush_sm() {
             resetPlugin();
             break;
         }
+        if (mShareDisplayBuffers) {
+            releaseDisplayBuffer(s_decode_op.u4_disp_buf_id);
+        }
     }
 
     if (mOutBufferFlush) {
@@ -394,9 +458,20 @@ status_t C2SoftHevcDec::createDecoder() {
     ivdext_create_ip_t s_create_ip;
     ivdext_create_op_t s_create_op;
 
+    {
+        IntfImpl::Lock lock = mIntf->lock();
+        mShareDisplayBuffers = mIntf->getSharedBuffers_l()->value;
+        mLowLatency = mIntf->getLowLatencyMode_l()->value;
+        mKeyFramesOnly = mIntf->getKeyFramesOnly_l()->value;
+        mMaxWidth = mIntf->getMaxSize_l()->width;
+        mMaxHeight = mIntf->getMaxSize_l()->height;
+    }
+    // libhevc shares display buffers in 420SP layout only
+    mIvColorformat = mShareDisplayBuffers ? IV_YUV_420SP_UV : IV_YUV_420P;
+
     s_create_ip.s_ivd_create_ip_t.u4_size = sizeof(ivdext_create_ip_t);
     s_create_ip.s_ivd_create_ip_t.e_cmd = IVD_CMD_CREATE;
-    s_create_ip.s_ivd_create_ip_t.u4_share_disp_buf = 0;
+    s_create_ip.s_ivd_create_ip_t.u4_share_disp_buf = mShareDisplayBuffers;
     s_create_ip.s_ivd_create_ip_t.e_output_format = mIvColorformat;
     s_create_ip.s_ivd_create_ip_t.pf_aligned_alloc = ivd_aligned_malloc;
     s_create_ip.s_ivd_create_ip_t.pf_aligned_free = ivd_aligned_free;
@@ -437,6 +512,24 @@ status_t C2SoftHevcDec::setNumCores() {
     return OK;
 }
 
+bool C2SoftHevcDec::updateWorkerThreads() {
+    std::shared_ptr<C2WorkerThreadsTuning> workerThreads;
+    {
+        IntfImpl::Lock lock = mIntf->lock();
+        workerThreads = mIntf->getWorkerThreads_l();
+    }
+    if (workerThreads == mWorkerThreads) {
+        return false;
+    }
+    // leave the CPUs of the component thread alone until they are first restricted
+    if (mWorkerThreads || workerThreads->cpuMask) {
+        SetWorkerCpus(*workerThreads);
+    }
+    mWorkerThreads = workerThreads;
+    mNumCores = LimitWorkerThreads(MIN(getCpuCoreCount(), MAX_NUM_CORES), *mWorkerThreads);
+    return true;
+}
+
 status_t C2SoftHevcDec::setParams(size_t stride, IVD_VIDEO_DECODE_MODE_T dec_mode) {
     ivd_ctl_set_config_ip_t s_set_dyn_params_ip;
     ivd_ctl_set_config_op_t s_set_dyn_params_op;
@@ -445,8 +538,12 @@ status_t C2SoftHevcDec::setParams(size_t stride, IVD_VIDEO_DECODE_MODE_T dec_mod
     s_set_dyn_params_ip.e_cmd = IVD_CMD_VIDEO_CTL;
     s_set_dyn_params_ip.e_sub_cmd = IVD_CMD_CTL_SETPARAMS;
     s_set_dyn_params_ip.u4_disp_wd = (UWORD32) stride;
-    s_set_dyn_params_ip.e_frm_skip_mode = IVD_SKIP_NONE;
-    s_set_dyn_params_ip.e_frm_out_mode = IVD_DISPLAY_FRAME_OUT;
+    // skipping P and B frames leaves the intra frames
+    s_set_dyn_params_ip.e_frm_skip_mode = mKeyFramesOnly ? IVD_SKIP_PB : IVD_SKIP_NONE;
+    // in low latency mode frames are output as soon as they are decoded, which only keeps them
+    // in display order if the stream has no reordering
+    s_set_dyn_params_ip.e_frm_out_mode =
+        (mLowLatency && !mMayReorder) ? IVD_DECODE_FRAME_OUT : IVD_DISPLAY_FRAME_OUT;
     s_set_dyn_params_ip.e_vid_dec_mode = dec_mode;
     s_set_dyn_params_op.u4_size = sizeof(ivd_ctl_set_config_op_t);
     IV_API_CALL_STATUS_T status = ivdec_api_function(mDecHandle,
@@ -487,8 +584,8 @@ status_t C2SoftHevcDec::getVersion() {
 
 status_t C2SoftHevcDec::initDecoder() {
     if (OK != createDecoder()) return UNKNOWN_ERROR;
-    mNumCores = MIN(getCpuCoreCount(), MAX_NUM_CORES);
-    mStride = ALIGN64(mWidth);
+    (void) updateWorkerThreads();
+    mStride = getOutputStride(mWidth);
     mSignalledError = false;
     resetPlugin();
     (void) setNumCores();
@@ -533,10 +630,15 @@ bool C2SoftHevcDec::setDecodeArgs(ivd_video_decode_ip_t *ps_decode_ip,
         ps_decode_ip->s_out_buffer.pu1_bufs[0] = outBuffer->data()[C2PlanarLayout::PLANE_Y];
         ps_decode_ip->s_out_buffer.pu1_bufs[1] = outBuffer->data()[C2PlanarLayout::PLANE_U];
         ps_decode_ip->s_out_buffer.pu1_bufs[2] = outBuffer->data()[C2PlanarLayout::PLANE_V];
-    } else {
+    } else if (mOutBufferFlush) {
         ps_decode_ip->s_out_buffer.pu1_bufs[0] = mOutBufferFlush;
         ps_decode_ip->s_out_buffer.pu1_bufs[1] = mOutBufferFlush + lumaSize;
         ps_decode_ip->s_out_buffer.pu1_bufs[2] = mOutBufferFlush + lumaSize + chromaSize;
+    } else {
+        // frames are decoded into the shared display buffers
+        ps_decode_ip->s_out_buffer.pu1_bufs[0] = nullptr;
+        ps_decode_ip->s_out_buffer.pu1_bufs[1] = nullptr;
+        ps_decode_ip->s_out_buffer.pu1_bufs[2] = nullptr;
     }
     ps_decode_ip->s_out_buffer.u4_num_bufs = 3;
     ps_decode_op->u4_size = sizeof(ivd_video_decode_op_t);
@@ -632,6 +734,8 @@ status_t C2SoftHevcDec::resetDecoder() {
     (void) setNumCores();
     mSignalledError = false;
     mHeaderDecoded = false;
+    // buffers are registered again once the next header is decoded
+    mDisplayBuffers.clear();
     return OK;
 }
 
@@ -679,6 +783,11 @@ void C2SoftHevcDec::finishWork(uint64_t index, const std::unique_ptr<C2Work> &wo
     std::shared_ptr<C2Buffer> buffer = createGraphicBuffer(std::move(mOutBlock),
                                                            C2Rect(mWidth, mHeight));
     mOutBlock = nullptr;
+    finishWork(index, work, buffer);
+}
+
+void C2SoftHevcDec::finishWork(uint64_t index, const std::unique_ptr<C2Work> &work,
+                               const std::shared_ptr<C2Buffer> &buffer) {
     {
         IntfImpl::Lock lock = mIntf->lock();
         buffer->setInfo(mIntf->getColorAspects_l());
@@ -698,29 +807,164 @@ void C2SoftHevcDec::finishWork(uint64_t index, const std::unique_ptr<C2Work> &wo
     }
 }
 
+c2_status_t C2SoftHevcDec::finishDisplayBuffer(const ivd_video_decode_op_t &decodeOp,
+                                               const std::shared_ptr<C2BlockPool> &pool,
+                                               const std::unique_ptr<C2Work> &work) {
+    uint32_t id = decodeOp.u4_disp_buf_id;
+    const iv_yuv_buf_t &frame = decodeOp.s_disp_frm_buf;
+    const uint8_t *y = (const uint8_t *)frame.pv_y_buf;
+    const uint8_t *uv = (const uint8_t *)frame.pv_u_buf;
+    std::shared_ptr<C2Buffer> buffer = mDisplayBuffers.share(
+            id, y, uv, frame.u4_y_strd, frame.u4_u_strd, mWidth, mHeight);
+    if (!buffer) {
+        // copy the frame out so that the display buffer can be reused right away
+        std::shared_ptr<C2GraphicBlock> block;
+        C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+        c2_status_t err = pool->fetchGraphicBlock(
+                ALIGN64(c2_max(mWidth, mMaxWidth)), c2_max(mHeight, mMaxHeight),
+                HAL_PIXEL_FORMAT_YV12, usage, &block);
+        if (err != C2_OK) {
+            ALOGE("fetchGraphicBlock for Output failed with status %d", err);
+            releaseDisplayBuffer(id);
+            return err;
+        }
+        {
+            C2GraphicView wView = block->map().get();
+            if (wView.error()) {
+                ALOGE("graphic view map failed %d", wView.error());
+                err = wView.error();
+            } else {
+                err = SharedDisplayBuffers::CopyFrame(
+                        wView, y, uv, frame.u4_y_strd, frame.u4_u_strd, mWidth, mHeight);
+            }
+        }
+        releaseDisplayBuffer(id);
+        if (err != C2_OK) {
+            return err;
+        }
+        buffer = createGraphicBuffer(block, C2Rect(mWidth, mHeight));
+    }
+    finishWork(decodeOp.u4_ts, work, buffer);
+    return C2_OK;
+}
+
+uint32_t C2SoftHevcDec::getStride(uint32_t width) const {
+    if (mShareDisplayBuffers) {
+        return ALIGN64(width + 2 * kDisplayBufferPadding);
+    }
+    return ALIGN64(width);
+}
+
+uint32_t C2SoftHevcDec::getOutputStride(uint32_t width) const {
+    // Output blocks are sized for the maximum picture size declared for adaptive playback, so
+    // that resolution changes up to it keep both the stride and the output blocks. Shared display
+    // buffers are set up again at each resolution change, so they are sized for the picture.
+    if (mShareDisplayBuffers) {
+        return getStride(width);
+    }
+    return getStride(c2_max(width, mMaxWidth));
+}
+
+status_t C2SoftHevcDec::setDisplayBuffers(const std::shared_ptr<C2BlockPool> &pool) {
+    ivd_ctl_getbufinfo_ip_t s_get_buf_info_ip;
+    ivd_ctl_getbufinfo_op_t s_get_buf_info_op;
+
+    s_get_buf_info_ip.u4_size = sizeof(ivd_ctl_getbufinfo_ip_t);
+    s_get_buf_info_ip.e_cmd = IVD_CMD_VIDEO_CTL;
+    s_get_buf_info_ip.e_sub_cmd = IVD_CMD_CTL_GETBUFINFO;
+    s_get_buf_info_op.u4_size = sizeof(ivd_ctl_getbufinfo_op_t);
+    IV_API_CALL_STATUS_T status = ivdec_api_function(mDecHandle,
+                                                     &s_get_buf_info_ip,
+                                                     &s_get_buf_info_op);
+    if (status != IV_SUCCESS) {
+        ALOGE("error in %s: 0x%x", __func__, s_get_buf_info_op.u4_error_code);
+        return UNKNOWN_ERROR;
+    }
+
+    size_t lumaSize = s_get_buf_info_op.u4_min_out_buf_size[0];
+    size_t chromaSize = s_get_buf_info_op.u4_min_out_buf_size[1];
+    uint32_t numBuffers = MIN(s_get_buf_info_op.u4_num_disp_bufs + kNumClientDisplayBuffers,
+                              (uint32_t)IVD_VIDDEC_MAX_IO_BUFFERS);
+    uint32_t numClientBuffers = numBuffers - MIN(numBuffers, s_get_buf_info_op.u4_num_disp_bufs);
+    if (C2_OK != mDisplayBuffers.allocate(
+            pool, numBuffers, numClientBuffers, mStride, lumaSize, chromaSize)) {
+        return NO_MEMORY;
+    }
+
+    ivd_set_display_frame_ip_t s_set_display_frame_ip;
+    ivd_set_display_frame_op_t s_set_display_frame_op;
+
+    s_set_display_frame_ip.u4_size = sizeof(ivd_set_display_frame_ip_t);
+    s_set_display_frame_ip.e_cmd = IVD_CMD_SET_DISPLAY_FRAME;
+    s_set_display_frame_ip.num_disp_bufs = numBuffers;
+    for (uint32_t i = 0; i < numBuffers; ++i) {
+        ivd_out_bufdesc_t &outBuffer = s_set_display_frame_ip.s_disp_buffer[i];
+        outBuffer.u4_num_bufs = 2;
+        outBuffer.pu1_bufs[0] = mDisplayBuffers[i].y;
+        outBuffer.pu1_bufs[1] = mDisplayBuffers[i].uv;
+        outBuffer.u4_min_out_buf_size[0] = lumaSize;
+        outBuffer.u4_min_out_buf_size[1] = chromaSize;
+    }
+    s_set_display_frame_op.u4_size = sizeof(ivd_set_display_frame_op_t);
+    status = ivdec_api_function(mDecHandle, &s_set_display_frame_ip, &s_set_display_frame_op);
+    if (status != IV_SUCCESS) {
+        ALOGE("error in %s: 0x%x", __func__, s_set_display_frame_op.u4_error_code);
+        mDisplayBuffers.clear();
+        return UNKNOWN_ERROR;
+    }
+
+    return OK;
+}
+
+void C2SoftHevcDec::releaseDisplayBuffer(uint32_t id) {
+    ivd_rel_display_frame_ip_t s_release_ip;
+    ivd_rel_display_frame_op_t s_release_op;
+
+    s_release_ip.u4_size = sizeof(ivd_rel_display_frame_ip_t);
+    s_release_ip.e_cmd = IVD_CMD_REL_DISPLAY_FRAME;
+    s_release_ip.u4_disp_buf_id = id;
+    s_release_op.u4_size = sizeof(ivd_rel_display_frame_op_t);
+    IV_API_CALL_STATUS_T status = ivdec_api_function(mDecHandle,
+                                                     &s_release_ip,
+                                                     &s_release_op);
+    if (status != IV_SUCCESS) {
+        ALOGD("error in %s: 0x%x", __func__, s_release_op.u4_error_code);
+    }
+}
+
 c2_status_t C2SoftHevcDec::ensureDecoderState(const std::shared_ptr<C2BlockPool> &pool) {
     if (!mDecHandle) {
         ALOGE("not supposed to be here, invalid decoder context");
         return C2_CORRUPTED;
     }
-    if (mStride != ALIGN64(mWidth)) {
-        mStride = ALIGN64(mWidth);
+    if (mStride != getOutputStride(mWidth)) {
+        mStride = getOutputStride(mWidth);
         if (OK != setParams(mStride, IVD_DECODE_FRAME)) return C2_CORRUPTED;
     }
+    if (mShareDisplayBuffers) {
+        if (mHeaderDecoded && mDisplayBuffers.empty()) {
+            if (OK != setDisplayBuffers(pool)) return C2_CORRUPTED;
+        }
+        for (uint32_t id : mDisplayBuffers.takeReleased()) {
+            releaseDisplayBuffer(id);
+        }
+        return C2_OK;
+    }
+    uint32_t outHeight = c2_max(mHeight, mMaxHeight);
     if (mOutBlock &&
-            (mOutBlock->width() != mStride || mOutBlock->height() != mHeight)) {
+            (mOutBlock->width() != mStride || mOutBlock->height() != outHeight)) {
         mOutBlock.reset();
     }
     if (!mOutBlock) {
         uint32_t format = HAL_PIXEL_FORMAT_YV12;
         C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
-        c2_status_t err = pool->fetchGraphicBlock(mStride, mHeight, format, usage, &mOutBlock);
+        c2_status_t err = pool->fetchGraphicBlock(mStride, outHeight, format, usage, &mOutBlock);
         if (err != C2_OK) {
             ALOGE("fetchGraphicBlock for Output failed with status %d", err);
             return err;
         }
         ALOGV("provided (%dx%d) required (%dx%d)",
-              mOutBlock->width(), mOutBlock->height(), mStride, mHeight);
+              mOutBlock->width(), mOutBlock->height(), mStride, outHeight);
     }
 
     return C2_OK;
@@ -745,6 +989,24 @@ void C2SoftHevcDec::process(
         work->result = C2_BAD_VALUE;
         return;
     }
+    if (mDecHandle && updateWorkerThreads()) {
+        (void) setNumCores();
+    }
+    bool lowLatency;
+    bool keyFramesOnly;
+    {
+        IntfImpl::Lock lock = mIntf->lock();
+        lowLatency = mIntf->getLowLatencyMode_l()->value;
+        keyFramesOnly = mIntf->getKeyFramesOnly_l()->value;
+    }
+    if (lowLatency != mLowLatency || keyFramesOnly != mKeyFramesOnly) {
+        mLowLatency = lowLatency;
+        mKeyFramesOnly = keyFramesOnly;
+        // until the header is decoded, the output and skip modes are set along with the stride
+        if (mDecHandle && mHeaderDecoded) {
+            (void) setParams(mStride, IVD_DECODE_FRAME);
+        }
+    }
 
     size_t inOffset = 0u;
     size_t inSize = 0u;
@@ -759,6 +1021,18 @@ void C2SoftHevcDec::process(
             return;
         }
     }
+    // The output order only matters in low latency mode, but the SPS may only be sent with the
+    // codec config.
+    if (inSize && (mLowLatency || (work->input.flags & C2FrameData::FLAG_CODEC_CONFIG))) {
+        bool mayReorder;
+        if (FindHevcPictureReordering(rView.data() + inOffset, inSize, &mayReorder)
+                && mayReorder != mMayReorder) {
+            mMayReorder = mayReorder;
+            if (mLowLatency && mDecHandle && mHeaderDecoded) {
+                (void) setParams(mStride, IVD_DECODE_FRAME);
+            }
+        }
+    }
     bool eos = ((work->input.flags & C2FrameData::FLAG_END_OF_STREAM) != 0);
     bool hasPicture = false;
 
@@ -773,15 +1047,18 @@ void C2SoftHevcDec::process(
             work->result = C2_CORRUPTED;
             return;
         }
-        C2GraphicView wView = mOutBlock->map().get();
-        if (wView.error()) {
-            ALOGE("graphic view map failed %d", wView.error());
-            work->result = wView.error();
-            return;
+        std::unique_ptr<C2GraphicView> wView;
+        if (!mShareDisplayBuffers) {
+            wView.reset(new C2GraphicView(mOutBlock->map().get()));
+            if (wView->error()) {
+                ALOGE("graphic view map failed %d", wView->error());
+                work->result = wView->error();
+                return;
+            }
         }
         ivd_video_decode_ip_t s_decode_ip;
         ivd_video_decode_op_t s_decode_op;
-        if (!setDecodeArgs(&s_decode_ip, &s_decode_op, &rView, &wView,
+        if (!setDecodeArgs(&s_decode_ip, &s_decode_op, &rView, wView.get(),
                            inOffset + inPos, inSize - inPos, workIndex)) {
             mSignalledError = true;
             work->workletsProcessed = 1u;
@@ -814,6 +1091,15 @@ void C2SoftHevcDec::process(
             work->workletsProcessed = 1u;
             work->result = C2_CORRUPTED;
             return;
+        } else if (IVD_DEC_REF_BUF_NULL == (s_decode_op.u4_error_code & 0xFF)) {
+            // Shared display buffers are handed back before each decode call, and the client
+            // never holds more than it was allocated on top of what the decoder needs. Ignoring
+            // this would silently drop the rest of the input.
+            ALOGE("no display buffer available to decode into");
+            mSignalledError = true;
+            work->workletsProcessed = 1u;
+            work->result = C2_CORRUPTED;
+            return;
         } else if (IVD_RES_CHANGED == (s_decode_op.u4_error_code & 0xFF)) {
             ALOGV("resolution changed");
             drainInternal(DRAIN_COMPONENT_NO_EOS, pool, work);
@@ -828,7 +1114,7 @@ void C2SoftHevcDec::process(
         if (0 < s_decode_op.u4_pic_wd && 0 < s_decode_op.u4_pic_ht) {
             if (mHeaderDecoded == false) {
                 mHeaderDecoded = true;
-                setParams(ALIGN64(s_decode_op.u4_pic_wd), IVD_DECODE_FRAME);
+                setParams(getOutputStride(s_decode_op.u4_pic_wd), IVD_DECODE_FRAME);
             }
             if (s_decode_op.u4_pic_wd != mWidth ||  s_decode_op.u4_pic_ht != mHeight) {
                 mWidth = s_decode_op.u4_pic_wd;
@@ -855,7 +1141,14 @@ void C2SoftHevcDec::process(
         (void) getVuiParams();
         hasPicture |= (1 == s_decode_op.u4_frame_decoded_flag);
         if (s_decode_op.u4_output_present) {
-            finishWork(s_decode_op.u4_ts, work);
+            if (!mShareDisplayBuffers) {
+                finishWork(s_decode_op.u4_ts, work);
+            } else if (C2_OK != finishDisplayBuffer(s_decode_op, pool, work)) {
+                mSignalledError = true;
+                work->workletsProcessed = 1u;
+                work->result = C2_CORRUPTED;
+                return;
+            }
         }
         if (0 == s_decode_op.u4_num_bytes_consumed) {
             ALOGD("Bytes consumed is zero. Ignoring remaining bytes");
@@ -898,21 +1191,30 @@ c2_status_t C2SoftHevcDec::drainInternal(
             work->result = C2_CORRUPTED;
             return C2_CORRUPTED;
         }
-        C2GraphicView wView = mOutBlock->map().get();
-        if (wView.error()) {
-            ALOGE("graphic view map failed %d", wView.error());
-            return C2_CORRUPTED;
+        std::unique_ptr<C2GraphicView> wView;
+        if (!mShareDisplayBuffers) {
+            wView.reset(new C2GraphicView(mOutBlock->map().get()));
+            if (wView->error()) {
+                ALOGE("graphic view map failed %d", wView->error());
+                return C2_CORRUPTED;
+            }
         }
         ivd_video_decode_ip_t s_decode_ip;
         ivd_video_decode_op_t s_decode_op;
-        if (!setDecodeArgs(&s_decode_ip, &s_decode_op, nullptr, &wView, 0, 0, 0)) {
+        if (!setDecodeArgs(&s_decode_ip, &s_decode_op, nullptr, wView.get(), 0, 0, 0)) {
             mSignalledError = true;
             work->workletsProcessed = 1u;
             return C2_CORRUPTED;
         }
         (void) ivdec_api_function(mDecHandle, &s_decode_ip, &s_decode_op);
         if (s_decode_op.u4_output_present) {
-            finishWork(s_decode_op.u4_ts, work);
+            if (!mShareDisplayBuffers) {
+                finishWork(s_decode_op.u4_ts, work);
+            } else if (C2_OK != finishDisplayBuffer(s_decode_op, pool, work)) {
+                mSignalledError = true;
+                work->workletsProcessed = 1u;
+                return C2_CORRUPTED;
+            }
         } else {
             fillEmptyWork(work);
             break;
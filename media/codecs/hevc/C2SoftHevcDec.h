@@ -19,6 +19,7 @@
 
 #include <media/stagefright/foundation/ColorUtils.h>
 
+#include <SharedDisplayBuffers.h>
 #include <SimpleC2Component.h>
 
 #include "ihevc_typedefs.h"
@@ -69,6 +70,7 @@ struct C2SoftHevcDec : public SimpleC2Component {
  private:
     status_t createDecoder();
     status_t setNumCores();
+    bool updateWorkerThreads();
     status_t setParams(size_t stride, IVD_VIDEO_DECODE_MODE_T dec_mode);
     status_t getVersion();
     status_t initDecoder();
@@ -87,8 +89,17 @@ struct C2SoftHevcDec : public SimpleC2Component {
     void updateFinalColorAspects(
             const ColorAspects &otherAspects, const ColorAspects &preferredAspects);
     status_t handleColorAspectsChange();
+    uint32_t getStride(uint32_t width) const;
+    uint32_t getOutputStride(uint32_t width) const;
+    status_t setDisplayBuffers(const std::shared_ptr<C2BlockPool> &pool);
+    void releaseDisplayBuffer(uint32_t id);
     c2_status_t ensureDecoderState(const std::shared_ptr<C2BlockPool> &pool);
     void finishWork(uint64_t index, const std::unique_ptr<C2Work> &work);
+    void finishWork(uint64_t index, const std::unique_ptr<C2Work> &work,
+                    const std::shared_ptr<C2Buffer> &buffer);
+    c2_status_t finishDisplayBuffer(const ivd_video_decode_op_t &decodeOp,
+                                    const std::shared_ptr<C2BlockPool> &pool,
+                                    const std::unique_ptr<C2Work> &work);
     status_t setFlushMode();
     c2_status_t drainInternal(
             uint32_t drainMode,
@@ -113,15 +124,36 @@ struct C2SoftHevcDec : public SimpleC2Component {
     uint8_t *mOutBufferFlush;
 
     size_t mNumCores;
+    // worker thread tuning that mNumCores and the CPUs of the component thread follow
+    std::shared_ptr<C2WorkerThreadsTuning> mWorkerThreads;
     IV_COLOR_FORMAT_T mIvColorformat;
 
     uint32_t mWidth;
     uint32_t mHeight;
     uint32_t mStride;
+    // maximum picture size declared by the client, e.g. for adaptive playback
+    uint32_t mMaxWidth;
+    uint32_t mMaxHeight;
     bool mSignalledOutputEos;
     bool mSignalledError;
     bool mHeaderDecoded;
 
+    // If set, the decoder decodes into display buffers that are shared with the client instead
+    // of writing each frame into a separate output block.
+    bool mShareDisplayBuffers;
+    SharedDisplayBuffers mDisplayBuffers;
+
+    // If set, frames of streams without reordering are output as soon as they are decoded, which
+    // removes the display delay of the decoder.
+    bool mLowLatency;
+    // Whether the last SPS seen in the input allows pictures to be output out of decode order.
+    // Until an SPS is seen this is assumed.
+    bool mMayReorder;
+
+    // If set, only intra frames are decoded. Skipped frames are returned without output, so
+    // output blocks are only used for the frames that are output.
+    bool mKeyFramesOnly;
+
     // Color aspects. These are ISO values and are meant to detect changes in aspects to avoid
     // converting them to C2 values for each frame
     struct VuiColorAspects {
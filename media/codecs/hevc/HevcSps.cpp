@@ -0,0 +1,118 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "HevcSps"
+#include <log/log.h>
+
+#include "HevcSps.h"
+
+namespace android {
+
+namespace {
+
+enum : uint32_t {
+    NAL_VCL_LAST = 31,
+    NAL_SPS = 33,
+};
+
+constexpr uint32_t kMaxSpsId = 15;
+constexpr uint32_t kMaxSubLayers = 7;
+
+// Number of bits of the profile fields in profile_tier_level(), from general_profile_space to
+// general_inbld_flag or the bit reserved in its place.
+constexpr uint32_t kProfileBits = 88;
+constexpr uint32_t kLevelBits = 8;
+
+}  // namespace
+
+bool ParseHevcSpsMaxNumReorderPics(NalBitReader &br, uint32_t *maxNumReorderPics) {
+    br.readBits(4);  // sps_video_parameter_set_id
+    uint32_t maxSubLayersMinus1 = br.readBits(3);
+    br.readFlag();  // sps_temporal_id_nesting_flag
+    if (maxSubLayersMinus1 >= kMaxSubLayers) {
+        return false;
+    }
+
+    // profile_tier_level(1, sps_max_sub_layers_minus1)
+    br.skipBits(kProfileBits + kLevelBits);
+    bool subLayerProfilePresent[kMaxSubLayers];
+    bool subLayerLevelPresent[kMaxSubLayers];
+    for (uint32_t i = 0; i < maxSubLayersMinus1; ++i) {
+        subLayerProfilePresent[i] = br.readFlag();
+        subLayerLevelPresent[i] = br.readFlag();
+    }
+    if (maxSubLayersMinus1 > 0) {
+        br.skipBits(2 * (8 - maxSubLayersMinus1));  // reserved_zero_2bits
+    }
+    for (uint32_t i = 0; i < maxSubLayersMinus1; ++i) {
+        br.skipBits((subLayerProfilePresent[i] ? kProfileBits : 0)
+                + (subLayerLevelPresent[i] ? kLevelBits : 0));
+    }
+
+    if (br.readUE() > kMaxSpsId) {  // sps_seq_parameter_set_id
+        return false;
+    }
+    if (br.readUE() == 3) {  // chroma_format_idc
+        br.readFlag();  // separate_colour_plane_flag
+    }
+    br.readUE();  // pic_width_in_luma_samples
+    br.readUE();  // pic_height_in_luma_samples
+    if (br.readFlag()) {  // conformance_window_flag
+        for (uint32_t i = 0; i < 4; ++i) {
+            br.readUE();  // conf_win_*_offset
+        }
+    }
+    br.readUE();  // bit_depth_luma_minus8
+    br.readUE();  // bit_depth_chroma_minus8
+    br.readUE();  // log2_max_pic_order_cnt_lsb_minus4
+    bool subLayerOrderingInfoPresent = br.readFlag();
+    for (uint32_t i = subLayerOrderingInfoPresent ? 0 : maxSubLayersMinus1;
+            i <= maxSubLayersMinus1; ++i) {
+        br.readUE();  // sps_max_dec_pic_buffering_minus1
+        *maxNumReorderPics = br.readUE();
+        br.readUE();  // sps_max_latency_increase_plus1
+    }
+    return !br.error();
+}
+
+bool FindHevcPictureReordering(const uint8_t *data, size_t size, bool *mayReorder) {
+    bool found = false;
+    size_t offset = FindNalStart(data, size, 0);
+    while (offset + 2 <= size) {
+        uint32_t nalType = (data[offset] >> 1) & 0x3f;
+        if (nalType <= NAL_VCL_LAST) {
+            // parameter sets precede the slices that use them
+            break;
+        }
+        size_t next = FindNalStart(data, size, offset + 2);
+        if (nalType == NAL_SPS) {
+            // the payload may include the zero bytes of the next start code, which are never read
+            NalBitReader br(data + offset + 2, next - offset - 2);
+            uint32_t maxNumReorderPics;
+            if (ParseHevcSpsMaxNumReorderPics(br, &maxNumReorderPics)) {
+                *mayReorder = maxNumReorderPics != 0;
+                found = true;
+            } else {
+                ALOGV("could not parse SPS");
+            }
+        }
+        offset = next;
+    }
+    return found;
+}
+
+}  // namespace android
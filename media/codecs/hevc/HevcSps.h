@@ -0,0 +1,47 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HEVC_SPS_H_
+#define ANDROID_HEVC_SPS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <NalBitReader.h>
+
+namespace android {
+
+/**
+ * Parses the RBSP of an H.265 SPS NAL unit following the NAL unit header up to the sub-layer
+ * ordering info, and returns sps_max_num_reorder_pics of the highest sub-layer in
+ * |maxNumReorderPics|.
+ *
+ * \return false if the SPS is truncated or uses values out of range.
+ */
+bool ParseHevcSpsMaxNumReorderPics(NalBitReader &br, uint32_t *maxNumReorderPics);
+
+/**
+ * Finds the last SPS before the first slice in the Annex B byte stream |data|, and returns whether
+ * pictures of its sequence may be output in a different order than they are decoded in, i.e.
+ * whether sps_max_num_reorder_pics is not 0, in |mayReorder|.
+ *
+ * \return false if |data| contains no SPS that could be parsed.
+ */
+bool FindHevcPictureReordering(const uint8_t *data, size_t size, bool *mayReorder);
+
+}  // namespace android
+
+#endif  // ANDROID_HEVC_SPS_H_
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "HevcSps.h"
+
+namespace android {
+
+namespace {
+
+// Writes the RBSP of a NAL unit and wraps it into an Annex B NAL unit.
+class NalWriter {
+public:
+    void writeBits(uint32_t value, uint32_t numBits) {
+        while (numBits--) {
+            mBits.push_back((value >> numBits) & 1);
+        }
+    }
+
+    void writeFlag(bool value) { writeBits(value, 1); }
+
+    void writeUE(uint32_t value) {
+        uint32_t numBits = 0;
+        while ((uint64_t(value) + 1) >> (numBits + 1)) {
+            ++numBits;
+        }
+        writeBits(0, numBits);
+        writeBits(value + 1, numBits + 1);
+    }
+
+    // Returns the NAL unit with a start code, a header of NAL unit type |nalType|, the RBSP with
+    // trailing bits and emulation prevention bytes.
+    std::vector<uint8_t> nal(uint8_t nalType) const {
+        std::vector<uint8_t> bits = mBits;
+        bits.push_back(1);
+        while (bits.size() % 8) {
+            bits.push_back(0);
+        }
+        std::vector<uint8_t> out = { 0, 0, 0, 1, uint8_t(nalType << 1), 1 };
+        size_t numZeros = 0;
+        for (size_t i = 0; i < bits.size(); i += 8) {
+            uint8_t byte = 0;
+            for (size_t j = 0; j < 8; ++j) {
+                byte = (byte << 1) | bits[i + j];
+            }
+            if (numZeros >= 2 && byte <= 3) {
+                out.push_back(3);
+                numZeros = 0;
+            }
+            out.push_back(byte);
+            numZeros = byte == 0 ? numZeros + 1 : 0;
+        }
+        return out;
+    }
+
+private:
+    std::vector<uint8_t> mBits;
+};
+
+constexpr uint8_t kNalIdrWRadl = 19;
+constexpr uint8_t kNalSps = 33;
+
+struct SpsParams {
+    uint32_t maxSubLayersMinus1 = 0;
+    bool subLayerOrderingInfoPresent = false;
+    bool conformanceWindow = false;
+    // sps_max_num_reorder_pics per sub-layer, the last one is used if ordering info is absent
+    std::vector<uint32_t> maxNumReorderPics = { 0 };
+};
+
+std::vector<uint8_t> makeSps(const SpsParams &params) {
+    NalWriter w;
+    w.writeBits(0, 4);  // sps_video_parameter_set_id
+    w.writeBits(params.maxSubLayersMinus1, 3);
+    w.writeFlag(true);  // sps_temporal_id_nesting_flag
+
+    // profile_tier_level
+    w.writeBits(0x01, 8);  // profile space, tier and profile idc
+    w.writeBits(0x60000000, 32);  // profile compatibility flags
+    w.writeBits(0xb0, 8);  // source and constraint flags
+    w.writeBits(0, 32);
+    w.writeBits(0, 8);
+    w.writeBits(93, 8);  // general_level_idc
+    for (uint32_t i = 0; i < params.maxSubLayersMinus1; ++i) {
+        w.writeFlag(i % 2 == 0);  // sub_layer_profile_present_flag
+        w.writeFlag(true);  // sub_layer_level_present_flag
+    }
+    if (params.maxSubLayersMinus1 > 0) {
+        w.writeBits(0, 2 * (8 - params.maxSubLayersMinus1));
+    }
+    for (uint32_t i = 0; i < params.maxSubLayersMinus1; ++i) {
+        if (i % 2 == 0) {
+            w.writeBits(0xffffffff, 32);
+            w.writeBits(0xffffffff, 32);
+            w.writeBits(0xffffff, 24);
+        }
+        w.writeBits(0xff, 8);  // sub_layer_level_idc
+    }
+
+    w.writeUE(0);  // sps_seq_parameter_set_id
+    w.writeUE(1);  // chroma_format_idc
+    w.writeUE(1920);  // pic_width_in_luma_samples
+    w.writeUE(1080);  // pic_height_in_luma_samples
+    w.writeFlag(params.conformanceWindow);
+    if (params.conformanceWindow) {
+        w.writeUE(0);
+        w.writeUE(0);
+        w.writeUE(0);
+        w.writeUE(4);
+    }
+    w.writeUE(0);  // bit_depth_luma_minus8
+    w.writeUE(0);  // bit_depth_chroma_minus8
+    w.writeUE(4);  // log2_max_pic_order_cnt_lsb_minus4
+    w.writeFlag(params.subLayerOrderingInfoPresent);
+    for (uint32_t reorder : params.maxNumReorderPics) {
+        w.writeUE(reorder + 1);  // sps_max_dec_pic_buffering_minus1
+        w.writeUE(reorder);
+        w.writeUE(0);  // sps_max_latency_increase_plus1
+    }
+    // the rest of the SPS is not parsed
+    w.writeUE(0);  // log2_min_luma_coding_block_size_minus3
+    return w.nal(kNalSps);
+}
+
+std::vector<uint8_t> makeIdrSlice() {
+    NalWriter w;
+    w.writeFlag(true);  // first_slice_segment_in_pic_flag
+    w.writeFlag(false);  // no_output_of_prior_pics_flag
+    w.writeUE(0);  // slice_pic_parameter_set_id
+    return w.nal(kNalIdrWRadl);
+}
+
+bool parse(const std::vector<uint8_t> &nal, uint32_t *maxNumReorderPics) {
+    // skip the start code and the NAL unit header
+    NalBitReader br(nal.data() + 6, nal.size() - 6);
+    return ParseHevcSpsMaxNumReorderPics(br, maxNumReorderPics);
+}
+
+bool findReordering(const std::vector<uint8_t> &data, bool *mayReorder) {
+    return FindHevcPictureReordering(data.data(), data.size(), mayReorder);
+}
+
+} // namespace
+
+TEST(HevcSpsTest, ParseSingleLayer) {
+    SpsParams params;
+    for (uint32_t reorder : { 0u, 2u }) {
+        for (bool conformanceWindow : { false, true }) {
+            params.maxNumReorderPics = { reorder };
+            params.conformanceWindow = conformanceWindow;
+            uint32_t maxNumReorderPics = ~0u;
+            ASSERT_TRUE(parse(makeSps(params), &maxNumReorderPics));
+            EXPECT_EQ(reorder, maxNumReorderPics);
+        }
+    }
+}
+
+TEST(HevcSpsTest, ParseSubLayers) {
+    SpsParams params;
+    params.maxSubLayersMinus1 = 3;
+    params.subLayerOrderingInfoPresent = true;
+    params.maxNumReorderPics = { 0, 0, 1, 3 };
+    uint32_t maxNumReorderPics = ~0u;
+    ASSERT_TRUE(parse(makeSps(params), &maxNumReorderPics));
+    // the highest sub-layer counts
+    EXPECT_EQ(3u, maxNumReorderPics);
+
+    params.maxSubLayersMinus1 = 6;
+    params.subLayerOrderingInfoPresent = false;
+    params.maxNumReorderPics = { 0 };
+    ASSERT_TRUE(parse(makeSps(params), &maxNumReorderPics));
+    EXPECT_EQ(0u, maxNumReorderPics);
+
+    params.maxSubLayersMinus1 = 7;
+    EXPECT_FALSE(parse(makeSps(params), &maxNumReorderPics));
+}
+
+TEST(HevcSpsTest, Truncated) {
+    SpsParams params;
+    params.maxNumReorderPics = { 2 };
+    std::vector<uint8_t> nal = makeSps(params);
+    uint32_t maxNumReorderPics;
+    ASSERT_TRUE(parse(nal, &maxNumReorderPics));
+    // drop the bytes of the unparsed fields and the trailing bits
+    for (size_t size = 6; size + 2 < nal.size(); ++size) {
+        std::vector<uint8_t> truncated(nal.begin(), nal.begin() + size);
+        EXPECT_FALSE(parse(truncated, &maxNumReorderPics)) << "size " << size;
+    }
+}
+
+TEST(HevcSpsTest, FindReordering) {
+    SpsParams params;
+    params.maxNumReorderPics = { 0 };
+    std::vector<uint8_t> lowDelaySps = makeSps(params);
+    params.maxNumReorderPics = { 2 };
+    std::vector<uint8_t> reorderSps = makeSps(params);
+    std::vector<uint8_t> slice = makeIdrSlice();
+
+    bool mayReorder = true;
+    EXPECT_FALSE(findReordering(slice, &mayReorder));
+    EXPECT_FALSE(findReordering({}, &mayReorder));
+
+    ASSERT_TRUE(findReordering(reorderSps, &mayReorder));
+    EXPECT_TRUE(mayReorder);
+
+    // the last SPS before the first slice counts
+    std::vector<uint8_t> data = reorderSps;
+    data.insert(data.end(), lowDelaySps.begin(), lowDelaySps.end());
+    data.insert(data.end(), slice.begin(), slice.end());
+    data.insert(data.end(), reorderSps.begin(), reorderSps.end());
+    mayReorder = true;
+    ASSERT_TRUE(findReordering(data, &mayReorder));
+    EXPECT_FALSE(mayReorder);
+
+    data = slice;
+    data.insert(data.end(), lowDelaySps.begin(), lowDelaySps.end());
+    EXPECT_FALSE(findReordering(data, &mayReorder));
+}
+
+} // namespace android
@@ -38,6 +38,7 @@ public:
         : C2InterfaceHelper(helper) {
 
         setDerivedInstance(this);
+        shareSchema(COMPONENT_NAME);
 
         addParameter(
                 DefineParam(mInputFormat, C2_NAME_INPUT_STREAM_FORMAT_SETTING)
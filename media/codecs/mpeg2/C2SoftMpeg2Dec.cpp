@@ -46,6 +46,7 @@ public:
         noOutputReferences();
         noInputLatency();
         noTimeStretch();
+        addWorkerThreads();
 
         // TODO: output latency and reordering
 
@@ -177,6 +178,13 @@ public:
                 .withConstValue(new C2StreamPixelFormatInfo::output(
                                      0u, HAL_PIXEL_FORMAT_YCBCR_420_888))
                 .build());
+
+        addParameter(
+                DefineParam(mKeyFramesOnly, C2_PARAMKEY_KEY_FRAMES_ONLY)
+                .withDefault(new C2GlobalKeyFramesOnlyTuning(C2_FALSE))
+                .withFields({C2F(mKeyFramesOnly, value).oneOf({ C2_FALSE, C2_TRUE })})
+                .withSetter(Setter<decltype(*mKeyFramesOnly)>::NonStrictValueWithNoDeps)
+                .build());
     }
 
     static C2R SizeSetter(bool mayBlock, const C2P<C2StreamPictureSizeInfo::output> &oldMe,
@@ -271,6 +279,14 @@ public:
         return mColorAspects;
     }
 
+    std::shared_ptr<C2WorkerThreadsTuning> getWorkerThreads_l() {
+        return mWorkerThreads;
+    }
+
+    std::shared_ptr<C2GlobalKeyFramesOnlyTuning> getKeyFramesOnly_l() {
+        return mKeyFramesOnly;
+    }
+
 private:
     std::shared_ptr<C2StreamProfileLevelInfo::input> mProfileLevel;
     std::shared_ptr<C2StreamPictureSizeInfo::output> mSize;
@@ -281,6 +297,7 @@ private:
     std::shared_ptr<C2StreamColorAspectsTuning::output> mDefaultColorAspects;
     std::shared_ptr<C2StreamColorAspectsInfo::output> mColorAspects;
     std::shared_ptr<C2StreamPixelFormatInfo::output> mPixelFormat;
+    std::shared_ptr<C2GlobalKeyFramesOnlyTuning> mKeyFramesOnly;
 };
 
 static size_t getCpuCoreCount() {
@@ -315,7 +332,8 @@ C2SoftMpeg2Dec::C2SoftMpeg2Dec(
         mOutBufferDrain(nullptr),
         mIvColorformat(IV_YUV_420P),
         mWidth(320),
-        mHeight(240) {
+        mHeight(240),
+        mKeyFramesOnly(false) {
     // If input dump is enabled, then open create an empty file
     GENERATE_FILE_NAMES();
     CREATE_DUMP_FILE(mInFile);
@@ -505,6 +523,24 @@ status_t C2SoftMpeg2Dec::setNumCores() {
     return OK;
 }
 
+bool C2SoftMpeg2Dec::updateWorkerThreads() {
+    std::shared_ptr<C2WorkerThreadsTuning> workerThreads;
+    {
+        IntfImpl::Lock lock = mIntf->lock();
+        workerThreads = mIntf->getWorkerThreads_l();
+    }
+    if (workerThreads == mWorkerThreads) {
+        return false;
+    }
+    // leave the CPUs of the component thread alone until they are first restricted
+    if (mWorkerThreads || workerThreads->cpuMask) {
+        SetWorkerCpus(*workerThreads);
+    }
+    mWorkerThreads = workerThreads;
+    mNumCores = LimitWorkerThreads(MIN(getCpuCoreCount(), MAX_NUM_CORES), *mWorkerThreads);
+    return true;
+}
+
 status_t C2SoftMpeg2Dec::setParams(size_t stride) {
     ivd_ctl_set_config_ip_t s_set_dyn_params_ip;
     ivd_ctl_set_config_op_t s_set_dyn_params_op;
@@ -513,7 +549,8 @@ status_t C2SoftMpeg2Dec::setParams(size_t stride) {
     s_set_dyn_params_ip.e_cmd = IVD_CMD_VIDEO_CTL;
     s_set_dyn_params_ip.e_sub_cmd = IVD_CMD_CTL_SETPARAMS;
     s_set_dyn_params_ip.u4_disp_wd = (UWORD32) stride;
-    s_set_dyn_params_ip.e_frm_skip_mode = IVD_SKIP_NONE;
+    // skipping P and B frames leaves the intra frames
+    s_set_dyn_params_ip.e_frm_skip_mode = mKeyFramesOnly ? IVD_SKIP_PB : IVD_SKIP_NONE;
     s_set_dyn_params_ip.e_frm_out_mode = IVD_DISPLAY_FRAME_OUT;
     s_set_dyn_params_ip.e_vid_dec_mode = IVD_DECODE_FRAME;
     s_set_dyn_params_op.u4_size = sizeof(ivd_ctl_set_config_op_t);
@@ -562,7 +599,11 @@ status_t C2SoftMpeg2Dec::initDecoder() {
 
     if (OK != createDecoder()) return UNKNOWN_ERROR;
 
-    mNumCores = MIN(getCpuCoreCount(), MAX_NUM_CORES);
+    (void) updateWorkerThreads();
+    {
+        IntfImpl::Lock lock = mIntf->lock();
+        mKeyFramesOnly = mIntf->getKeyFramesOnly_l()->value;
+    }
     mStride = ALIGN64(mWidth);
     mSignalledError = false;
     resetPlugin();
@@ -827,6 +868,20 @@ void C2SoftMpeg2Dec::process(
         work->result = C2_BAD_VALUE;
         return;
     }
+    if (mDecHandle && updateWorkerThreads()) {
+        (void) setNumCores();
+    }
+    bool keyFramesOnly;
+    {
+        IntfImpl::Lock lock = mIntf->lock();
+        keyFramesOnly = mIntf->getKeyFramesOnly_l()->value;
+    }
+    if (keyFramesOnly != mKeyFramesOnly) {
+        mKeyFramesOnly = keyFramesOnly;
+        if (mDecHandle) {
+            (void) setParams(mStride);
+        }
+    }
 
     size_t inOffset = 0u;
     size_t inSize = 0u;
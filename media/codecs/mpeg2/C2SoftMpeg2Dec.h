@@ -114,6 +114,7 @@ struct C2SoftMpeg2Dec : public SimpleC2Component {
     status_t fillMemRecords();
     status_t createDecoder();
     status_t setNumCores();
+    bool updateWorkerThreads();
     status_t setParams(size_t stride);
     status_t getVersion();
     status_t initDecoder();
@@ -154,6 +155,8 @@ struct C2SoftMpeg2Dec : public SimpleC2Component {
     uint8_t *mOutBufferDrain;
 
     size_t mNumCores;
+    // worker thread tuning that mNumCores and the CPUs of the component thread follow
+    std::shared_ptr<C2WorkerThreadsTuning> mWorkerThreads;
     IV_COLOR_FORMAT_T mIvColorformat;
 
     uint32_t mWidth;
@@ -162,6 +165,10 @@ struct C2SoftMpeg2Dec : public SimpleC2Component {
     bool mSignalledOutputEos;
     bool mSignalledError;
 
+    // If set, only intra frames are decoded. Skipped frames are returned without output, so
+    // output blocks are only used for the frames that are output.
+    bool mKeyFramesOnly;
+
     // Color aspects. These are ISO values and are meant to detect changes in aspects to avoid
     // converting them to C2 values for each frame
     struct VuiColorAspects {
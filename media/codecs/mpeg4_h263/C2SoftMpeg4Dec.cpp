@@ -27,6 +27,7 @@
 
 #include <C2Debug.h>
 #include <C2PlatformSupport.h>
+#include <Codec2BufferUtils.h>
 #include <SimpleC2Interface.h>
 
 #include "C2SoftMpeg4Dec.h"
@@ -246,7 +247,8 @@ C2SoftMpeg4Dec::C2SoftMpeg4Dec(
       mIntf(intfImpl),
       mDecHandle(nullptr),
       mOutputBuffer{},
-      mInitialized(false) {
+      mInitialized(false),
+      mUseBlockBuffers(true) {
 }
 
 C2SoftMpeg4Dec::~C2SoftMpeg4Dec() {
@@ -271,6 +273,7 @@ c2_status_t C2SoftMpeg4Dec::onStop() {
             mOutputBuffer[i] = nullptr;
         }
     }
+    mRefBlock.reset();
     mNumSamplesOutput = 0;
     mFramesConfigured = false;
     mSignalledOutputEos = false;
@@ -296,6 +299,7 @@ void C2SoftMpeg4Dec::onRelease() {
     if (mOutBlock) {
         mOutBlock.reset();
     }
+    mRefBlock.reset();
     for (int32_t i = 0; i < kNumOutputBuffers; ++i) {
         if (mOutputBuffer[i]) {
             free(mOutputBuffer[i]);
@@ -310,6 +314,11 @@ c2_status_t C2SoftMpeg4Dec::onFlush_sm() {
             return C2_CORRUPTED;
         }
     }
+    if (mRefBlock) {
+        // point the decoder back at an internal reference before dropping the reference block
+        mFramesConfigured = false;
+        mRefBlock.reset();
+    }
     mSignalledOutputEos = false;
     mSignalledError = false;
     return C2_OK;
@@ -341,6 +350,7 @@ status_t C2SoftMpeg4Dec::initDecoder() {
     mNumSamplesOutput = 0;
     mInitialized = false;
     mFramesConfigured = false;
+    mUseBlockBuffers = true;
     mSignalledOutputEos = false;
     mSignalledError = false;
 
@@ -383,6 +393,23 @@ void C2SoftMpeg4Dec::finishWork(uint64_t index, const std::unique_ptr<C2Work> &w
     }
 }
 
+// Returns true iff the decoder can write frames into |view| directly. The decoder writes
+// contiguous I420 frames with the luma stride and height aligned to 16.
+static bool isDecoderFrameLayout(const C2GraphicView &view) {
+    if (view.error() != C2_OK || !IsI420(view)) {
+        return false;
+    }
+    const C2PlanarLayout &layout = view.layout();
+    const uint8_t *const *data = view.data();
+    int32_t stride = view.width();
+    size_t lumaSize = (size_t)stride * view.height();
+    return layout.planes[C2PlanarLayout::PLANE_Y].rowInc == stride
+            && layout.planes[C2PlanarLayout::PLANE_U].rowInc == stride / 2
+            && layout.planes[C2PlanarLayout::PLANE_V].rowInc == stride / 2
+            && data[C2PlanarLayout::PLANE_U] == data[C2PlanarLayout::PLANE_Y] + lumaSize
+            && data[C2PlanarLayout::PLANE_V] == data[C2PlanarLayout::PLANE_U] + lumaSize / 4;
+}
+
 c2_status_t C2SoftMpeg4Dec::ensureDecoderState(const std::shared_ptr<C2BlockPool> &pool) {
     if (!mDecHandle) {
         ALOGE("not supposed to be here, invalid decoder context");
@@ -398,10 +425,27 @@ c2_status_t C2SoftMpeg4Dec::ensureDecoderState(const std::shared_ptr<C2BlockPool
             }
         }
     }
+    // Buffers of a surface are recycled by the consumer regardless of whether the decoder still
+    // references them, so they cannot hold reference frames.
+    if (mUseBlockBuffers && (pool->getAllocatorId() == C2PlatformAllocatorStore::BUFFERQUEUE
+            || (size_t)mDecHandle->size != (size_t)align(mWidth, 16) * align(mHeight, 16))) {
+        mUseBlockBuffers = false;
+    }
+    uint32_t blockHeight = mUseBlockBuffers ? align(mHeight, 16) : mHeight;
     if (mOutBlock &&
-            (mOutBlock->width() != align(mWidth, 16) || mOutBlock->height() != mHeight)) {
+            (mOutBlock->width() != align(mWidth, 16) || mOutBlock->height() != blockHeight)) {
         mOutBlock.reset();
     }
+    if (!mOutBlock && mUseBlockBuffers) {
+        C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+        c2_status_t err = pool->fetchGraphicBlock(
+                align(mWidth, 16), blockHeight, HAL_PIXEL_FORMAT_YCBCR_420_888, usage, &mOutBlock);
+        if (err != C2_OK || !isDecoderFrameLayout(mOutBlock->map().get())) {
+            ALOGD("output blocks cannot be decoded into; copying frames");
+            mUseBlockBuffers = false;
+            mOutBlock.reset();
+        }
+    }
     if (!mOutBlock) {
         uint32_t format = HAL_PIXEL_FORMAT_YV12;
         C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
@@ -434,6 +478,7 @@ bool C2SoftMpeg4Dec::handleResChange(const std::unique_ptr<C2Work> &work) {
         mWidth = disp_width;
         mHeight = disp_height;
         resChanged = true;
+        mRefBlock.reset();
         for (int32_t i = 0; i < kNumOutputBuffers; ++i) {
             if (mOutputBuffer[i]) {
                 free(mOutputBuffer[i]);
@@ -460,8 +505,7 @@ bool C2SoftMpeg4Dec::handleResChange(const std::unique_ptr<C2Work> &work) {
     return resChanged;
 }
 
-/* TODO: can remove temporary copy after library supports writing to display
- * buffer Y, U and V plane pointers using stride info. */
+/* Used only when output blocks do not match the layout the decoder writes. */
 static void copyOutputBufferToYV12Frame(uint8_t *dst, uint8_t *src, size_t dstYStride,
                                         size_t srcYStride, uint32_t width, uint32_t height) {
     size_t dstUVStride = align(dstYStride / 2, 16);
@@ -617,6 +661,9 @@ void C2SoftMpeg4Dec::process(
             mFramesConfigured = true;
         }
 
+        uint8_t *outputBuffer = mUseBlockBuffers
+                ? wView.data()[C2PlanarLayout::PLANE_Y] : mOutputBuffer[mNumSamplesOutput & 1];
+
         // Need to check if header contains new info, e.g., width/height, etc.
         VopHeaderInfo header_info;
         uint32_t useExtTimestamp = (inPos == 0);
@@ -625,8 +672,7 @@ void C2SoftMpeg4Dec::process(
         uint32_t timestamp = workIndex;
         if (PVDecodeVopHeader(
                     mDecHandle, &bitstreamTmp, &timestamp, &tmpInSize,
-                    &header_info, &useExtTimestamp,
-                    mOutputBuffer[mNumSamplesOutput & 1]) != PV_TRUE) {
+                    &header_info, &useExtTimestamp, outputBuffer) != PV_TRUE) {
             ALOGE("failed to decode vop header.");
             mSignalledError = true;
             work->result = C2_CORRUPTED;
@@ -668,9 +714,15 @@ void C2SoftMpeg4Dec::process(
             return;
         }
 
-        uint8_t *outputBufferY = wView.data()[C2PlanarLayout::PLANE_Y];
-        (void)copyOutputBufferToYV12Frame(outputBufferY, mOutputBuffer[mNumSamplesOutput & 1],
-                                          wView.width(), align(mWidth, 16), mWidth, mHeight);
+        if (mUseBlockBuffers) {
+            // the frame is the reference for the next one; keep its block out of the pool
+            mRefBlock = mOutBlock;
+        } else {
+            uint8_t *outputBufferY = wView.data()[C2PlanarLayout::PLANE_Y];
+            (void)copyOutputBufferToYV12Frame(outputBufferY, outputBuffer,
+                                              wView.width(), align(mWidth, 16), mWidth, mHeight);
+            mRefBlock.reset();
+        }
 
         inPos += inSize - (size_t)tmpInSize;
         finishWork(workIndex, work);
@@ -56,6 +56,9 @@ struct C2SoftMpeg4Dec : public SimpleC2Component {
     std::shared_ptr<IntfImpl> mIntf;
     tagvideoDecControls *mDecHandle;
     std::shared_ptr<C2GraphicBlock> mOutBlock;
+    // Block holding the last decoded frame, which the decoder references for prediction. Only
+    // set when frames are decoded into output blocks directly.
+    std::shared_ptr<C2GraphicBlock> mRefBlock;
     uint8_t *mOutputBuffer[kNumOutputBuffers];
     size_t  mOutputBufferSize;
 
@@ -66,6 +69,7 @@ struct C2SoftMpeg4Dec : public SimpleC2Component {
     bool mIsMpeg4;
     bool mInitialized;
     bool mFramesConfigured;
+    bool mUseBlockBuffers;
     bool mSignalledOutputEos;
     bool mSignalledError;
 
@@ -50,6 +50,7 @@ class C2SoftMpeg4Enc::IntfImpl : public C2InterfaceHelper {
     explicit IntfImpl(const std::shared_ptr<C2ReflectorHelper>& helper)
         : C2InterfaceHelper(helper) {
         setDerivedInstance(this);
+        shareSchema(COMPONENT_NAME);
 
         addParameter(
             DefineParam(mInputFormat, C2_NAME_INPUT_STREAM_FORMAT_SETTING)
@@ -378,6 +379,8 @@ c2_status_t C2SoftMpeg4Enc::initEncoder() {
         mBitrate = mIntf->getBitrate_l();
         mFrameRate = mIntf->getFrameRate_l();
     }
+    mInputConverter.configure(EncoderInputConverter::FORMAT_I420, mSize->width, mSize->height,
+                              mSize->width, mSize->height, true /* halfChromaStride */);
     c2_status_t err = initEncParams();
     if (C2_OK != err) {
         ALOGE("Failed to initialized encoder params");
@@ -490,77 +493,20 @@ void C2SoftMpeg4Enc::process(
         return;
     }
 
-    const C2PlanarLayout &layout = rView->layout();
-    uint8_t *yPlane = const_cast<uint8_t *>(rView->data()[C2PlanarLayout::PLANE_Y]);
-    uint8_t *uPlane = const_cast<uint8_t *>(rView->data()[C2PlanarLayout::PLANE_U]);
-    uint8_t *vPlane = const_cast<uint8_t *>(rView->data()[C2PlanarLayout::PLANE_V]);
-    int32_t yStride = layout.planes[C2PlanarLayout::PLANE_Y].rowInc;
-    int32_t uStride = layout.planes[C2PlanarLayout::PLANE_U].rowInc;
-    int32_t vStride = layout.planes[C2PlanarLayout::PLANE_V].rowInc;
+    EncoderInputConverter::Frame frame;
+    err = mInputConverter.convert(*rView, &frame);
+    if (err != C2_OK) {
+        work->result = err;
+        return;
+    }
+    uint8_t *yPlane = const_cast<uint8_t *>(frame.y);
+    uint8_t *uPlane = const_cast<uint8_t *>(frame.u);
+    uint8_t *vPlane = const_cast<uint8_t *>(frame.v);
     uint32_t width = mSize->width;
     uint32_t height = mSize->height;
     // width and height are always even (as block size is 16x16)
     CHECK_EQ((width & 1u), 0u);
     CHECK_EQ((height & 1u), 0u);
-    size_t yPlaneSize = width * height;
-    switch (layout.type) {
-        case C2PlanarLayout::TYPE_RGB:
-            [[fallthrough]];
-        case C2PlanarLayout::TYPE_RGBA: {
-            MemoryBlock conversionBuffer = mConversionBuffers.fetch(yPlaneSize * 3 / 2);
-            mConversionBuffersInUse.emplace(conversionBuffer.data(), conversionBuffer);
-            yPlane = conversionBuffer.data();
-            uPlane = yPlane + yPlaneSize;
-            vPlane = uPlane + yPlaneSize / 4;
-            yStride = width;
-            uStride = vStride = width / 2;
-            ConvertRGBToPlanarYUV(yPlane, yStride, height, conversionBuffer.size(), *rView.get());
-            break;
-        }
-        case C2PlanarLayout::TYPE_YUV: {
-            if (!IsYUV420(*rView)) {
-                ALOGE("input is not YUV420");
-                work->result = C2_BAD_VALUE;
-                break;
-            }
-
-            if (layout.planes[layout.PLANE_Y].colInc == 1
-                    && layout.planes[layout.PLANE_U].colInc == 1
-                    && layout.planes[layout.PLANE_V].colInc == 1
-                    && uStride == vStride
-                    && yStride == 2 * vStride) {
-                // I420 compatible - planes are already set up above
-                break;
-            }
-
-            // copy to I420
-            MemoryBlock conversionBuffer = mConversionBuffers.fetch(yPlaneSize * 3 / 2);
-            mConversionBuffersInUse.emplace(conversionBuffer.data(), conversionBuffer);
-            MediaImage2 img = CreateYUV420PlanarMediaImage2(width, height, width, height);
-            status_t err = ImageCopy(conversionBuffer.data(), &img, *rView);
-            if (err != OK) {
-                ALOGE("Buffer conversion failed: %d", err);
-                work->result = C2_BAD_VALUE;
-                return;
-            }
-            yPlane = conversionBuffer.data();
-            uPlane = yPlane + yPlaneSize;
-            vPlane = uPlane + yPlaneSize / 4;
-            yStride = width;
-            uStride = vStride = width / 2;
-            break;
-        }
-
-        case C2PlanarLayout::TYPE_YUVA:
-            ALOGE("YUVA plane type is not supported");
-            work->result = C2_BAD_VALUE;
-            return;
-
-        default:
-            ALOGE("Unrecognized plane type: %d", layout.type);
-            work->result = C2_BAD_VALUE;
-            return;
-    }
 
     CHECK(NULL != yPlane);
     /* Encode frames */
@@ -603,7 +549,7 @@ void C2SoftMpeg4Enc::process(
         mSignalledOutputEos = true;
     }
 
-    mConversionBuffersInUse.erase(yPlane);
+    mInputConverter.release(yPlane);
 }
 
 c2_status_t C2SoftMpeg4Enc::drain(
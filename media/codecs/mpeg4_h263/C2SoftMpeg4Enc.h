@@ -17,9 +17,7 @@
 #ifndef C2_SOFT_MPEG4_ENC_H__
 #define C2_SOFT_MPEG4_ENC_H__
 
-#include <map>
-
-#include <Codec2BufferUtils.h>
+#include <EncoderInputConverter.h>
 #include <SimpleC2Component.h>
 
 #include "mp4enc_api.h"
@@ -69,8 +67,7 @@ private:
     int64_t  mNumInputFrames;
     MP4EncodingMode mEncodeMode;
 
-    MemoryBlockPool mConversionBuffers;
-    std::map<void *, MemoryBlock> mConversionBuffersInUse;
+    EncoderInputConverter mInputConverter;
 
     c2_status_t initEncParams();
     c2_status_t initEncoder();
@@ -25,12 +25,23 @@ namespace android {
 
 constexpr char COMPONENT_NAME[] = "c2.android.vp9.encoder";
 
+// VP9 tiles are at least 256 pixels wide; there are at most 4 tile rows.
+constexpr uint32_t kMinTileWidth = 256;
+constexpr uint32_t kMaxTileRows = 4;
+
+static int32_t floorLog2(uint32_t value) {
+    int32_t log2 = 0;
+    while (value >>= 1) {
+        ++log2;
+    }
+    return log2;
+}
+
 C2SoftVp9Enc::C2SoftVp9Enc(const char* name, c2_node_id_t id,
                            const std::shared_ptr<IntfImpl>& intfImpl)
     : C2SoftVpxEnc(name, id, intfImpl),
       mProfile(1),
       mLevel(0),
-      mTileColumns(0),
       mFrameParallelDecoding(false) {
 }
 
@@ -62,11 +73,27 @@ void C2SoftVp9Enc::setCodecSpecificConfiguration() {
 }
 
 vpx_codec_err_t C2SoftVp9Enc::setCodecSpecificControls() {
+    // Tile counts are set as log2. By default use a tile column per thread so that threads can
+    // work in parallel even without row-mt.
+    uint32_t tileColumns = mThreading->tileColumns ? mThreading->tileColumns : mNumThreads;
+    tileColumns = c2_clamp(1u, tileColumns, c2_max(mSize->width / kMinTileWidth, 1u));
+    uint32_t tileRows = c2_clamp(1u, mThreading->tileRows, kMaxTileRows);
+    int32_t log2TileColumns = floorLog2(tileColumns);
+    int32_t log2TileRows = floorLog2(tileRows);
+    ALOGV("tiles: %d x %d (log2)", log2TileColumns, log2TileRows);
+
     vpx_codec_err_t codecReturn = vpx_codec_control(
-            mCodecContext, VP9E_SET_TILE_COLUMNS, mTileColumns);
+            mCodecContext, VP9E_SET_TILE_COLUMNS, log2TileColumns);
     if (codecReturn != VPX_CODEC_OK) {
         ALOGE("Error setting VP9E_SET_TILE_COLUMNS to %d. vpx_codec_control() "
-              "returned %d", mTileColumns, codecReturn);
+              "returned %d", log2TileColumns, codecReturn);
+        return codecReturn;
+    }
+    codecReturn = vpx_codec_control(
+            mCodecContext, VP9E_SET_TILE_ROWS, log2TileRows);
+    if (codecReturn != VPX_CODEC_OK) {
+        ALOGE("Error setting VP9E_SET_TILE_ROWS to %d. vpx_codec_control() "
+              "returned %d", log2TileRows, codecReturn);
         return codecReturn;
     }
     codecReturn = vpx_codec_control(
@@ -78,19 +105,11 @@ vpx_codec_err_t C2SoftVp9Enc::setCodecSpecificControls() {
               codecReturn);
         return codecReturn;
     }
-    codecReturn = vpx_codec_control(mCodecContext, VP9E_SET_ROW_MT, 1);
-    if (codecReturn != VPX_CODEC_OK) {
-        ALOGE("Error setting VP9E_SET_ROW_MT to 1. vpx_codec_control() "
-              "returned %d", codecReturn);
-        return codecReturn;
-    }
-
-    // For VP9, we always set CPU_USED to 8 (because the realtime default is 0
-    // which is too slow).
-    codecReturn = vpx_codec_control(mCodecContext, VP8E_SET_CPUUSED, 8);
+    int32_t rowMt = mThreading->rowMt ? 1 : 0;
+    codecReturn = vpx_codec_control(mCodecContext, VP9E_SET_ROW_MT, rowMt);
     if (codecReturn != VPX_CODEC_OK) {
-        ALOGE("Error setting VP8E_SET_CPUUSED to 8. vpx_codec_control() "
-              "returned %d", codecReturn);
+        ALOGE("Error setting VP9E_SET_ROW_MT to %d. vpx_codec_control() "
+              "returned %d", rowMt, codecReturn);
         return codecReturn;
     }
     return codecReturn;
@@ -47,8 +47,6 @@ struct C2SoftVp9Enc : public C2SoftVpxEnc {
     int32_t mProfile;
     int32_t mLevel __unused;
 
-    int32_t mTileColumns;
-
     bool mFrameParallelDecoding;
 
     C2_DO_NOT_COPY(C2SoftVp9Enc);
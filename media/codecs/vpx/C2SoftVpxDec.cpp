@@ -54,6 +54,7 @@ public:
         noOutputReferences();
         noInputLatency();
         noTimeStretch();
+        addWorkerThreads();
 
         // TODO: output latency and reordering
 
@@ -194,6 +195,20 @@ public:
                 .withConstValue(new C2StreamPixelFormatInfo::output(
                                      0u, HAL_PIXEL_FORMAT_YCBCR_420_888))
                 .build());
+
+        addParameter(
+                DefineParam(mLowLatency, C2_PARAMKEY_LOW_LATENCY_MODE)
+                .withDefault(new C2GlobalLowLatencyModeTuning(C2_FALSE))
+                .withFields({C2F(mLowLatency, value).oneOf({ C2_FALSE, C2_TRUE })})
+                .withSetter(Setter<decltype(*mLowLatency)>::NonStrictValueWithNoDeps)
+                .build());
+
+        addParameter(
+                DefineParam(mKeyFramesOnly, C2_PARAMKEY_KEY_FRAMES_ONLY)
+                .withDefault(new C2GlobalKeyFramesOnlyTuning(C2_FALSE))
+                .withFields({C2F(mKeyFramesOnly, value).oneOf({ C2_FALSE, C2_TRUE })})
+                .withSetter(Setter<decltype(*mKeyFramesOnly)>::NonStrictValueWithNoDeps)
+                .build());
     }
 
     static C2R SizeSetter(bool mayBlock, const C2P<C2StreamPictureSizeInfo::output> &oldMe,
@@ -249,6 +264,18 @@ public:
         return C2R::Ok();
     }
 
+    std::shared_ptr<C2WorkerThreadsTuning> getWorkerThreads_l() {
+        return mWorkerThreads;
+    }
+
+    std::shared_ptr<C2GlobalLowLatencyModeTuning> getLowLatencyMode_l() {
+        return mLowLatency;
+    }
+
+    std::shared_ptr<C2GlobalKeyFramesOnlyTuning> getKeyFramesOnly_l() {
+        return mKeyFramesOnly;
+    }
+
 private:
     std::shared_ptr<C2StreamProfileLevelInfo::input> mProfileLevel;
     std::shared_ptr<C2StreamPictureSizeInfo::output> mSize;
@@ -256,6 +283,8 @@ private:
     std::shared_ptr<C2StreamMaxBufferSizeInfo::input> mMaxInputSize;
     std::shared_ptr<C2StreamColorInfo::output> mColorInfo;
     std::shared_ptr<C2StreamPixelFormatInfo::output> mPixelFormat;
+    std::shared_ptr<C2GlobalLowLatencyModeTuning> mLowLatency;
+    std::shared_ptr<C2GlobalKeyFramesOnlyTuning> mKeyFramesOnly;
 #ifdef VP9
 #if 0
     std::shared_ptr<C2StreamHdrStaticInfo::output> mHdrStaticInfo;
@@ -271,7 +300,11 @@ C2SoftVpxDec::C2SoftVpxDec(
         const std::shared_ptr<IntfImpl> &intfImpl)
     : SimpleC2Component(std::make_shared<SimpleInterface<IntfImpl>>(name, id, intfImpl)),
       mIntf(intfImpl),
-      mCodecCtx(nullptr) {
+      mCodecCtx(nullptr),
+      mUseBlockFrameBuffers(false),
+      mFrameBufferWidth(0),
+      mLowLatency(false),
+      mSkipToKeyFrame(false) {
 }
 
 C2SoftVpxDec::~C2SoftVpxDec() {
@@ -325,6 +358,30 @@ c2_status_t C2SoftVpxDec::onFlush_sm() {
     return C2_OK;
 }
 
+bool C2SoftVpxDec::isKeyFrame(const uint8_t *data, size_t size) const {
+    vpx_codec_stream_info_t si;
+    si.sz = sizeof(si);
+    si.is_kf = 0;
+    return vpx_codec_peek_stream_info(
+            mMode == MODE_VP8 ? &vpx_codec_vp8_dx_algo : &vpx_codec_vp9_dx_algo,
+            data, size, &si) == VPX_CODEC_OK && si.is_kf;
+}
+
+bool C2SoftVpxDec::skipFrame(const uint8_t *data, size_t size) {
+    bool keyFramesOnly;
+    {
+        IntfImpl::Lock lock = mIntf->lock();
+        keyFramesOnly = mIntf->getKeyFramesOnly_l()->value;
+    }
+    // libvpx has no frame skipping of its own. Frames following a skipped frame cannot be
+    // decoded either, so decoding resumes at the next key frame.
+    if (!keyFramesOnly && !mSkipToKeyFrame) {
+        return false;
+    }
+    mSkipToKeyFrame = !isKeyFrame(data, size);
+    return mSkipToKeyFrame;
+}
+
 static int GetCPUCoreCount() {
     int cpuCoreCount = 1;
 #if defined(_SC_NPROCESSORS_ONLN)
@@ -338,6 +395,165 @@ static int GetCPUCoreCount() {
     return cpuCoreCount;
 }
 
+// Border that the VP9 decoder adds around each plane of its frame buffers (see
+// VP9_DEC_BORDER_IN_PIXELS in libvpx).
+constexpr uint32_t kVp9DecBorder = 32;
+
+// Alignment of the frame buffers; libvpx requests this much extra memory to align the buffer
+// itself if needed.
+constexpr uintptr_t kFrameBufferAlign = 32;
+
+// Maximum number of free heap frame buffers kept for reuse.
+constexpr size_t kMaxFreeHeapFrameBuffers = 8;
+
+// A frame buffer of the decoder, backed by either an output block or heap memory.
+struct C2SoftVpxDec::FrameBuffer {
+    std::shared_ptr<C2GraphicBlock> block;
+    std::unique_ptr<C2GraphicView> view;
+    std::vector<uint8_t> heap;
+};
+
+// static
+int C2SoftVpxDec::GetFrameBuffer(void *priv, size_t minSize, vpx_codec_frame_buffer_t *fb) {
+    return static_cast<C2SoftVpxDec *>(priv)->getFrameBuffer(minSize, fb);
+}
+
+// static
+int C2SoftVpxDec::ReleaseFrameBuffer(void *priv, vpx_codec_frame_buffer_t *fb) {
+    return static_cast<C2SoftVpxDec *>(priv)->releaseFrameBuffer(fb);
+}
+
+int C2SoftVpxDec::getFrameBuffer(size_t minSize, vpx_codec_frame_buffer_t *fb) {
+    std::unique_ptr<FrameBuffer> buffer;
+    if (mUseBlockFrameBuffers) {
+        buffer = fetchBlockFrameBuffer(minSize);
+    }
+    if (buffer) {
+        fb->data = const_cast<uint8_t *>(buffer->view->data()[C2PlanarLayout::PLANE_Y]);
+    } else {
+        if (!mFreeHeapFrameBuffers.empty()) {
+            buffer = std::move(mFreeHeapFrameBuffers.back());
+            mFreeHeapFrameBuffers.pop_back();
+        } else {
+            buffer.reset(new FrameBuffer);
+        }
+        if (buffer->heap.size() < minSize) {
+            buffer->heap.resize(minSize);
+        }
+        fb->data = buffer->heap.data();
+    }
+    fb->size = minSize;
+    fb->priv = buffer.release();
+    return 0;
+}
+
+int C2SoftVpxDec::releaseFrameBuffer(vpx_codec_frame_buffer_t *fb) {
+    std::unique_ptr<FrameBuffer> buffer(static_cast<FrameBuffer *>(fb->priv));
+    fb->priv = nullptr;
+    // Output blocks go back to the pool once the client also releases them.
+    if (buffer && !buffer->block && mFreeHeapFrameBuffers.size() < kMaxFreeHeapFrameBuffers) {
+        mFreeHeapFrameBuffers.push_back(std::move(buffer));
+    }
+    return 0;
+}
+
+std::unique_ptr<C2SoftVpxDec::FrameBuffer> C2SoftVpxDec::fetchBlockFrameBuffer(size_t minSize) {
+    // Buffers of a surface are recycled by the consumer regardless of whether the decoder still
+    // references them, so they cannot hold reference frames.
+    if (!mOutputPool || !mFrameBufferWidth
+            || mOutputPool->getAllocatorId() == C2PlatformAllocatorStore::BUFFERQUEUE) {
+        return nullptr;
+    }
+
+    // libvpx lays out an 8-bit I420 frame with borders: a Y plane of |stride| x |height| followed
+    // by U and V planes of half the stride and height, and asks for alignment slack on top.
+    uint32_t stride = align(align(mFrameBufferWidth, 8) + 2 * kVp9DecBorder, 32);
+    if (minSize < kFrameBufferAlign) {
+        return nullptr;
+    }
+    size_t frameSize = minSize - (kFrameBufferAlign - 1);
+    size_t ySize = frameSize / 3 * 2;
+    if (frameSize % 3 || ySize % (stride * 2)) {
+        return nullptr;
+    }
+    uint32_t height = ySize / stride;
+
+    std::shared_ptr<C2GraphicBlock> block;
+    C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+    c2_status_t err = mOutputPool->fetchGraphicBlock(
+            stride, height, HAL_PIXEL_FORMAT_YCBCR_420_888, usage, &block);
+    if (err != C2_OK) {
+        ALOGD("fetchGraphicBlock for frame buffer failed with status %d", err);
+        return nullptr;
+    }
+    std::unique_ptr<C2GraphicView> view(new C2GraphicView(block->map().get()));
+    if (view->error()) {
+        ALOGD("graphic view map failed %d", view->error());
+        return nullptr;
+    }
+
+    // The block must be exactly that layout in contiguous memory. It is aligned as the extra
+    // alignment memory is not needed then.
+    const C2PlanarLayout layout = view->layout();
+    const uint8_t *const *data = view->data();
+    const C2PlaneInfo &y = layout.planes[C2PlanarLayout::PLANE_Y];
+    const C2PlaneInfo &u = layout.planes[C2PlanarLayout::PLANE_U];
+    const C2PlaneInfo &v = layout.planes[C2PlanarLayout::PLANE_V];
+    if (layout.type != C2PlanarLayout::TYPE_YUV || layout.rootPlanes != 3
+            || y.colInc != 1 || y.rowInc != (int32_t)stride || y.allocatedDepth != 8
+            || u.colInc != 1 || u.rowInc != (int32_t)stride / 2 || u.allocatedDepth != 8
+            || v.colInc != 1 || v.rowInc != (int32_t)stride / 2 || v.allocatedDepth != 8
+            || data[C2PlanarLayout::PLANE_U] != data[C2PlanarLayout::PLANE_Y] + ySize
+            || data[C2PlanarLayout::PLANE_V] != data[C2PlanarLayout::PLANE_U] + ySize / 4
+            || ((uintptr_t)data[C2PlanarLayout::PLANE_Y] & (kFrameBufferAlign - 1))) {
+        ALOGD("output blocks do not match the decoder layout; decoding to heap buffers");
+        mUseBlockFrameBuffers = false;
+        return nullptr;
+    }
+
+    std::unique_ptr<FrameBuffer> buffer(new FrameBuffer);
+    buffer->block = std::move(block);
+    buffer->view = std::move(view);
+    return buffer;
+}
+
+bool C2SoftVpxDec::getOutputBlock(
+        const vpx_image_t *img, std::shared_ptr<C2GraphicBlock> *block, C2Rect *crop) {
+    const FrameBuffer *buffer = static_cast<const FrameBuffer *>(img->fb_priv);
+    if (!buffer || !buffer->block) {
+        return false;
+    }
+
+    // Find the crop of the block that the image occupies.
+    const uint8_t *const *data = buffer->view->data();
+    const C2PlanarLayout layout = buffer->view->layout();
+    int32_t yStride = layout.planes[C2PlanarLayout::PLANE_Y].rowInc;
+    int32_t uvStride = layout.planes[C2PlanarLayout::PLANE_U].rowInc;
+    ptrdiff_t yOffset = img->planes[VPX_PLANE_Y] - data[C2PlanarLayout::PLANE_Y];
+    uint32_t top = yOffset / yStride;
+    uint32_t left = yOffset % yStride;
+    ptrdiff_t uvOffset = (top / 2) * uvStride + left / 2;
+    if (img->fmt != VPX_IMG_FMT_I420 || yOffset < 0 || (top & 1) || (left & 1)
+            || img->stride[VPX_PLANE_Y] != yStride
+            || img->stride[VPX_PLANE_U] != uvStride || img->stride[VPX_PLANE_V] != uvStride
+            || img->planes[VPX_PLANE_U] - data[C2PlanarLayout::PLANE_U] != uvOffset
+            || img->planes[VPX_PLANE_V] - data[C2PlanarLayout::PLANE_V] != uvOffset
+            || left + mWidth > buffer->block->width() || top + mHeight > buffer->block->height()) {
+        ALOGD("decoded frame does not fit its block; decoding to heap buffers");
+        mUseBlockFrameBuffers = false;
+        return false;
+    }
+    *block = buffer->block;
+    *crop = C2Rect(mWidth, mHeight).at(left, top);
+    return true;
+}
+
+bool C2SoftVpxDec::decoderTuningsChanged() {
+    IntfImpl::Lock lock = mIntf->lock();
+    return mIntf->getWorkerThreads_l() != mWorkerThreads
+            || (mIntf->getLowLatencyMode_l()->value != C2_FALSE) != mLowLatency;
+}
+
 status_t C2SoftVpxDec::initDecoder() {
 #ifdef VP9
     mMode = MODE_VP9;
@@ -359,13 +575,26 @@ status_t C2SoftVpxDec::initDecoder() {
         return NO_MEMORY;
     }
 
+    std::shared_ptr<C2WorkerThreadsTuning> workerThreads;
+    {
+        IntfImpl::Lock lock = mIntf->lock();
+        workerThreads = mIntf->getWorkerThreads_l();
+        mLowLatency = mIntf->getLowLatencyMode_l()->value;
+    }
+    // leave the CPUs of the component thread alone until they are first restricted
+    if (mWorkerThreads || workerThreads->cpuMask) {
+        SetWorkerCpus(*workerThreads);
+    }
+    mWorkerThreads = workerThreads;
+
     vpx_codec_dec_cfg_t cfg;
     memset(&cfg, 0, sizeof(vpx_codec_dec_cfg_t));
-    cfg.threads = GetCPUCoreCount();
+    cfg.threads = LimitWorkerThreads(GetCPUCoreCount(), *mWorkerThreads);
 
     vpx_codec_flags_t flags;
     memset(&flags, 0, sizeof(vpx_codec_flags_t));
-    if (mFrameParallelMode) flags |= VPX_CODEC_USE_FRAME_THREADING;
+    // frame parallel decoding holds back a frame per thread
+    if (mFrameParallelMode && !mLowLatency) flags |= VPX_CODEC_USE_FRAME_THREADING;
 
     vpx_codec_err_t vpx_err;
     if ((vpx_err = vpx_codec_dec_init(
@@ -375,6 +604,26 @@ status_t C2SoftVpxDec::initDecoder() {
         return UNKNOWN_ERROR;
     }
 
+    if (mMode == MODE_VP9 && mLowLatency) {
+        // spread the decoding of each frame over the threads, not just over its tile columns
+        vpx_err = vpx_codec_control(mCodecCtx, VP9D_SET_ROW_MT, 1);
+        if (vpx_err != VPX_CODEC_OK) {
+            ALOGW("failed to enable row based multi-threading (%d)", vpx_err);
+        }
+    }
+
+    mUseBlockFrameBuffers = false;
+    mFrameBufferWidth = 0;
+    if (mMode == MODE_VP9) {
+        vpx_err = vpx_codec_set_frame_buffer_functions(
+                mCodecCtx, GetFrameBuffer, ReleaseFrameBuffer, this);
+        if (vpx_err == VPX_CODEC_OK) {
+            mUseBlockFrameBuffers = true;
+        } else {
+            ALOGW("failed to set frame buffer functions (%d)", vpx_err);
+        }
+    }
+
     return OK;
 }
 
@@ -384,6 +633,8 @@ status_t C2SoftVpxDec::destroyDecoder() {
         delete mCodecCtx;
         mCodecCtx = nullptr;
     }
+    mFreeHeapFrameBuffers.clear();
+    mOutputPool.reset();
 
     return OK;
 }
@@ -401,9 +652,8 @@ void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
 }
 
 void C2SoftVpxDec::finishWork(uint64_t index, const std::unique_ptr<C2Work> &work,
-                           const std::shared_ptr<C2GraphicBlock> &block) {
-    std::shared_ptr<C2Buffer> buffer = createGraphicBuffer(block,
-                                                           C2Rect(mWidth, mHeight));
+                           const std::shared_ptr<C2GraphicBlock> &block, const C2Rect &crop) {
+    std::shared_ptr<C2Buffer> buffer = createGraphicBuffer(block, crop);
     auto fillWork = [buffer, index, intf = this->mIntf](
             const std::unique_ptr<C2Work> &work) {
         uint32_t flags = 0;
@@ -498,8 +748,37 @@ void C2SoftVpxDec::process(
 
     int64_t frameIndex = work->input.ordinal.frameIndex.peekll();
 
-    if (inSize) {
-        uint8_t *bitstream = const_cast<uint8_t *>(rView.data() + inOffset);
+    uint8_t *bitstream = const_cast<uint8_t *>(rView.data() + inOffset);
+    bool skipped = inSize && skipFrame(bitstream, inSize);
+    if (inSize && !skipped) {
+        // libvpx sets up its threads when the decoder is created, so new worker thread or low
+        // latency tunings are applied by recreating the decoder at the next key frame.
+        if (decoderTuningsChanged() && isKeyFrame(bitstream, inSize)) {
+            uint32_t width = mWidth;
+            uint32_t height = mHeight;
+            destroyDecoder();
+            if (initDecoder() != OK) {
+                ALOGE("failed to recreate decoder");
+                mSignalledError = true;
+                work->workletsProcessed = 1u;
+                work->result = C2_CORRUPTED;
+                return;
+            }
+            mWidth = width;
+            mHeight = height;
+        }
+        if (mUseBlockFrameBuffers) {
+            // frame buffers are fetched while decoding; their layout depends on the frame width
+            mOutputPool = pool;
+            vpx_codec_stream_info_t si;
+            si.sz = sizeof(si);
+            si.w = 0;
+            if (vpx_codec_peek_stream_info(
+                        &vpx_codec_vp9_dx_algo, bitstream, inSize, &si) == VPX_CODEC_OK
+                    && si.w > 0) {
+                mFrameBufferWidth = si.w;
+            }
+        }
         vpx_codec_err_t err = vpx_codec_decode(
                 mCodecCtx, bitstream, inSize, &frameIndex, 0);
         if (err != VPX_CODEC_OK) {
@@ -516,7 +795,7 @@ void C2SoftVpxDec::process(
     if (eos) {
         drainInternal(DRAIN_COMPONENT_WITH_EOS, pool, work);
         mSignalledOutputEos = true;
-    } else if (!inSize) {
+    } else if (!inSize || skipped) {
         fillEmptyWork(work);
     }
 }
@@ -587,6 +866,14 @@ bool C2SoftVpxDec::outputBuffer(
     }
 
     std::shared_ptr<C2GraphicBlock> block;
+    C2Rect crop(mWidth, mHeight);
+    if (getOutputBlock(img, &block, &crop)) {
+        ALOGV("output frame without copy at (%u,%u), out frameindex %d",
+              crop.left, crop.top, (int)*(int64_t *)img->user_priv);
+        finishWork(*(int64_t *)img->user_priv, work, std::move(block), crop);
+        return true;
+    }
+
     uint32_t format = HAL_PIXEL_FORMAT_YV12;
     C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
     c2_status_t err = pool->fetchGraphicBlock(align(mWidth, 16) * bpp, mHeight, format, usage, &block);
@@ -616,7 +903,7 @@ bool C2SoftVpxDec::outputBuffer(
     copyOutputBufferToYV12Frame(dst, srcY, srcU, srcV,
                                 srcYStride, srcUStride, srcVStride, mWidth, mHeight, bpp);
 
-    finishWork(*(int64_t *)img->user_priv, work, std::move(block));
+    finishWork(*(int64_t *)img->user_priv, work, std::move(block), crop);
     return true;
 }
 
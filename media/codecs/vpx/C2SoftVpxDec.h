@@ -19,8 +19,11 @@
 
 #include <SimpleC2Component.h>
 
+#include <memory>
+#include <vector>
 
 #include "vpx/vpx_decoder.h"
+#include "vpx/vpx_frame_buffer.h"
 #include "vpx/vp8dx.h"
 
 namespace android {
@@ -45,6 +48,8 @@ struct C2SoftVpxDec : public SimpleC2Component {
             uint32_t drainMode,
             const std::shared_ptr<C2BlockPool> &pool) override;
  private:
+    struct FrameBuffer;
+
     enum {
         MODE_VP8,
         MODE_VP9,
@@ -59,10 +64,36 @@ struct C2SoftVpxDec : public SimpleC2Component {
     bool mSignalledOutputEos;
     bool mSignalledError;
 
+    // Frame buffers of the decoder (VP9 only). Frames are decoded into output blocks when their
+    // layout matches the one libvpx decodes into, so that they are output without a copy.
+    // Otherwise frames are decoded into heap buffers and copied.
+    std::shared_ptr<C2BlockPool> mOutputPool;
+    bool mUseBlockFrameBuffers;
+    uint32_t mFrameBufferWidth;
+    std::vector<std::unique_ptr<FrameBuffer>> mFreeHeapFrameBuffers;
+
+    static int GetFrameBuffer(void *priv, size_t minSize, vpx_codec_frame_buffer_t *fb);
+    static int ReleaseFrameBuffer(void *priv, vpx_codec_frame_buffer_t *fb);
+    int getFrameBuffer(size_t minSize, vpx_codec_frame_buffer_t *fb);
+    int releaseFrameBuffer(vpx_codec_frame_buffer_t *fb);
+    std::unique_ptr<FrameBuffer> fetchBlockFrameBuffer(size_t minSize);
+    bool getOutputBlock(const vpx_image_t *img,
+                        std::shared_ptr<C2GraphicBlock> *block, C2Rect *crop);
+
+    // tunings the decoder was created with
+    std::shared_ptr<C2WorkerThreadsTuning> mWorkerThreads;
+    bool mLowLatency;
+    bool decoderTuningsChanged();
+    bool isKeyFrame(const uint8_t *data, size_t size) const;
+
+    // set while frames are skipped until the next key frame
+    bool mSkipToKeyFrame;
+    bool skipFrame(const uint8_t *data, size_t size);
+
     status_t initDecoder();
     status_t destroyDecoder();
     void finishWork(uint64_t index, const std::unique_ptr<C2Work> &work,
-                    const std::shared_ptr<C2GraphicBlock> &block);
+                    const std::shared_ptr<C2GraphicBlock> &block, const C2Rect &crop);
     bool outputBuffer(
             const std::shared_ptr<C2BlockPool> &pool,
             const std::unique_ptr<C2Work> &work);
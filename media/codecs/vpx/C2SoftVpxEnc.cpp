@@ -23,6 +23,8 @@
 
 #include <Codec2BufferUtils.h>
 #include <C2Debug.h>
+#include <eco/ECOEncoderStatsProvider.h>
+#include <eco/ECOServiceConstants.h>
 #include "C2SoftVpxEnc.h"
 
 #ifndef INT32_MAX
@@ -31,7 +33,6 @@
 
 namespace android {
 
-#if 0
 static size_t getCpuCoreCount() {
     long cpuCoreCount = 1;
 #if defined(_SC_NPROCESSORS_ONLN)
@@ -44,8 +45,26 @@ static size_t getCpuCoreCount() {
     ALOGV("Number of CPU cores: %ld", cpuCoreCount);
     return (size_t)cpuCoreCount;
 }
+
+#ifdef VP9
+// The realtime default speed of VP9 is too slow, so it is always set.
+constexpr bool kAlwaysSetSpeed = true;
+#else
+// VP8 keeps the libvpx default speed in VBR mode unless the client sets one.
+constexpr bool kAlwaysSetSpeed = false;
 #endif
 
+// Pixel rate that a single encoding thread is expected to sustain in realtime.
+constexpr uint64_t kPixelRatePerThread = 640 * 480 * 30;
+
+// Returns the number of threads to encode |width| x |height| at |frameRate|.
+static uint32_t getAutoThreadCount(uint32_t width, uint32_t height, float frameRate) {
+    uint64_t pixelRate = (uint64_t)((double)width * height * c2_clamp(1.f, frameRate, 240.f));
+    uint64_t threads = (pixelRate + kPixelRatePerThread - 1) / kPixelRatePerThread;
+    uint64_t maxThreads = c2_min(getCpuCoreCount(), (size_t)C2SoftVpxEnc::IntfImpl::kMaxThreads);
+    return (uint32_t)c2_clamp((uint64_t)1, threads, maxThreads);
+}
+
 C2SoftVpxEnc::C2SoftVpxEnc(const char* name, c2_node_id_t id,
                            const std::shared_ptr<IntfImpl>& intfImpl)
     : SimpleC2Component(
@@ -66,7 +85,9 @@ C2SoftVpxEnc::C2SoftVpxEnc(const char* name, c2_node_id_t id,
       mTemporalPatternIdx(0),
       mLastTimestamp(0x7FFFFFFFFFFFFFFFull),
       mSignalledOutputEos(false),
-      mSignalledError(false) {
+      mSignalledError(false),
+      mNumEcoFrames(0),
+      mNumThreads(1) {
     memset(mTemporalLayerBitrateRatio, 0, sizeof(mTemporalLayerBitrateRatio));
     mTemporalLayerBitrateRatio[0] = 100;
 }
@@ -81,6 +102,11 @@ c2_status_t C2SoftVpxEnc::onInit() {
 }
 
 void C2SoftVpxEnc::onRelease() {
+    if (mEcoStatsProvider != nullptr) {
+        mEcoStatsProvider->release();
+        mEcoStatsProvider = nullptr;
+    }
+
     if (mCodecContext) {
         vpx_codec_destroy(mCodecContext);
         delete mCodecContext;
@@ -115,6 +141,9 @@ c2_status_t C2SoftVpxEnc::onFlush_sm() {
 status_t C2SoftVpxEnc::initEncoder() {
     vpx_codec_err_t codec_return;
     status_t result = UNKNOWN_ERROR;
+    std::shared_ptr<C2EcoStatsTuning> ecoStats;
+    float operatingRate;
+    bool speedSet;
     {
         IntfImpl::Lock lock = mIntf->lock();
         mSize = mIntf->getSize_l();
@@ -124,6 +153,17 @@ status_t C2SoftVpxEnc::initEncoder() {
         mIntraRefresh = mIntf->getIntraRefresh_l();
         mRequestSync = mIntf->getRequestSync_l();
         mTemporalLayers = mIntf->getTemporalLayers_l()->m.layerCount;
+        ecoStats = mIntf->getEcoStats_l();
+        mThreading = mIntf->getThreading_l();
+        mSpeed = mIntf->getSpeed_l();
+        speedSet = mIntf->isSpeedSet_l();
+        operatingRate = mIntf->getOperatingRate_l()->value;
+    }
+
+    mNumThreads = mThreading->threads;
+    if (mNumThreads == 0) {
+        mNumThreads = getAutoThreadCount(
+                mSize->width, mSize->height, c2_max(mFrameRate->value, operatingRate));
     }
 
     switch (mBitrateMode->value) {
@@ -140,9 +180,9 @@ status_t C2SoftVpxEnc::initEncoder() {
     setCodecSpecificInterface();
     if (!mCodecInterface) goto CleanUp;
 
-    ALOGD("VPx: initEncoder. BRMode: %u. TSLayers: %zu. KF: %u. QP: %u - %u",
+    ALOGD("VPx: initEncoder. BRMode: %u. TSLayers: %zu. KF: %u. QP: %u - %u. Threads: %u",
           (uint32_t)mBitrateControlMode, mTemporalLayers, mIntf->getSyncFramePeriod(),
-          mMinQuantizer, mMaxQuantizer);
+          mMinQuantizer, mMaxQuantizer, mNumThreads);
 
     mCodecConfiguration = new vpx_codec_enc_cfg_t;
     if (!mCodecConfiguration) goto CleanUp;
@@ -156,8 +196,7 @@ status_t C2SoftVpxEnc::initEncoder() {
 
     mCodecConfiguration->g_w = mSize->width;
     mCodecConfiguration->g_h = mSize->height;
-    //mCodecConfiguration->g_threads = getCpuCoreCount();
-    mCodecConfiguration->g_threads = 0;
+    mCodecConfiguration->g_threads = mNumThreads;
     mCodecConfiguration->g_error_resilient = mErrorResilience;
 
     // timebase unit is microsecond
@@ -296,17 +335,21 @@ status_t C2SoftVpxEnc::initEncoder() {
                                              VP8E_SET_MAX_INTRA_BITRATE_PCT,
                                              rc_max_intra_target);
         }
-        if (codec_return == VPX_CODEC_OK) {
-            codec_return = vpx_codec_control(mCodecContext,
-                                             VP8E_SET_CPUUSED,
-                                             -8);
-        }
         if (codec_return != VPX_CODEC_OK) {
             ALOGE("Error setting cbr parameters for vpx encoder.");
             goto CleanUp;
         }
     }
 
+    if (kAlwaysSetSpeed || speedSet || mBitrateControlMode == VPX_CBR) {
+        codec_return = vpx_codec_control(mCodecContext, VP8E_SET_CPUUSED, mSpeed->value);
+        if (codec_return != VPX_CODEC_OK) {
+            ALOGE("Error setting VP8E_SET_CPUUSED to %d. vpx_codec_control() returned %d",
+                  mSpeed->value, codec_return);
+            goto CleanUp;
+        }
+    }
+
     codec_return = setCodecSpecificControls();
     if (codec_return != VPX_CODEC_OK) goto CleanUp;
 
@@ -319,13 +362,19 @@ status_t C2SoftVpxEnc::initEncoder() {
         } else {
             uint32_t stride = (width + mStrideAlign - 1) & ~(mStrideAlign - 1);
             uint32_t vstride = (height + mStrideAlign - 1) & ~(mStrideAlign - 1);
-            mConversionBuffer = MemoryBlock::Allocate(stride * vstride * 3 / 2);
-            if (!mConversionBuffer.size()) {
-                ALOGE("Allocating conversion buffer failed.");
-            } else {
-                mNumInputFrames = -1;
-                return OK;
+            mInputConverter.configure(EncoderInputConverter::FORMAT_I420, width, height, stride,
+                                      vstride, false /* halfChromaStride */);
+            mInputConverter.setNumThreads(mNumThreads);
+            mNumInputFrames = -1;
+            if (ecoStats->enabled) {
+                mEcoStatsProvider = media::eco::ECOEncoderStatsProvider::Create(
+                        intf()->getName(), width, height, ecoStats->cameraRecording);
+                mNumEcoFrames = 0;
+                if (mEcoStatsProvider != nullptr) {
+                    pushEcoSessionStats();
+                }
             }
+            return OK;
         }
     }
 
@@ -334,6 +383,35 @@ CleanUp:
     return result;
 }
 
+void C2SoftVpxEnc::pushEcoSessionStats() {
+    media::eco::SimpleEncoderConfig config(
+            intf()->getName(),
+#ifdef VP9
+            media::eco::CodecTypeVP9,
+#else
+            media::eco::CodecTypeVP8,
+#endif
+            -1 /* profile */, -1 /* level */, mBitrate->value,
+            mCodecConfiguration->kf_max_dist, mFrameRate->value);
+    if (!mEcoStatsProvider->pushSessionStats(config)) {
+        ALOGD("ECO session stats not accepted");
+    }
+}
+
+void C2SoftVpxEnc::pushEcoFrameStats(const vpx_codec_cx_pkt_t* encoded_packet) {
+    // The quantizer of the last encoded frame on the 0-63 scale.
+    int qp = -1;
+    if (vpx_codec_control(mCodecContext, VP8E_GET_LAST_QUANTIZER_64, &qp) != VPX_CODEC_OK) {
+        qp = -1;
+    }
+    int8_t frameType = (encoded_packet->data.frame.flags & VPX_FRAME_IS_KEY)
+            ? media::eco::FrameTypeI : media::eco::FrameTypeP;
+    media::eco::SimpleEncodedFrameData frame(
+            mNumEcoFrames++, frameType, encoded_packet->data.frame.pts, qp,
+            encoded_packet->data.frame.sz);
+    mEcoStatsProvider->pushFrameStats(frame);
+}
+
 vpx_enc_frame_flags_t C2SoftVpxEnc::getEncodeFlags() {
     vpx_enc_frame_flags_t flags = 0;
     if (mTemporalPatternLength > 0) {
@@ -466,7 +544,6 @@ void C2SoftVpxEnc::process(
     }
     bool eos = ((work->input.flags & C2FrameData::FLAG_END_OF_STREAM) != 0);
     vpx_image_t raw_frame;
-    const C2PlanarLayout &layout = rView->layout();
     uint32_t width = rView->width();
     uint32_t height = rView->height();
     if (width > 0x8000 || height > 0x8000) {
@@ -474,62 +551,19 @@ void C2SoftVpxEnc::process(
         work->result = C2_BAD_VALUE;
         return;
     }
-    uint32_t stride = (width + mStrideAlign - 1) & ~(mStrideAlign - 1);
-    uint32_t vstride = (height + mStrideAlign - 1) & ~(mStrideAlign - 1);
-    switch (layout.type) {
-        case C2PlanarLayout::TYPE_RGB:
-        case C2PlanarLayout::TYPE_RGBA: {
-            ConvertRGBToPlanarYUV(mConversionBuffer.data(), stride, vstride,
-                                  mConversionBuffer.size(), *rView.get());
-            vpx_img_wrap(&raw_frame, VPX_IMG_FMT_I420, width, height,
-                         mStrideAlign, mConversionBuffer.data());
-            break;
-        }
-        case C2PlanarLayout::TYPE_YUV: {
-            if (!IsYUV420(*rView)) {
-                ALOGE("input is not YUV420");
-                work->result = C2_BAD_VALUE;
-                return;
-            }
-
-            if (layout.planes[layout.PLANE_Y].colInc == 1
-                    && layout.planes[layout.PLANE_U].colInc == 1
-                    && layout.planes[layout.PLANE_V].colInc == 1) {
-                // I420 compatible - though with custom offset and stride
-                vpx_img_wrap(&raw_frame, VPX_IMG_FMT_I420, width, height,
-                             mStrideAlign, (uint8_t*)rView->data()[0]);
-                raw_frame.planes[1] = (uint8_t*)rView->data()[1];
-                raw_frame.planes[2] = (uint8_t*)rView->data()[2];
-                raw_frame.stride[0] = layout.planes[layout.PLANE_Y].rowInc;
-                raw_frame.stride[1] = layout.planes[layout.PLANE_U].rowInc;
-                raw_frame.stride[2] = layout.planes[layout.PLANE_V].rowInc;
-            } else {
-                // copy to I420
-                MediaImage2 img = CreateYUV420PlanarMediaImage2(width, height, stride, vstride);
-                if (mConversionBuffer.size() >= stride * vstride * 3 / 2) {
-                    status_t err = ImageCopy(mConversionBuffer.data(), &img, *rView);
-                    if (err != OK) {
-                        ALOGE("Buffer conversion failed: %d", err);
-                        work->result = C2_BAD_VALUE;
-                        return;
-                    }
-                    vpx_img_wrap(&raw_frame, VPX_IMG_FMT_I420, stride, vstride,
-                                 mStrideAlign, (uint8_t*)rView->data()[0]);
-                    vpx_img_set_rect(&raw_frame, 0, 0, width, height);
-                } else {
-                    ALOGE("Conversion buffer is too small: %u x %u for %zu",
-                            stride, vstride, mConversionBuffer.size());
-                    work->result = C2_BAD_VALUE;
-                    return;
-                }
-            }
-            break;
-        }
-        default:
-            ALOGE("Unrecognized plane type: %d", layout.type);
-            work->result = C2_BAD_VALUE;
-            return;
+    EncoderInputConverter::Frame frame;
+    c2_status_t err = mInputConverter.convert(*rView, &frame);
+    if (err != C2_OK) {
+        work->result = err;
+        return;
     }
+    vpx_img_wrap(&raw_frame, VPX_IMG_FMT_I420, width, height, mStrideAlign,
+                 const_cast<uint8_t *>(frame.y));
+    raw_frame.planes[VPX_PLANE_U] = const_cast<uint8_t *>(frame.u);
+    raw_frame.planes[VPX_PLANE_V] = const_cast<uint8_t *>(frame.v);
+    raw_frame.stride[VPX_PLANE_Y] = frame.yStride;
+    raw_frame.stride[VPX_PLANE_U] = frame.uStride;
+    raw_frame.stride[VPX_PLANE_V] = frame.vStride;
 
     vpx_enc_frame_flags_t flags = getEncodeFlags();
     // handle dynamic config parameters
@@ -571,6 +605,9 @@ void C2SoftVpxEnc::process(
                 work->result = C2_CORRUPTED;
                 return;
             }
+            if (mEcoStatsProvider != nullptr) {
+                pushEcoSessionStats();
+            }
         }
     }
 
@@ -592,6 +629,8 @@ void C2SoftVpxEnc::process(
                                                     inputTimeStamp,
                                                     frameDuration, flags,
                                                     VPX_DL_REALTIME);
+    // the encoder keeps its own copy of the frame
+    mInputConverter.releaseAll();
     if (codec_return != VPX_CODEC_OK) {
         ALOGE("vpx encoder failed to encode frame");
         mSignalledError = true;
@@ -636,6 +675,9 @@ void C2SoftVpxEnc::process(
                         0u /* stream id */, C2PictureTypeKeyFrame));
             }
             work->worklets.front()->output.buffers.push_back(buffer);
+            if (mEcoStatsProvider != nullptr) {
+                pushEcoFrameStats(encoded_packet);
+            }
             work->worklets.front()->output.ordinal = work->input.ordinal;
             work->worklets.front()->output.ordinal.timestamp = encoded_packet->data.frame.pts;
             work->workletsProcessed = 1u;
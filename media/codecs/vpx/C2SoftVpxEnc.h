@@ -17,10 +17,13 @@
 #ifndef ANDROID_C2_SOFT_VPX_ENC_H__
 #define ANDROID_C2_SOFT_VPX_ENC_H__
 
+#include <algorithm>
+
 #include <media/stagefright/foundation/MediaDefs.h>
+#include <utils/StrongPointer.h>
 
 #include <C2PlatformSupport.h>
-#include <Codec2BufferUtils.h>
+#include <EncoderInputConverter.h>
 #include <SimpleC2Component.h>
 #include <SimpleC2Interface.h>
 #include <util/C2InterfaceHelper.h>
@@ -32,6 +35,12 @@
 
 namespace android {
 
+namespace media {
+namespace eco {
+class ECOEncoderStatsProvider;
+}  // namespace eco
+}  // namespace media
+
 // TODO: These defs taken from deprecated OMX_VideoExt.h. Move these definitions
 // to a new header file and include it.
 
@@ -55,6 +64,9 @@ typedef enum TemporalPatternType {
 //    - frame rate
 //    - error resilience
 //    - reconstruction & loop filters (g_profile)
+//    - encoding threads and speed (cpu-used); by default the number of threads
+// is scaled to the picture size and frame rate (or operating rate), up to the
+// number of online cpu's available
 //
 // Only following color formats are recognized
 //    - C2PlanarLayout::TYPE_RGB
@@ -62,8 +74,6 @@ typedef enum TemporalPatternType {
 //
 // Following settings are not configurable by the client
 //    - encoding deadline is realtime
-//    - multithreaded encoding utilizes a number of threads equal
-// to online cpu's available
 //    - the algorithm interface for encoder is decided by the sub-class in use
 //    - fractional bits of frame rate is discarded
 //    - timestamps are in microseconds, therefore encoder timebase is fixed
@@ -108,6 +118,12 @@ struct C2SoftVpxEnc : public SimpleC2Component {
      // Get current encode flags.
      virtual vpx_enc_frame_flags_t getEncodeFlags();
 
+     // Pushes the current encoder configuration to the ECO stats provider.
+     void pushEcoSessionStats();
+
+     // Pushes the stats of an encoded frame to the ECO stats provider.
+     void pushEcoFrameStats(const vpx_codec_cx_pkt_t* encoded_packet);
+
      enum TemporalReferences {
          // For 1 layer case: reference all (last, golden, and alt ref), but only
          // update last.
@@ -200,9 +216,8 @@ struct C2SoftVpxEnc : public SimpleC2Component {
      // Number of input frames
      int64_t mNumInputFrames;
 
-     // Conversion buffer is needed to input to
-     // yuv420 planar format.
-     MemoryBlock mConversionBuffer;
+     // Brings input into yuv420 planar format.
+     EncoderInputConverter mInputConverter;
 
      // Signalled EOS
      bool mSignalledOutputEos;
@@ -210,6 +225,15 @@ struct C2SoftVpxEnc : public SimpleC2Component {
      // Signalled Error
      bool mSignalledError;
 
+     // ECO stats provider; only created if stats reporting is enabled.
+     sp<media::eco::ECOEncoderStatsProvider> mEcoStatsProvider;
+
+     // Number of frames reported to the ECO stats provider
+     int32_t mNumEcoFrames;
+
+     // Number of encoding threads (g_threads)
+     uint32_t mNumThreads;
+
     // configurations used by component in process
     // (TODO: keep this in intf but make them internal only)
     std::shared_ptr<C2StreamPictureSizeInfo::input> mSize;
@@ -218,6 +242,8 @@ struct C2SoftVpxEnc : public SimpleC2Component {
     std::shared_ptr<C2StreamBitrateInfo::output> mBitrate;
     std::shared_ptr<C2StreamBitrateModeTuning::output> mBitrateMode;
     std::shared_ptr<C2StreamRequestSyncFrameTuning::output> mRequestSync;
+    std::shared_ptr<C2StreamEncoderThreadingTuning::output> mThreading;
+    std::shared_ptr<C2StreamEncoderSpeedTuning::output> mSpeed;
 
      C2_DO_NOT_COPY(C2SoftVpxEnc);
 };
@@ -225,7 +251,7 @@ struct C2SoftVpxEnc : public SimpleC2Component {
 class C2SoftVpxEnc::IntfImpl : public C2InterfaceHelper {
    public:
     explicit IntfImpl(const std::shared_ptr<C2ReflectorHelper>& helper)
-        : C2InterfaceHelper(helper) {
+        : C2InterfaceHelper(helper), mSpeedSet(false) {
         setDerivedInstance(this);
 
         addParameter(
@@ -266,8 +292,8 @@ class C2SoftVpxEnc::IntfImpl : public C2InterfaceHelper {
             DefineParam(mSize, C2_NAME_STREAM_VIDEO_SIZE_SETTING)
                 .withDefault(new C2VideoSizeStreamTuning::input(0u, 320, 240))
                 .withFields({
-                    C2F(mSize, width).inRange(2, 2048, 2),
-                    C2F(mSize, height).inRange(2, 2048, 2),
+                    C2F(mSize, width).inRange(2, 4096, 2),
+                    C2F(mSize, height).inRange(2, 4096, 2),
                 })
                 .withSetter(SizeSetter)
                 .build());
@@ -344,6 +370,89 @@ class C2SoftVpxEnc::IntfImpl : public C2InterfaceHelper {
                 .withFields({C2F(mRequestSync, value).oneOf({ C2_FALSE, C2_TRUE }) })
                 .withSetter(Setter<decltype(*mRequestSync)>::NonStrictValueWithNoDeps)
                 .build());
+
+        addParameter(
+                DefineParam(mEcoStats, C2_PARAMKEY_ECO_STATS)
+                .withDefault(new C2EcoStatsTuning(C2_FALSE, C2_FALSE))
+                .withFields({
+                    C2F(mEcoStats, enabled).oneOf({ C2_FALSE, C2_TRUE }),
+                    C2F(mEcoStats, cameraRecording).oneOf({ C2_FALSE, C2_TRUE })
+                })
+                .withSetter(EcoStatsSetter)
+                .build());
+
+        addParameter(
+                DefineParam(mOperatingRate, C2_PARAMKEY_OPERATING_RATE)
+                .withDefault(new C2OperatingRateTuning(0.))
+                .withFields({C2F(mOperatingRate, value).any()})
+                .withSetter(Setter<decltype(*mOperatingRate)>::NonStrictValueWithNoDeps)
+                .build());
+
+        addParameter(
+                DefineParam(mThreading, C2_PARAMKEY_ENCODER_THREADING)
+                .withDefault(new C2StreamEncoderThreadingTuning::output(0u, 0, 0, 0, C2_TRUE))
+                .withFields({
+                    C2F(mThreading, threads).inRange(0, kMaxThreads),
+                    C2F(mThreading, tileColumns).any(),
+                    C2F(mThreading, tileRows).any(),
+                    C2F(mThreading, rowMt).oneOf({ C2_FALSE, C2_TRUE })
+                })
+                .withSetter(ThreadingSetter)
+                .build());
+
+        addParameter(
+                DefineParam(mSpeed, C2_PARAMKEY_ENCODER_SPEED)
+#ifdef VP9
+                // the realtime default (0) is too slow
+                .withDefault(new C2StreamEncoderSpeedTuning::output(0u, 8))
+                .withFields({C2F(mSpeed, value).inRange(-8, 8)})
+#else
+                // only applied in CBR mode unless set by the client
+                .withDefault(new C2StreamEncoderSpeedTuning::output(0u, -8))
+                .withFields({C2F(mSpeed, value).inRange(-16, 16)})
+#endif
+                .withSetter(Setter<decltype(*mSpeed)>::NonStrictValueWithNoDeps)
+                .build());
+    }
+
+    // Maximum number of encoding threads.
+    static constexpr uint32_t kMaxThreads = 8;
+
+    // Records whether the client has successfully configured the speed, which VP8 only applies
+    // if so in VBR mode.
+    c2_status_t config(
+            const std::vector<C2Param*> &params, c2_blocking_t mayBlock,
+            std::vector<std::unique_ptr<C2SettingResult>>* const failures,
+            bool updateParams = true,
+            std::vector<std::shared_ptr<C2Param>> *changes = nullptr) override {
+        // the params may be invalidated by the config, so identify the speed fields beforehand
+        std::vector<C2ParamField> speedFields;
+        for (C2Param *param : params) {
+            C2StreamEncoderSpeedTuning::output *speed =
+                C2StreamEncoderSpeedTuning::output::From(param);
+            if (speed) {
+                speedFields.emplace_back(speed);
+                speedFields.emplace_back(speed, &speed->value);
+            }
+        }
+        size_t numFailures = failures ? failures->size() : 0;
+        c2_status_t err = C2InterfaceHelper::config(
+                params, mayBlock, failures, updateParams, changes);
+        if (err != C2_OK || speedFields.empty()) {
+            return err;
+        }
+        if (failures) {
+            for (size_t i = numFailures; i < failures->size(); ++i) {
+                const C2ParamField &field = (*failures)[i]->field.paramOrField;
+                if (std::find(speedFields.begin(), speedFields.end(), field)
+                        != speedFields.end()) {
+                    return err;
+                }
+            }
+        }
+        Lock lock = this->lock();
+        mSpeedSet = true;
+        return err;
     }
 
     static C2R BitrateSetter(bool mayBlock, C2P<C2StreamBitrateInfo::output> &me) {
@@ -383,6 +492,21 @@ class C2SoftVpxEnc::IntfImpl : public C2InterfaceHelper {
         return C2R::Ok();
     }
 
+    static C2R EcoStatsSetter(bool mayBlock, C2P<C2EcoStatsTuning> &me) {
+        (void)mayBlock;
+        C2R res = me.F(me.v.enabled).validatePossible(me.v.enabled);
+        res.plus(me.F(me.v.cameraRecording).validatePossible(me.v.cameraRecording));
+        return res;
+    }
+
+    static C2R ThreadingSetter(bool mayBlock, C2P<C2StreamEncoderThreadingTuning::output> &me) {
+        (void)mayBlock;
+        if (me.v.threads > kMaxThreads) {
+            me.set().threads = kMaxThreads;
+        }
+        return me.F(me.v.rowMt).validatePossible(me.v.rowMt);
+    }
+
     static C2R LayeringSetter(bool mayBlock, C2P<C2StreamTemporalLayeringTuning::output>& me) {
         (void)mayBlock;
         C2R res = C2R::Ok();
@@ -407,6 +531,11 @@ class C2SoftVpxEnc::IntfImpl : public C2InterfaceHelper {
     std::shared_ptr<C2StreamBitrateModeTuning::output> getBitrateMode_l() const { return mBitrateMode; }
     std::shared_ptr<C2StreamRequestSyncFrameTuning::output> getRequestSync_l() const { return mRequestSync; }
     std::shared_ptr<C2StreamTemporalLayeringTuning::output> getTemporalLayers_l() const { return mLayering; }
+    std::shared_ptr<C2EcoStatsTuning> getEcoStats_l() const { return mEcoStats; }
+    std::shared_ptr<C2OperatingRateTuning> getOperatingRate_l() const { return mOperatingRate; }
+    std::shared_ptr<C2StreamEncoderThreadingTuning::output> getThreading_l() const { return mThreading; }
+    std::shared_ptr<C2StreamEncoderSpeedTuning::output> getSpeed_l() const { return mSpeed; }
+    bool isSpeedSet_l() const { return mSpeedSet; }
     uint32_t getSyncFramePeriod() const {
         if (mSyncFramePeriod->value < 0 || mSyncFramePeriod->value == INT64_MAX) {
             return 0;
@@ -430,6 +559,11 @@ class C2SoftVpxEnc::IntfImpl : public C2InterfaceHelper {
     std::shared_ptr<C2BitrateTuning::output> mBitrate;
     std::shared_ptr<C2StreamBitrateModeTuning::output> mBitrateMode;
     std::shared_ptr<C2StreamProfileLevelInfo::output> mProfileLevel;
+    std::shared_ptr<C2EcoStatsTuning> mEcoStats;
+    std::shared_ptr<C2OperatingRateTuning> mOperatingRate;
+    std::shared_ptr<C2StreamEncoderThreadingTuning::output> mThreading;
+    std::shared_ptr<C2StreamEncoderSpeedTuning::output> mSpeed;
+    bool mSpeedSet;
 };
 
 }  // namespace android
@@ -35,6 +35,99 @@ namespace eco {
 
 using namespace ::android;
 
+namespace {
+
+// Names of the standard keys indexed by ECODataKeyId.
+constexpr const char* kStandardKeys[] = {
+        KEY_ECO_DATA_TYPE,
+        KEY_ECO_DATA_TIME_US,
+        KEY_PROVIDER_NAME,
+        KEY_PROVIDER_TYPE,
+        KEY_LISTENER_NAME,
+        KEY_LISTENER_TYPE,
+        KEY_LISTENER_QP_BLOCKINESS_THRESHOLD,
+        KEY_LISTENER_QP_CHANGE_THRESHOLD,
+        KEY_STATS_TYPE,
+        KEY_INFO_TYPE,
+        ENCODER_NAME,
+        ENCODER_TYPE,
+        ENCODER_PROFILE,
+        ENCODER_LEVEL,
+        ENCODER_INPUT_WIDTH,
+        ENCODER_INPUT_HEIGHT,
+        ENCODER_OUTPUT_WIDTH,
+        ENCODER_OUTPUT_HEIGHT,
+        ENCODER_TARGET_BITRATE_BPS,
+        ENCODER_ACTUAL_BITRATE_BPS,
+        ENCODER_KFI_FRAMES,
+        ENCODER_FRAMERATE_FPS,
+        FRAME_NUM,
+        FRAME_PTS_US,
+        FRAME_AVG_QP,
+        FRAME_TYPE,
+        FRAME_SIZE_BYTES,
+        KEY_LISTENER_WINDOW_US,
+        KEY_LISTENER_WINDOW_BITRATE_THRESHOLD_BPS,
+        KEY_LISTENER_WINDOW_QP_THRESHOLD,
+        WINDOW_DURATION_US,
+        WINDOW_NUM_FRAMES,
+        WINDOW_NUM_I_FRAMES,
+        WINDOW_NUM_P_FRAMES,
+        WINDOW_NUM_B_FRAMES,
+        WINDOW_BITRATE_BPS,
+        WINDOW_AVG_FRAME_SIZE_BYTES,
+        WINDOW_AVG_QP,
+        WINDOW_P90_QP,
+};
+static_assert(sizeof(kStandardKeys) / sizeof(kStandardKeys[0]) == KEY_ID_COUNT,
+              "kStandardKeys must list all the standard keys");
+
+// Each parceled entry starts with a tag that holds the value type in the low 8 bits and the key
+// id plus one in the upper bits. A key id part of 0 means that the key name follows the tag.
+constexpr int32_t kTagValueTypeMask = 0xFF;
+constexpr int32_t kTagKeyIdShift = 8;
+
+}  // namespace
+
+// static
+ECODataKeyId ECOData::getKeyId(const std::string& key) {
+    static const std::unordered_map<std::string, ECODataKeyId> sKeyIds = [] {
+        std::unordered_map<std::string, ECODataKeyId> keyIds;
+        for (int32_t id = 0; id < KEY_ID_COUNT; ++id) {
+            keyIds.emplace(kStandardKeys[id], static_cast<ECODataKeyId>(id));
+        }
+        return keyIds;
+    }();
+    auto it = sKeyIds.find(key);
+    return it == sKeyIds.end() ? KEY_ID_UNKNOWN : it->second;
+}
+
+// static
+const char* ECOData::getKeyName(ECODataKeyId keyId) {
+    if (keyId < 0 || keyId >= KEY_ID_COUNT) {
+        return nullptr;
+    }
+    return kStandardKeys[keyId];
+}
+
+ECOData::ECODataValueType& ECOData::getOrInsertValue(const std::string& key) {
+    ECODataKeyId keyId = getKeyId(key);
+    if (keyId == KEY_ID_UNKNOWN) {
+        return mKeyValueStore[key];
+    }
+    mStandardKeyMask |= 1ull << keyId;
+    return mStandardValues[keyId];
+}
+
+const ECOData::ECODataValueType* ECOData::getValue(const std::string& key) const {
+    ECODataKeyId keyId = getKeyId(key);
+    if (keyId == KEY_ID_UNKNOWN) {
+        auto it = mKeyValueStore.find(key);
+        return it == mKeyValueStore.end() ? nullptr : &it->second;
+    }
+    return (mStandardKeyMask & (1ull << keyId)) ? &mStandardValues[keyId] : nullptr;
+}
+
 status_t ECOData::readFromParcel(const Parcel* parcel) {
     if (parcel == nullptr) {
         ALOGE("readFromParcel failed. Parcel pointer can not be null");
@@ -51,44 +144,53 @@ status_t ECOData::readFromParcel(const Parcel* parcel) {
 
     // Reads the key-value pairs one by one.
     for (size_t i = 0; i < numOfItems; ++i) {
-        // Reads the name of the key.
-        const char* name = parcel->readCString();
-        if (name == NULL) {
-            ALOGE("Failed reading name for the key. Parsing aborted.");
+        // Reads the tag and the name of the key if it is not a standard key.
+        int32_t tag;
+        RETURN_STATUS_IF_ERROR(parcel->readInt32(&tag));
+        const int32_t keyId = (tag >> kTagKeyIdShift) - 1;
+        const char* name = nullptr;
+        if (keyId == KEY_ID_UNKNOWN) {
+            name = parcel->readCString();
+            if (name == NULL || name[0] == '\0') {
+                ALOGE("Failed reading name for the key. Parsing aborted.");
+                return NAME_NOT_FOUND;
+            }
+        } else if (keyId < 0) {
+            ALOGE("Invalid key id %d. Parsing aborted.", keyId);
             return NAME_NOT_FOUND;
         }
 
-        int32_t type;
-        RETURN_STATUS_IF_ERROR(parcel->readInt32(&type));
-        switch (static_cast<ValueType>(type)) {
+        ECODataValueType value;
+
+        switch (static_cast<ValueType>(tag & kTagValueTypeMask)) {
         case kTypeInt32: {
             int32_t value32;
             RETURN_STATUS_IF_ERROR(parcel->readInt32(&value32));
-            setInt32(std::string(name), value32);
+            value = value32;
             break;
         }
         case kTypeInt64: {
             int64_t value64;
             RETURN_STATUS_IF_ERROR(parcel->readInt64(&value64));
-            setInt64(std::string(name), value64);
+            value = value64;
             break;
         }
         case kTypeSize: {
             int32_t valueSize;
             RETURN_STATUS_IF_ERROR(parcel->readInt32(&valueSize));
-            setInt32(std::string(name), valueSize);
+            value = valueSize;
             break;
         }
         case kTypeFloat: {
             float valueFloat;
             RETURN_STATUS_IF_ERROR(parcel->readFloat(&valueFloat));
-            setFloat(std::string(name), valueFloat);
+            value = valueFloat;
             break;
         }
         case kTypeDouble: {
             double valueDouble;
             RETURN_STATUS_IF_ERROR(parcel->readDouble(&valueDouble));
-            setDouble(std::string(name), valueDouble);
+            value = valueDouble;
             break;
         }
         case kTypeString: {
@@ -97,19 +199,30 @@ status_t ECOData::readFromParcel(const Parcel* parcel) {
                 ALOGE("Failed reading name for the key. Parsing aborted.");
                 return NAME_NOT_FOUND;
             }
-            setString(std::string(name), valueStr);
+            value = std::string(valueStr);
             break;
         }
         case kTypeInt8: {
             int8_t value8;
             RETURN_STATUS_IF_ERROR(parcel->readByte(&value8));
-            setInt8(std::string(name), value8);
+            value = value8;
             break;
         }
         default: {
             return BAD_TYPE;
         }
         }
+
+        if (name != nullptr) {
+            getOrInsertValue(std::string(name)) = std::move(value);
+        } else if (keyId >= KEY_ID_COUNT) {
+            // The writer knows standard keys that were added after this version. Their values
+            // are read like any other to keep parsing in step, but are dropped.
+            ALOGW("Skipping value of unknown key id %d", keyId);
+        } else {
+            mStandardKeyMask |= 1ull << keyId;
+            mStandardValues[keyId] = std::move(value);
+        }
     }
 
     return NO_ERROR;
@@ -126,43 +239,47 @@ status_t ECOData::writeToParcel(Parcel* parcel) const {
     RETURN_STATUS_IF_ERROR(parcel->writeInt64(mDataTimeUs));
 
     // Writes out number of items.
-    RETURN_STATUS_IF_ERROR(parcel->writeUint32(int32_t(mKeyValueStore.size())));
+    RETURN_STATUS_IF_ERROR(parcel->writeUint32(int32_t(getNumOfEntries())));
 
     // Writes out the key-value pairs one by one.
-    for (const auto& it : mKeyValueStore) {
-        // Writes out the key.
-        RETURN_STATUS_IF_ERROR(parcel->writeCString(it.first.c_str()));
+    ECODataKeyValueIterator it(*this);
+    while (it.hasNext()) {
+        // Writes out the tag and the name of the key if it is not a standard key.
+        const ECODataKeyId keyId = it.keyId();
+        const ECODataValueType& value = it.value();
+        RETURN_STATUS_IF_ERROR(parcel->writeInt32(((keyId + 1) << kTagKeyIdShift) |
+                                                  static_cast<int32_t>(value.index())));
+        if (keyId == KEY_ID_UNKNOWN) {
+            RETURN_STATUS_IF_ERROR(parcel->writeCString(it.next().first.c_str()));
+        }
 
-        // Writes out the data type.
-        const ECODataValueType& value = it.second;
-        RETURN_STATUS_IF_ERROR(parcel->writeInt32(static_cast<int32_t>(value.index())));
         switch (static_cast<ValueType>(value.index())) {
         case kTypeInt32:
-            RETURN_STATUS_IF_ERROR(parcel->writeInt32(std::get<int32_t>(it.second)));
+            RETURN_STATUS_IF_ERROR(parcel->writeInt32(std::get<int32_t>(value)));
             break;
 
         case kTypeInt64:
-            RETURN_STATUS_IF_ERROR(parcel->writeInt64(std::get<int64_t>(it.second)));
+            RETURN_STATUS_IF_ERROR(parcel->writeInt64(std::get<int64_t>(value)));
             break;
 
         case kTypeSize:
-            RETURN_STATUS_IF_ERROR(parcel->writeUint32(std::get<size_t>(it.second)));
+            RETURN_STATUS_IF_ERROR(parcel->writeUint32(std::get<size_t>(value)));
             break;
 
         case kTypeFloat:
-            RETURN_STATUS_IF_ERROR(parcel->writeFloat(std::get<float>(it.second)));
+            RETURN_STATUS_IF_ERROR(parcel->writeFloat(std::get<float>(value)));
             break;
 
         case kTypeDouble:
-            RETURN_STATUS_IF_ERROR(parcel->writeDouble(std::get<double>(it.second)));
+            RETURN_STATUS_IF_ERROR(parcel->writeDouble(std::get<double>(value)));
             break;
 
         case kTypeString:
-            RETURN_STATUS_IF_ERROR(parcel->writeCString(std::get<std::string>(it.second).c_str()));
+            RETURN_STATUS_IF_ERROR(parcel->writeCString(std::get<std::string>(value).c_str()));
             break;
 
         case kTypeInt8:
-            RETURN_STATUS_IF_ERROR(parcel->writeByte(std::get<int8_t>(it.second)));
+            RETURN_STATUS_IF_ERROR(parcel->writeByte(std::get<int8_t>(value)));
             break;
 
         default:
@@ -188,7 +305,7 @@ ECODataStatus ECOData::setString(const std::string& key, const std::string& valu
         return ECODataStatus::INVALID_ARGUMENT;
     }
 
-    mKeyValueStore[key] = value;
+    getOrInsertValue(key) = value;
 
     // TODO(hkuang): Check the valueType is valid for the key.
     return ECODataStatus::OK;
@@ -200,12 +317,13 @@ ECODataStatus ECOData::findString(const std::string& key, std::string* value) co
     }
 
     // Check if the key exists.
-    if (mKeyValueStore.find(key) == mKeyValueStore.end()) {
+    const ECODataValueType* entry = getValue(key);
+    if (entry == nullptr) {
         return ECODataStatus::KEY_NOT_EXIST;
     }
 
     // Safely access the value.
-    const std::string& entryValue = std::get<std::string>(mKeyValueStore.at(key));
+    const std::string& entryValue = std::get<std::string>(*entry);
     value->assign(entryValue);
 
     return ECODataStatus::OK;
@@ -219,7 +337,7 @@ ECODataStatus ECOData::setValue(const std::string& key, T value) {
         return ECODataStatus::INVALID_ARGUMENT;
     }
 
-    mKeyValueStore[key] = value;
+    getOrInsertValue(key) = value;
     return ECODataStatus::OK;
 }
 
@@ -229,12 +347,13 @@ ECODataStatus ECOData::findValue(const std::string& key, T* out) const {
         return ECODataStatus::INVALID_ARGUMENT;
     }
 
-    if (mKeyValueStore.find(key) == mKeyValueStore.end()) {
+    const ECODataValueType* entry = getValue(key);
+    if (entry == nullptr) {
         return ECODataStatus::KEY_NOT_EXIST;
     }
 
     // Safely access the value.
-    *out = std::get<T>(mKeyValueStore.at(key));
+    *out = std::get<T>(*entry);
 
     return ECODataStatus::OK;
 }
@@ -291,7 +410,7 @@ ECODataStatus ECOData::set(const std::string& key, const ECOData::ECODataValueTy
     if (key.empty()) {
         return ECODataStatus::INVALID_ARGUMENT;
     }
-    mKeyValueStore[key] = value;
+    getOrInsertValue(key) = value;
     return ECODataStatus::OK;
 }
 
@@ -300,16 +419,39 @@ ECODataStatus ECOData::find(const std::string& key, ECOData::ECODataValueType* o
         return ECODataStatus::INVALID_ARGUMENT;
     }
 
-    if (mKeyValueStore.find(key) == mKeyValueStore.end()) {
+    const ECODataValueType* entry = getValue(key);
+    if (entry == nullptr) {
         return ECODataStatus::KEY_NOT_EXIST;
     }
 
     // Safely access the value.
-    *out = mKeyValueStore.at(key);
+    *out = *entry;
 
     return ECODataStatus::OK;
 }
 
+ECODataStatus ECOData::set(ECODataKeyId keyId, const ECOData::ECODataValueType& value) {
+    if (keyId < 0 || keyId >= KEY_ID_COUNT) {
+        return ECODataStatus::INVALID_ARGUMENT;
+    }
+    mStandardKeyMask |= 1ull << keyId;
+    mStandardValues[keyId] = value;
+    return ECODataStatus::OK;
+}
+
+ECODataStatus ECOData::find(ECODataKeyId keyId, ECOData::ECODataValueType* out) const {
+    if (keyId < 0 || keyId >= KEY_ID_COUNT || out == nullptr) {
+        return ECODataStatus::INVALID_ARGUMENT;
+    }
+
+    if ((mStandardKeyMask & (1ull << keyId)) == 0) {
+        return ECODataStatus::KEY_NOT_EXIST;
+    }
+
+    *out = mStandardValues[keyId];
+    return ECODataStatus::OK;
+}
+
 std::string ECOData::getDataTypeString() const {
     switch (mDataType) {
     case DATA_TYPE_UNKNOWN:
@@ -326,25 +468,41 @@ std::string ECOData::getDataTypeString() const {
     return {};
 }
 
-// TODO(hkuang): Add test for this.
 bool ECODataKeyValueIterator::hasNext() {
-    if (mIterator == mKeyValueStore.end()) return false;
-
-    if (!mBeginReturned) {
-        // mIterator has been initialized to the beginning and
-        // hasn't been returned. Do not advance:
-        mBeginReturned = true;
-    } else {
-        std::advance(mIterator, 1);
+    if (mKeyId < KEY_ID_COUNT) {
+        // Advances to the next standard key that is set.
+        while (++mKeyId < KEY_ID_COUNT) {
+            if (mData.mStandardKeyMask & (1ull << mKeyId)) {
+                return true;
+            }
+        }
+        // mIterator has been initialized to the beginning of the other keys. Do not advance.
+        return mIterator != mData.mKeyValueStore.end();
     }
-    return mIterator != mKeyValueStore.end();
+
+    if (mIterator == mData.mKeyValueStore.end()) return false;
+    std::advance(mIterator, 1);
+    return mIterator != mData.mKeyValueStore.end();
 }
 
-// TODO(hkuang): Add test for this.
 ECOData::ECODataKeyValuePair ECODataKeyValueIterator::next() const {
+    if (mKeyId < KEY_ID_COUNT) {
+        return ECOData::ECODataKeyValuePair(kStandardKeys[mKeyId], mData.mStandardValues[mKeyId]);
+    }
     return ECOData::ECODataKeyValuePair(mIterator->first, mIterator->second);
 }
 
+ECODataKeyId ECODataKeyValueIterator::keyId() const {
+    return mKeyId < KEY_ID_COUNT ? static_cast<ECODataKeyId>(mKeyId) : KEY_ID_UNKNOWN;
+}
+
+const ECOData::ECODataValueType& ECODataKeyValueIterator::value() const {
+    if (mKeyId < KEY_ID_COUNT) {
+        return mData.mStandardValues[mKeyId];
+    }
+    return mIterator->second;
+}
+
 std::string ECOData::debugString() const {
     std::string s = "ECOData(type = ";
 
@@ -372,7 +530,9 @@ std::string ECOData::debugString() const {
     s.append(") = {\n  ");
 
     // Writes out the key-value pairs one by one.
-    for (const auto& it : mKeyValueStore) {
+    ECODataKeyValueIterator iter(*this);
+    while (iter.hasNext()) {
+        const ECODataKeyValuePair it = iter.next();
         const size_t SIZE = 100;
         char keyValue[SIZE];
         const ECODataValueType& value = it.second;
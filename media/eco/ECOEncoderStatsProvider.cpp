@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ECOEncoderStatsProvider"
+
+#include "eco/ECOEncoderStatsProvider.h"
+
+#include <android/media/eco/IECOService.h>
+#include <binder/IServiceManager.h>
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "eco/ECODataKey.h"
+#include "eco/ECOService.h"
+
+namespace android {
+namespace media {
+namespace eco {
+
+// static
+sp<ECOEncoderStatsProvider> ECOEncoderStatsProvider::Create(const std::string& name,
+                                                            int32_t width, int32_t height,
+                                                            bool isCameraRecording) {
+    // Use checkService() so that encoders never wait for the ECOService to start.
+    sp<IBinder> binder =
+            defaultServiceManager()->checkService(String16(ECOService::getServiceName()));
+    if (binder == nullptr) {
+        ALOGD("ECOService is not available");
+        return nullptr;
+    }
+    sp<IECOService> service = interface_cast<IECOService>(binder);
+
+    sp<IECOSession> session;
+    Status status = service->obtainSession(width, height, isCameraRecording, &session);
+    if (!status.isOk() || session == nullptr) {
+        ALOGW("Failed to obtain ECOSession for %dx%d", width, height);
+        return nullptr;
+    }
+    return Create(name, session);
+}
+
+// static
+sp<ECOEncoderStatsProvider> ECOEncoderStatsProvider::Create(const std::string& name,
+                                                            const sp<IECOSession>& session) {
+    sp<ECOEncoderStatsProvider> provider = new ECOEncoderStatsProvider(name, session);
+
+    ECOData config(ECOData::DATA_TYPE_STATS_PROVIDER_CONFIG, systemTime(SYSTEM_TIME_BOOTTIME));
+    config.setString(KEY_PROVIDER_NAME, name);
+    config.setInt32(KEY_PROVIDER_TYPE,
+                    IECOServiceStatsProvider::STATS_PROVIDER_TYPE_VIDEO_ENCODER);
+    bool added = false;
+    Status status = session->addStatsProvider(provider, config, &added);
+    if (!status.isOk() || !added) {
+        ALOGW("Failed to add stats provider %s to ECOSession", name.c_str());
+        return nullptr;
+    }
+
+    IInterface::asBinder(session)->linkToDeath(provider);
+    // The thread keeps the provider alive until it has unregistered from the session.
+    std::thread([provider] { provider->pushLoop(); }).detach();
+    return provider;
+}
+
+ECOEncoderStatsProvider::ECOEncoderStatsProvider(const std::string& name,
+                                                 const sp<IECOSession>& session)
+      : mName(name), mSession(session) {}
+
+ECOEncoderStatsProvider::~ECOEncoderStatsProvider() {
+    ALOGV("%s: %s", __FUNCTION__, mName.c_str());
+}
+
+bool ECOEncoderStatsProvider::pushSessionStats(const SimpleEncoderConfig& config) {
+    ECOData stats = config.toEcoData(ECOData::DATA_TYPE_STATS);
+    stats.setString(ENCODER_NAME, mName);
+    return queueStats(stats, false /* isFrameStats */);
+}
+
+bool ECOEncoderStatsProvider::pushFrameStats(const SimpleEncodedFrameData& frame) {
+    return queueStats(frame.toEcoData(ECOData::DATA_TYPE_STATS), true /* isFrameStats */);
+}
+
+bool ECOEncoderStatsProvider::queueStats(const ECOData& stats, bool isFrameStats) {
+    std::scoped_lock<std::mutex> lock(mLock);
+    if (mSession == nullptr || mReleased) {
+        return false;
+    }
+    if (mQueue.size() >= kMaxQueuedStats) {
+        auto it = std::find_if(mQueue.begin(), mQueue.end(),
+                               [](const QueuedStats& queued) { return queued.isFrameStats; });
+        if (it != mQueue.end()) {
+            mQueue.erase(it);
+            ++mNumDroppedFrameStats;
+        } else if (isFrameStats) {
+            ++mNumDroppedFrameStats;
+            return true;
+        }
+        // Session stats are queued even if the queue only holds session stats.
+    }
+    mQueue.push_back({stats, isFrameStats});
+    mQueueCV.notify_one();
+    return true;
+}
+
+void ECOEncoderStatsProvider::pushLoop() {
+    std::unique_lock<std::mutex> lock(mLock);
+    while (true) {
+        mQueueCV.wait(lock, [this] { return !mQueue.empty() || mReleased || mSession == nullptr; });
+        if (mReleased || mSession == nullptr) {
+            break;
+        }
+        sp<IECOSession> session = mSession;
+        ECOData stats = std::move(mQueue.front().stats);
+        mQueue.pop_front();
+        lock.unlock();
+        bool accepted = false;
+        Status status = session->pushNewStats(stats, &accepted);
+        if (!status.isOk() || !accepted) {
+            ALOGV("%s: stats not accepted by ECOSession", mName.c_str());
+        }
+        lock.lock();
+    }
+    mQueue.clear();
+    sp<IECOSession> session = mSession;
+    mSession = nullptr;
+    lock.unlock();
+
+    if (session == nullptr) {
+        return;
+    }
+    IInterface::asBinder(session)->unlinkToDeath(this);
+    bool removed = false;
+    session->removeStatsProvider(this, &removed);
+    if (!removed) {
+        ALOGW("Failed to remove stats provider %s from ECOSession", mName.c_str());
+    }
+}
+
+void ECOEncoderStatsProvider::release() {
+    std::scoped_lock<std::mutex> lock(mLock);
+    mReleased = true;
+    mQueueCV.notify_one();
+}
+
+uint64_t ECOEncoderStatsProvider::getNumDroppedFrameStats() {
+    std::scoped_lock<std::mutex> lock(mLock);
+    return mNumDroppedFrameStats;
+}
+
+Status ECOEncoderStatsProvider::getType(int32_t* _aidl_return) {
+    *_aidl_return = STATS_PROVIDER_TYPE_VIDEO_ENCODER;
+    return binder::Status::ok();
+}
+
+Status ECOEncoderStatsProvider::getName(::android::String16* _aidl_return) {
+    *_aidl_return = String16(mName.c_str());
+    return binder::Status::ok();
+}
+
+Status ECOEncoderStatsProvider::getECOSession(sp<::android::IBinder>* _aidl_return) {
+    std::scoped_lock<std::mutex> lock(mLock);
+    *_aidl_return = IInterface::asBinder(mSession);
+    return binder::Status::ok();
+}
+
+// IBinder::DeathRecipient implementation
+void ECOEncoderStatsProvider::binderDied(const wp<IBinder>& /*who*/) {
+    ALOGW("ECOSession died, stop pushing stats from %s", mName.c_str());
+    std::scoped_lock<std::mutex> lock(mLock);
+    mSession = nullptr;
+    mQueueCV.notify_one();
+}
+
+}  // namespace eco
+}  // namespace media
+}  // namespace android
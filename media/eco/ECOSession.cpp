@@ -43,6 +43,16 @@ namespace eco {
 using android::binder::Status;
 using android::sp;
 
+namespace {
+
+bool isFrameStats(const ECOData& stats) {
+    std::string statsType;
+    return stats.findString(KEY_STATS_TYPE, &statsType) == ECODataStatus::OK &&
+           statsType.compare(VALUE_STATS_TYPE_FRAME) == 0;
+}
+
+}  // namespace
+
 #define RETURN_IF_ERROR(expr)         \
     {                                 \
         status_t _errorCode = (expr); \
@@ -67,8 +77,9 @@ sp<ECOSession> ECOSession::createECOSession(int32_t width, int32_t height, bool
 ECOSession::ECOSession(int32_t width, int32_t height, bool isCameraRecording)
       : BnECOSession(),
         mStopThread(false),
-        mLastReportedQp(0),
-        mListener(nullptr),
+        mStatsQueueLimit(DEFAULT_STATS_QUEUE_LIMIT),
+        mStatsQueueOverflowPolicy(QueueOverflowPolicy::DROP_OLDEST),
+        mNumCoalescedInfos(0),
         mProvider(nullptr),
         mWidth(width),
         mHeight(height),
@@ -87,12 +98,27 @@ ECOSession::ECOSession(int32_t width, int32_t height, bool isCameraRecording)
     ECOLOGI("ECOSession debug settings: logStats: %s, entries: %d, logInfo: %s entries: %d",
             mLogStats ? "true" : "false", mLogStatsEntries, mLogInfo ? "true" : "false",
             mLogInfoEntries);
+
+    int32_t queueLimit = property_get_int32(kStatsQueueSize, DEFAULT_STATS_QUEUE_LIMIT);
+    int32_t queuePolicy = property_get_int32(
+            kStatsQueuePolicy, static_cast<int32_t>(QueueOverflowPolicy::DROP_OLDEST));
+    if (queuePolicy < static_cast<int32_t>(QueueOverflowPolicy::DROP_OLDEST) ||
+        queuePolicy > static_cast<int32_t>(QueueOverflowPolicy::BLOCK_PROVIDER)) {
+        ECOLOGW("Unknown stats queue policy %d, use drop oldest", queuePolicy);
+        queuePolicy = static_cast<int32_t>(QueueOverflowPolicy::DROP_OLDEST);
+    }
+    setStatsQueueLimit(queueLimit < 0 ? 0 : queueLimit,
+                       static_cast<QueueOverflowPolicy>(queuePolicy));
 }
 
 ECOSession::~ECOSession() {
-    mStopThread = true;
+    {
+        std::scoped_lock<std::mutex> lock(mStatsQueueLock);
+        mStopThread = true;
+    }
 
     mWorkerWaitCV.notify_all();
+    mStatsQueueSpaceCV.notify_all();
     if (mThread.joinable()) {
         ECOLOGD("ECOSession: join the thread");
         mThread.join();
@@ -110,35 +136,42 @@ void ECOSession::run() {
     ECOLOGD("ECOSession: starting main thread");
 
     while (!mStopThread) {
-        std::unique_lock<std::mutex> runLock(mStatsQueueLock);
+        std::deque<ECOData> batch;
+        {
+            std::unique_lock<std::mutex> runLock(mStatsQueueLock);
 
-        mWorkerWaitCV.wait(runLock, [this] {
-            return mStopThread == true || !mStatsQueue.empty() || mNewListenerAdded;
-        });
+            mWorkerWaitCV.wait(runLock, [this] {
+                return mStopThread == true || !mStatsQueue.empty() || mNewListenerAdded;
+            });
 
-        if (mStopThread) return;
+            if (mStopThread) return;
+
+            // Drain all the pending stats so that a burst of stats is handled in one wakeup and
+            // the provider is not blocked while the stats are being processed.
+            batch.swap(mStatsQueue);
+        }
+        mStatsQueueSpaceCV.notify_all();
 
         std::scoped_lock<std::mutex> lock(mSessionLock);
+        removeDeadListeners();
         if (mNewListenerAdded) {
             // Check if there is any session info available.
             ECOData sessionInfo = generateLatestSessionInfoEcoData();
-            if (!sessionInfo.isEmpty()) {
-                Status status = mListener->onNewInfo(sessionInfo);
-                if (!status.isOk()) {
-                    ECOLOGE("%s: Failed to publish info: %s due to binder error", __FUNCTION__,
-                            sessionInfo.debugString().c_str());
-                    // Remove the listener. The lock has been acquired outside this function.
-                    mListener = nullptr;
+            for (const std::unique_ptr<Listener>& listener : mListeners) {
+                if (listener->mNeedSessionInfo && !sessionInfo.isEmpty()) {
+                    listener->post(sessionInfo, false /* isFrameInfo */);
                 }
+                listener->mNeedSessionInfo = false;
             }
             mNewListenerAdded = false;
         }
 
-        if (!mStatsQueue.empty()) {
-            ECOData stats = mStatsQueue.front();
-            mStatsQueue.pop_front();
+        // QP conditions are evaluated for every frame, but only the latest frame info that needs
+        // to be reported is sent to each listener as it supersedes the earlier ones.
+        for (const ECOData& stats : batch) {
             processStats(stats);  // TODO: Handle the error from processStats
         }
+        flushPendingFrameInfos();
     }
 
     ECOLOGD("ECOSession: exiting main thread");
@@ -160,6 +193,8 @@ bool ECOSession::processStats(const ECOData& stats) {
     }
 
     if (statsType.compare(VALUE_STATS_TYPE_SESSION) == 0) {
+        // Keep the order of the infos sent to the listeners.
+        flushPendingFrameInfos();
         processSessionStats(stats);
     } else if (statsType.compare(VALUE_STATS_TYPE_FRAME) == 0) {
         processFrameStats(stats);
@@ -179,69 +214,210 @@ void ECOSession::processSessionStats(const ECOData& stats) {
 
     ECODataKeyValueIterator iter(stats);
     while (iter.hasNext()) {
-        ECOData::ECODataKeyValuePair entry = iter.next();
-        const std::string& key = entry.first;
-        const ECOData::ECODataValueType value = entry.second;
-        ECOLOGV("Processing key: %s", key.c_str());
-        if (!key.compare(KEY_STATS_TYPE)) {
+        const ECODataKeyId keyId = iter.keyId();
+        const ECOData::ECODataValueType& value = iter.value();
+        ECOLOGV("Processing key: %d", keyId);
+        switch (keyId) {
+        case KEY_ID_STATS_TYPE:
             // Skip the key KEY_STATS_TYPE as that has been parsed already.
             continue;
-        } else if (!key.compare(ENCODER_TYPE)) {
+        case KEY_ID_ENCODER_TYPE:
             mCodecType = std::get<int32_t>(value);
             ECOLOGV("codec type is %d", mCodecType);
-        } else if (!key.compare(ENCODER_PROFILE)) {
+            break;
+        case KEY_ID_ENCODER_PROFILE:
             mCodecProfile = std::get<int32_t>(value);
             ECOLOGV("codec profile is %d", mCodecProfile);
-        } else if (!key.compare(ENCODER_LEVEL)) {
+            break;
+        case KEY_ID_ENCODER_LEVEL:
             mCodecLevel = std::get<int32_t>(value);
             ECOLOGV("codec level is %d", mCodecLevel);
-        } else if (!key.compare(ENCODER_TARGET_BITRATE_BPS)) {
+            break;
+        case KEY_ID_ENCODER_TARGET_BITRATE_BPS:
             mTargetBitrateBps = std::get<int32_t>(value);
             ECOLOGV("codec target bitrate is %d", mTargetBitrateBps);
-        } else if (!key.compare(ENCODER_KFI_FRAMES)) {
+            break;
+        case KEY_ID_ENCODER_KFI_FRAMES:
             mKeyFrameIntervalFrames = std::get<int32_t>(value);
             ECOLOGV("codec kfi is %d", mKeyFrameIntervalFrames);
-        } else if (!key.compare(ENCODER_FRAMERATE_FPS)) {
+            break;
+        case KEY_ID_ENCODER_FRAMERATE_FPS:
             mFramerateFps = std::get<float>(value);
             ECOLOGV("codec framerate is %f", mFramerateFps);
-        } else if (!key.compare(ENCODER_INPUT_WIDTH)) {
+            break;
+        case KEY_ID_ENCODER_INPUT_WIDTH: {
             int32_t width = std::get<int32_t>(value);
             if (width != mWidth) {
                 ECOLOGW("Codec width: %d, expected: %d", width, mWidth);
             }
             ECOLOGV("codec input width is %d", width);
-        } else if (!key.compare(ENCODER_INPUT_HEIGHT)) {
+            break;
+        }
+        case KEY_ID_ENCODER_INPUT_HEIGHT: {
             int32_t height = std::get<int32_t>(value);
             if (height != mHeight) {
                 ECOLOGW("Codec height: %d, expected: %d", height, mHeight);
             }
             ECOLOGV("codec input height is %d", height);
-        } else if (!key.compare(ENCODER_OUTPUT_WIDTH)) {
+            break;
+        }
+        case KEY_ID_ENCODER_OUTPUT_WIDTH:
             mOutputWidth = std::get<int32_t>(value);
             if (mOutputWidth != mWidth) {
                 ECOLOGW("Codec output width: %d, expected: %d", mOutputWidth, mWidth);
             }
             ECOLOGV("codec output width is %d", mOutputWidth);
-        } else if (!key.compare(ENCODER_OUTPUT_HEIGHT)) {
+            break;
+        case KEY_ID_ENCODER_OUTPUT_HEIGHT:
             mOutputHeight = std::get<int32_t>(value);
             if (mOutputHeight != mHeight) {
                 ECOLOGW("Codec output height: %d, expected: %d", mOutputHeight, mHeight);
             }
             ECOLOGV("codec output height is %d", mOutputHeight);
-        } else {
-            ECOLOGW("Unknown session stats key %s from provider.", key.c_str());
+            break;
+        default:
+            ECOLOGW("Unknown session stats key %s from provider.", iter.next().first.c_str());
             continue;
         }
-        info.set(key, value);
+        info.set(keyId, value);
+    }
+
+    for (const std::unique_ptr<Listener>& listener : mListeners) {
+        listener->post(info, false /* isFrameInfo */);
+    }
+}
+
+void ECOSession::flushPendingFrameInfos() {
+    for (const std::unique_ptr<Listener>& listener : mListeners) {
+        listener->flushPendingFrameInfo();
+    }
+}
+
+void ECOSession::removeDeadListeners() {
+    mListeners.erase(std::remove_if(mListeners.begin(), mListeners.end(),
+                                    [](const std::unique_ptr<Listener>& listener) {
+                                        if (listener->isAlive()) return false;
+                                        ECOLOGW("Remove unreachable listener %s",
+                                                String8(listener->mName).string());
+                                        return true;
+                                    }),
+                     mListeners.end());
+}
+
+ECOSession::Listener::Listener(const sp<IECOServiceInfoListener>& listener, const String16& name,
+                               const ListenerCondition& condition,
+                               std::atomic<uint64_t>* numCoalescedInfos)
+      : mListener(listener),
+        mName(name),
+        mCondition(condition),
+        mNumCoalescedInfos(numCoalescedInfos),
+        mDead(false) {
+    if (mCondition.hasWindowCondition()) {
+        mWindow = std::make_unique<ECOStatsWindow>(mCondition.mWindowUs);
+    }
+    mThread = std::thread([this] { run(); });
+}
+
+ECOSession::Listener::~Listener() {
+    {
+        std::scoped_lock<std::mutex> lock(mLock);
+        mStop = true;
+    }
+    mCV.notify_all();
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+void ECOSession::Listener::post(const ECOData& info, bool isFrameInfo) {
+    if (mDead) return;
+
+    {
+        std::scoped_lock<std::mutex> lock(mLock);
+        if (isFrameInfo && !mInfos.empty() && mInfos.back().second) {
+            // The listener has not got the previous frame info yet. Only send the latest one.
+            mInfos.back().first = info;
+            ++*mNumCoalescedInfos;
+            return;
+        }
+        mInfos.emplace_back(info, isFrameInfo);
     }
+    mCV.notify_one();
+}
+
+void ECOSession::Listener::flushPendingFrameInfo() {
+    if (mPendingFrameInfo) {
+        post(*mPendingFrameInfo, true /* isFrameInfo */);
+        mPendingFrameInfo.reset();
+    }
+}
+
+bool ECOSession::Listener::checkQpCondition(int32_t avgQp) {
+    const QpCondition& qpCondition = mCondition.mQpCondition;
+
+    // Check if the delta between current QP and last reported QP is larger than the threshold
+    // specified by the listener.
+    const bool largeQPChangeDetected =
+            abs(avgQp - mLastReportedQp) > qpCondition.mQpChangeThreshold;
+
+    // Check if the qp is going from below threshold to beyond threshold.
+    const bool exceedQpBlockinessThreshold =
+            (mLastReportedQp <= qpCondition.mQpBlocknessThreshold &&
+             avgQp > qpCondition.mQpBlocknessThreshold);
+
+    // Check if the qp is going from beyond threshold to below threshold.
+    const bool fallBelowQpBlockinessThreshold =
+            (mLastReportedQp > qpCondition.mQpBlocknessThreshold &&
+             avgQp <= qpCondition.mQpBlocknessThreshold);
+
+    // Notify the listener if any of the above three conditions met.
+    if (largeQPChangeDetected || exceedQpBlockinessThreshold || fallBelowQpBlockinessThreshold) {
+        mLastReportedQp = avgQp;
+        return true;
+    }
+    return false;
+}
 
-    if (mListener != nullptr) {
+bool ECOSession::Listener::checkWindowCondition() {
+    bool crossed = false;
+
+    if (mCondition.mWindowBitrateThresholdBps != -1) {
+        const bool above = mWindow->getBitrateBps() > mCondition.mWindowBitrateThresholdBps;
+        crossed |= (above != mAboveWindowBitrateThreshold);
+        mAboveWindowBitrateThreshold = above;
+    }
+
+    if (mCondition.mWindowQpThreshold != -1) {
+        // Windows without qp never cross the qp threshold.
+        const bool above = mWindow->getAvgQp() > mCondition.mWindowQpThreshold;
+        crossed |= (above != mAboveWindowQpThreshold);
+        mAboveWindowQpThreshold = above;
+    }
+
+    return crossed;
+}
+
+void ECOSession::Listener::run() {
+    std::unique_lock<std::mutex> lock(mLock);
+    while (true) {
+        mCV.wait(lock, [this] { return mStop || !mInfos.empty(); });
+        if (mStop) return;
+
+        ECOData info = std::move(mInfos.front().first);
+        mInfos.pop_front();
+
+        // Do not hold the lock while calling into the listener so that new infos could be queued.
+        lock.unlock();
         Status status = mListener->onNewInfo(info);
+        lock.lock();
+
         if (!status.isOk()) {
             ECOLOGE("%s: Failed to publish info: %s due to binder error", __FUNCTION__,
                     info.debugString().c_str());
-            // Remove the listener. The lock has been acquired outside this function.
-            mListener = nullptr;
+            // The session thread removes the listener.
+            mDead = true;
+            mInfos.clear();
+            return;
         }
     }
 }
@@ -300,65 +476,72 @@ ECOData ECOSession::generateLatestSessionInfoEcoData() {
 void ECOSession::processFrameStats(const ECOData& stats) {
     ECOLOGD("processFrameStats");
 
-    bool needToNotifyListener = false;
+    int32_t avgQp = -1;
+    int64_t ptsUs = stats.getDataTimeUs();
+    int32_t sizeBytes = 0;
+    int8_t frameType = FrameTypeUnknown;
     ECOData info(ECOData::DATA_TYPE_INFO, systemTime(SYSTEM_TIME_BOOTTIME));
     info.setString(KEY_INFO_TYPE, VALUE_INFO_TYPE_FRAME);
 
     ECODataKeyValueIterator iter(stats);
     while (iter.hasNext()) {
-        ECOData::ECODataKeyValuePair entry = iter.next();
-        const std::string& key = entry.first;
-        const ECOData::ECODataValueType value = entry.second;
-        ECOLOGD("Processing %s key", key.c_str());
+        const ECODataKeyId keyId = iter.keyId();
+        const ECOData::ECODataValueType& value = iter.value();
+        ECOLOGD("Processing %d key", keyId);
 
-        if (!key.compare(KEY_STATS_TYPE)) {
+        switch (keyId) {
+        case KEY_ID_STATS_TYPE:
             // Skip the key KEY_STATS_TYPE as that has been parsed already.
-            continue;
-        } else if (!key.compare(FRAME_NUM) || !key.compare(FRAME_PTS_US) ||
-                   !key.compare(FRAME_TYPE) || !key.compare(FRAME_SIZE_BYTES) ||
-                   !key.compare(ENCODER_ACTUAL_BITRATE_BPS) ||
-                   !key.compare(ENCODER_FRAMERATE_FPS)) {
+            break;
+        case KEY_ID_FRAME_PTS_US:
+            ptsUs = std::get<int64_t>(value);
+            info.set(keyId, value);
+            break;
+        case KEY_ID_FRAME_TYPE:
+            frameType = std::get<int8_t>(value);
+            info.set(keyId, value);
+            break;
+        case KEY_ID_FRAME_SIZE_BYTES:
+            sizeBytes = std::get<int32_t>(value);
+            info.set(keyId, value);
+            break;
+        case KEY_ID_FRAME_NUM:
+        case KEY_ID_ENCODER_ACTUAL_BITRATE_BPS:
+        case KEY_ID_ENCODER_FRAMERATE_FPS:
             // Only process the keys that are supported by ECOService 1.0.
-            info.set(key, value);
-        } else if (!key.compare(FRAME_AVG_QP)) {
-            // Check the qp to see if need to notify the listener.
-            const int32_t currAverageQp = std::get<int32_t>(value);
-
-            // Check if the delta between current QP and last reported QP is larger than the
-            // threshold specified by the listener.
-            const bool largeQPChangeDetected =
-                    abs(currAverageQp - mLastReportedQp) > mListenerQpCondition.mQpChangeThreshold;
-
-            // Check if the qp is going from below threshold to beyond threshold.
-            const bool exceedQpBlockinessThreshold =
-                    (mLastReportedQp <= mListenerQpCondition.mQpBlocknessThreshold &&
-                     currAverageQp > mListenerQpCondition.mQpBlocknessThreshold);
-
-            // Check if the qp is going from beyond threshold to below threshold.
-            const bool fallBelowQpBlockinessThreshold =
-                    (mLastReportedQp > mListenerQpCondition.mQpBlocknessThreshold &&
-                     currAverageQp <= mListenerQpCondition.mQpBlocknessThreshold);
-
-            // Notify the listener if any of the above three conditions met.
-            if (largeQPChangeDetected || exceedQpBlockinessThreshold ||
-                fallBelowQpBlockinessThreshold) {
-                mLastReportedQp = currAverageQp;
-                needToNotifyListener = true;
-            }
-
-            info.set(key, value);
-        } else {
-            ECOLOGW("Unknown frame stats key %s from provider.", key.c_str());
+            info.set(keyId, value);
+            break;
+        case KEY_ID_FRAME_AVG_QP:
+            // Check the qp to see if need to notify the listeners.
+            avgQp = std::get<int32_t>(value);
+            info.set(keyId, value);
+            break;
+        default:
+            ECOLOGW("Unknown frame stats key %s from provider.", iter.next().first.c_str());
+            break;
         }
     }
 
-    if (needToNotifyListener && mListener != nullptr) {
-        Status status = mListener->onNewInfo(info);
-        if (!status.isOk()) {
-            ECOLOGE("%s: Failed to publish info: %s due to binder error", __FUNCTION__,
-                    info.debugString().c_str());
-            // Remove the listener. The lock has been acquired outside this function.
-            mListener = nullptr;
+    for (const std::unique_ptr<Listener>& listener : mListeners) {
+        if (listener->mCondition.mHasQpCondition && avgQp != -1 &&
+            listener->checkQpCondition(avgQp)) {
+            if (listener->mPendingFrameInfo) {
+                ++mNumCoalescedInfos;
+            }
+            listener->mPendingFrameInfo = info;
+        }
+
+        if (listener->mWindow != nullptr) {
+            listener->mWindow->addFrame(ptsUs, sizeBytes, avgQp, frameType);
+            if (listener->checkWindowCondition()) {
+                ECOData windowInfo(ECOData::DATA_TYPE_INFO, systemTime(SYSTEM_TIME_BOOTTIME));
+                windowInfo.setString(KEY_INFO_TYPE, VALUE_INFO_TYPE_WINDOW);
+                windowInfo.set(KEY_ID_FRAME_PTS_US, ptsUs);
+                listener->mWindow->toEcoData(&windowInfo);
+                // Window infos are never coalesced as each of them reports a threshold crossing.
+                listener->flushPendingFrameInfo();
+                listener->post(windowInfo, false /* isFrameInfo */);
+            }
         }
     }
 }
@@ -446,18 +629,27 @@ Status ECOSession::addInfoListener(
         return STATUS_ERROR(ERROR_PERMISSION_DENIED, "Failed to get listener name");
     }
 
-    if (mListener != nullptr) {
-        ECOLOGE("ECOService 1.0 only supports one listener");
-        *status = false;
-        return STATUS_ERROR(ERROR_ALREADY_EXISTS, "ECOService 1.0 only supports one listener");
-    }
-
     if (listener == nullptr) {
         ECOLOGE("%s: listener must not be null", __FUNCTION__);
         *status = false;
         return STATUS_ERROR(ERROR_ILLEGAL_ARGUMENT, "Null listener given to addInfoListener");
     }
 
+    removeDeadListeners();
+    for (const std::unique_ptr<Listener>& entry : mListeners) {
+        if (IInterface::asBinder(entry->mListener) == IInterface::asBinder(listener)) {
+            ECOLOGE("%s: listener has already been added", __FUNCTION__);
+            *status = false;
+            return STATUS_ERROR(ERROR_ALREADY_EXISTS, "Listener has already been added");
+        }
+    }
+
+    if (mListeners.size() >= MAX_NUM_LISTENERS) {
+        ECOLOGE("ECOSession supports at most %zu listeners", MAX_NUM_LISTENERS);
+        *status = false;
+        return STATUS_ERROR(ERROR_ALREADY_EXISTS, "Too many listeners");
+    }
+
     if (config.getDataType() != ECOData::DATA_TYPE_INFO_LISTENER_CONFIG) {
         *status = false;
         ECOLOGE("%s: listener config is invalid", __FUNCTION__);
@@ -470,13 +662,8 @@ Status ECOSession::addInfoListener(
         return STATUS_ERROR(ERROR_ILLEGAL_ARGUMENT, "listener config is empty");
     }
 
-    // For ECOService 1.0, listener must specify the two threshold in order to receive info.
-    if (config.findInt32(KEY_LISTENER_QP_BLOCKINESS_THRESHOLD,
-                         &mListenerQpCondition.mQpBlocknessThreshold) != ECODataStatus::OK ||
-        config.findInt32(KEY_LISTENER_QP_CHANGE_THRESHOLD,
-                         &mListenerQpCondition.mQpChangeThreshold) != ECODataStatus::OK ||
-        mListenerQpCondition.mQpBlocknessThreshold < ENCODER_MIN_QP ||
-        mListenerQpCondition.mQpBlocknessThreshold > ENCODER_MAX_QP) {
+    ListenerCondition condition;
+    if (!parseListenerCondition(config, &condition)) {
         *status = false;
         ECOLOGE("%s: listener config is invalid", __FUNCTION__);
         return STATUS_ERROR(ERROR_ILLEGAL_ARGUMENT, "listener config is not valid");
@@ -485,8 +672,11 @@ Status ECOSession::addInfoListener(
     ECOLOGD("Info listener name: %s uid: %d pid %d", ::android::String8(name).string(),
             IPCThreadState::self()->getCallingUid(), IPCThreadState::self()->getCallingPid());
 
-    mListener = listener;
-    mListenerName = name;
+    // Remove the listener as soon as its process dies.
+    IInterface::asBinder(listener)->linkToDeath(this);
+
+    mListeners.push_back(
+            std::make_unique<Listener>(listener, name, condition, &mNumCoalescedInfos));
     mNewListenerAdded = true;
     mWorkerWaitCV.notify_all();
 
@@ -494,18 +684,62 @@ Status ECOSession::addInfoListener(
     return binder::Status::ok();
 }
 
+// static
+bool ECOSession::parseListenerCondition(const ECOData& config, ListenerCondition* condition) {
+    // The two QP thresholds must be specified together.
+    QpCondition& qpCondition = condition->mQpCondition;
+    const bool hasBlockinessThreshold =
+            config.findInt32(KEY_LISTENER_QP_BLOCKINESS_THRESHOLD,
+                             &qpCondition.mQpBlocknessThreshold) == ECODataStatus::OK;
+    const bool hasChangeThreshold = config.findInt32(KEY_LISTENER_QP_CHANGE_THRESHOLD,
+                                                     &qpCondition.mQpChangeThreshold) ==
+                                    ECODataStatus::OK;
+    if (hasBlockinessThreshold != hasChangeThreshold) {
+        return false;
+    }
+    if (hasBlockinessThreshold && (qpCondition.mQpBlocknessThreshold < ENCODER_MIN_QP ||
+                                   qpCondition.mQpBlocknessThreshold > ENCODER_MAX_QP)) {
+        return false;
+    }
+    condition->mHasQpCondition = hasBlockinessThreshold;
+
+    if (config.findInt32(KEY_LISTENER_WINDOW_BITRATE_THRESHOLD_BPS,
+                         &condition->mWindowBitrateThresholdBps) == ECODataStatus::OK &&
+        condition->mWindowBitrateThresholdBps < 0) {
+        return false;
+    }
+    if (config.findInt32(KEY_LISTENER_WINDOW_QP_THRESHOLD, &condition->mWindowQpThreshold) ==
+                ECODataStatus::OK &&
+        (condition->mWindowQpThreshold < ENCODER_MIN_QP ||
+         condition->mWindowQpThreshold > ECOStatsWindow::MAX_QP)) {
+        return false;
+    }
+    if (config.findInt64(KEY_LISTENER_WINDOW_US, &condition->mWindowUs) == ECODataStatus::OK &&
+        (condition->mWindowUs <= 0 || condition->mWindowUs > MAX_WINDOW_US)) {
+        return false;
+    }
+
+    // Listener must specify at least one condition in order to receive info.
+    return condition->mHasQpCondition || condition->hasWindowCondition();
+}
+
 Status ECOSession::removeInfoListener(
         const sp<::android::media::eco::IECOServiceInfoListener>& listener, bool* _aidl_return) {
     std::scoped_lock<std::mutex> lock(mSessionLock);
-    // Check if the listener is the same as current listener for the session.
-    if (IInterface::asBinder(listener) != IInterface::asBinder(mListener)) {
+    // Check if the listener has been added to the session.
+    auto it = std::find_if(mListeners.begin(), mListeners.end(),
+                           [&listener](const std::unique_ptr<Listener>& entry) {
+                               return IInterface::asBinder(entry->mListener) ==
+                                      IInterface::asBinder(listener);
+                           });
+    if (it == mListeners.end()) {
         *_aidl_return = false;
         ECOLOGE("Failed to remove listener");
         return STATUS_ERROR(ERROR_ILLEGAL_ARGUMENT, "Listener does not match");
     }
 
-    mListener = nullptr;
-    mNewListenerAdded = false;
+    IInterface::asBinder(listener)->unlinkToDeath(this);
+    mListeners.erase(it);
     *_aidl_return = true;
     return binder::Status::ok();
 }
@@ -513,12 +747,78 @@ Status ECOSession::removeInfoListener(
 Status ECOSession::pushNewStats(const ::android::media::eco::ECOData& stats, bool* _aidl_return) {
     ECOLOGV("ECOSession get new stats type: %s", stats.getDataTypeString().c_str());
     std::unique_lock<std::mutex> lock(mStatsQueueLock);
+    *_aidl_return = true;
+
+    if (mStatsQueueLimit > 0 && mStatsQueue.size() >= mStatsQueueLimit) {
+        switch (mStatsQueueOverflowPolicy) {
+        case QueueOverflowPolicy::BLOCK_PROVIDER:
+            mStatsQueueSpaceCV.wait(lock, [this] {
+                return mStopThread == true || mStatsQueueLimit == 0 ||
+                       mStatsQueue.size() < mStatsQueueLimit ||
+                       mStatsQueueOverflowPolicy != QueueOverflowPolicy::BLOCK_PROVIDER;
+            });
+            if (mStopThread) {
+                *_aidl_return = false;
+                return binder::Status::ok();
+            }
+            break;
+        case QueueOverflowPolicy::DROP_FRAME_STATS: {
+            auto it = std::find_if(mStatsQueue.begin(), mStatsQueue.end(), isFrameStats);
+            if (it != mStatsQueue.end()) {
+                mStatsQueue.erase(it);
+                ++mNumDroppedStats;
+            } else if (isFrameStats(stats)) {
+                ++mNumDroppedStats;
+                *_aidl_return = false;
+                return binder::Status::ok();
+            }
+            // Otherwise the queue only holds session stats, which are never dropped.
+            break;
+        }
+        case QueueOverflowPolicy::DROP_OLDEST:
+        default:
+            mStatsQueue.pop_front();
+            ++mNumDroppedStats;
+            break;
+        }
+        ECOLOGV("ECOSession stats queue is full, dropped %" PRIu64 " stats", mNumDroppedStats);
+    }
+
     mStatsQueue.push_back(stats);
+    mMaxStatsQueueDepth = std::max(mMaxStatsQueueDepth, mStatsQueue.size());
     mWorkerWaitCV.notify_all();
-    *_aidl_return = true;
     return binder::Status::ok();
 }
 
+void ECOSession::setStatsQueueLimit(uint32_t limit, QueueOverflowPolicy policy) {
+    {
+        std::scoped_lock<std::mutex> lock(mStatsQueueLock);
+        mStatsQueueLimit = limit;
+        mStatsQueueOverflowPolicy = policy;
+    }
+    // Let the blocked providers re-check the new limit.
+    mStatsQueueSpaceCV.notify_all();
+}
+
+size_t ECOSession::getStatsQueueDepth() {
+    std::scoped_lock<std::mutex> lock(mStatsQueueLock);
+    return mStatsQueue.size();
+}
+
+size_t ECOSession::getMaxStatsQueueDepth() {
+    std::scoped_lock<std::mutex> lock(mStatsQueueLock);
+    return mMaxStatsQueueDepth;
+}
+
+uint64_t ECOSession::getNumOfDroppedStats() {
+    std::scoped_lock<std::mutex> lock(mStatsQueueLock);
+    return mNumDroppedStats;
+}
+
+uint64_t ECOSession::getNumOfCoalescedInfos() {
+    return mNumCoalescedInfos;
+}
+
 Status ECOSession::getWidth(int32_t* _aidl_return) {
     std::scoped_lock<std::mutex> lock(mSessionLock);
     *_aidl_return = mWidth;
@@ -533,7 +833,7 @@ Status ECOSession::getHeight(int32_t* _aidl_return) {
 
 Status ECOSession::getNumOfListeners(int32_t* _aidl_return) {
     std::scoped_lock<std::mutex> lock(mSessionLock);
-    *_aidl_return = (mListener == nullptr ? 0 : 1);
+    *_aidl_return = mListeners.size();
     return binder::Status::ok();
 }
 
@@ -543,8 +843,15 @@ Status ECOSession::getNumOfProviders(int32_t* _aidl_return) {
     return binder::Status::ok();
 }
 
-/*virtual*/ void ECOSession::binderDied(const wp<IBinder>& /*who*/) {
+/*virtual*/ void ECOSession::binderDied(const wp<IBinder>& who) {
     ECOLOGV("binderDied");
+    std::scoped_lock<std::mutex> lock(mSessionLock);
+    mListeners.erase(std::remove_if(mListeners.begin(), mListeners.end(),
+                                    [&who](const std::unique_ptr<Listener>& entry) {
+                                        return IInterface::asBinder(entry->mListener).get() ==
+                                               who.unsafe_get();
+                                    }),
+                     mListeners.end());
 }
 
 status_t ECOSession::dump(int fd, const Vector<String16>& /*args*/) {
@@ -558,8 +865,32 @@ status_t ECOSession::dump(int fd, const Vector<String16>& /*args*/) {
     if (mProvider != nullptr) {
         dprintf(fd, "Provider: %s \n", ::android::String8(mProviderName).string());
     }
-    if (mListener != nullptr) {
-        dprintf(fd, "Listener: %s \n", ::android::String8(mListenerName).string());
+    for (const std::unique_ptr<Listener>& listener : mListeners) {
+        const ListenerCondition& condition = listener->mCondition;
+        dprintf(fd, "Listener: %s%s\n", ::android::String8(listener->mName).string(),
+                listener->isAlive() ? "" : " (dead)");
+        if (condition.mHasQpCondition) {
+            dprintf(fd, "  qp-blockiness-threshold: %d qp-change-threshold: %d\n",
+                    condition.mQpCondition.mQpBlocknessThreshold,
+                    condition.mQpCondition.mQpChangeThreshold);
+        }
+        if (listener->mWindow != nullptr) {
+            dprintf(fd,
+                    "  window: %" PRId64 " us bitrate-threshold: %d bps qp-threshold: %d "
+                    "bitrate: %d bps avg-qp: %.2f frames: %d\n",
+                    condition.mWindowUs, condition.mWindowBitrateThresholdBps,
+                    condition.mWindowQpThreshold, listener->mWindow->getBitrateBps(),
+                    listener->mWindow->getAvgQp(), listener->mWindow->getNumOfFrames());
+        }
+    }
+    dprintf(fd, "Coalesced infos: %" PRIu64 "\n", mNumCoalescedInfos.load());
+    {
+        std::scoped_lock<std::mutex> queueLock(mStatsQueueLock);
+        dprintf(fd,
+                "Stats queue depth: %zu max depth: %zu limit: %u policy: %d dropped stats: "
+                "%" PRIu64 "\n",
+                mStatsQueue.size(), mMaxStatsQueueDepth, mStatsQueueLimit,
+                static_cast<int32_t>(mStatsQueueOverflowPolicy), mNumDroppedStats);
     }
     dprintf(fd, "\n===================\n\n");
 
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ECOStatsWindow"
+
+#include "eco/ECOStatsWindow.h"
+
+#include <algorithm>
+#include <climits>
+
+#include "eco/ECODataKey.h"
+#include "eco/ECOServiceConstants.h"
+
+namespace android {
+namespace media {
+namespace eco {
+
+ECOStatsWindow::ECOStatsWindow(int64_t durationUs)
+      : mDurationUs(durationUs), mLatestPtsUs(INT64_MIN) {
+    mQpHistogram.fill(0);
+}
+
+void ECOStatsWindow::addFrame(int64_t ptsUs, int32_t sizeBytes, int32_t avgQp, int8_t frameType) {
+    Frame frame = {ptsUs, std::max(sizeBytes, 0), std::min(avgQp, MAX_QP), frameType};
+    mFrames.push_back(frame);
+    mTotalSizeBytes += frame.mSizeBytes;
+    if (frame.mAvgQp >= 0) {
+        mTotalQp += frame.mAvgQp;
+        ++mNumOfQpFrames;
+        ++mQpHistogram[frame.mAvgQp];
+    }
+    if (frameType == FrameTypeI) {
+        ++mNumOfIFrames;
+    } else if (frameType == FrameTypeP) {
+        ++mNumOfPFrames;
+    } else if (frameType == FrameTypeB) {
+        ++mNumOfBFrames;
+    }
+
+    mLatestPtsUs = std::max(mLatestPtsUs, ptsUs);
+    while (!mFrames.empty() && (mFrames.size() > MAX_NUM_FRAMES ||
+                                mFrames.front().mPtsUs <= mLatestPtsUs - mDurationUs)) {
+        removeOldestFrame();
+    }
+}
+
+void ECOStatsWindow::removeOldestFrame() {
+    const Frame& frame = mFrames.front();
+    mTotalSizeBytes -= frame.mSizeBytes;
+    if (frame.mAvgQp >= 0) {
+        mTotalQp -= frame.mAvgQp;
+        --mNumOfQpFrames;
+        --mQpHistogram[frame.mAvgQp];
+    }
+    if (frame.mFrameType == FrameTypeI) {
+        --mNumOfIFrames;
+    } else if (frame.mFrameType == FrameTypeP) {
+        --mNumOfPFrames;
+    } else if (frame.mFrameType == FrameTypeB) {
+        --mNumOfBFrames;
+    }
+    mFrames.pop_front();
+}
+
+int32_t ECOStatsWindow::getNumOfFrames(int8_t frameType) const {
+    switch (frameType) {
+    case FrameTypeI:
+        return mNumOfIFrames;
+    case FrameTypeP:
+        return mNumOfPFrames;
+    case FrameTypeB:
+        return mNumOfBFrames;
+    default:
+        return mFrames.size() - mNumOfIFrames - mNumOfPFrames - mNumOfBFrames;
+    }
+}
+
+int32_t ECOStatsWindow::getBitrateBps() const {
+    const int64_t bitrate = mTotalSizeBytes * 8 * 1000000 / mDurationUs;
+    return std::min(bitrate, static_cast<int64_t>(INT32_MAX));
+}
+
+int32_t ECOStatsWindow::getAvgFrameSizeBytes() const {
+    return mFrames.empty() ? 0 : mTotalSizeBytes / static_cast<int64_t>(mFrames.size());
+}
+
+float ECOStatsWindow::getAvgQp() const {
+    return mNumOfQpFrames == 0 ? -1.0f : static_cast<float>(mTotalQp) / mNumOfQpFrames;
+}
+
+int32_t ECOStatsWindow::getQpPercentile(int32_t percentile) const {
+    if (mNumOfQpFrames == 0) return -1;
+
+    // Number of frames that must be at or below the returned qp, rounded up.
+    const int64_t rank = std::max<int64_t>(
+            (static_cast<int64_t>(mNumOfQpFrames) * std::clamp(percentile, 0, 100) + 99) / 100, 1);
+    int64_t count = 0;
+    for (int32_t qp = 0; qp <= MAX_QP; ++qp) {
+        count += mQpHistogram[qp];
+        if (count >= rank) return qp;
+    }
+    return MAX_QP;
+}
+
+void ECOStatsWindow::toEcoData(ECOData* info) const {
+    info->set(KEY_ID_WINDOW_DURATION_US, mDurationUs);
+    info->set(KEY_ID_WINDOW_NUM_FRAMES, getNumOfFrames());
+    info->set(KEY_ID_WINDOW_NUM_I_FRAMES, mNumOfIFrames);
+    info->set(KEY_ID_WINDOW_NUM_P_FRAMES, mNumOfPFrames);
+    info->set(KEY_ID_WINDOW_NUM_B_FRAMES, mNumOfBFrames);
+    info->set(KEY_ID_WINDOW_BITRATE_BPS, getBitrateBps());
+    info->set(KEY_ID_WINDOW_AVG_FRAME_SIZE_BYTES, getAvgFrameSizeBytes());
+    info->set(KEY_ID_WINDOW_AVG_QP, getAvgQp());
+    info->set(KEY_ID_WINDOW_P90_QP, getQpPercentile(90));
+}
+
+}  // namespace eco
+}  // namespace media
+}  // namespace android
@@ -26,7 +26,7 @@ namespace media {
 namespace eco {
 
 // Convert this SimpleEncoderConfig to ECOData with dataType.
-ECOData SimpleEncoderConfig::toEcoData(ECOData::ECODatatype dataType) {
+ECOData SimpleEncoderConfig::toEcoData(ECOData::ECODatatype dataType) const {
     ECOData data(dataType, systemTime(SYSTEM_TIME_BOOTTIME));
     data.setString(KEY_STATS_TYPE, VALUE_STATS_TYPE_SESSION);
     data.setInt32(ENCODER_TYPE, mCodecType);
@@ -39,7 +39,7 @@ ECOData SimpleEncoderConfig::toEcoData(ECOData::ECODatatype dataType) {
 }
 
 // Convert this SimpleEncodedFrameData to ECOData with dataType.
-ECOData SimpleEncodedFrameData::toEcoData(ECOData::ECODatatype dataType) {
+ECOData SimpleEncodedFrameData::toEcoData(ECOData::ECODatatype dataType) const {
     ECOData data(dataType, systemTime(SYSTEM_TIME_BOOTTIME));
     data.setString(KEY_STATS_TYPE, VALUE_STATS_TYPE_FRAME);
     data.setInt32(FRAME_NUM, mFrameNum);
@@ -52,6 +52,8 @@ ECOData SimpleEncodedFrameData::toEcoData(ECOData::ECODatatype dataType) {
 
 bool copyKeyValue(const ECOData& src, ECOData* dst) {
     if (src.isEmpty() || dst == nullptr) return false;
+    dst->mStandardValues = src.mStandardValues;
+    dst->mStandardKeyMask = src.mStandardKeyMask;
     dst->mKeyValueStore = src.mKeyValueStore;
     return true;
 }
@@ -20,10 +20,13 @@
 #include <binder/Parcel.h>
 #include <binder/Parcelable.h>
 
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <variant>
 
+#include "ECODataKey.h"
+
 namespace android {
 namespace media {
 namespace eco {
@@ -59,6 +62,9 @@ enum class ECODataStatus {
 * ECOData does not support duplicate keys with different values. When inserting a key-value pair,
 * a new entry will be created if the key does not exist. Othewise, they key's value will be
 * overwritten with the new value.
+*
+* The standard keys in ECODataKey.h are interned: their values are kept in a flat array indexed
+* by ECODataKeyId and they are parceled by id. Any other key is kept in a string map.
 * 
 *  Sample usage:
 *
@@ -98,6 +104,16 @@ public:
     ECODataStatus set(const std::string& key, const ECODataValueType& value);
     ECODataStatus find(const std::string& key, ECODataValueType* out) const;
 
+    // set/find functions for standard keys that skip the key lookup.
+    ECODataStatus set(ECODataKeyId keyId, const ECODataValueType& value);
+    ECODataStatus find(ECODataKeyId keyId, ECODataValueType* out) const;
+
+    /* Returns the id of |key|, or KEY_ID_UNKNOWN if it is not a standard key. */
+    static ECODataKeyId getKeyId(const std::string& key);
+
+    /* Returns the name of a standard key, or nullptr if |keyId| is not valid. */
+    static const char* getKeyName(ECODataKeyId keyId);
+
     // Convenient set/find functions for string value type.
     ECODataStatus setString(const std::string& key, const std::string& value);
     ECODataStatus findString(const std::string& key, std::string* out) const;
@@ -149,10 +165,12 @@ public:
     void setDataTimeUs();
 
     /* Gets the number of keys in the ECOData. */
-    size_t getNumOfEntries() const { return mKeyValueStore.size(); }
+    size_t getNumOfEntries() const {
+        return __builtin_popcountll(mStandardKeyMask) + mKeyValueStore.size();
+    }
 
     /* Whether the ECOData is empty. */
-    size_t isEmpty() const { return mKeyValueStore.size() == 0; }
+    size_t isEmpty() const { return mStandardKeyMask == 0 && mKeyValueStore.size() == 0; }
 
     friend class ECODataKeyValueIterator;
 
@@ -181,9 +199,22 @@ protected:
     // unavailable.
     int64_t mDataTimeUs;
 
-    // Internal store for the key value pairs.
+    static_assert(KEY_ID_COUNT <= 64, "standard keys must fit in mStandardKeyMask");
+
+    // Values of the standard keys indexed by ECODataKeyId. An entry is only valid if its bit is
+    // set in mStandardKeyMask.
+    std::array<ECODataValueType, KEY_ID_COUNT> mStandardValues;
+    uint64_t mStandardKeyMask = 0;
+
+    // Internal store for the key value pairs with non-standard keys.
     std::unordered_map<std::string, ECODataValueType> mKeyValueStore;
 
+    // Returns the value of |key| for writing, inserting it if it does not exist.
+    ECODataValueType& getOrInsertValue(const std::string& key);
+
+    // Returns the value of |key|, or nullptr if it does not exist.
+    const ECODataValueType* getValue(const std::string& key) const;
+
     template <typename T>
     ECODataStatus setValue(const std::string& key, T value);
 
@@ -191,7 +222,8 @@ protected:
     ECODataStatus findValue(const std::string& key, T* out) const;
 };
 
-// A simple ECOData iterator that will iterate over all the key value paris in ECOData.
+// A simple ECOData iterator that will iterate over all the key value paris in ECOData. Standard
+// keys are visited first in the order of their ids.
 // To be used like:
 // while (it.hasNext()) {
 //   entry = it.next();
@@ -199,17 +231,25 @@ protected:
 class ECODataKeyValueIterator {
 public:
     ECODataKeyValueIterator(const ECOData& data)
-          : mKeyValueStore(data.mKeyValueStore), mBeginReturned(false) {
-        mIterator = mKeyValueStore.begin();
+          : mData(data), mKeyId(-1) {
+        mIterator = mData.mKeyValueStore.begin();
     }
     ~ECODataKeyValueIterator() = default;
     bool hasNext();
     ECOData::ECODataKeyValuePair next() const;
 
+    // Returns the id of the current key, or KEY_ID_UNKNOWN if it is not a standard key. This and
+    // value() avoid the string copy of next().
+    ECODataKeyId keyId() const;
+
+    // Returns the value of the current key.
+    const ECOData::ECODataValueType& value() const;
+
 private:
-    const std::unordered_map<std::string, ECOData::ECODataValueType>& mKeyValueStore;
+    const ECOData& mData;
+    // Id of the current standard key, or KEY_ID_COUNT once all standard keys were visited.
+    int32_t mKeyId;
     std::unordered_map<std::string, ECOData::ECODataValueType>::const_iterator mIterator;
-    bool mBeginReturned;
 };
 
 }  // namespace eco
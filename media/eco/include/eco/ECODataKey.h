@@ -54,6 +54,16 @@ constexpr char KEY_LISTENER_TYPE[] = "listener-type";
 constexpr char KEY_LISTENER_QP_BLOCKINESS_THRESHOLD[] = "listener-qp-blockness-threshold";
 constexpr char KEY_LISTENER_QP_CHANGE_THRESHOLD[] = "listener-qp-change-threshold";
 
+// Following keys are used by the listener to be notified on the statistics of the frames in a
+// sliding window instead of on individual frames. KEY_LISTENER_WINDOW_US specifies the length of
+// the window in presentation time and defaults to 1 second. When the bitrate or the average qp of
+// the frames in the window crosses the threshold, ECOService will notify the listener with an info
+// of type VALUE_INFO_TYPE_WINDOW.
+constexpr char KEY_LISTENER_WINDOW_US[] = "listener-window-us";
+constexpr char KEY_LISTENER_WINDOW_BITRATE_THRESHOLD_BPS[] =
+        "listener-window-bitrate-threshold-bps";
+constexpr char KEY_LISTENER_WINDOW_QP_THRESHOLD[] = "listener-window-qp-threshold";
+
 // ================================================================================================
 // ECOService Stats keys. These key MUST BE specified when provider pushes the stats to ECOService
 // to indicate the stats is session stats or frame stats.
@@ -69,6 +79,7 @@ constexpr char VALUE_STATS_TYPE_FRAME[] = "stats-type-frame";      // value for
 constexpr char KEY_INFO_TYPE[] = "info-type";
 constexpr char VALUE_INFO_TYPE_SESSION[] = "info-type-session";  // value for KEY_INFO_TYPE.
 constexpr char VALUE_INFO_TYPE_FRAME[] = "info-type-frame";      // value for KEY_INFO_TYPE.
+constexpr char VALUE_INFO_TYPE_WINDOW[] = "info-type-window";    // value for KEY_INFO_TYPE.
 
 // ================================================================================================
 // General keys to be used by both stats and info in the ECOData.
@@ -92,6 +103,69 @@ constexpr char FRAME_AVG_QP[] = "frame-avg-qp";
 constexpr char FRAME_TYPE[] = "frame-type";
 constexpr char FRAME_SIZE_BYTES[] = "frame-size-bytes";
 
+// Statistics of the frames in a sliding window, used in the info of type VALUE_INFO_TYPE_WINDOW.
+constexpr char WINDOW_DURATION_US[] = "window-duration-us";
+constexpr char WINDOW_NUM_FRAMES[] = "window-num-frames";
+constexpr char WINDOW_NUM_I_FRAMES[] = "window-num-i-frames";
+constexpr char WINDOW_NUM_P_FRAMES[] = "window-num-p-frames";
+constexpr char WINDOW_NUM_B_FRAMES[] = "window-num-b-frames";
+constexpr char WINDOW_BITRATE_BPS[] = "window-bitrate-bps";
+constexpr char WINDOW_AVG_FRAME_SIZE_BYTES[] = "window-avg-frame-size-bytes";
+constexpr char WINDOW_AVG_QP[] = "window-avg-qp";
+constexpr char WINDOW_P90_QP[] = "window-p90-qp";
+
+// ================================================================================================
+// Ids of the standard keys above. ECOData stores the values of standard keys in a flat array
+// indexed by these ids instead of in a string map, and parcels them by id instead of by name.
+// The ids are part of the parcel format, which the system service and vendor codecs may build
+// from different versions, so they are frozen: never renumber or reuse an id. New standard keys
+// must get the next id before KEY_ID_COUNT and be added to the key table in ECOData.cpp. Readers
+// skip the values of ids they do not know.
+// ================================================================================================
+enum ECODataKeyId : int32_t {
+    KEY_ID_UNKNOWN = -1,  // not a standard key
+    KEY_ID_ECO_DATA_TYPE = 0,
+    KEY_ID_ECO_DATA_TIME_US = 1,
+    KEY_ID_PROVIDER_NAME = 2,
+    KEY_ID_PROVIDER_TYPE = 3,
+    KEY_ID_LISTENER_NAME = 4,
+    KEY_ID_LISTENER_TYPE = 5,
+    KEY_ID_LISTENER_QP_BLOCKINESS_THRESHOLD = 6,
+    KEY_ID_LISTENER_QP_CHANGE_THRESHOLD = 7,
+    KEY_ID_STATS_TYPE = 8,
+    KEY_ID_INFO_TYPE = 9,
+    KEY_ID_ENCODER_NAME = 10,
+    KEY_ID_ENCODER_TYPE = 11,
+    KEY_ID_ENCODER_PROFILE = 12,
+    KEY_ID_ENCODER_LEVEL = 13,
+    KEY_ID_ENCODER_INPUT_WIDTH = 14,
+    KEY_ID_ENCODER_INPUT_HEIGHT = 15,
+    KEY_ID_ENCODER_OUTPUT_WIDTH = 16,
+    KEY_ID_ENCODER_OUTPUT_HEIGHT = 17,
+    KEY_ID_ENCODER_TARGET_BITRATE_BPS = 18,
+    KEY_ID_ENCODER_ACTUAL_BITRATE_BPS = 19,
+    KEY_ID_ENCODER_KFI_FRAMES = 20,
+    KEY_ID_ENCODER_FRAMERATE_FPS = 21,
+    KEY_ID_FRAME_NUM = 22,
+    KEY_ID_FRAME_PTS_US = 23,
+    KEY_ID_FRAME_AVG_QP = 24,
+    KEY_ID_FRAME_TYPE = 25,
+    KEY_ID_FRAME_SIZE_BYTES = 26,
+    KEY_ID_LISTENER_WINDOW_US = 27,
+    KEY_ID_LISTENER_WINDOW_BITRATE_THRESHOLD_BPS = 28,
+    KEY_ID_LISTENER_WINDOW_QP_THRESHOLD = 29,
+    KEY_ID_WINDOW_DURATION_US = 30,
+    KEY_ID_WINDOW_NUM_FRAMES = 31,
+    KEY_ID_WINDOW_NUM_I_FRAMES = 32,
+    KEY_ID_WINDOW_NUM_P_FRAMES = 33,
+    KEY_ID_WINDOW_NUM_B_FRAMES = 34,
+    KEY_ID_WINDOW_BITRATE_BPS = 35,
+    KEY_ID_WINDOW_AVG_FRAME_SIZE_BYTES = 36,
+    KEY_ID_WINDOW_AVG_QP = 37,
+    KEY_ID_WINDOW_P90_QP = 38,
+    KEY_ID_COUNT,
+};
+
 }  // namespace eco
 }  // namespace media
 }  // namespace android
@@ -32,6 +32,8 @@ static const char* kDebugLogStats = "vendor.media.ecoservice.log.stats";
 static const char* kDebugLogStatsSize = "vendor.media.ecoservice.log.stats.size";
 static const char* kDebugLogInfos = "vendor.media.ecoservice.log.info";
 static const char* kDebugLogInfosSize = "vendor.media.ecoservice.log.info.size";
+static const char* kStatsQueueSize = "vendor.media.ecoservice.stats.queue.size";
+static const char* kStatsQueuePolicy = "vendor.media.ecoservice.stats.queue.policy";
 
 // A debug variable that should only be accessed by ECOService through updateLogLevel. It is rare
 // that this variable will have race condition. But if so, it is ok as this is just for debugging.
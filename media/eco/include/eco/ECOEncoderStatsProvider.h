@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_MEDIA_ECO_ENCODER_STATS_PROVIDER_H_
+#define ANDROID_MEDIA_ECO_ENCODER_STATS_PROVIDER_H_
+
+#include <android/media/eco/BnECOServiceStatsProvider.h>
+#include <android/media/eco/IECOSession.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "eco/ECOData.h"
+#include "eco/ECOUtils.h"
+
+namespace android {
+namespace media {
+namespace eco {
+
+using ::android::sp;
+using ::android::binder::Status;
+
+/**
+ * A stats provider for video encoders.
+ *
+ * ECOEncoderStatsProvider connects an encoder to the ECOSession matching its resolution and
+ * pushes the encoder's session stats and per-frame stats to it. It is meant to be created only
+ * when stats reporting is enabled so that encoders that do not report stats pay nothing.
+ *
+ * Stats are queued and pushed to the session by a thread of the provider so that a slow session
+ * never stalls the encoder. If the queue is full, the oldest frame stats are dropped; session stats
+ * are never dropped. Stats are dropped silently once the session has died or the provider has been
+ * released.
+ */
+class ECOEncoderStatsProvider : public BnECOServiceStatsProvider,
+                                public virtual IBinder::DeathRecipient {
+public:
+    // Obtains the ECOSession for |width| x |height| from the ECOService and registers a provider
+    // named |name| with it. Returns nullptr if the ECOService is not running or the session could
+    // not be obtained. This does not wait for the ECOService to start.
+    static sp<ECOEncoderStatsProvider> Create(const std::string& name, int32_t width,
+                                              int32_t height, bool isCameraRecording);
+
+    // Registers a provider named |name| with |session|. Returns nullptr if the session did not
+    // accept the provider.
+    static sp<ECOEncoderStatsProvider> Create(const std::string& name,
+                                              const sp<IECOSession>& session);
+
+    virtual ~ECOEncoderStatsProvider();
+
+    // Queues the encoder configuration as session stats. Returns false if the session has died or
+    // the provider has been released.
+    bool pushSessionStats(const SimpleEncoderConfig& config);
+
+    // Queues the stats of one encoded frame. Returns false if the session has died or the provider
+    // has been released.
+    bool pushFrameStats(const SimpleEncodedFrameData& frame);
+
+    // Unregisters from the ECOSession without waiting for it. Queued stats that have not been
+    // pushed yet are dropped. This must be called before the last reference is dropped as the
+    // session and the push thread hold references to the provider.
+    void release();
+
+    // Returns the number of frame stats dropped because the queue was full.
+    uint64_t getNumDroppedFrameStats();
+
+    // IECOServiceStatsProvider implementation.
+    virtual Status getType(int32_t* _aidl_return);
+    virtual Status getName(::android::String16* _aidl_return);
+    virtual Status getECOSession(sp<::android::IBinder>* _aidl_return);
+
+    // IBinder::DeathRecipient implementation.
+    virtual void binderDied(const wp<IBinder>& who);
+
+private:
+    // Maximum number of stats waiting to be pushed to the session.
+    static constexpr size_t kMaxQueuedStats = 32;
+
+    struct QueuedStats {
+        ECOData stats;
+        bool isFrameStats;
+    };
+
+    ECOEncoderStatsProvider(const std::string& name, const sp<IECOSession>& session);
+
+    bool queueStats(const ECOData& stats, bool isFrameStats);
+
+    // Pushes the queued stats to the session until the provider is released or the session dies,
+    // then unregisters from the session.
+    void pushLoop();
+
+    const std::string mName;
+
+    std::mutex mLock;
+    std::condition_variable mQueueCV;
+    sp<IECOSession> mSession;          // GUARDED_BY(mLock)
+    bool mReleased = false;            // GUARDED_BY(mLock)
+    std::deque<QueuedStats> mQueue;    // GUARDED_BY(mLock)
+    uint64_t mNumDroppedFrameStats = 0;  // GUARDED_BY(mLock)
+};
+
+}  // namespace eco
+}  // namespace media
+}  // namespace android
+
+#endif  // ANDROID_MEDIA_ECO_ENCODER_STATS_PROVIDER_H_
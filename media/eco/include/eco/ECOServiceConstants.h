@@ -27,6 +27,8 @@ namespace eco {
 constexpr int32_t CodecTypeUnknown = 0x00;
 constexpr int32_t CodecTypeAVC = 0x01;
 constexpr int32_t CodecTypeHEVC = 0x02;
+constexpr int32_t CodecTypeVP8 = 0x03;
+constexpr int32_t CodecTypeVP9 = 0x04;
 
 // Encoded frame type.
 constexpr int32_t FrameTypeUnknown = 0x0;
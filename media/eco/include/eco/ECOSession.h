@@ -26,11 +26,14 @@
 #include <list>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <thread>
+#include <vector>
 
 #include "ECOData.h"
 #include "ECOServiceInfoListener.h"
 #include "ECOServiceStatsProvider.h"
+#include "ECOStatsWindow.h"
 #include "ECOUtils.h"
 
 namespace android {
@@ -45,7 +48,8 @@ using ::android::binder::Status;
  * ECOSession is created by ECOService to manage an encoding session. Both the providers and
  * listeners should interact with ECO session after obtain it from ECOService. For ECOService 1.0,
  * it only supports resolution of up to 720P and only for camera recording use case. Also, it only
- * supports encoder as the provider and camera as listener.
+ * supports encoder as the provider. Multiple listeners could observe the same session, each with
+ * its own conditions on the QP of every frame or on the statistics of a sliding window of frames.
  */
 class ECOSession : public BinderService<ECOSession>,
                    public BnECOSession,
@@ -53,6 +57,17 @@ class ECOSession : public BinderService<ECOSession>,
     friend class BinderService<ECOSession>;
 
 public:
+    // What pushNewStats does when the stats queue is full.
+    enum class QueueOverflowPolicy : int32_t {
+        // Drop the oldest stats in the queue to make room for the new stats.
+        DROP_OLDEST = 0,
+        // Drop the oldest frame stats in the queue, or the new stats if it is a frame stats and
+        // there is no frame stats in the queue. Session stats are never dropped.
+        DROP_FRAME_STATS = 1,
+        // Block the provider until the session thread drains the queue.
+        BLOCK_PROVIDER = 2,
+    };
+
     virtual ~ECOSession();
 
     virtual Status addStatsProvider(const sp<IECOServiceStatsProvider>& provider,
@@ -81,6 +96,23 @@ public:
     // IBinder::DeathRecipient implementation
     virtual void binderDied(const wp<IBinder>& who);
 
+    // Sets the maximum number of stats waiting in the queue and what to do when the queue is full.
+    // A limit of 0 means the queue is unbounded.
+    void setStatsQueueLimit(uint32_t limit, QueueOverflowPolicy policy);
+
+    // Returns the number of stats waiting to be processed by the session thread.
+    size_t getStatsQueueDepth();
+
+    // Returns the maximum number of stats that have been waiting in the queue at the same time.
+    size_t getMaxStatsQueueDepth();
+
+    // Returns the number of stats dropped because the queue was full.
+    uint64_t getNumOfDroppedStats();
+
+    // Returns the number of frame infos that were superseded by a later frame info and thus never
+    // sent to the listener.
+    uint64_t getNumOfCoalescedInfos();
+
     // Grant permission to EcoSessionTest to run test.
     friend class EcoSessionTest;
 
@@ -110,9 +142,18 @@ private:
     // Process the session stats received from provider.
     void processSessionStats(const ECOData& stats);
 
-    // Process the frame stats received from provider.
+    // Process the frame stats received from provider. The frame info is kept pending for each
+    // listener whose QP conditions are met so that it could be superseded by a later frame info in
+    // the same batch. The frame is also added to the sliding window of each listener with window
+    // conditions.
     void processFrameStats(const ECOData& stats);
 
+    // Sends the pending frame infos to the listeners.
+    void flushPendingFrameInfos();
+
+    // Removes the listeners that could not be reached.
+    void removeDeadListeners();
+
     // Generate the latest session info if available.
     ECOData generateLatestSessionInfoEcoData();
 
@@ -121,23 +162,114 @@ private:
     std::mutex mStatsQueueLock;
     std::deque<ECOData> mStatsQueue;  // GUARDED_BY(mStatsQueueLock)
     std::condition_variable mWorkerWaitCV;
+    // Signaled when the session thread drains the queue. Used with BLOCK_PROVIDER policy.
+    std::condition_variable mStatsQueueSpaceCV;
+
+    constexpr static uint32_t DEFAULT_STATS_QUEUE_LIMIT = 256;
+
+    uint32_t mStatsQueueLimit;                      // GUARDED_BY(mStatsQueueLock)
+    QueueOverflowPolicy mStatsQueueOverflowPolicy;  // GUARDED_BY(mStatsQueueLock)
+    size_t mMaxStatsQueueDepth = 0;                 // GUARDED_BY(mStatsQueueLock)
+    uint64_t mNumDroppedStats = 0;                  // GUARDED_BY(mStatsQueueLock)
+
+    // Number of frame infos superseded by a later frame info.
+    std::atomic<uint64_t> mNumCoalescedInfos;
 
     bool mNewListenerAdded = false;
 
     constexpr static int32_t ENCODER_MIN_QP = 0;
     constexpr static int32_t ENCODER_MAX_QP = 51;
 
-    // Save the QP last reported to the listener. Init to be 0.
-    int32_t mLastReportedQp;
+    constexpr static size_t MAX_NUM_LISTENERS = 8;
 
     typedef struct QpRange {
         int32_t mQpBlocknessThreshold = 50;
         int32_t mQpChangeThreshold = 50;
     } QpCondition;
-    QpCondition mListenerQpCondition;
 
-    android::sp<IECOServiceInfoListener> mListener;
-    String16 mListenerName;
+    constexpr static int64_t DEFAULT_WINDOW_US = 1000000;
+    constexpr static int64_t MAX_WINDOW_US = 60000000;
+
+    // Conditions for notifying a listener, parsed from the listener config.
+    struct ListenerCondition {
+        // Conditions on the QP of every frame.
+        bool mHasQpCondition = false;
+        QpCondition mQpCondition;
+
+        // Conditions on the frames in a sliding window. -1 means the threshold is not set.
+        int64_t mWindowUs = DEFAULT_WINDOW_US;
+        int32_t mWindowBitrateThresholdBps = -1;
+        int32_t mWindowQpThreshold = -1;
+
+        bool hasWindowCondition() const {
+            return mWindowBitrateThresholdBps != -1 || mWindowQpThreshold != -1;
+        }
+    };
+
+    // Parses the listener config. Returns false if the config is invalid.
+    static bool parseListenerCondition(const ECOData& config, ListenerCondition* condition);
+
+    // A listener of the session. Infos are delivered to each listener on its own thread so that a
+    // slow or dead listener does not delay the others.
+    class Listener {
+    public:
+        Listener(const sp<IECOServiceInfoListener>& listener, const String16& name,
+                 const ListenerCondition& condition, std::atomic<uint64_t>* numCoalescedInfos);
+        ~Listener();
+
+        // Queues the info to be delivered to the listener. A frame info replaces the frame info
+        // that is still waiting to be delivered.
+        void post(const ECOData& info, bool isFrameInfo);
+
+        // Returns false once the listener could not be reached.
+        bool isAlive() const { return !mDead; }
+
+        // Returns true if the listener needs to be notified of a frame with |avgQp|.
+        bool checkQpCondition(int32_t avgQp);
+
+        // Returns true if the listener needs to be notified of the statistics in mWindow, which
+        // happens when they cross a threshold.
+        bool checkWindowCondition();
+
+        // Posts the pending frame info if there is one.
+        void flushPendingFrameInfo();
+
+        const sp<IECOServiceInfoListener> mListener;
+        const String16 mName;
+        const ListenerCondition mCondition;
+
+        // Sliding window of the frames. Only used if the listener has window conditions.
+        std::unique_ptr<ECOStatsWindow> mWindow;
+
+        // Whether the latest session info needs to be sent to the listener.
+        bool mNeedSessionInfo = true;
+
+        // Frame info waiting to be posted at the end of the current batch.
+        std::optional<ECOData> mPendingFrameInfo;
+
+    private:
+        void run();
+
+        // QP last reported to the listener. Init to be 0.
+        int32_t mLastReportedQp = 0;
+
+        // Whether the window statistics were above the thresholds when last checked.
+        bool mAboveWindowBitrateThreshold = false;
+        bool mAboveWindowQpThreshold = false;
+
+        std::atomic<uint64_t>* const mNumCoalescedInfos;
+        std::atomic<bool> mDead;
+
+        std::mutex mLock;
+        std::condition_variable mCV;
+        // Infos to be delivered, and whether each of them is a frame info.
+        std::deque<std::pair<ECOData, bool>> mInfos;  // GUARDED_BY(mLock)
+        bool mStop = false;                            // GUARDED_BY(mLock)
+
+        std::thread mThread;
+    };
+
+    std::vector<std::unique_ptr<Listener>> mListeners;  // GUARDED_BY(mSessionLock)
 
     android::sp<IECOServiceStatsProvider> mProvider;
     String16 mProviderName;
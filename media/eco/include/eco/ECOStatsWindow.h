@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANDROID_MEDIA_ECO_STATS_WINDOW_H_
+#define ANDROID_MEDIA_ECO_STATS_WINDOW_H_
+
+#include <stdint.h>
+
+#include <array>
+#include <deque>
+
+#include "ECOData.h"
+
+namespace android {
+namespace media {
+namespace eco {
+
+/**
+ * ECOStatsWindow keeps the statistics of the frames in a sliding window of presentation time.
+ *
+ * The running totals are updated as frames enter and leave the window, so adding a frame and
+ * querying the bitrate, the average frame size, the average qp and the frame type mix are O(1)
+ * (amortized for adding). The qp percentiles come from a histogram over the fixed qp range, so no
+ * per-frame sorting is needed either.
+ */
+class ECOStatsWindow {
+public:
+    constexpr static int32_t MAX_QP = 127;
+
+    // Upper bound of the number of frames in the window, in case the provider does not advance
+    // the presentation time.
+    constexpr static size_t MAX_NUM_FRAMES = 16384;
+
+    explicit ECOStatsWindow(int64_t durationUs);
+
+    // Adds a frame to the window and removes the frames that are older than the window duration
+    // relative to the latest frame. |avgQp| is -1 if the frame has no qp.
+    void addFrame(int64_t ptsUs, int32_t sizeBytes, int32_t avgQp, int8_t frameType);
+
+    int64_t getDurationUs() const { return mDurationUs; }
+
+    int32_t getNumOfFrames() const { return mFrames.size(); }
+
+    // Returns the number of frames of |frameType| in the window.
+    int32_t getNumOfFrames(int8_t frameType) const;
+
+    // Returns the number of bits in the window divided by the window duration.
+    int32_t getBitrateBps() const;
+
+    // Returns the average frame size, or 0 if the window is empty.
+    int32_t getAvgFrameSizeBytes() const;
+
+    // Returns the average qp of the frames with qp, or -1 if there is none.
+    float getAvgQp() const;
+
+    // Returns the smallest qp that is not exceeded by |percentile| percent of the frames with qp,
+    // or -1 if there is none.
+    int32_t getQpPercentile(int32_t percentile) const;
+
+    // Fills |info| with the statistics of the window.
+    void toEcoData(ECOData* info) const;
+
+private:
+    struct Frame {
+        int64_t mPtsUs;
+        int32_t mSizeBytes;
+        int32_t mAvgQp;
+        int8_t mFrameType;
+    };
+
+    void removeOldestFrame();
+
+    const int64_t mDurationUs;
+
+    // Frames in the order they were added.
+    std::deque<Frame> mFrames;
+
+    // Latest presentation time seen. Frames may be added out of presentation order, so the
+    // window ends at the latest time instead of at the time of the last frame.
+    int64_t mLatestPtsUs;
+
+    int64_t mTotalSizeBytes = 0;
+    int64_t mTotalQp = 0;
+    int32_t mNumOfQpFrames = 0;
+    int32_t mNumOfIFrames = 0;
+    int32_t mNumOfPFrames = 0;
+    int32_t mNumOfBFrames = 0;
+    std::array<int32_t, MAX_QP + 1> mQpHistogram;
+};
+
+}  // namespace eco
+}  // namespace media
+}  // namespace android
+
+#endif  // ANDROID_MEDIA_ECO_STATS_WINDOW_H_
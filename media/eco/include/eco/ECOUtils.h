@@ -82,7 +82,7 @@ struct SimpleEncoderConfig {
             mFrameRateFps(framerateFps) {}
 
     // Convert this SimpleEncoderConfig to ECOData with dataType.
-    ECOData toEcoData(ECOData::ECODatatype dataType);
+    ECOData toEcoData(ECOData::ECODatatype dataType) const;
 };
 
 // Helper structure for
@@ -118,7 +118,7 @@ struct SimpleEncodedFrameData {
             mFrameSizeBytes(sizeBytes) {}
 
     // Convert this SimpleEncoderConfig to ECOData with dataType.
-    ECOData toEcoData(ECOData::ECODatatype dataType);
+    ECOData toEcoData(ECOData::ECODatatype dataType) const;
 };
 
 bool copyKeyValue(const ECOData& src, ECOData* dst);
@@ -362,6 +362,113 @@ TEST(EcoDataTest, TestReadInvalidParcel) {
     EXPECT_TRUE(dstData->readFromParcel(parcel.get()) != NO_ERROR);
 }
 
+TEST(EcoDataTest, TestStandardKeyIds) {
+    EXPECT_EQ(ECOData::getKeyId(FRAME_AVG_QP), KEY_ID_FRAME_AVG_QP);
+    EXPECT_EQ(ECOData::getKeyId(KEY_STATS_TYPE), KEY_ID_STATS_TYPE);
+    EXPECT_EQ(ECOData::getKeyId("custom-key"), KEY_ID_UNKNOWN);
+    for (int32_t id = 0; id < KEY_ID_COUNT; ++id) {
+        const char* name = ECOData::getKeyName(static_cast<ECODataKeyId>(id));
+        ASSERT_TRUE(name != nullptr);
+        EXPECT_EQ(ECOData::getKeyId(name), id);
+    }
+    EXPECT_TRUE(ECOData::getKeyName(KEY_ID_UNKNOWN) == nullptr);
+    EXPECT_TRUE(ECOData::getKeyName(KEY_ID_COUNT) == nullptr);
+}
+
+TEST(EcoDataTest, TestSetAndFindMixedStandardKeys) {
+    ECOData data(ECOData::DATA_TYPE_STATS, 1000);
+    EXPECT_TRUE(data.setString(KEY_STATS_TYPE, VALUE_STATS_TYPE_FRAME) == ECODataStatus::OK);
+    EXPECT_TRUE(data.setInt32(FRAME_AVG_QP, 30) == ECODataStatus::OK);
+    EXPECT_TRUE(data.set(KEY_ID_FRAME_SIZE_BYTES, 4096) == ECODataStatus::OK);
+    EXPECT_TRUE(data.setInt32("custom-key", 7) == ECODataStatus::OK);
+    EXPECT_EQ(data.getNumOfEntries(), 4u);
+
+    // Standard keys can be found both by name and by id.
+    int32_t value32;
+    EXPECT_TRUE(data.findInt32(FRAME_SIZE_BYTES, &value32) == ECODataStatus::OK);
+    EXPECT_EQ(value32, 4096);
+    ECOData::ECODataValueType value;
+    EXPECT_TRUE(data.find(KEY_ID_FRAME_AVG_QP, &value) == ECODataStatus::OK);
+    EXPECT_EQ(std::get<int32_t>(value), 30);
+    EXPECT_TRUE(data.find(KEY_ID_FRAME_NUM, &value) == ECODataStatus::KEY_NOT_EXIST);
+    EXPECT_TRUE(data.set(KEY_ID_COUNT, 1) != ECODataStatus::OK);
+
+    // Overwriting a standard key does not add an entry.
+    EXPECT_TRUE(data.setInt32(FRAME_AVG_QP, 31) == ECODataStatus::OK);
+    EXPECT_EQ(data.getNumOfEntries(), 4u);
+
+    // The iterator visits the standard keys first, then the other keys.
+    ECODataKeyValueIterator iter(data);
+    std::vector<std::string> keys;
+    while (iter.hasNext()) {
+        keys.push_back(iter.next().first);
+        EXPECT_EQ(iter.keyId(), ECOData::getKeyId(keys.back()));
+    }
+    std::vector<std::string> expectedKeys = {KEY_STATS_TYPE, FRAME_AVG_QP, FRAME_SIZE_BYTES,
+                                             "custom-key"};
+    EXPECT_EQ(keys, expectedKeys);
+
+    // Writes and reads back the data.
+    Parcel parcel;
+    EXPECT_TRUE(data.writeToParcel(&parcel) == NO_ERROR);
+    parcel.setDataPosition(0);
+    ECOData dstData;
+    EXPECT_TRUE(dstData.readFromParcel(&parcel) == NO_ERROR);
+    EXPECT_EQ(dstData.getNumOfEntries(), 4u);
+    std::string valueStr;
+    EXPECT_TRUE(dstData.findString(KEY_STATS_TYPE, &valueStr) == ECODataStatus::OK);
+    EXPECT_EQ(valueStr, VALUE_STATS_TYPE_FRAME);
+    EXPECT_TRUE(dstData.findInt32(FRAME_AVG_QP, &value32) == ECODataStatus::OK);
+    EXPECT_EQ(value32, 31);
+    EXPECT_TRUE(dstData.findInt32(FRAME_SIZE_BYTES, &value32) == ECODataStatus::OK);
+    EXPECT_EQ(value32, 4096);
+    EXPECT_TRUE(dstData.findInt32("custom-key", &value32) == ECODataStatus::OK);
+    EXPECT_EQ(value32, 7);
+}
+
+TEST(EcoDataTest, TestStandardKeyIdsAreFrozen) {
+    // The ids are part of the parcel format and must never change.
+    static_assert(KEY_ID_ECO_DATA_TYPE == 0, "standard key ids are frozen");
+    static_assert(KEY_ID_FRAME_AVG_QP == 24, "standard key ids are frozen");
+    static_assert(KEY_ID_WINDOW_P90_QP == 38, "standard key ids are frozen");
+    EXPECT_STREQ(ECOData::getKeyName(KEY_ID_FRAME_AVG_QP), FRAME_AVG_QP);
+    EXPECT_STREQ(ECOData::getKeyName(KEY_ID_WINDOW_P90_QP), WINDOW_P90_QP);
+}
+
+TEST(EcoDataTest, TestReadParcelWithUnknownKeyId) {
+    // Writes a parcel as a newer version that knows two more standard keys would. Each tag holds
+    // the value type in the low 8 bits and the key id plus one above them.
+    auto tag = [](int32_t keyId, const ECOData::ECODataValueType& value) {
+        return ((keyId + 1) << 8) | static_cast<int32_t>(value.index());
+    };
+    Parcel parcel;
+    parcel.writeInt32(ECOData::DATA_TYPE_STATS);
+    parcel.writeInt64(1000);
+    parcel.writeUint32(4);
+    parcel.writeInt32(tag(KEY_ID_COUNT, std::string()));
+    parcel.writeCString("newer-value");
+    parcel.writeInt32(tag(KEY_ID_FRAME_AVG_QP, int32_t(0)));
+    parcel.writeInt32(30);
+    parcel.writeInt32(tag(KEY_ID_COUNT + 1, int64_t(0)));
+    parcel.writeInt64(1ll << 40);
+    parcel.writeInt32(tag(KEY_ID_UNKNOWN, int32_t(0)));
+    parcel.writeCString("custom-key");
+    parcel.writeInt32(7);
+    parcel.setDataPosition(0);
+
+    // The values of the unknown ids are skipped, the other entries are read.
+    ECOData data;
+    EXPECT_TRUE(data.readFromParcel(&parcel) == NO_ERROR);
+    EXPECT_EQ(data.getDataType(), ECOData::DATA_TYPE_STATS);
+    EXPECT_EQ(data.getDataTimeUs(), 1000);
+    EXPECT_EQ(data.getNumOfEntries(), 2u);
+    int32_t value32;
+    EXPECT_TRUE(data.findInt32(FRAME_AVG_QP, &value32) == ECODataStatus::OK);
+    EXPECT_EQ(value32, 30);
+    EXPECT_TRUE(data.findInt32("custom-key", &value32) == ECODataStatus::OK);
+    EXPECT_EQ(value32, 7);
+}
+
 }  // namespace eco
 }  // namespace media
-}  // namespace android
\ No newline at end of file
+}  // namespace android
@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit Test for ECOEncoderStatsProvider.
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ECOEncoderStatsProviderTest"
+
+#include <android/media/eco/BnECOSession.h>
+#include <gtest/gtest.h>
+#include <utils/Log.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "eco/ECODataKey.h"
+#include "eco/ECOEncoderStatsProvider.h"
+#include "eco/ECOServiceConstants.h"
+#include "eco/ECOUtils.h"
+
+namespace android {
+namespace media {
+namespace eco {
+
+using android::sp;
+using ::android::binder::Status;
+
+static constexpr char kProviderName[] = "c2.android.avc.encoder";
+static constexpr std::chrono::seconds kTimeout(5);
+
+/**
+ * A fake ECOSession whose pushNewStats blocks until the test opens its gate, standing in for a
+ * slow ECOService.
+ */
+class FakeSlowECOSession : public BnECOSession {
+public:
+    Status addStatsProvider(const sp<IECOServiceStatsProvider>& /*provider*/,
+                            const ECOData& /*config*/, bool* _aidl_return) override {
+        *_aidl_return = true;
+        return Status::ok();
+    }
+
+    Status removeStatsProvider(const sp<IECOServiceStatsProvider>& /*provider*/,
+                               bool* _aidl_return) override {
+        std::scoped_lock<std::mutex> lock(mLock);
+        mRemoved = true;
+        mCV.notify_all();
+        *_aidl_return = true;
+        return Status::ok();
+    }
+
+    Status addInfoListener(const sp<IECOServiceInfoListener>& /*listener*/,
+                           const ECOData& /*config*/, bool* _aidl_return) override {
+        *_aidl_return = false;
+        return Status::ok();
+    }
+
+    Status removeInfoListener(const sp<IECOServiceInfoListener>& /*listener*/,
+                              bool* _aidl_return) override {
+        *_aidl_return = false;
+        return Status::ok();
+    }
+
+    Status pushNewStats(const ECOData& newStats, bool* _aidl_return) override {
+        std::unique_lock<std::mutex> lock(mLock);
+        ++mNumBlocked;
+        mCV.notify_all();
+        mCV.wait(lock, [this] { return mGateOpen; });
+        --mNumBlocked;
+        mStats.push_back(newStats);
+        mCV.notify_all();
+        *_aidl_return = true;
+        return Status::ok();
+    }
+
+    Status getWidth(int32_t* _aidl_return) override {
+        *_aidl_return = 1280;
+        return Status::ok();
+    }
+
+    Status getHeight(int32_t* _aidl_return) override {
+        *_aidl_return = 720;
+        return Status::ok();
+    }
+
+    Status getIsCameraRecording(bool* _aidl_return) override {
+        *_aidl_return = true;
+        return Status::ok();
+    }
+
+    Status getNumOfListeners(int32_t* _aidl_return) override {
+        *_aidl_return = 0;
+        return Status::ok();
+    }
+
+    Status getNumOfProviders(int32_t* _aidl_return) override {
+        *_aidl_return = 1;
+        return Status::ok();
+    }
+
+    void openGate() {
+        std::scoped_lock<std::mutex> lock(mLock);
+        mGateOpen = true;
+        mCV.notify_all();
+    }
+
+    // Waits until a pushNewStats call is blocked at the gate.
+    bool waitForBlockedPush() {
+        std::unique_lock<std::mutex> lock(mLock);
+        return mCV.wait_for(lock, kTimeout, [this] { return mNumBlocked > 0; });
+    }
+
+    bool waitForStats(size_t numStats) {
+        std::unique_lock<std::mutex> lock(mLock);
+        return mCV.wait_for(lock, kTimeout, [this, numStats] { return mStats.size() >= numStats; });
+    }
+
+    bool waitForRemoved() {
+        std::unique_lock<std::mutex> lock(mLock);
+        return mCV.wait_for(lock, kTimeout, [this] { return mRemoved; });
+    }
+
+    std::vector<ECOData> getStats() {
+        std::scoped_lock<std::mutex> lock(mLock);
+        return mStats;
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCV;
+    bool mGateOpen = false;
+    bool mRemoved = false;
+    int32_t mNumBlocked = 0;
+    std::vector<ECOData> mStats;
+};
+
+class EcoEncoderStatsProviderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mSession = new FakeSlowECOSession();
+        mProvider = ECOEncoderStatsProvider::Create(kProviderName, mSession);
+        ASSERT_NE(nullptr, mProvider);
+    }
+
+    void TearDown() override {
+        mSession->openGate();
+        mProvider->release();
+        EXPECT_TRUE(mSession->waitForRemoved());
+    }
+
+    // Pushes session stats and waits until the push thread is stuck in the session.
+    void stallSession() {
+        SimpleEncoderConfig config(kProviderName, CodecTypeAVC, AVCProfileBaseline, AVCLevel31,
+                                   2000000 /* bitrate */, 30 /* kfi */, 30.0f /* framerateFps */);
+        ASSERT_TRUE(mProvider->pushSessionStats(config));
+        ASSERT_TRUE(mSession->waitForBlockedPush());
+    }
+
+    bool pushFrame(int32_t frameNum) {
+        SimpleEncodedFrameData frame(frameNum, FrameTypeP, frameNum * 33333 /* ptsUs */,
+                                     20 + frameNum % 10 /* qp */, 1000 /* sizeBytes */);
+        return mProvider->pushFrameStats(frame);
+    }
+
+    sp<FakeSlowECOSession> mSession;
+    sp<ECOEncoderStatsProvider> mProvider;
+};
+
+TEST_F(EcoEncoderStatsProviderTest, FrameStatsArePushedInOrder) {
+    mSession->openGate();
+    for (int32_t i = 0; i < 10; ++i) {
+        EXPECT_TRUE(pushFrame(i));
+    }
+    ASSERT_TRUE(mSession->waitForStats(10));
+
+    std::vector<ECOData> stats = mSession->getStats();
+    for (int32_t i = 0; i < 10; ++i) {
+        std::string statsType;
+        EXPECT_EQ(ECODataStatus::OK, stats[i].findString(KEY_STATS_TYPE, &statsType));
+        EXPECT_EQ(VALUE_STATS_TYPE_FRAME, statsType);
+        int32_t frameNum;
+        EXPECT_EQ(ECODataStatus::OK, stats[i].findInt32(FRAME_NUM, &frameNum));
+        EXPECT_EQ(i, frameNum);
+        int32_t qp;
+        EXPECT_EQ(ECODataStatus::OK, stats[i].findInt32(FRAME_AVG_QP, &qp));
+        EXPECT_EQ(20 + i % 10, qp);
+    }
+    EXPECT_EQ(0u, mProvider->getNumDroppedFrameStats());
+}
+
+TEST_F(EcoEncoderStatsProviderTest, PushDoesNotBlockOnSlowSession) {
+    stallSession();
+
+    // None of these would return if the pushes waited for the stalled session.
+    constexpr int32_t kNumFrames = 100;
+    for (int32_t i = 0; i < kNumFrames; ++i) {
+        EXPECT_TRUE(pushFrame(i));
+    }
+
+    // The queue keeps the newest frame stats and drops the oldest ones.
+    uint64_t numDropped = mProvider->getNumDroppedFrameStats();
+    EXPECT_GT(numDropped, 0u);
+    size_t numQueued = kNumFrames - numDropped;
+
+    mSession->openGate();
+    ASSERT_TRUE(mSession->waitForStats(1 + numQueued));
+    std::vector<ECOData> stats = mSession->getStats();
+    ASSERT_EQ(1 + numQueued, stats.size());
+    for (size_t i = 0; i < numQueued; ++i) {
+        int32_t frameNum;
+        EXPECT_EQ(ECODataStatus::OK, stats[1 + i].findInt32(FRAME_NUM, &frameNum));
+        EXPECT_EQ((int32_t)(numDropped + i), frameNum);
+    }
+}
+
+TEST_F(EcoEncoderStatsProviderTest, SessionStatsAreNotDropped) {
+    stallSession();
+
+    constexpr int32_t kNumConfigs = 50;
+    for (int32_t i = 0; i < kNumConfigs; ++i) {
+        SimpleEncoderConfig config(kProviderName, CodecTypeAVC, AVCProfileBaseline, AVCLevel31,
+                                   1000000 + i /* bitrate */, 30 /* kfi */,
+                                   30.0f /* framerateFps */);
+        EXPECT_TRUE(mProvider->pushSessionStats(config));
+        EXPECT_TRUE(pushFrame(i));
+    }
+
+    size_t numStats = 1 + kNumConfigs + kNumConfigs - mProvider->getNumDroppedFrameStats();
+    mSession->openGate();
+    ASSERT_TRUE(mSession->waitForStats(numStats));
+    int32_t numSessionStats = 0;
+    for (const ECOData& stats : mSession->getStats()) {
+        std::string statsType;
+        EXPECT_EQ(ECODataStatus::OK, stats.findString(KEY_STATS_TYPE, &statsType));
+        if (statsType == VALUE_STATS_TYPE_SESSION) {
+            ++numSessionStats;
+        }
+    }
+    EXPECT_EQ(1 + kNumConfigs, numSessionStats);
+}
+
+TEST_F(EcoEncoderStatsProviderTest, ReleaseDoesNotBlockOnSlowSession) {
+    stallSession();
+    EXPECT_TRUE(pushFrame(0));
+
+    mProvider->release();
+    // Nothing is queued after the release.
+    EXPECT_FALSE(pushFrame(1));
+
+    // The provider unregisters once the stalled push returns.
+    mSession->openGate();
+    EXPECT_TRUE(mSession->waitForRemoved());
+}
+
+}  // namespace eco
+}  // namespace media
+}  // namespace android
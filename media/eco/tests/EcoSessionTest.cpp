@@ -29,6 +29,9 @@
 #include <sys/mman.h>
 #include <utils/Log.h>
 
+#include <atomic>
+#include <thread>
+
 #include "FakeECOServiceInfoListener.h"
 #include "FakeECOServiceStatsProvider.h"
 #include "eco/ECOSession.h"
@@ -59,6 +62,9 @@ public:
         return mSession;
     }
 
+    // Holding the session lock stalls the session thread so that the stats pile up in the queue.
+    std::mutex& getSessionLock(const sp<ECOSession>& session) { return session->mSessionLock; }
+
 private:
     sp<ECOSession> mSession = nullptr;
 };
@@ -603,6 +609,333 @@ TEST_F(EcoSessionTest, TestAddListenerAferProviderStarts) {
     EXPECT_EQ(kfi, kKeyFrameIntervalFrames);
 }
 
+TEST_F(EcoSessionTest, TestStatsQueueDropOldestAndCoalesceFrameInfos) {
+    // The time that listener needs to wait for the info from ECOService.
+    static constexpr int kServiceWaitTimeMs = 10;
+
+    sp<ECOSession> ecoSession = createSession(kTestWidth, kTestHeight, kIsCameraRecording);
+    ecoSession->setStatsQueueLimit(4, ECOSession::QueueOverflowPolicy::DROP_OLDEST);
+
+    sp<FakeECOServiceInfoListener> fakeListener =
+            new FakeECOServiceInfoListener(kTestWidth, kTestHeight, kIsCameraRecording, ecoSession);
+    ECOData listenerConfig(ECOData::DATA_TYPE_INFO_LISTENER_CONFIG,
+                           systemTime(SYSTEM_TIME_BOOTTIME));
+    listenerConfig.setString(KEY_LISTENER_NAME, "FakeECOServiceInfoListener");
+    listenerConfig.setInt32(KEY_LISTENER_TYPE, ECOServiceInfoListener::INFO_LISTENER_TYPE_CAMERA);
+    listenerConfig.setInt32(KEY_LISTENER_QP_BLOCKINESS_THRESHOLD, 40);
+    listenerConfig.setInt32(KEY_LISTENER_QP_CHANGE_THRESHOLD, 5);
+    bool res;
+    ecoSession->addInfoListener(fakeListener, listenerConfig, &res);
+    EXPECT_TRUE(res);
+
+    std::vector<ECOData> infos;
+    fakeListener->setInfoAvailableCallback(
+            [&infos](const ::android::media::eco::ECOData& newInfo) { infos.push_back(newInfo); });
+
+    SimpleEncodedFrameData frameStats(1 /* seq number */, FrameTypeI, 0 /* framePtsUs */,
+                                      30 /* avg-qp */, 56 /* frameSize */);
+    ecoSession->pushNewStats(frameStats.toEcoData(ECOData::DATA_TYPE_STATS), &res);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kServiceWaitTimeMs));
+
+    {
+        std::scoped_lock<std::mutex> lock(getSessionLock(ecoSession));
+
+        // The session stats is taken by the session thread, which then stalls on the session
+        // lock.
+        SimpleEncoderConfig sessionEncoderConfig("google-avc", CodecTypeAVC, AVCProfileHigh,
+                                                 AVCLevel52, kTargetBitrateBps,
+                                                 kKeyFrameIntervalFrames, kFrameRate);
+        ecoSession->pushNewStats(sessionEncoderConfig.toEcoData(ECOData::DATA_TYPE_STATS), &res);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kServiceWaitTimeMs));
+        EXPECT_EQ(ecoSession->getStatsQueueDepth(), 0u);
+
+        // Every frame changes the qp by more than the threshold. Frame 2 and 3 are dropped.
+        for (int32_t frameNum = 2; frameNum <= 7; ++frameNum) {
+            SimpleEncodedFrameData frameStats(frameNum, FrameTypeP, frameNum * 33333,
+                                              frameNum % 2 ? 45 : 10 /* avg-qp */, 56);
+            ecoSession->pushNewStats(frameStats.toEcoData(ECOData::DATA_TYPE_STATS), &res);
+            EXPECT_TRUE(res);
+        }
+        EXPECT_EQ(ecoSession->getStatsQueueDepth(), 4u);
+        EXPECT_EQ(ecoSession->getMaxStatsQueueDepth(), 4u);
+        EXPECT_EQ(ecoSession->getNumOfDroppedStats(), 2u);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kServiceWaitTimeMs));
+    EXPECT_EQ(ecoSession->getStatsQueueDepth(), 0u);
+
+    // Frame 4 to 6 are superseded by frame 7 in the same batch.
+    ASSERT_EQ(infos.size(), 3u);
+    int32_t frameNum;
+    EXPECT_TRUE(infos[0].findInt32(FRAME_NUM, &frameNum) == ECODataStatus::OK);
+    EXPECT_EQ(frameNum, 1);
+    std::string infoType;
+    EXPECT_TRUE(infos[1].findString(KEY_INFO_TYPE, &infoType) == ECODataStatus::OK);
+    EXPECT_EQ(infoType, VALUE_INFO_TYPE_SESSION);
+    EXPECT_TRUE(infos[2].findInt32(FRAME_NUM, &frameNum) == ECODataStatus::OK);
+    EXPECT_EQ(frameNum, 7);
+    EXPECT_EQ(ecoSession->getNumOfCoalescedInfos(), 3u);
+}
+
+TEST_F(EcoSessionTest, TestStatsQueueDropFrameStatsKeepsSessionStats) {
+    // The time that ECOService needs to pick up the stats.
+    static constexpr int kServiceWaitTimeMs = 10;
+
+    sp<ECOSession> ecoSession = createSession(kTestWidth, kTestHeight, kIsCameraRecording);
+    ecoSession->setStatsQueueLimit(2, ECOSession::QueueOverflowPolicy::DROP_FRAME_STATS);
+
+    SimpleEncoderConfig sessionEncoderConfig("google-avc", CodecTypeAVC, AVCProfileHigh, AVCLevel52,
+                                             kTargetBitrateBps, kKeyFrameIntervalFrames,
+                                             kFrameRate);
+    ECOData sessionStats = sessionEncoderConfig.toEcoData(ECOData::DATA_TYPE_STATS);
+    ECOData frameStats = SimpleEncodedFrameData(1, FrameTypeI, 0, 30, 56)
+                                 .toEcoData(ECOData::DATA_TYPE_STATS);
+
+    std::scoped_lock<std::mutex> lock(getSessionLock(ecoSession));
+    bool res;
+    ecoSession->pushNewStats(frameStats, &res);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kServiceWaitTimeMs));
+
+    ecoSession->pushNewStats(sessionStats, &res);
+    EXPECT_TRUE(res);
+    ecoSession->pushNewStats(frameStats, &res);
+    EXPECT_TRUE(res);
+    EXPECT_EQ(ecoSession->getNumOfDroppedStats(), 0u);
+
+    // The queued frame stats is dropped in favor of the new stats.
+    ecoSession->pushNewStats(frameStats, &res);
+    EXPECT_TRUE(res);
+    EXPECT_EQ(ecoSession->getNumOfDroppedStats(), 1u);
+    ecoSession->pushNewStats(sessionStats, &res);
+    EXPECT_TRUE(res);
+    EXPECT_EQ(ecoSession->getNumOfDroppedStats(), 2u);
+
+    // The queue only holds session stats now, so the new frame stats is dropped.
+    ecoSession->pushNewStats(frameStats, &res);
+    EXPECT_FALSE(res);
+    EXPECT_EQ(ecoSession->getNumOfDroppedStats(), 3u);
+    EXPECT_EQ(ecoSession->getStatsQueueDepth(), 2u);
+}
+
+TEST_F(EcoSessionTest, TestStatsQueueBlockProvider) {
+    // The time that ECOService needs to pick up the stats.
+    static constexpr int kServiceWaitTimeMs = 10;
+
+    sp<ECOSession> ecoSession = createSession(kTestWidth, kTestHeight, kIsCameraRecording);
+    ecoSession->setStatsQueueLimit(1, ECOSession::QueueOverflowPolicy::BLOCK_PROVIDER);
+
+    ECOData frameStats = SimpleEncodedFrameData(1, FrameTypeI, 0, 30, 56)
+                                 .toEcoData(ECOData::DATA_TYPE_STATS);
+    std::atomic<bool> pushed(false);
+    std::thread provider;
+    {
+        std::scoped_lock<std::mutex> lock(getSessionLock(ecoSession));
+        bool res;
+        ecoSession->pushNewStats(frameStats, &res);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kServiceWaitTimeMs));
+        ecoSession->pushNewStats(frameStats, &res);
+        EXPECT_EQ(ecoSession->getStatsQueueDepth(), 1u);
+
+        provider = std::thread([&ecoSession, &frameStats, &pushed] {
+            bool res;
+            ecoSession->pushNewStats(frameStats, &res);
+            pushed = res;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(kServiceWaitTimeMs));
+        EXPECT_FALSE(pushed);
+    }
+
+    // The provider is unblocked once the session thread drains the queue.
+    provider.join();
+    EXPECT_TRUE(pushed);
+    EXPECT_EQ(ecoSession->getNumOfDroppedStats(), 0u);
+}
+
+TEST_F(EcoSessionTest, TestMultipleListenersWithDifferentQpConditions) {
+    // The time that listener needs to wait for the info from ECOService.
+    static constexpr int kServiceWaitTimeMs = 10;
+
+    sp<ECOSession> ecoSession = createSession(kTestWidth, kTestHeight, kIsCameraRecording);
+
+    // Listener 1 is notified on small qp changes. Listener 2 only on crossing qp 40.
+    const int32_t kQpChangeThresholds[] = {5, 50};
+    sp<FakeECOServiceInfoListener> fakeListeners[2];
+    std::vector<int32_t> reportedFrames[2];
+    for (int i = 0; i < 2; ++i) {
+        fakeListeners[i] = new FakeECOServiceInfoListener(kTestWidth, kTestHeight,
+                                                          kIsCameraRecording, ecoSession);
+        fakeListeners[i]->setInfoAvailableCallback(
+                [&reportedFrames, i](const ::android::media::eco::ECOData& newInfo) {
+                    int32_t frameNum;
+                    if (newInfo.findInt32(FRAME_NUM, &frameNum) == ECODataStatus::OK) {
+                        reportedFrames[i].push_back(frameNum);
+                    }
+                });
+
+        ECOData listenerConfig(ECOData::DATA_TYPE_INFO_LISTENER_CONFIG,
+                               systemTime(SYSTEM_TIME_BOOTTIME));
+        listenerConfig.setString(KEY_LISTENER_NAME, "FakeECOServiceInfoListener");
+        listenerConfig.setInt32(KEY_LISTENER_TYPE,
+                                ECOServiceInfoListener::INFO_LISTENER_TYPE_CAMERA);
+        listenerConfig.setInt32(KEY_LISTENER_QP_BLOCKINESS_THRESHOLD, 40);
+        listenerConfig.setInt32(KEY_LISTENER_QP_CHANGE_THRESHOLD, kQpChangeThresholds[i]);
+        bool res;
+        ecoSession->addInfoListener(fakeListeners[i], listenerConfig, &res);
+        EXPECT_TRUE(res);
+    }
+
+    int32_t numListeners;
+    ecoSession->getNumOfListeners(&numListeners);
+    EXPECT_EQ(numListeners, 2);
+
+    // Adding the same listener again fails.
+    ECOData listenerConfig(ECOData::DATA_TYPE_INFO_LISTENER_CONFIG,
+                           systemTime(SYSTEM_TIME_BOOTTIME));
+    listenerConfig.setInt32(KEY_LISTENER_QP_BLOCKINESS_THRESHOLD, 40);
+    listenerConfig.setInt32(KEY_LISTENER_QP_CHANGE_THRESHOLD, 5);
+    bool res;
+    ecoSession->addInfoListener(fakeListeners[0], listenerConfig, &res);
+    EXPECT_FALSE(res);
+
+    const int32_t kFrameQps[] = {30, 36, 45, 47, 30};
+    for (int32_t frameNum = 1; frameNum <= 5; ++frameNum) {
+        SimpleEncodedFrameData frameStats(frameNum, FrameTypeP, frameNum * 33333,
+                                          kFrameQps[frameNum - 1], 56 /* frameSize */);
+        ecoSession->pushNewStats(frameStats.toEcoData(ECOData::DATA_TYPE_STATS), &res);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kServiceWaitTimeMs));
+    }
+
+    EXPECT_EQ(reportedFrames[0], std::vector<int32_t>({1, 2, 3, 5}));
+    EXPECT_EQ(reportedFrames[1], std::vector<int32_t>({3, 5}));
+
+    // Removing one listener does not affect the other.
+    ecoSession->removeInfoListener(fakeListeners[1], &res);
+    EXPECT_TRUE(res);
+    ecoSession->getNumOfListeners(&numListeners);
+    EXPECT_EQ(numListeners, 1);
+
+    SimpleEncodedFrameData frameStats(6, FrameTypeP, 6 * 33333, 45 /* avg-qp */, 56);
+    ecoSession->pushNewStats(frameStats.toEcoData(ECOData::DATA_TYPE_STATS), &res);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kServiceWaitTimeMs));
+    EXPECT_EQ(reportedFrames[0], std::vector<int32_t>({1, 2, 3, 5, 6}));
+    EXPECT_EQ(reportedFrames[1], std::vector<int32_t>({3, 5}));
+}
+
+TEST_F(EcoSessionTest, TestSlowListenerDoesNotDelayOtherListeners) {
+    // The time that listener needs to wait for the info from ECOService.
+    static constexpr int kServiceWaitTimeMs = 10;
+    // The time that the slow listener takes to handle an info.
+    static constexpr int kSlowListenerTimeMs = 200;
+
+    sp<ECOSession> ecoSession = createSession(kTestWidth, kTestHeight, kIsCameraRecording);
+
+    std::atomic<int> numInfos[2] = {0, 0};
+    sp<FakeECOServiceInfoListener> fakeListeners[2];
+    for (int i = 0; i < 2; ++i) {
+        fakeListeners[i] = new FakeECOServiceInfoListener(kTestWidth, kTestHeight,
+                                                          kIsCameraRecording, ecoSession);
+        fakeListeners[i]->setInfoAvailableCallback(
+                [&numInfos, i](const ::android::media::eco::ECOData& /*newInfo*/) {
+                    if (i == 0) {
+                        std::this_thread::sleep_for(
+                                std::chrono::milliseconds(kSlowListenerTimeMs));
+                    }
+                    ++numInfos[i];
+                });
+
+        ECOData listenerConfig(ECOData::DATA_TYPE_INFO_LISTENER_CONFIG,
+                               systemTime(SYSTEM_TIME_BOOTTIME));
+        listenerConfig.setInt32(KEY_LISTENER_QP_BLOCKINESS_THRESHOLD, 40);
+        listenerConfig.setInt32(KEY_LISTENER_QP_CHANGE_THRESHOLD, 5);
+        bool res;
+        ecoSession->addInfoListener(fakeListeners[i], listenerConfig, &res);
+        EXPECT_TRUE(res);
+    }
+
+    // Every frame changes the qp by more than the threshold.
+    bool res;
+    for (int32_t frameNum = 1; frameNum <= 3; ++frameNum) {
+        SimpleEncodedFrameData frameStats(frameNum, FrameTypeP, frameNum * 33333,
+                                          frameNum % 2 ? 45 : 10 /* avg-qp */, 56);
+        ecoSession->pushNewStats(frameStats.toEcoData(ECOData::DATA_TYPE_STATS), &res);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kServiceWaitTimeMs));
+    }
+
+    // The fast listener got all the infos while the slow one is still handling the first one.
+    EXPECT_EQ(numInfos[1], 3);
+    EXPECT_EQ(numInfos[0], 0);
+
+    // The frame infos that the slow listener has not got yet are superseded by the latest one.
+    const uint64_t numCoalescedInfos = ecoSession->getNumOfCoalescedInfos();
+    EXPECT_GE(numCoalescedInfos, 1u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(kSlowListenerTimeMs * 3));
+    EXPECT_EQ(numInfos[0], 3 - static_cast<int>(numCoalescedInfos));
+}
+
+TEST_F(EcoSessionTest, TestListenerWithWindowCondition) {
+    // The time that listener needs to wait for the info from ECOService.
+    static constexpr int kServiceWaitTimeMs = 10;
+    static constexpr int64_t kFrameDurationUs = 100000;  // 10 fps
+
+    sp<ECOSession> ecoSession = createSession(kTestWidth, kTestHeight, kIsCameraRecording);
+
+    sp<FakeECOServiceInfoListener> fakeListener =
+            new FakeECOServiceInfoListener(kTestWidth, kTestHeight, kIsCameraRecording, ecoSession);
+    std::vector<ECOData> infos;
+    fakeListener->setInfoAvailableCallback(
+            [&infos](const ::android::media::eco::ECOData& newInfo) { infos.push_back(newInfo); });
+
+    // Only one of the qp thresholds is not a valid condition.
+    ECOData listenerConfig(ECOData::DATA_TYPE_INFO_LISTENER_CONFIG,
+                           systemTime(SYSTEM_TIME_BOOTTIME));
+    listenerConfig.setString(KEY_LISTENER_NAME, "FakeECOServiceInfoListener");
+    listenerConfig.setInt32(KEY_LISTENER_QP_CHANGE_THRESHOLD, 5);
+    bool res;
+    ecoSession->addInfoListener(fakeListener, listenerConfig, &res);
+    EXPECT_FALSE(res);
+
+    // Get notified when the bitrate over the last second crosses 100 kbps.
+    listenerConfig = ECOData(ECOData::DATA_TYPE_INFO_LISTENER_CONFIG,
+                             systemTime(SYSTEM_TIME_BOOTTIME));
+    listenerConfig.setString(KEY_LISTENER_NAME, "FakeECOServiceInfoListener");
+    listenerConfig.setInt64(KEY_LISTENER_WINDOW_US, 1000000);
+    listenerConfig.setInt32(KEY_LISTENER_WINDOW_BITRATE_THRESHOLD_BPS, 100000);
+    ecoSession->addInfoListener(fakeListener, listenerConfig, &res);
+    EXPECT_TRUE(res);
+
+    // 1000 bytes per frame is 80 kbps. The qp changes do not matter to this listener.
+    int32_t frameNum = 0;
+    auto pushFrames = [&](int numFrames, int32_t sizeBytes) {
+        for (int i = 0; i < numFrames; ++i, ++frameNum) {
+            SimpleEncodedFrameData frameStats(frameNum, FrameTypeP, frameNum * kFrameDurationUs,
+                                              frameNum % 2 ? 45 : 10 /* avg-qp */, sizeBytes);
+            ecoSession->pushNewStats(frameStats.toEcoData(ECOData::DATA_TYPE_STATS), &res);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(kServiceWaitTimeMs));
+    };
+    pushFrames(20, 1000);
+    EXPECT_EQ(infos.size(), 0u);
+
+    // The bitrate goes beyond 100 kbps on the 3rd frame of 2000 bytes and stays there.
+    pushFrames(20, 2000);
+    ASSERT_EQ(infos.size(), 1u);
+    std::string infoType;
+    EXPECT_TRUE(infos[0].findString(KEY_INFO_TYPE, &infoType) == ECODataStatus::OK);
+    EXPECT_EQ(infoType, VALUE_INFO_TYPE_WINDOW);
+    int64_t ptsUs;
+    EXPECT_TRUE(infos[0].findInt64(FRAME_PTS_US, &ptsUs) == ECODataStatus::OK);
+    EXPECT_EQ(ptsUs, 22 * kFrameDurationUs);
+    int32_t bitrate;
+    EXPECT_TRUE(infos[0].findInt32(WINDOW_BITRATE_BPS, &bitrate) == ECODataStatus::OK);
+    EXPECT_EQ(bitrate, 104000);
+
+    // The bitrate falls back below 100 kbps.
+    pushFrames(20, 1000);
+    ASSERT_EQ(infos.size(), 2u);
+    EXPECT_TRUE(infos[1].findInt32(WINDOW_BITRATE_BPS, &bitrate) == ECODataStatus::OK);
+    EXPECT_LE(bitrate, 100000);
+}
+
 }  // namespace eco
 }  // namespace media
 }  // namespace android
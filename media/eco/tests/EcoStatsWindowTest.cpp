@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Unit Test for ECOStatsWindow.
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ECOStatsWindowTest"
+
+#include <gtest/gtest.h>
+#include <utils/Log.h>
+
+#include "eco/ECODataKey.h"
+#include "eco/ECOServiceConstants.h"
+#include "eco/ECOStatsWindow.h"
+
+namespace android {
+namespace media {
+namespace eco {
+
+static constexpr int64_t kWindowUs = 1000000;
+static constexpr int64_t kFrameDurationUs = 100000;  // 10 fps
+
+TEST(EcoStatsWindowTest, TestEmptyWindow) {
+    ECOStatsWindow window(kWindowUs);
+    EXPECT_EQ(window.getDurationUs(), kWindowUs);
+    EXPECT_EQ(window.getNumOfFrames(), 0);
+    EXPECT_EQ(window.getBitrateBps(), 0);
+    EXPECT_EQ(window.getAvgFrameSizeBytes(), 0);
+    EXPECT_EQ(window.getAvgQp(), -1.0f);
+    EXPECT_EQ(window.getQpPercentile(90), -1);
+}
+
+TEST(EcoStatsWindowTest, TestFramesLeaveWindow) {
+    ECOStatsWindow window(kWindowUs);
+
+    // 10 frames of 1000 bytes fill the window: 80000 bits per second.
+    for (int i = 0; i < 10; ++i) {
+        window.addFrame(i * kFrameDurationUs, 1000, 30, i == 0 ? FrameTypeI : FrameTypeP);
+    }
+    EXPECT_EQ(window.getNumOfFrames(), 10);
+    EXPECT_EQ(window.getNumOfFrames(FrameTypeI), 1);
+    EXPECT_EQ(window.getNumOfFrames(FrameTypeP), 9);
+    EXPECT_EQ(window.getBitrateBps(), 80000);
+    EXPECT_EQ(window.getAvgFrameSizeBytes(), 1000);
+    EXPECT_FLOAT_EQ(window.getAvgQp(), 30.0f);
+
+    // The I frame leaves the window when the 11th frame comes in.
+    window.addFrame(10 * kFrameDurationUs, 3000, 40, FrameTypeP);
+    EXPECT_EQ(window.getNumOfFrames(), 10);
+    EXPECT_EQ(window.getNumOfFrames(FrameTypeI), 0);
+    EXPECT_EQ(window.getNumOfFrames(FrameTypeP), 10);
+    EXPECT_EQ(window.getBitrateBps(), 96000);
+    EXPECT_EQ(window.getAvgFrameSizeBytes(), 1200);
+    EXPECT_FLOAT_EQ(window.getAvgQp(), 31.0f);
+
+    // A gap in the presentation time empties the window except for the new frame.
+    window.addFrame(30 * kFrameDurationUs, 500, -1, FrameTypeB);
+    EXPECT_EQ(window.getNumOfFrames(), 1);
+    EXPECT_EQ(window.getNumOfFrames(FrameTypeB), 1);
+    EXPECT_EQ(window.getBitrateBps(), 4000);
+    EXPECT_EQ(window.getAvgQp(), -1.0f);
+}
+
+TEST(EcoStatsWindowTest, TestOutOfOrderFrames) {
+    ECOStatsWindow window(kWindowUs);
+
+    // Frames in decoding order I0 P2 B1 P4 B3 ...
+    window.addFrame(0, 100, 20, FrameTypeI);
+    for (int i = 2; i <= 20; i += 2) {
+        window.addFrame(i * kFrameDurationUs, 100, 20, FrameTypeP);
+        window.addFrame((i - 1) * kFrameDurationUs, 100, 20, FrameTypeB);
+    }
+
+    // The window ends at the latest presentation time, 2000 ms.
+    EXPECT_EQ(window.getNumOfFrames(), 10);
+    EXPECT_EQ(window.getNumOfFrames(FrameTypeI), 0);
+    EXPECT_EQ(window.getNumOfFrames(FrameTypeP), 5);
+    EXPECT_EQ(window.getNumOfFrames(FrameTypeB), 5);
+}
+
+TEST(EcoStatsWindowTest, TestQpPercentile) {
+    ECOStatsWindow window(kWindowUs);
+
+    for (int i = 0; i < 10; ++i) {
+        window.addFrame(i * kFrameDurationUs, 100, i + 1 /* qp 1 to 10 */, FrameTypeP);
+    }
+    EXPECT_EQ(window.getQpPercentile(0), 1);
+    EXPECT_EQ(window.getQpPercentile(50), 5);
+    EXPECT_EQ(window.getQpPercentile(90), 9);
+    EXPECT_EQ(window.getQpPercentile(91), 10);
+    EXPECT_EQ(window.getQpPercentile(100), 10);
+
+    // qp beyond the range is clamped.
+    window.addFrame(10 * kFrameDurationUs, 100, 200, FrameTypeP);
+    EXPECT_EQ(window.getQpPercentile(100), ECOStatsWindow::MAX_QP);
+}
+
+TEST(EcoStatsWindowTest, TestToEcoData) {
+    ECOStatsWindow window(kWindowUs);
+    window.addFrame(0, 1000, 30, FrameTypeI);
+    window.addFrame(kFrameDurationUs, 500, 40, FrameTypeP);
+
+    ECOData info(ECOData::DATA_TYPE_INFO);
+    window.toEcoData(&info);
+
+    int64_t durationUs;
+    EXPECT_TRUE(info.findInt64(WINDOW_DURATION_US, &durationUs) == ECODataStatus::OK);
+    EXPECT_EQ(durationUs, kWindowUs);
+
+    int32_t value;
+    EXPECT_TRUE(info.findInt32(WINDOW_NUM_FRAMES, &value) == ECODataStatus::OK);
+    EXPECT_EQ(value, 2);
+    EXPECT_TRUE(info.findInt32(WINDOW_NUM_I_FRAMES, &value) == ECODataStatus::OK);
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(info.findInt32(WINDOW_NUM_P_FRAMES, &value) == ECODataStatus::OK);
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(info.findInt32(WINDOW_BITRATE_BPS, &value) == ECODataStatus::OK);
+    EXPECT_EQ(value, 12000);
+    EXPECT_TRUE(info.findInt32(WINDOW_AVG_FRAME_SIZE_BYTES, &value) == ECODataStatus::OK);
+    EXPECT_EQ(value, 750);
+    EXPECT_TRUE(info.findInt32(WINDOW_P90_QP, &value) == ECODataStatus::OK);
+    EXPECT_EQ(value, 40);
+
+    float avgQp;
+    EXPECT_TRUE(info.findFloat(WINDOW_AVG_QP, &avgQp) == ECODataStatus::OK);
+    EXPECT_FLOAT_EQ(avgQp, 35.0f);
+}
+
+}  // namespace eco
+}  // namespace media
+}  // namespace android
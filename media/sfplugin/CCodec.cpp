@@ -1583,29 +1583,38 @@ void CCodec::onMessageReceived(const sp<AMessage> &msg) {
                     && (work->worklets.front()->output.flags
                             & C2FrameData::FLAG_DISCARD_FRAME) == 0) {
 
-                // copy buffer info to config
-                std::vector<std::unique_ptr<C2Param>> updates =
-                    std::move(work->worklets.front()->output.configUpdate);
+                // copy buffer info to config. Per-frame copies are made in the update arena, and
+                // the config only copies params whose size changed.
+                std::vector<C2Param*> updates;
+                for (const std::unique_ptr<C2Param> &param :
+                        work->worklets.front()->output.configUpdate) {
+                    updates.push_back(param.get());
+                }
                 unsigned stream = 0;
                 for (const std::shared_ptr<C2Buffer> &buf : work->worklets.front()->output.buffers) {
                     for (const std::shared_ptr<const C2Info> &info : buf->info()) {
                         // move all info into output-stream #0 domain
-                        updates.emplace_back(C2Param::CopyAsStream(*info, true /* output */, stream));
+                        updates.push_back(mConfigUpdateArena.copyAsStream(
+                                *info, true /* output */, stream));
                     }
                     for (const C2ConstGraphicBlock &block : buf->data().graphicBlocks()) {
                         // ALOGV("got output buffer with crop %u,%u+%u,%u and size %u,%u",
                         //      block.crop().left, block.crop().top,
                         //      block.crop().width, block.crop().height,
                         //      block.width(), block.height());
-                        updates.emplace_back(new C2StreamCropRectInfo::output(stream, block.crop()));
-                        updates.emplace_back(new C2StreamPictureSizeInfo::output(
-                                stream, block.width(), block.height()));
+                        updates.push_back(mConfigUpdateArena.emplace<C2StreamCropRectInfo::output>(
+                                stream, block.crop()));
+                        updates.push_back(
+                                mConfigUpdateArena.emplace<C2StreamPictureSizeInfo::output>(
+                                        stream, block.width(), block.height()));
                         break; // for now only do the first block
                     }
                     ++stream;
                 }
 
                 changed = config->updateConfiguration(updates, config->mOutputDomain);
+                mConfigUpdateArena.clear();
+                work->worklets.front()->output.configUpdate.clear();
 
                 // copy standard infos to graphic buffers if not already present (otherwise, we
                 // may overwrite the actual intermediate value with a final value)
@@ -24,6 +24,7 @@
 
 #include <C2Component.h>
 #include <codec2/hidl/client.h>
+#include <util/C2ParamUtils.h>
 
 #include <android/native_window.h>
 #include <media/hardware/MetadataBufferType.h>
@@ -174,6 +175,8 @@ private:
     Mutexed<Config> mConfig;
     Mutexed<std::list<std::unique_ptr<C2Work>>> mWorkDoneQueue;
     Mutexed<std::list<size_t>> mNumDiscardedInputBuffersQueue;
+    // scratch storage for config updates of finished work; only used on the looper thread
+    C2ParamArena mConfigUpdateArena;
 
     friend class CCodecCallbackImpl;
 
@@ -528,6 +528,31 @@ void CCodecConfig::initializeStandardParams() {
             return C2Value();
         }));
     add(ConfigMapper(KEY_QUALITY, C2_PARAMKEY_QUALITY, "value"));
+    add(ConfigMapper("android._eco-stats", C2_PARAMKEY_ECO_STATS, "enabled")
+        .limitTo(D::ENCODER & D::VIDEO & D::CONFIG));
+    add(ConfigMapper("android._eco-stats-camera-recording",
+                     C2_PARAMKEY_ECO_STATS, "camera-recording")
+        .limitTo(D::ENCODER & D::VIDEO & D::CONFIG));
+    add(ConfigMapper("android._encoder-threads", C2_PARAMKEY_ENCODER_THREADING, "threads")
+        .limitTo(D::ENCODER & D::VIDEO & D::CONFIG));
+    add(ConfigMapper("android._tile-columns", C2_PARAMKEY_ENCODER_THREADING, "tile-columns")
+        .limitTo(D::ENCODER & D::VIDEO & D::CONFIG));
+    add(ConfigMapper("android._tile-rows", C2_PARAMKEY_ENCODER_THREADING, "tile-rows")
+        .limitTo(D::ENCODER & D::VIDEO & D::CONFIG));
+    add(ConfigMapper("android._row-mt", C2_PARAMKEY_ENCODER_THREADING, "row-mt")
+        .limitTo(D::ENCODER & D::VIDEO & D::CONFIG));
+    add(ConfigMapper("android._encoder-speed", C2_PARAMKEY_ENCODER_SPEED, "value")
+        .limitTo(D::ENCODER & D::VIDEO & D::CONFIG));
+    add(ConfigMapper("android._shared-output-buffers", C2_PARAMKEY_OUTPUT_SHARED_BUFFERS, "value")
+        .limitTo(D::DECODER & D::VIDEO & D::CONFIG));
+    add(ConfigMapper("android._max-worker-threads", C2_PARAMKEY_WORKER_THREADS, "max-count")
+        .limitTo(D::VIDEO & (D::CONFIG | D::PARAM)));
+    add(ConfigMapper("android._worker-cpu-mask", C2_PARAMKEY_WORKER_THREADS, "cpu-mask")
+        .limitTo(D::VIDEO & (D::CONFIG | D::PARAM)));
+    add(ConfigMapper("low-latency", C2_PARAMKEY_LOW_LATENCY_MODE, "value")
+        .limitTo(D::DECODER & D::VIDEO & (D::CONFIG | D::PARAM)));
+    add(ConfigMapper("android._key-frames-only", C2_PARAMKEY_KEY_FRAMES_ONLY, "value")
+        .limitTo(D::DECODER & D::VIDEO & (D::CONFIG | D::PARAM)));
     deprecated(ConfigMapper(PARAMETER_KEY_REQUEST_SYNC_FRAME,
                      "coding.request-sync", "value")
         .limitTo(D::PARAM & D::ENCODER)
@@ -1014,6 +1039,38 @@ bool CCodecConfig::updateConfiguration(
     return false;
 }
 
+bool CCodecConfig::updateConfiguration(
+        const std::vector<C2Param*> &configUpdate, Domain domain) {
+    ALOGV("updating configuration with %zu params", configUpdate.size());
+    bool changed = false;
+    for (C2Param *p : configUpdate) {
+        if (p && *p) {
+            auto insertion = mCurrentConfig.emplace(p->index(), nullptr);
+            if (insertion.second || *insertion.first->second != *p) {
+                if (mSupportedIndices.count(p->index()) || mLocalParams.count(p->index())) {
+                    // only track changes in supported (reflected or local) indices
+                    changed = true;
+                } else {
+                    ALOGV("an unlisted config was %s: %#x",
+                            insertion.second ? "added" : "updated", p->index());
+                }
+                // update in place unless the size differs
+                std::unique_ptr<C2Param> &value = insertion.first->second;
+                if (!value || value->size() != p->size() || !value->updateFrom(*p)) {
+                    value = C2Param::Copy(*p);
+                }
+            }
+        }
+    }
+
+    ALOGV("updated configuration has %zu params (%s)", mCurrentConfig.size(),
+            changed ? "CHANGED" : "no change");
+    if (changed) {
+        return updateFormats(domain);
+    }
+    return false;
+}
+
 bool CCodecConfig::updateFormats(Domain domain) {
     // get addresses of params in the current config
     std::vector<C2Param*> paramPointers;
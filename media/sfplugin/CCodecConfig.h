@@ -223,6 +223,13 @@ struct CCodecConfig {
     bool updateConfiguration(
             std::vector<std::unique_ptr<C2Param>> &configUpdate, Domain domain);
 
+    /// Applies configuration updates, and updates format in the specific domain. This version
+    /// does not take ownership of the updates, and only copies params that changed in size.
+    /// Returns true if formats were updated
+    /// \param domain input/output bitmask
+    bool updateConfiguration(
+            const std::vector<C2Param*> &configUpdate, Domain domain);
+
     /// Updates formats in the specific domain. Returns true if any of the formats have changed.
     /// \param domain input/output bitmask
     bool updateFormats(Domain domain);
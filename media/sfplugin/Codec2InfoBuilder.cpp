@@ -18,7 +18,16 @@
 #define LOG_TAG "Codec2InfoBuilder"
 #include <log/log.h>
 
+#include <dirent.h>
+#include <string.h>
 #include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <thread>
 
 #include <C2Component.h>
 #include <C2Config.h>
@@ -50,6 +59,7 @@
 #include <media/stagefright/xmlparser/MediaCodecsXmlParser.h>
 
 #include "Codec2InfoBuilder.h"
+#include "Codec2InfoCache.h"
 
 namespace android {
 
@@ -73,9 +83,105 @@ constexpr OMX_U32 kPortIndexInput = 0;
 constexpr OMX_U32 kPortIndexOutput = 1;
 constexpr OMX_U32 kMaxIndicesToCheck = 32;
 
+void writeCodecRecords(
+        const std::vector<CodecRecord>& records,
+        MediaCodecListWriter* writer) {
+    for (const CodecRecord& record : records) {
+        std::unique_ptr<MediaCodecInfoWriter> info = writer->addMediaCodecInfo();
+        info->setName(record.name.c_str());
+        info->setOwner(record.owner.c_str());
+        info->setAttributes(record.attrs);
+        info->setRank(record.rank);
+        for (const std::string& alias : record.aliases) {
+            info->addAlias(alias.c_str());
+        }
+        for (const MediaTypeRecord& type : record.mediaTypes) {
+            std::unique_ptr<MediaCodecInfo::CapabilitiesWriter> caps =
+                    info->addMediaType(type.mediaType.c_str());
+            for (const MediaTypeRecord::Detail& detail : type.details) {
+                if (detail.isInt) {
+                    caps->addDetail(detail.key.c_str(), detail.intValue);
+                } else {
+                    caps->addDetail(detail.key.c_str(), detail.stringValue.c_str());
+                }
+            }
+            for (const std::pair<uint32_t, uint32_t>& pl : type.profileLevels) {
+                caps->addProfileLevel(pl.first, pl.second);
+            }
+            for (uint32_t colorFormat : type.colorFormats) {
+                caps->addColorFormat(colorFormat);
+            }
+        }
+    }
+}
+
+// Codec info cache
+// ================
+//
+// The codec list is persisted to kCacheFile along with a key describing
+// everything the list was derived from: the run-time options, the system
+// properties in kCacheKeyProperties, the traits of all Codec2 components and
+// the modification times and sizes of the codec XML files. The cache is used
+// only if the stored key matches exactly.
+
+constexpr char kCacheFile[] = "/data/misc/media/codec2_info.cache";
+
+// System properties that affect the codec records. Any property read while
+// building the records must be listed here.
+constexpr const char* kCacheKeyProperties[] = {
+    // These change whenever codec libraries are updated.
+    "ro.build.fingerprint",
+    "ro.vendor.build.fingerprint",
+    // Rank of the OMX codecs (see buildOmxInfo()).
+    "debug.stagefright.omx_default_rank",
+};
+
+// Directories searched by MediaCodecsXmlParser.
+constexpr const char* kXmlSearchDirs[] = { "/odm/etc", "/vendor/etc", "/etc" };
+
+// Maximum number of threads used to query Codec2 components.
+constexpr size_t kMaxQueryThreads = 8;
+
+std::string getCacheKey(
+        int option, bool surfaceTest, const std::vector<Traits>& traits) {
+    std::ostringstream key;
+    key << "option=" << option << ";surface=" << surfaceTest << ";";
+    for (const char* property : kCacheKeyProperties) {
+        key << property << "=" << ::android::base::GetProperty(property, "") << ";";
+    }
+    for (const Traits& trait : traits) {
+        key << "trait=" << trait.name << "," << trait.owner << ","
+            << trait.mediaType << "," << trait.rank << ","
+            << trait.domain << "," << trait.kind << ";";
+    }
+    for (const char* dir : kXmlSearchDirs) {
+        DIR* d = opendir(dir);
+        if (d == nullptr) {
+            continue;
+        }
+        std::vector<std::string> files;
+        while (struct dirent* entry = readdir(d)) {
+            std::string file = entry->d_name;
+            if (hasPrefix(file, "media_codecs") && hasSuffix(file, ".xml")) {
+                files.push_back(file);
+            }
+        }
+        closedir(d);
+        std::sort(files.begin(), files.end());
+        for (const std::string& file : files) {
+            std::string path = std::string(dir) + "/" + file;
+            struct stat st;
+            if (stat(path.c_str(), &st) == 0) {
+                key << "xml=" << path << "," << st.st_mtime << "," << st.st_size << ";";
+            }
+        }
+    }
+    return key.str();
+}
+
 status_t queryOmxCapabilities(
         const char* name, const char* mediaType, bool isEncoder,
-        MediaCodecInfo::CapabilitiesWriter* caps) {
+        MediaTypeRecord* caps) {
 
     const char *role = GetComponentRole(isEncoder, mediaType);
     if (role == nullptr) {
@@ -257,7 +363,7 @@ status_t queryOmxCapabilities(
 }
 
 void buildOmxInfo(const MediaCodecsXmlParser& parser,
-                  MediaCodecListWriter* writer) {
+                  std::vector<CodecRecord>* records) {
     uint32_t omxRank = ::android::base::GetUintProperty(
             "debug.stagefright.omx_default_rank", uint32_t(0x100));
     for (const MediaCodecsXmlParser::Codec& codec : parser.getCodecMap()) {
@@ -267,11 +373,11 @@ void buildOmxInfo(const MediaCodecsXmlParser& parser,
         }
         const MediaCodecsXmlParser::CodecProperties &properties = codec.second;
         bool encoder = properties.isEncoder;
-        std::unique_ptr<MediaCodecInfoWriter> info =
-                writer->addMediaCodecInfo();
+        records->emplace_back();
+        CodecRecord* info = &records->back();
         info->setName(name.c_str());
         info->setOwner("default");
-        typename std::underlying_type<MediaCodecInfo::Attributes>::type attrs = 0;
+        attrs_t attrs = 0;
         if (encoder) {
             attrs |= MediaCodecInfo::kFlagIsEncoder;
         }
@@ -288,8 +394,7 @@ void buildOmxInfo(const MediaCodecsXmlParser& parser,
         // OMX components don't have aliases
         for (const MediaCodecsXmlParser::Type &type : properties.typeMap) {
             const std::string &mediaType = type.first;
-            std::unique_ptr<MediaCodecInfo::CapabilitiesWriter> caps =
-                    info->addMediaType(mediaType.c_str());
+            MediaTypeRecord* caps = info->addMediaType(mediaType.c_str());
             const MediaCodecsXmlParser::AttributeMap &attrMap = type.second;
             for (const MediaCodecsXmlParser::Attribute& attr : attrMap) {
                 const std::string &key = attr.first;
@@ -305,7 +410,7 @@ void buildOmxInfo(const MediaCodecsXmlParser& parser,
                     name.c_str(),
                     mediaType.c_str(),
                     encoder,
-                    caps.get());
+                    caps);
             if (err != OK) {
                 ALOGI("Failed to query capabilities for %s (media type: %s). Error: %d",
                         name.c_str(),
@@ -316,6 +421,287 @@ void buildOmxInfo(const MediaCodecsXmlParser& parser,
     }
 }
 
+// Queries the capabilities of a Codec2 component and fills in |record|.
+// Returns false if the component should not be listed.
+//
+// This is called from multiple threads at the same time.
+bool buildCodec2Info(
+        const Traits& trait, int option,
+        const MediaCodecsXmlParser& parser,
+        CodecRecord* record) {
+    C2Component::rank_t rank = trait.rank;
+
+    std::shared_ptr<Codec2Client::Interface> intf =
+        Codec2Client::CreateInterfaceByName(trait.name.c_str());
+    if (!intf || parser.getCodecMap().count(intf->getName()) == 0) {
+        ALOGD("%s not found in xml", trait.name.c_str());
+        return false;
+    }
+    std::string canonName = intf->getName();
+
+    // TODO: Remove this block once all codecs are enabled by default.
+    switch (option) {
+    case 0:
+        return false;
+    case 1:
+        if (hasPrefix(canonName, "c2.vda.")) {
+            break;
+        }
+        if (hasPrefix(canonName, "c2.android.")) {
+            if (trait.domain == C2Component::DOMAIN_AUDIO) {
+                rank = 1;
+                break;
+            }
+            break;
+        }
+        if (hasSuffix(canonName, ".avc.decoder") ||
+                hasSuffix(canonName, ".avc.encoder")) {
+            rank = std::numeric_limits<decltype(rank)>::max();
+            break;
+        }
+        return false;
+    case 2:
+        if (hasPrefix(canonName, "c2.vda.")) {
+            break;
+        }
+        if (hasPrefix(canonName, "c2.android.")) {
+            rank = 1;
+            break;
+        }
+        if (hasSuffix(canonName, ".avc.decoder") ||
+                hasSuffix(canonName, ".avc.encoder")) {
+            rank = std::numeric_limits<decltype(rank)>::max();
+            break;
+        }
+        return false;
+    case 3:
+        if (hasPrefix(canonName, "c2.android.")) {
+            rank = 1;
+        }
+        break;
+    }
+
+    ALOGV("canonName = %s", canonName.c_str());
+    CodecRecord* codecInfo = record;
+    codecInfo->setName(trait.name.c_str());
+    codecInfo->setOwner(("codec2::" + trait.owner).c_str());
+    const MediaCodecsXmlParser::CodecProperties &codec = parser.getCodecMap().at(canonName);
+
+    bool encoder = trait.kind == C2Component::KIND_ENCODER;
+    attrs_t attrs = 0;
+
+    if (encoder) {
+        attrs |= MediaCodecInfo::kFlagIsEncoder;
+    }
+    if (trait.owner == "software") {
+        attrs |= MediaCodecInfo::kFlagIsSoftwareOnly;
+    } else {
+        attrs |= MediaCodecInfo::kFlagIsVendor;
+        if (trait.owner == "vendor-software") {
+            attrs |= MediaCodecInfo::kFlagIsSoftwareOnly;
+        } else if (codec.quirkSet.find("attribute::software-codec") == codec.quirkSet.end()) {
+            attrs |= MediaCodecInfo::kFlagIsHardwareAccelerated;
+        }
+    }
+    codecInfo->setAttributes(attrs);
+    codecInfo->setRank(rank);
+
+    for (const std::string &alias : codec.aliases) {
+        codecInfo->addAlias(alias.c_str());
+    }
+
+    for (auto typeIt = codec.typeMap.begin(); typeIt != codec.typeMap.end(); ++typeIt) {
+        const std::string &mediaType = typeIt->first;
+        const MediaCodecsXmlParser::AttributeMap &attrMap = typeIt->second;
+        MediaTypeRecord* caps = codecInfo->addMediaType(mediaType.c_str());
+        for (auto attrIt = attrMap.begin(); attrIt != attrMap.end(); ++attrIt) {
+            std::string key, value;
+            std::tie(key, value) = *attrIt;
+            if (key.find("feature-") == 0 && key.find("feature-bitrate-modes") != 0) {
+                caps->addDetail(key.c_str(), std::stoi(value));
+            } else {
+                caps->addDetail(key.c_str(), value.c_str());
+            }
+        }
+
+        bool gotProfileLevels = false;
+        if (intf) {
+            std::shared_ptr<C2Mapper::ProfileLevelMapper> mapper =
+                C2Mapper::GetProfileLevelMapper(trait.mediaType);
+            // if we don't know the media type, pass through all values unmapped
+
+            // TODO: we cannot find levels that are local 'maxima' without knowing the coding
+            // e.g. H.263 level 45 and level 30 could be two values for highest level as
+            // they don't include one another. For now we use the last supported value.
+            C2StreamProfileLevelInfo pl(encoder /* output */, 0u);
+            std::vector<C2FieldSupportedValuesQuery> profileQuery = {
+                C2FieldSupportedValuesQuery::Possible(C2ParamField(&pl, &pl.profile))
+            };
+
+            c2_status_t err = intf->querySupportedValues(profileQuery, C2_DONT_BLOCK);
+            ALOGV("query supported profiles -> %s | %s",
+                    asString(err), asString(profileQuery[0].status));
+            if (err == C2_OK && profileQuery[0].status == C2_OK) {
+                if (profileQuery[0].values.type == C2FieldSupportedValues::VALUES) {
+                    std::vector<std::shared_ptr<C2ParamDescriptor>> supportedParams;
+                    bool hdrSupported = false;
+                    err = intf->querySupportedParams(&supportedParams);
+                    if (err == C2_OK) {
+                        for (const std::shared_ptr<C2ParamDescriptor> &desc : supportedParams) {
+                            if (desc->index().coreIndex() == C2StreamHdrStaticInfo::CORE_INDEX) {
+                                hdrSupported = true;
+                                break;
+                            }
+                        }
+                    }
+                    ALOGV("HDR %ssupported", hdrSupported ? "" : "not ");
+                    for (C2Value::Primitive profile : profileQuery[0].values.values) {
+                        pl.profile = (C2Config::profile_t)profile.ref<uint32_t>();
+                        std::vector<std::unique_ptr<C2SettingResult>> failures;
+                        err = intf->config({&pl}, C2_DONT_BLOCK, &failures);
+                        ALOGV("set profile to %u -> %s", pl.profile, asString(err));
+                        std::vector<C2FieldSupportedValuesQuery> levelQuery = {
+                            C2FieldSupportedValuesQuery::Current(C2ParamField(&pl, &pl.level))
+                        };
+                        err = intf->querySupportedValues(levelQuery, C2_DONT_BLOCK);
+                        ALOGV("query supported levels -> %s | %s",
+                                asString(err), asString(levelQuery[0].status));
+                        if (err == C2_OK && levelQuery[0].status == C2_OK) {
+                            if (levelQuery[0].values.type == C2FieldSupportedValues::VALUES
+                                    && levelQuery[0].values.values.size() > 0) {
+                                C2Value::Primitive level = levelQuery[0].values.values.back();
+                                pl.level = (C2Config::level_t)level.ref<uint32_t>();
+                                ALOGV("supporting level: %u", pl.level);
+                                bool added = false;
+                                int32_t sdkProfile, sdkLevel;
+                                if (mapper && mapper->mapProfile(pl.profile, &sdkProfile)
+                                        && mapper->mapLevel(pl.level, &sdkLevel)) {
+                                    caps->addProfileLevel(
+                                            (uint32_t)sdkProfile, (uint32_t)sdkLevel);
+                                    gotProfileLevels = true;
+                                    added = true;
+                                } else if (!mapper) {
+                                    sdkProfile = pl.profile;
+                                    sdkLevel = pl.level;
+                                    caps->addProfileLevel(pl.profile, pl.level);
+                                    gotProfileLevels = true;
+                                    added = true;
+                                }
+                                if (added && hdrSupported) {
+                                    static ALookup<int32_t, int32_t> sHdrProfileMap = {
+                                        { VP9Profile2, VP9Profile2HDR },
+                                        { VP9Profile3, VP9Profile3HDR },
+                                    };
+                                    int32_t sdkHdrProfile;
+                                    if (sHdrProfileMap.lookup(sdkProfile, &sdkHdrProfile)) {
+                                        caps->addProfileLevel(
+                                                (uint32_t)sdkHdrProfile, (uint32_t)sdkLevel);
+                                    }
+                                }
+
+                                // for H.263 also advertise the second highest level if the
+                                // codec supports level 45, as level 45 only covers level 10
+                                // TODO: move this to some form of a setting so it does not
+                                // have to be here
+                                if (mediaType == MIMETYPE_VIDEO_H263) {
+                                    C2Config::level_t nextLevel = C2Config::LEVEL_UNUSED;
+                                    for (C2Value::Primitive v : levelQuery[0].values.values) {
+                                        C2Config::level_t level =
+                                            (C2Config::level_t)v.ref<uint32_t>();
+                                        if (level < C2Config::LEVEL_H263_45
+                                                && level > nextLevel) {
+                                            nextLevel = level;
+                                        }
+                                    }
+                                    if (nextLevel != C2Config::LEVEL_UNUSED
+                                            && nextLevel != pl.level
+                                            && mapper
+                                            && mapper->mapProfile(pl.profile, &sdkProfile)
+                                            && mapper->mapLevel(nextLevel, &sdkLevel)) {
+                                        caps->addProfileLevel(
+                                                (uint32_t)sdkProfile, (uint32_t)sdkLevel);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        if (!gotProfileLevels) {
+            if (mediaType == MIMETYPE_VIDEO_VP9) {
+                if (encoder) {
+                    caps->addProfileLevel(VP9Profile0,    VP9Level41);
+                } else {
+                    caps->addProfileLevel(VP9Profile0,    VP9Level5);
+                    caps->addProfileLevel(VP9Profile2,    VP9Level5);
+                    caps->addProfileLevel(VP9Profile2HDR, VP9Level5);
+                }
+            } else if (mediaType == MIMETYPE_VIDEO_HEVC && !encoder) {
+                caps->addProfileLevel(HEVCProfileMain,      HEVCMainTierLevel51);
+                caps->addProfileLevel(HEVCProfileMainStill, HEVCMainTierLevel51);
+            } else if (mediaType == MIMETYPE_VIDEO_VP8) {
+                if (encoder) {
+                    caps->addProfileLevel(VP8ProfileMain, VP8Level_Version0);
+                } else {
+                    caps->addProfileLevel(VP8ProfileMain, VP8Level_Version0);
+                }
+            } else if (mediaType == MIMETYPE_VIDEO_AVC) {
+                if (encoder) {
+                    caps->addProfileLevel(AVCProfileBaseline,            AVCLevel41);
+//                      caps->addProfileLevel(AVCProfileConstrainedBaseline, AVCLevel41);
+                    caps->addProfileLevel(AVCProfileMain,                AVCLevel41);
+                } else {
+                    caps->addProfileLevel(AVCProfileBaseline,            AVCLevel52);
+                    caps->addProfileLevel(AVCProfileConstrainedBaseline, AVCLevel52);
+                    caps->addProfileLevel(AVCProfileMain,                AVCLevel52);
+                    caps->addProfileLevel(AVCProfileConstrainedHigh,     AVCLevel52);
+                    caps->addProfileLevel(AVCProfileHigh,                AVCLevel52);
+                }
+            } else if (mediaType == MIMETYPE_VIDEO_MPEG4) {
+                if (encoder) {
+                    caps->addProfileLevel(MPEG4ProfileSimple,  MPEG4Level2);
+                } else {
+                    caps->addProfileLevel(MPEG4ProfileSimple,  MPEG4Level3);
+                }
+            } else if (mediaType == MIMETYPE_VIDEO_H263) {
+                if (encoder) {
+                    caps->addProfileLevel(H263ProfileBaseline, H263Level45);
+                } else {
+                    caps->addProfileLevel(H263ProfileBaseline, H263Level30);
+                    caps->addProfileLevel(H263ProfileBaseline, H263Level45);
+                    caps->addProfileLevel(H263ProfileISWV2,    H263Level30);
+                    caps->addProfileLevel(H263ProfileISWV2,    H263Level45);
+                }
+            } else if (mediaType == MIMETYPE_VIDEO_MPEG2 && !encoder) {
+                caps->addProfileLevel(MPEG2ProfileSimple, MPEG2LevelHL);
+                caps->addProfileLevel(MPEG2ProfileMain,   MPEG2LevelHL);
+            }
+        }
+
+        // TODO: get this from intf() as well, but how do we map them to
+        // MediaCodec color formats?
+        if (mediaType.find("video") != std::string::npos) {
+            // vendor video codecs prefer opaque format
+            if (trait.name.find("android") == std::string::npos) {
+                caps->addColorFormat(COLOR_FormatSurface);
+            }
+            caps->addColorFormat(COLOR_FormatYUV420Flexible);
+            caps->addColorFormat(COLOR_FormatYUV420Planar);
+            caps->addColorFormat(COLOR_FormatYUV420SemiPlanar);
+            caps->addColorFormat(COLOR_FormatYUV420PackedPlanar);
+            caps->addColorFormat(COLOR_FormatYUV420PackedSemiPlanar);
+            // framework video encoders must support surface format, though it is unclear
+            // that they will be able to map it if it is opaque
+            if (encoder && trait.name.find("android") != std::string::npos) {
+                caps->addColorFormat(COLOR_FormatSurface);
+            }
+        }
+    }
+    return true;
+}
+
 } // unnamed namespace
 
 status_t Codec2InfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
@@ -352,6 +738,18 @@ status_t Codec2InfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
     // Obtain Codec2Client
     std::vector<Traits> traits = Codec2Client::ListComponents();
 
+    bool surfaceTest(Codec2Client::CreateInputSurface());
+
+    bool useCache = ::android::base::GetBoolProperty(
+            "debug.stagefright.c2info.cache", true);
+    std::string cacheKey = getCacheKey(option, surfaceTest, traits);
+    std::vector<CodecRecord> records;
+    if (useCache && LoadCodecInfoCache(kCacheFile, cacheKey, &records)) {
+        ALOGV("using cached codec info (%zu codecs)", records.size());
+        writeCodecRecords(records, writer);
+        return OK;
+    }
+
     MediaCodecsXmlParser parser;
     if (option == 0) {
         parser.parseXmlFilesInSearchDirs();
@@ -364,284 +762,42 @@ status_t Codec2InfoBuilder::buildMediaCodecList(MediaCodecListWriter* writer) {
         return OK;
     }
 
-    bool surfaceTest(Codec2Client::CreateInputSurface());
     if (option == 0 || (option != 4 && !surfaceTest)) {
-        buildOmxInfo(parser, writer);
+        buildOmxInfo(parser, &records);
     }
 
-    for (const Traits& trait : traits) {
-        C2Component::rank_t rank = trait.rank;
-
-        std::shared_ptr<Codec2Client::Interface> intf =
-            Codec2Client::CreateInterfaceByName(trait.name.c_str());
-        if (!intf || parser.getCodecMap().count(intf->getName()) == 0) {
-            ALOGD("%s not found in xml", trait.name.c_str());
-            continue;
-        }
-        std::string canonName = intf->getName();
-
-        // TODO: Remove this block once all codecs are enabled by default.
-        switch (option) {
-        case 0:
-            continue;
-        case 1:
-            if (hasPrefix(canonName, "c2.vda.")) {
-                break;
-            }
-            if (hasPrefix(canonName, "c2.android.")) {
-                if (trait.domain == C2Component::DOMAIN_AUDIO) {
-                    rank = 1;
-                    break;
-                }
-                break;
-            }
-            if (hasSuffix(canonName, ".avc.decoder") ||
-                    hasSuffix(canonName, ".avc.encoder")) {
-                rank = std::numeric_limits<decltype(rank)>::max();
-                break;
-            }
-            continue;
-        case 2:
-            if (hasPrefix(canonName, "c2.vda.")) {
-                break;
-            }
-            if (hasPrefix(canonName, "c2.android.")) {
-                rank = 1;
-                break;
-            }
-            if (hasSuffix(canonName, ".avc.decoder") ||
-                    hasSuffix(canonName, ".avc.encoder")) {
-                rank = std::numeric_limits<decltype(rank)>::max();
-                break;
-            }
-            continue;
-        case 3:
-            if (hasPrefix(canonName, "c2.android.")) {
-                rank = 1;
-            }
-            break;
-        }
-
-        ALOGV("canonName = %s", canonName.c_str());
-        std::unique_ptr<MediaCodecInfoWriter> codecInfo = writer->addMediaCodecInfo();
-        codecInfo->setName(trait.name.c_str());
-        codecInfo->setOwner(("codec2::" + trait.owner).c_str());
-        const MediaCodecsXmlParser::CodecProperties &codec = parser.getCodecMap().at(canonName);
-
-        bool encoder = trait.kind == C2Component::KIND_ENCODER;
-        typename std::underlying_type<MediaCodecInfo::Attributes>::type attrs = 0;
-
-        if (encoder) {
-            attrs |= MediaCodecInfo::kFlagIsEncoder;
-        }
-        if (trait.owner == "software") {
-            attrs |= MediaCodecInfo::kFlagIsSoftwareOnly;
-        } else {
-            attrs |= MediaCodecInfo::kFlagIsVendor;
-            if (trait.owner == "vendor-software") {
-                attrs |= MediaCodecInfo::kFlagIsSoftwareOnly;
-            } else if (codec.quirkSet.find("attribute::software-codec") == codec.quirkSet.end()) {
-                attrs |= MediaCodecInfo::kFlagIsHardwareAccelerated;
-            }
+    // Query Codec2 components in parallel. Each component gets its own slot
+    // so that the codec list keeps the order of |traits|.
+    std::vector<CodecRecord> codec2Records(traits.size());
+    std::vector<char> listed(traits.size(), false);
+    std::atomic_size_t nextIndex(0);
+    auto queryComponents = [&]() {
+        for (size_t i = nextIndex++; i < traits.size(); i = nextIndex++) {
+            listed[i] = buildCodec2Info(traits[i], option, parser, &codec2Records[i]);
         }
-        codecInfo->setAttributes(attrs);
-        codecInfo->setRank(rank);
-
-        for (const std::string &alias : codec.aliases) {
-            codecInfo->addAlias(alias.c_str());
+    };
+    size_t numThreads = std::min(
+            { traits.size(), kMaxQueryThreads,
+              std::max(size_t(std::thread::hardware_concurrency()), size_t(1)) });
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; ++i) {
+        threads.emplace_back(queryComponents);
+    }
+    queryComponents();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < traits.size(); ++i) {
+        if (listed[i]) {
+            records.push_back(std::move(codec2Records[i]));
         }
+    }
 
-        for (auto typeIt = codec.typeMap.begin(); typeIt != codec.typeMap.end(); ++typeIt) {
-            const std::string &mediaType = typeIt->first;
-            const MediaCodecsXmlParser::AttributeMap &attrMap = typeIt->second;
-            std::unique_ptr<MediaCodecInfo::CapabilitiesWriter> caps =
-                codecInfo->addMediaType(mediaType.c_str());
-            for (auto attrIt = attrMap.begin(); attrIt != attrMap.end(); ++attrIt) {
-                std::string key, value;
-                std::tie(key, value) = *attrIt;
-                if (key.find("feature-") == 0 && key.find("feature-bitrate-modes") != 0) {
-                    caps->addDetail(key.c_str(), std::stoi(value));
-                } else {
-                    caps->addDetail(key.c_str(), value.c_str());
-                }
-            }
-
-            bool gotProfileLevels = false;
-            if (intf) {
-                std::shared_ptr<C2Mapper::ProfileLevelMapper> mapper =
-                    C2Mapper::GetProfileLevelMapper(trait.mediaType);
-                // if we don't know the media type, pass through all values unmapped
-
-                // TODO: we cannot find levels that are local 'maxima' without knowing the coding
-                // e.g. H.263 level 45 and level 30 could be two values for highest level as
-                // they don't include one another. For now we use the last supported value.
-                C2StreamProfileLevelInfo pl(encoder /* output */, 0u);
-                std::vector<C2FieldSupportedValuesQuery> profileQuery = {
-                    C2FieldSupportedValuesQuery::Possible(C2ParamField(&pl, &pl.profile))
-                };
-
-                c2_status_t err = intf->querySupportedValues(profileQuery, C2_DONT_BLOCK);
-                ALOGV("query supported profiles -> %s | %s",
-                        asString(err), asString(profileQuery[0].status));
-                if (err == C2_OK && profileQuery[0].status == C2_OK) {
-                    if (profileQuery[0].values.type == C2FieldSupportedValues::VALUES) {
-                        std::vector<std::shared_ptr<C2ParamDescriptor>> supportedParams;
-                        bool hdrSupported = false;
-                        err = intf->querySupportedParams(&supportedParams);
-                        if (err == C2_OK) {
-                            for (const std::shared_ptr<C2ParamDescriptor> &desc : supportedParams) {
-                                if (desc->index().coreIndex() == C2StreamHdrStaticInfo::CORE_INDEX) {
-                                    hdrSupported = true;
-                                    break;
-                                }
-                            }
-                        }
-                        ALOGV("HDR %ssupported", hdrSupported ? "" : "not ");
-                        for (C2Value::Primitive profile : profileQuery[0].values.values) {
-                            pl.profile = (C2Config::profile_t)profile.ref<uint32_t>();
-                            std::vector<std::unique_ptr<C2SettingResult>> failures;
-                            err = intf->config({&pl}, C2_DONT_BLOCK, &failures);
-                            ALOGV("set profile to %u -> %s", pl.profile, asString(err));
-                            std::vector<C2FieldSupportedValuesQuery> levelQuery = {
-                                C2FieldSupportedValuesQuery::Current(C2ParamField(&pl, &pl.level))
-                            };
-                            err = intf->querySupportedValues(levelQuery, C2_DONT_BLOCK);
-                            ALOGV("query supported levels -> %s | %s",
-                                    asString(err), asString(levelQuery[0].status));
-                            if (err == C2_OK && levelQuery[0].status == C2_OK) {
-                                if (levelQuery[0].values.type == C2FieldSupportedValues::VALUES
-                                        && levelQuery[0].values.values.size() > 0) {
-                                    C2Value::Primitive level = levelQuery[0].values.values.back();
-                                    pl.level = (C2Config::level_t)level.ref<uint32_t>();
-                                    ALOGV("supporting level: %u", pl.level);
-                                    bool added = false;
-                                    int32_t sdkProfile, sdkLevel;
-                                    if (mapper && mapper->mapProfile(pl.profile, &sdkProfile)
-                                            && mapper->mapLevel(pl.level, &sdkLevel)) {
-                                        caps->addProfileLevel(
-                                                (uint32_t)sdkProfile, (uint32_t)sdkLevel);
-                                        gotProfileLevels = true;
-                                        added = true;
-                                    } else if (!mapper) {
-                                        sdkProfile = pl.profile;
-                                        sdkLevel = pl.level;
-                                        caps->addProfileLevel(pl.profile, pl.level);
-                                        gotProfileLevels = true;
-                                        added = true;
-                                    }
-                                    if (added && hdrSupported) {
-                                        static ALookup<int32_t, int32_t> sHdrProfileMap = {
-                                            { VP9Profile2, VP9Profile2HDR },
-                                            { VP9Profile3, VP9Profile3HDR },
-                                        };
-                                        int32_t sdkHdrProfile;
-                                        if (sHdrProfileMap.lookup(sdkProfile, &sdkHdrProfile)) {
-                                            caps->addProfileLevel(
-                                                    (uint32_t)sdkHdrProfile, (uint32_t)sdkLevel);
-                                        }
-                                    }
-
-                                    // for H.263 also advertise the second highest level if the
-                                    // codec supports level 45, as level 45 only covers level 10
-                                    // TODO: move this to some form of a setting so it does not
-                                    // have to be here
-                                    if (mediaType == MIMETYPE_VIDEO_H263) {
-                                        C2Config::level_t nextLevel = C2Config::LEVEL_UNUSED;
-                                        for (C2Value::Primitive v : levelQuery[0].values.values) {
-                                            C2Config::level_t level =
-                                                (C2Config::level_t)v.ref<uint32_t>();
-                                            if (level < C2Config::LEVEL_H263_45
-                                                    && level > nextLevel) {
-                                                nextLevel = level;
-                                            }
-                                        }
-                                        if (nextLevel != C2Config::LEVEL_UNUSED
-                                                && nextLevel != pl.level
-                                                && mapper
-                                                && mapper->mapProfile(pl.profile, &sdkProfile)
-                                                && mapper->mapLevel(nextLevel, &sdkLevel)) {
-                                            caps->addProfileLevel(
-                                                    (uint32_t)sdkProfile, (uint32_t)sdkLevel);
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-
-            if (!gotProfileLevels) {
-                if (mediaType == MIMETYPE_VIDEO_VP9) {
-                    if (encoder) {
-                        caps->addProfileLevel(VP9Profile0,    VP9Level41);
-                    } else {
-                        caps->addProfileLevel(VP9Profile0,    VP9Level5);
-                        caps->addProfileLevel(VP9Profile2,    VP9Level5);
-                        caps->addProfileLevel(VP9Profile2HDR, VP9Level5);
-                    }
-                } else if (mediaType == MIMETYPE_VIDEO_HEVC && !encoder) {
-                    caps->addProfileLevel(HEVCProfileMain,      HEVCMainTierLevel51);
-                    caps->addProfileLevel(HEVCProfileMainStill, HEVCMainTierLevel51);
-                } else if (mediaType == MIMETYPE_VIDEO_VP8) {
-                    if (encoder) {
-                        caps->addProfileLevel(VP8ProfileMain, VP8Level_Version0);
-                    } else {
-                        caps->addProfileLevel(VP8ProfileMain, VP8Level_Version0);
-                    }
-                } else if (mediaType == MIMETYPE_VIDEO_AVC) {
-                    if (encoder) {
-                        caps->addProfileLevel(AVCProfileBaseline,            AVCLevel41);
-//                      caps->addProfileLevel(AVCProfileConstrainedBaseline, AVCLevel41);
-                        caps->addProfileLevel(AVCProfileMain,                AVCLevel41);
-                    } else {
-                        caps->addProfileLevel(AVCProfileBaseline,            AVCLevel52);
-                        caps->addProfileLevel(AVCProfileConstrainedBaseline, AVCLevel52);
-                        caps->addProfileLevel(AVCProfileMain,                AVCLevel52);
-                        caps->addProfileLevel(AVCProfileConstrainedHigh,     AVCLevel52);
-                        caps->addProfileLevel(AVCProfileHigh,                AVCLevel52);
-                    }
-                } else if (mediaType == MIMETYPE_VIDEO_MPEG4) {
-                    if (encoder) {
-                        caps->addProfileLevel(MPEG4ProfileSimple,  MPEG4Level2);
-                    } else {
-                        caps->addProfileLevel(MPEG4ProfileSimple,  MPEG4Level3);
-                    }
-                } else if (mediaType == MIMETYPE_VIDEO_H263) {
-                    if (encoder) {
-                        caps->addProfileLevel(H263ProfileBaseline, H263Level45);
-                    } else {
-                        caps->addProfileLevel(H263ProfileBaseline, H263Level30);
-                        caps->addProfileLevel(H263ProfileBaseline, H263Level45);
-                        caps->addProfileLevel(H263ProfileISWV2,    H263Level30);
-                        caps->addProfileLevel(H263ProfileISWV2,    H263Level45);
-                    }
-                } else if (mediaType == MIMETYPE_VIDEO_MPEG2 && !encoder) {
-                    caps->addProfileLevel(MPEG2ProfileSimple, MPEG2LevelHL);
-                    caps->addProfileLevel(MPEG2ProfileMain,   MPEG2LevelHL);
-                }
-            }
-
-            // TODO: get this from intf() as well, but how do we map them to
-            // MediaCodec color formats?
-            if (mediaType.find("video") != std::string::npos) {
-                // vendor video codecs prefer opaque format
-                if (trait.name.find("android") == std::string::npos) {
-                    caps->addColorFormat(COLOR_FormatSurface);
-                }
-                caps->addColorFormat(COLOR_FormatYUV420Flexible);
-                caps->addColorFormat(COLOR_FormatYUV420Planar);
-                caps->addColorFormat(COLOR_FormatYUV420SemiPlanar);
-                caps->addColorFormat(COLOR_FormatYUV420PackedPlanar);
-                caps->addColorFormat(COLOR_FormatYUV420PackedSemiPlanar);
-                // framework video encoders must support surface format, though it is unclear
-                // that they will be able to map it if it is opaque
-                if (encoder && trait.name.find("android") != std::string::npos) {
-                    caps->addColorFormat(COLOR_FormatSurface);
-                }
-            }
-        }
+    writeCodecRecords(records, writer);
+    if (useCache) {
+        SaveCodecInfoCache(kCacheFile, cacheKey, records);
     }
+
     return OK;
 }
 
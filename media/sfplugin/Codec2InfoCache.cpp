@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "Codec2InfoCache"
+#include <log/log.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iterator>
+
+#include "Codec2InfoCache.h"
+
+namespace android {
+
+namespace /* unnamed */ {
+
+constexpr char kCacheMagic[] = "C2INFO";
+// Bump this whenever the record layout or the way records are built changes.
+constexpr uint32_t kCacheVersion = 1;
+
+struct CacheWriter {
+    std::string data;
+
+    void writeU32(uint32_t v) {
+        data.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+    void writeString(const std::string& s) {
+        writeU32(s.size());
+        data.append(s);
+    }
+};
+
+struct CacheReader {
+    const std::string& data;
+    size_t pos;
+
+    explicit CacheReader(const std::string& d) : data(d), pos(0) {}
+
+    bool readU32(uint32_t* v) {
+        if (data.size() - pos < sizeof(*v)) {
+            return false;
+        }
+        memcpy(v, data.data() + pos, sizeof(*v));
+        pos += sizeof(*v);
+        return true;
+    }
+    bool readString(std::string* s) {
+        uint32_t size;
+        if (!readU32(&size) || data.size() - pos < size) {
+            return false;
+        }
+        s->assign(data, pos, size);
+        pos += size;
+        return true;
+    }
+};
+
+} // unnamed namespace
+
+bool SaveCodecInfoCache(
+        const std::string& path, const std::string& key,
+        const std::vector<CodecRecord>& records) {
+    CacheWriter w;
+    w.writeString(kCacheMagic);
+    w.writeU32(kCacheVersion);
+    w.writeString(key);
+    w.writeU32(records.size());
+    for (const CodecRecord& record : records) {
+        w.writeString(record.name);
+        w.writeString(record.owner);
+        w.writeU32(static_cast<uint32_t>(record.attrs));
+        w.writeU32(record.rank);
+        w.writeU32(record.aliases.size());
+        for (const std::string& alias : record.aliases) {
+            w.writeString(alias);
+        }
+        w.writeU32(record.mediaTypes.size());
+        for (const MediaTypeRecord& type : record.mediaTypes) {
+            w.writeString(type.mediaType);
+            w.writeU32(type.details.size());
+            for (const MediaTypeRecord::Detail& detail : type.details) {
+                w.writeString(detail.key);
+                w.writeU32(detail.isInt);
+                w.writeString(detail.stringValue);
+                w.writeU32(static_cast<uint32_t>(detail.intValue));
+            }
+            w.writeU32(type.profileLevels.size());
+            for (const std::pair<uint32_t, uint32_t>& pl : type.profileLevels) {
+                w.writeU32(pl.first);
+                w.writeU32(pl.second);
+            }
+            w.writeU32(type.colorFormats.size());
+            for (uint32_t colorFormat : type.colorFormats) {
+                w.writeU32(colorFormat);
+            }
+        }
+    }
+
+    // Write to a temporary file first so that readers never see a partial cache.
+    std::string tmpFile = path + ".tmp";
+    {
+        std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+        if (!out || !out.write(w.data.data(), w.data.size())) {
+            ALOGD("Cannot write codec info cache");
+            return false;
+        }
+    }
+    if (rename(tmpFile.c_str(), path.c_str()) != 0) {
+        ALOGD("Cannot rename codec info cache");
+        unlink(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool LoadCodecInfoCache(
+        const std::string& path, const std::string& key,
+        std::vector<CodecRecord>* records) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+    CacheReader r(data);
+    std::string magic, storedKey;
+    uint32_t version, count;
+    if (!r.readString(&magic) || magic != kCacheMagic
+            || !r.readU32(&version) || version != kCacheVersion
+            || !r.readString(&storedKey) || storedKey != key
+            || !r.readU32(&count)) {
+        ALOGV("codec info cache is stale");
+        return false;
+    }
+    // Do not touch |records| unless the whole file is valid.
+    std::vector<CodecRecord> loaded;
+    for (uint32_t i = 0; i < count; ++i) {
+        CodecRecord record;
+        uint32_t attrs, numAliases, numTypes;
+        if (!r.readString(&record.name) || !r.readString(&record.owner)
+                || !r.readU32(&attrs) || !r.readU32(&record.rank)
+                || !r.readU32(&numAliases) || numAliases > data.size()) {
+            return false;
+        }
+        record.attrs = static_cast<attrs_t>(attrs);
+        record.aliases.resize(numAliases);
+        for (std::string& alias : record.aliases) {
+            if (!r.readString(&alias)) {
+                return false;
+            }
+        }
+        if (!r.readU32(&numTypes) || numTypes > data.size()) {
+            return false;
+        }
+        record.mediaTypes.resize(numTypes);
+        for (MediaTypeRecord& type : record.mediaTypes) {
+            uint32_t numDetails, numProfileLevels, numColorFormats;
+            if (!r.readString(&type.mediaType)
+                    || !r.readU32(&numDetails) || numDetails > data.size()) {
+                return false;
+            }
+            type.details.resize(numDetails);
+            for (MediaTypeRecord::Detail& detail : type.details) {
+                uint32_t isInt, intValue;
+                if (!r.readString(&detail.key) || !r.readU32(&isInt)
+                        || !r.readString(&detail.stringValue) || !r.readU32(&intValue)) {
+                    return false;
+                }
+                detail.isInt = isInt;
+                detail.intValue = static_cast<int32_t>(intValue);
+            }
+            if (!r.readU32(&numProfileLevels) || numProfileLevels > data.size()) {
+                return false;
+            }
+            type.profileLevels.resize(numProfileLevels);
+            for (std::pair<uint32_t, uint32_t>& pl : type.profileLevels) {
+                if (!r.readU32(&pl.first) || !r.readU32(&pl.second)) {
+                    return false;
+                }
+            }
+            if (!r.readU32(&numColorFormats) || numColorFormats > data.size()) {
+                return false;
+            }
+            type.colorFormats.resize(numColorFormats);
+            for (uint32_t& colorFormat : type.colorFormats) {
+                if (!r.readU32(&colorFormat)) {
+                    return false;
+                }
+            }
+        }
+        loaded.push_back(std::move(record));
+    }
+    *records = std::move(loaded);
+    return true;
+}
+
+}  // namespace android
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CODEC2_INFO_CACHE_H_
+#define CODEC2_INFO_CACHE_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <media/MediaCodecInfo.h>
+
+namespace android {
+
+typedef typename std::underlying_type<MediaCodecInfo::Attributes>::type attrs_t;
+
+// Capabilities of one media type of a codec. This mirrors the parts of
+// MediaCodecInfo::CapabilitiesWriter that are used here so that capabilities
+// can be discovered in parallel and persisted before being written out.
+struct MediaTypeRecord {
+    struct Detail {
+        std::string key;
+        bool isInt;
+        std::string stringValue;
+        int32_t intValue;
+    };
+
+    std::string mediaType;
+    std::vector<Detail> details;
+    std::vector<std::pair<uint32_t, uint32_t>> profileLevels;
+    std::vector<uint32_t> colorFormats;
+
+    void addDetail(const char* key, const char* value) {
+        details.push_back({ key, false, value, 0 });
+    }
+    void addDetail(const char* key, int32_t value) {
+        details.push_back({ key, true, "", value });
+    }
+    void addProfileLevel(uint32_t profile, uint32_t level) {
+        profileLevels.emplace_back(profile, level);
+    }
+    void addColorFormat(uint32_t colorFormat) {
+        colorFormats.push_back(colorFormat);
+    }
+};
+
+// Information about one codec. This mirrors MediaCodecInfoWriter.
+struct CodecRecord {
+    std::string name;
+    std::string owner;
+    attrs_t attrs = 0;
+    uint32_t rank = 0;
+    std::vector<std::string> aliases;
+    std::vector<MediaTypeRecord> mediaTypes;
+
+    void setName(const char* name_) { name = name_; }
+    void setOwner(const char* owner_) { owner = owner_; }
+    void setAttributes(attrs_t attrs_) { attrs = attrs_; }
+    void setRank(uint32_t rank_) { rank = rank_; }
+    void addAlias(const char* alias) { aliases.emplace_back(alias); }
+    MediaTypeRecord* addMediaType(const char* mediaType) {
+        mediaTypes.emplace_back();
+        mediaTypes.back().mediaType = mediaType;
+        return &mediaTypes.back();
+    }
+};
+
+// Writes |records| to the cache file at |path| along with |key|. The file is
+// replaced atomically. Returns true on success.
+bool SaveCodecInfoCache(
+        const std::string& path, const std::string& key,
+        const std::vector<CodecRecord>& records);
+
+// Reads the records from the cache file at |path|. Returns false if the file
+// is missing, was written with a different key or layout version, or is
+// truncated or corrupt.
+bool LoadCodecInfoCache(
+        const std::string& path, const std::string& key,
+        std::vector<CodecRecord>* records);
+
+}  // namespace android
+
+#endif  // CODEC2_INFO_CACHE_H_
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2018 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iterator>
+
+#include <gtest/gtest.h>
+
+#include <Codec2InfoCache.h>
+
+namespace android {
+
+namespace {
+
+constexpr char kKey[] = "option=1;surface=1;ro.build.fingerprint=test;";
+
+std::vector<CodecRecord> makeRecords() {
+    std::vector<CodecRecord> records(2);
+
+    records[0].setName("c2.android.avc.decoder");
+    records[0].setOwner("codec2::software");
+    records[0].setAttributes(MediaCodecInfo::kFlagIsSoftwareOnly);
+    records[0].setRank(0x200);
+    records[0].addAlias("OMX.google.h264.decoder");
+    MediaTypeRecord* caps = records[0].addMediaType("video/avc");
+    caps->addDetail("alignment", "2x2");
+    caps->addDetail("max-concurrent-instances", 16);
+    caps->addDetail("feature-adaptive-playback", -1);
+    caps->addProfileLevel(1, 0x8000);
+    caps->addProfileLevel(8, 0x10000);
+    caps->addColorFormat(0x7F420888);
+
+    records[1].setName("c2.android.g711.mlaw.decoder");
+    records[1].setOwner("codec2::software");
+    records[1].setAttributes(MediaCodecInfo::kFlagIsSoftwareOnly);
+    records[1].setRank(0x200);
+    caps = records[1].addMediaType("audio/g711-mlaw");
+    caps->addDetail("max-channel-count", 1);
+    return records;
+}
+
+void expectEqual(const std::vector<CodecRecord>& expected,
+                 const std::vector<CodecRecord>& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const CodecRecord& e = expected[i];
+        const CodecRecord& a = actual[i];
+        EXPECT_EQ(e.name, a.name);
+        EXPECT_EQ(e.owner, a.owner);
+        EXPECT_EQ(e.attrs, a.attrs);
+        EXPECT_EQ(e.rank, a.rank);
+        EXPECT_EQ(e.aliases, a.aliases);
+        ASSERT_EQ(e.mediaTypes.size(), a.mediaTypes.size());
+        for (size_t j = 0; j < e.mediaTypes.size(); ++j) {
+            const MediaTypeRecord& et = e.mediaTypes[j];
+            const MediaTypeRecord& at = a.mediaTypes[j];
+            EXPECT_EQ(et.mediaType, at.mediaType);
+            ASSERT_EQ(et.details.size(), at.details.size());
+            for (size_t k = 0; k < et.details.size(); ++k) {
+                EXPECT_EQ(et.details[k].key, at.details[k].key);
+                EXPECT_EQ(et.details[k].isInt, at.details[k].isInt);
+                EXPECT_EQ(et.details[k].stringValue, at.details[k].stringValue);
+                EXPECT_EQ(et.details[k].intValue, at.details[k].intValue);
+            }
+            EXPECT_EQ(et.profileLevels, at.profileLevels);
+            EXPECT_EQ(et.colorFormats, at.colorFormats);
+        }
+    }
+}
+
+} // namespace
+
+class Codec2InfoCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mPath = ::testing::TempDir() + "codec2_info_cache_test." + std::to_string(getpid());
+    }
+
+    void TearDown() override {
+        unlink(mPath.c_str());
+    }
+
+    std::string readFile() {
+        std::ifstream in(mPath, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    }
+
+    void writeFile(const std::string& data) {
+        std::ofstream out(mPath, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+    }
+
+    std::string mPath;
+};
+
+TEST_F(Codec2InfoCacheTest, RoundTrip) {
+    std::vector<CodecRecord> records = makeRecords();
+    ASSERT_TRUE(SaveCodecInfoCache(mPath, kKey, records));
+    // the temporary file is renamed over the cache
+    EXPECT_NE(0, access((mPath + ".tmp").c_str(), F_OK));
+
+    std::vector<CodecRecord> loaded;
+    ASSERT_TRUE(LoadCodecInfoCache(mPath, kKey, &loaded));
+    expectEqual(records, loaded);
+}
+
+TEST_F(Codec2InfoCacheTest, EmptyList) {
+    ASSERT_TRUE(SaveCodecInfoCache(mPath, kKey, {}));
+    std::vector<CodecRecord> loaded = makeRecords();
+    ASSERT_TRUE(LoadCodecInfoCache(mPath, kKey, &loaded));
+    EXPECT_TRUE(loaded.empty());
+}
+
+TEST_F(Codec2InfoCacheTest, MissingFile) {
+    std::vector<CodecRecord> loaded;
+    EXPECT_FALSE(LoadCodecInfoCache(mPath, kKey, &loaded));
+}
+
+TEST_F(Codec2InfoCacheTest, StaleKey) {
+    ASSERT_TRUE(SaveCodecInfoCache(mPath, kKey, makeRecords()));
+
+    std::vector<CodecRecord> loaded;
+    EXPECT_FALSE(LoadCodecInfoCache(
+            mPath, std::string(kKey) + "debug.stagefright.omx_default_rank=0;", &loaded));
+    EXPECT_FALSE(LoadCodecInfoCache(mPath, "", &loaded));
+    EXPECT_TRUE(loaded.empty());
+}
+
+TEST_F(Codec2InfoCacheTest, Truncated) {
+    ASSERT_TRUE(SaveCodecInfoCache(mPath, kKey, makeRecords()));
+    std::string data = readFile();
+    ASSERT_FALSE(data.empty());
+
+    // every proper prefix of the file is rejected
+    for (size_t size = 0; size < data.size(); ++size) {
+        writeFile(data.substr(0, size));
+        std::vector<CodecRecord> loaded;
+        EXPECT_FALSE(LoadCodecInfoCache(mPath, kKey, &loaded)) << "size " << size;
+        // a partially read file does not leave records behind
+        EXPECT_TRUE(loaded.empty()) << "size " << size;
+    }
+}
+
+TEST_F(Codec2InfoCacheTest, CorruptCount) {
+    ASSERT_TRUE(SaveCodecInfoCache(mPath, kKey, makeRecords()));
+    std::string data = readFile();
+
+    // a huge alias count right after the first record's rank must not be trusted
+    size_t pos = data.find("codec2::software");
+    ASSERT_NE(std::string::npos, pos);
+    pos += strlen("codec2::software") + 2 * sizeof(uint32_t);
+    ASSERT_LE(pos + sizeof(uint32_t), data.size());
+    data.replace(pos, sizeof(uint32_t), std::string(sizeof(uint32_t), '\xff'));
+    writeFile(data);
+
+    std::vector<CodecRecord> loaded;
+    EXPECT_FALSE(LoadCodecInfoCache(mPath, kKey, &loaded));
+}
+
+} // namespace android
@@ -14,9 +14,16 @@
  * limitations under the License.
  */
 
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MediaCodec_sanity_test"
+#include <log/log.h>
+
 #include <stdlib.h>
 
 #include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
 
 #include <binder/ProcessState.h>
 #include <gtest/gtest.h>
@@ -450,4 +457,86 @@ INSTANTIATE_TEST_CASE_P(InputSizes, MediaCodecByteBufferTest, ::testing::Values(
         COLOR_FormatYUV420PackedSemiPlanar,
         COLOR_FormatYUV420Flexible));
 
+// Measures the encoding frame rate of a video encoder at common resolutions. The frame rate is
+// reported for information only; the test fails only if the encoder does not support the size or
+// does not encode all frames.
+class MediaCodecEncoderFpsTest : public MediaCodecSanityTest,
+        public ::testing::WithParamInterface<std::tuple<const char *, int32_t>> {
+};
+
+TEST_P(MediaCodecEncoderFpsTest, TestVpxEncoder) {
+    const char *component = std::get<0>(GetParam());
+    const int32_t height = std::get<1>(GetParam());
+    const int32_t width = height * 16 / 9;
+    const size_t kNumFrames = 60;
+
+    codec = MediaCodec::CreateByComponentName(looper, component);
+    ASSERT_NE(codec, nullptr);
+    cfg->setInt32("width", width);
+    cfg->setInt32("height", height);
+    cfg->setString("mime", strstr(component, "vp9") ? MIMETYPE_VIDEO_VP9 : MIMETYPE_VIDEO_VP8);
+    cfg->setInt32("color-format", COLOR_FormatYUV420Flexible);
+    cfg->setInt32("bitrate", width * height * 4);
+    cfg->setFloat("frame-rate", 30.);
+    cfg->setInt32("i-frame-interval", 1);
+    ASSERT_EQ(codec->configure(cfg, nullptr, nullptr, MediaCodec::CONFIGURE_FLAG_ENCODE), OK)
+            << component << " does not support " << width << "x" << height;
+    EXPECT_EQ(codec->start(),  OK);
+
+    // source picture that is larger than a frame so that each frame can be taken at a different
+    // offset to simulate motion
+    const size_t frameSize = width * height * 3 / 2;
+    std::vector<uint8_t> source(frameSize + kNumFrames * width);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < source.size(); ++i) {
+        seed = seed * 1103515245 + 12345;
+        source[i] = (uint8_t)((i % width + i / width) * 2 + ((seed >> 16) & 0xf));
+    }
+
+    size_t ix, offset, size;
+    int64_t ts;
+    uint32_t flags;
+    sp<MediaCodecBuffer> buf;
+    size_t numInputFrames = 0;
+    size_t numOutputFrames = 0;
+    bool eos = false;
+    int64_t startUs = ALooper::GetNowUs();
+    while (!eos) {
+        if (numInputFrames <= kNumFrames && codec->dequeueInputBuffer(&ix, 0) == OK) {
+            EXPECT_EQ(codec->getInputBuffer(ix, &buf),  OK);
+            ASSERT_GE(buf->capacity(), frameSize);
+            if (numInputFrames < kNumFrames) {
+                memcpy(buf->base(), source.data() + numInputFrames * width, frameSize);
+                EXPECT_EQ(codec->queueInputBuffer(ix, 0, frameSize, numInputFrames * 33333, 0),
+                          OK);
+            } else {
+                EXPECT_EQ(codec->queueInputBuffer(
+                        ix, 0, 0, numInputFrames * 33333, BUFFER_FLAG_END_OF_STREAM), OK);
+            }
+            ++numInputFrames;
+        }
+        status_t err = codec->dequeueOutputBuffer(&ix, &offset, &size, &ts, &flags, 10000);
+        if (err == OK) {
+            if (size > 0 && !(flags & BUFFER_FLAG_CODEC_CONFIG)) {
+                ++numOutputFrames;
+            }
+            eos = flags & BUFFER_FLAG_END_OF_STREAM;
+            EXPECT_EQ(codec->releaseOutputBuffer(ix), OK);
+        } else {
+            ASSERT_TRUE(err == -EAGAIN || err == INFO_FORMAT_CHANGED
+                    || err == INFO_OUTPUT_BUFFERS_CHANGED) << "unexpected error " << err;
+        }
+    }
+    int64_t elapsedUs = ALooper::GetNowUs() - startUs;
+    EXPECT_EQ(numOutputFrames, kNumFrames);
+
+    double fps = numOutputFrames * 1e6 / std::max(elapsedUs, (int64_t)1);
+    ALOGI("%s %dx%d: %.1f fps", component, width, height, fps);
+    RecordProperty("fps", std::to_string(fps));
+}
+
+INSTANTIATE_TEST_CASE_P(Sizes, MediaCodecEncoderFpsTest, ::testing::Combine(
+        ::testing::Values("c2.android.vp8.encoder", "c2.android.vp9.encoder"),
+        ::testing::Values(720, 1080, 2160)));
+
 } // namespace android
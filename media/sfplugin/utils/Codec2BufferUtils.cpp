@@ -225,6 +225,20 @@ bool IsNV12(const C2GraphicView &view) {
             && layout.planes[layout.PLANE_V].offset == 1);
 }
 
+bool IsNV21(const C2GraphicView &view) {
+    if (!IsYUV420(view)) {
+        return false;
+    }
+    const C2PlanarLayout &layout = view.layout();
+    return (layout.rootPlanes == 2
+            && layout.planes[layout.PLANE_U].colInc == 2
+            && layout.planes[layout.PLANE_U].rootIx == layout.PLANE_V
+            && layout.planes[layout.PLANE_U].offset == 1
+            && layout.planes[layout.PLANE_V].colInc == 2
+            && layout.planes[layout.PLANE_V].rootIx == layout.PLANE_V
+            && layout.planes[layout.PLANE_V].offset == 0);
+}
+
 bool IsI420(const C2GraphicView &view) {
     if (!IsYUV420(view)) {
         return false;
@@ -261,6 +275,15 @@ bool IsNV12(const MediaImage2 *img) {
             && (img->mPlane[2].mOffset - img->mPlane[1].mOffset == 1));
 }
 
+bool IsNV21(const MediaImage2 *img) {
+    if (!IsYUV420(img)) {
+        return false;
+    }
+    return (img->mPlane[1].mColInc == 2
+            && img->mPlane[2].mColInc == 2
+            && (img->mPlane[1].mOffset - img->mPlane[2].mOffset == 1));
+}
+
 bool IsI420(const MediaImage2 *img) {
     if (!IsYUV420(img)) {
         return false;
@@ -343,9 +366,19 @@ MediaImage2 CreateYUV420SemiPlanarMediaImage2(
 status_t ConvertRGBToPlanarYUV(
         uint8_t *dstY, size_t dstStride, size_t dstVStride, size_t bufferSize,
         const C2GraphicView &src) {
+    return ConvertRGBRowsToPlanarYUV(
+            dstY, dstStride, dstVStride, bufferSize, src, 0, src.height());
+}
+
+status_t ConvertRGBRowsToPlanarYUV(
+        uint8_t *dstY, size_t dstStride, size_t dstVStride, size_t bufferSize,
+        const C2GraphicView &src, size_t startRow, size_t endRow) {
     CHECK(dstY != nullptr);
     CHECK((src.width() & 1) == 0);
     CHECK((src.height() & 1) == 0);
+    CHECK((startRow & 1) == 0);
+    CHECK((endRow & 1) == 0);
+    CHECK(endRow <= src.height());
 
     if (dstStride * dstVStride * 3 / 2 > bufferSize) {
         ALOGD("conversion buffer is too small for converting from RGB to YUV");
@@ -360,8 +393,15 @@ status_t ConvertRGBToPlanarYUV(
     const uint8_t *pGreen = src.data()[C2PlanarLayout::PLANE_G];
     const uint8_t *pBlue  = src.data()[C2PlanarLayout::PLANE_B];
 
+    dstY += dstStride * startRow;
+    dstU += (dstStride >> 1) * (startRow >> 1);
+    dstV += (dstStride >> 1) * (startRow >> 1);
+    pRed   += layout.planes[C2PlanarLayout::PLANE_R].rowInc * (ssize_t)startRow;
+    pGreen += layout.planes[C2PlanarLayout::PLANE_G].rowInc * (ssize_t)startRow;
+    pBlue  += layout.planes[C2PlanarLayout::PLANE_B].rowInc * (ssize_t)startRow;
+
 #define CLIP3(x,y,z) (((z) < (x)) ? (x) : (((z) > (y)) ? (y) : (z)))
-    for (size_t y = 0; y < src.height(); ++y) {
+    for (size_t y = startRow; y < endRow; ++y) {
         for (size_t x = 0; x < src.width(); ++x) {
             uint8_t red = *pRed;
             uint8_t green = *pGreen;
@@ -41,6 +41,25 @@ status_t ConvertRGBToPlanarYUV(
         uint8_t *dstY, size_t dstStride, size_t dstVStride, size_t bufferSize,
         const C2GraphicView &src);
 
+/**
+ * Converts rows [startRow, endRow) of an RGB view to planar YUV 420 media image. Rows of
+ * different ranges can be converted concurrently.
+ *
+ * \param dstY       pointer to media image buffer
+ * \param dstStride  stride in bytes
+ * \param dstVStride vertical stride in pixels
+ * \param bufferSize media image buffer size
+ * \param src source image
+ * \param startRow first row to convert; must be even
+ * \param endRow end of the rows to convert; must be even and not above the height of src
+ *
+ * \retval NO_MEMORY media image is too small
+ * \retval OK on success
+ */
+status_t ConvertRGBRowsToPlanarYUV(
+        uint8_t *dstY, size_t dstStride, size_t dstVStride, size_t bufferSize,
+        const C2GraphicView &src, size_t startRow, size_t endRow);
+
 /**
  * Returns a planar YUV 420 8-bit media image descriptor.
  *
@@ -95,6 +114,11 @@ bool IsYUV420(const C2GraphicView &view);
  */
 bool IsNV12(const C2GraphicView &view);
 
+/**
+ * Returns true iff a view has a NV21 layout.
+ */
+bool IsNV21(const C2GraphicView &view);
+
 /**
  * Returns true iff a view has a I420 layout.
  */
@@ -110,6 +134,11 @@ bool IsYUV420(const MediaImage2 *img);
  */
 bool IsNV12(const MediaImage2 *img);
 
+/**
+ * Returns true iff a MediaImage2 has a NV21 layout.
+ */
+bool IsNV21(const MediaImage2 *img);
+
 /**
  * Returns true iff a MediaImage2 has a I420 layout.
  */